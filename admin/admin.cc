@@ -27,11 +27,17 @@
 
 #define __STDC_LIMIT_MACROS
 
+// C
+#include <assert.h>
+#include <string.h>
+
 // STL
+#include <algorithm>
 #include <sstream>
 
 // e
 #include <e/endian.h>
+#include <e/strescape.h>
 
 // BusyBee
 #include <busybee_constants.h>
@@ -39,6 +45,7 @@
 // HyperDex
 #include <hyperdex/hyperspace_builder.h>
 #include "visibility.h"
+#include "common/datatype_info.h"
 #include "common/macros.h"
 #include "common/serialization.h"
 #include "admin/admin.h"
@@ -47,6 +54,7 @@
 #include "admin/coord_rpc_backup.h"
 #include "admin/coord_rpc_generic.h"
 #include "admin/hyperspace_builder_internal.h"
+#include "admin/pending_bulk_ingest.h"
 #include "admin/pending_perf_counters.h"
 #include "admin/pending_raw_backup.h"
 #include "admin/pending_string.h"
@@ -661,6 +669,165 @@ admin :: raw_backup(const server_id& sid, const char* name,
     return op->admin_visible_id();
 }
 
+namespace
+{
+
+class key_order
+{
+    public:
+        key_order(const std::vector<e::slice>& keys) : m_keys(keys) {}
+        bool operator () (size_t lhs, size_t rhs) const
+        {
+            const e::slice& l(m_keys[lhs]);
+            const e::slice& r(m_keys[rhs]);
+            int cmp = memcmp(l.data(), r.data(), std::min(l.size(), r.size()));
+            return cmp < 0 || (cmp == 0 && l.size() < r.size());
+        }
+
+    private:
+        const std::vector<e::slice>& m_keys;
+};
+
+} // namespace
+
+int64_t
+admin :: bulk_ingest(const char* space,
+                     const hyperdex_admin_ingest_object* objects,
+                     size_t objects_sz,
+                     enum hyperdex_admin_returncode* status)
+{
+    if (!maintain_coord_connection(status))
+    {
+        return -1;
+    }
+
+    const schema* sc = m_config.get_schema(space);
+
+    if (!sc)
+    {
+        ERROR(BADSPACE) << "space \"" << e::strescape(space) << "\" does not exist";
+        return -1;
+    }
+
+    // lay every object out the way the daemons store it, and group the
+    // objects by the region that holds them
+    typedef std::map<region_id, std::vector<size_t> > region_map_t;
+    std::vector<e::slice> keys(objects_sz);
+    std::vector<std::vector<e::slice> > values(objects_sz, std::vector<e::slice>(sc->attrs_sz - 1));
+    region_map_t regions;
+
+    for (size_t i = 0; i < objects_sz; ++i)
+    {
+        const hyperdex_admin_ingest_object& obj(objects[i]);
+        keys[i] = e::slice(obj.key, obj.key_sz);
+
+        if (!datatype_info::lookup(sc->attrs[0].type)->validate(keys[i]))
+        {
+            ERROR(LOCALERROR) << "object " << i << " has a malformed key";
+            return -1;
+        }
+
+        for (size_t j = 0; j < obj.attrs_sz; ++j)
+        {
+            const hyperdex_admin_ingest_attribute& a(obj.attrs[j]);
+            uint16_t attr = sc->lookup_attr(a.attr);
+            e::slice value(a.value, a.value_sz);
+
+            if (attr == 0 || attr >= sc->attrs_sz)
+            {
+                ERROR(LOCALERROR) << "object " << i << " sets attribute \""
+                                  << e::strescape(a.attr) << "\", which is not an attribute of space \""
+                                  << e::strescape(space) << "\"";
+                return -1;
+            }
+
+            if (a.datatype != sc->attrs[attr].type ||
+                !datatype_info::lookup(a.datatype)->validate(value))
+            {
+                ERROR(LOCALERROR) << "object " << i << " sets attribute \""
+                                  << e::strescape(a.attr) << "\" to a value of the wrong type";
+                return -1;
+            }
+
+            values[i][attr - 1] = value;
+        }
+
+        virtual_server_id vsi = m_config.point_leader(space, keys[i]);
+        region_id ri = m_config.get_region_id(vsi);
+
+        if (vsi == virtual_server_id() || ri == region_id())
+        {
+            ERROR(SERVERERROR) << "no server holds object " << i;
+            return -1;
+        }
+
+        // the daemons write only the key subspace
+        if (regions.empty() &&
+            m_config.subspace_next(m_config.subspace_of(ri)) != subspace_id())
+        {
+            ERROR(BADSPACE) << "cannot bulk ingest into space \"" << e::strescape(space)
+                            << "\" because it has more than one subspace";
+            return -1;
+        }
+
+        regions[ri].push_back(i);
+    }
+
+    int64_t id = m_next_admin_id;
+    ++m_next_admin_id;
+    e::intrusive_ptr<pending_bulk_ingest> op = new pending_bulk_ingest(id, status);
+
+    for (region_map_t::iterator it = regions.begin(); it != regions.end(); ++it)
+    {
+        // every region has a point leader, or the loop above would have failed
+        virtual_server_id point_leader = m_config.head_of_region(it->first);
+        assert(point_leader != virtual_server_id());
+
+        // sorted batches turn into sequential writes on the daemons
+        std::vector<size_t>& objs(it->second);
+        std::stable_sort(objs.begin(), objs.end(), key_order(keys));
+        size_t start = 0;
+
+        while (start < objs.size())
+        {
+            size_t limit = start;
+            size_t bytes = 0;
+
+            while (limit < objs.size() &&
+                   (limit == start || bytes < HYPERDEX_ADMIN_BULK_INGEST_BATCH_SIZE))
+            {
+                bytes += pack_size(keys[objs[limit]]) + pack_size(values[objs[limit]]);
+                ++limit;
+            }
+
+            const uint64_t batch = op->next_batch();
+            const uint32_t count = limit - start;
+            size_t sz = HYPERDEX_ADMIN_HEADER_SIZE_REQ
+                      + sizeof(uint64_t)
+                      + sizeof(uint32_t)
+                      + bytes;
+            std::auto_ptr<e::buffer> msg(e::buffer::create(sz));
+            e::packer pa = msg->pack_at(HYPERDEX_ADMIN_HEADER_SIZE_REQ);
+            pa = pa << batch << count;
+
+            for (size_t i = start; i < limit; ++i)
+            {
+                pa = pa << keys[objs[i]] << values[objs[i]];
+            }
+
+            op->send_batch(this, point_leader, msg);
+            start = limit;
+        }
+    }
+
+    if (!op->has_outstanding())
+    {
+        m_yieldable.push_back(op.get());
+    }
+
+    return op->admin_visible_id();
+}
+
 int64_t
 admin :: enable_perf_counters(hyperdex_admin_returncode* status,
                               hyperdex_admin_perf_counter* pc)
@@ -1064,12 +1231,24 @@ admin :: send(network_msgtype mt,
               std::auto_ptr<e::buffer> msg,
               e::intrusive_ptr<pending> op,
               hyperdex_admin_returncode* status)
+{
+    return send(mt, id, virtual_server_id(UINT64_MAX), nonce, msg, op, status);
+}
+
+bool
+admin :: send(network_msgtype mt,
+              server_id id,
+              virtual_server_id vto,
+              uint64_t nonce,
+              std::auto_ptr<e::buffer> msg,
+              e::intrusive_ptr<pending> op,
+              hyperdex_admin_returncode* status)
 {
     const uint8_t type = static_cast<uint8_t>(mt);
     const uint8_t flags = 0;
     const uint64_t version = m_config.version();
     msg->pack_at(BUSYBEE_HEADER_SIZE)
-        << type << flags << version << uint64_t(UINT64_MAX) << nonce;
+        << type << flags << version << vto.get() << nonce;
     m_busybee.set_timeout(-1);
 
     switch (m_busybee.send(id.get(), msg))
@@ -87,6 +87,11 @@ class admin
         int64_t list_subspaces(const char* space,
                             enum hyperdex_admin_returncode* status,
                             const char** subspaces);
+        // load objects directly into each replica, bypassing the chains
+        int64_t bulk_ingest(const char* space,
+                            const hyperdex_admin_ingest_object* objects,
+                            size_t objects_sz,
+                            enum hyperdex_admin_returncode* status);
         // manage servers
         int64_t server_register(uint64_t token, const char* address,
                                 enum hyperdex_admin_returncode* status);
@@ -132,6 +137,7 @@ class admin
         typedef std::map<int64_t, e::intrusive_ptr<multi_yieldable> > multi_yieldable_map_t;
         typedef std::list<pending_server_pair> pending_queue_t;
         friend class backup_state_machine;
+        friend class pending_bulk_ingest;
         friend class pending_perf_counters;
 
     private:
@@ -146,6 +152,14 @@ class admin
                   std::auto_ptr<e::buffer> msg,
                   e::intrusive_ptr<pending> op,
                   hyperdex_admin_returncode* status);
+        // as above, but addressed to one virtual server of "id"
+        bool send(network_msgtype mt,
+                  server_id id,
+                  virtual_server_id vto,
+                  uint64_t nonce,
+                  std::auto_ptr<e::buffer> msg,
+                  e::intrusive_ptr<pending> op,
+                  hyperdex_admin_returncode* status);
         void handle_disruption(const server_id& si);
 
     private:
@@ -347,6 +347,19 @@ hyperdex_admin_loop(struct hyperdex_admin* _adm, int timeout,
     );
 }
 
+HYPERDEX_API int64_t
+hyperdex_admin_bulk_ingest(struct hyperdex_admin* _adm,
+                           const char* space,
+                           const struct hyperdex_admin_ingest_object* objects,
+                           size_t objects_sz,
+                           enum hyperdex_admin_returncode* status)
+{
+    C_WRAP_EXCEPT(
+    hyperdex::admin* adm = reinterpret_cast<hyperdex::admin*>(_adm);
+    return adm->bulk_ingest(space, objects, objects_sz, status);
+    );
+}
+
 HYPERDEX_API const char*
 hyperdex_admin_error_message(struct hyperdex_admin* _adm)
 {
@@ -42,4 +42,7 @@
                                          + sizeof(uint64_t) /*vidt*/ \
                                          + sizeof(uint64_t) /*nonce*/)
 
+// bulk ingest splits a region's objects into messages of about this size
+#define HYPERDEX_ADMIN_BULK_INGEST_BATCH_SIZE (4ULL * 1024ULL * 1024ULL)
+
 #endif // hyperdex_admin_constants_h_
@@ -106,6 +106,8 @@ class hyperspace
         uint64_t fault_tolerance;
         uint64_t partitions;
         bool authorization;
+        hyperdex::schema::durability_t durability;
+        hyperdex::schema::consistency_t consistency;
 
     private:
         hyperspace(const hyperspace&);
@@ -124,6 +126,8 @@ hyperspace :: hyperspace()
     , fault_tolerance(1)
     , partitions(64)
     , authorization(false)
+    , durability(hyperdex::schema::DURABILITY_NONE)
+    , consistency(hyperdex::schema::CONSISTENCY_STRONG)
 {
     memset(buffer, 0, 1024);
 }
@@ -495,6 +499,54 @@ hyperspace_use_authorization(struct hyperspace* space)
     return HYPERSPACE_SUCCESS;
 }
 
+HYPERDEX_API enum hyperspace_returncode
+hyperspace_set_durability(struct hyperspace* space, const char* mode)
+{
+    if (strcmp(mode, "none") == 0)
+    {
+        space->durability = hyperdex::schema::DURABILITY_NONE;
+    }
+    else if (strcmp(mode, "periodic") == 0)
+    {
+        space->durability = hyperdex::schema::DURABILITY_PERIODIC;
+    }
+    else if (strcmp(mode, "sync") == 0)
+    {
+        space->durability = hyperdex::schema::DURABILITY_SYNC;
+    }
+    else
+    {
+        snprintf(space->buffer, BUFFER_SIZE, "durability must be one of \"none\", \"periodic\", or \"sync\", not \"%s\"", mode);
+        space->buffer[BUFFER_SIZE - 1] = '\0';
+        space->error = space->buffer;
+        return HYPERSPACE_INVALID_DURABILITY;
+    }
+
+    return HYPERSPACE_SUCCESS;
+}
+
+HYPERDEX_API enum hyperspace_returncode
+hyperspace_set_consistency(struct hyperspace* space, const char* mode)
+{
+    if (strcmp(mode, "strong") == 0)
+    {
+        space->consistency = hyperdex::schema::CONSISTENCY_STRONG;
+    }
+    else if (strcmp(mode, "stale") == 0)
+    {
+        space->consistency = hyperdex::schema::CONSISTENCY_STALE;
+    }
+    else
+    {
+        snprintf(space->buffer, BUFFER_SIZE, "consistency must be one of \"strong\" or \"stale\", not \"%s\"", mode);
+        space->buffer[BUFFER_SIZE - 1] = '\0';
+        space->error = space->buffer;
+        return HYPERSPACE_INVALID_CONSISTENCY;
+    }
+
+    return HYPERSPACE_SUCCESS;
+}
+
 char*
 hyperspace_buffer(hyperspace* space)
 {
@@ -535,6 +587,8 @@ hyperdex :: space_to_space(hyperspace* in, hyperdex::space* out)
     schema sc;
     sc.attrs_sz = attrs.size();
     sc.attrs = &attrs.front();
+    sc.durability = in->durability;
+    sc.consistency = in->consistency;
     space sp(in->name, sc);
     sp.subspaces.push_back(subspace());
     sp.subspaces.back().attrs.push_back(0);
@@ -75,6 +75,8 @@ yyerror(YYLTYPE* yylloc, struct hyperspace* space, void* scanner, const char* ms
 %token INDEX
 %token WITH
 %token AUTHORIZATION
+%token DURABILITY
+%token CONSISTENCY
 
 %token <str> IDENTIFIER
 %token <num> NUMBER
@@ -144,6 +146,8 @@ options :                { }
 option : TOLERATE NUMBER FAILURES { hyperspace_set_fault_tolerance(space, $2); }
        | CREATE NUMBER PARTITIONS { hyperspace_set_number_of_partitions(space, $2); }
        | WITH AUTHORIZATION { hyperspace_use_authorization(space); }
+       | WITH DURABILITY IDENTIFIER { hyperspace_set_durability(space, $3); free($3); }
+       | WITH CONSISTENCY IDENTIFIER { hyperspace_set_consistency(space, $3); free($3); }
 
 type : STRING                        { $$ = HYPERDATATYPE_STRING; }
      | INT64                         { $$ = HYPERDATATYPE_INT64; }
@@ -0,0 +1,151 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <assert.h>
+
+// HyperDex
+#include "common/network_returncode.h"
+#include "common/serialization.h"
+#include "admin/admin.h"
+#include "admin/constants.h"
+#include "admin/pending_bulk_ingest.h"
+
+using hyperdex::pending_bulk_ingest;
+
+pending_bulk_ingest :: pending_bulk_ingest(uint64_t id,
+                                           hyperdex_admin_returncode* status)
+    : pending(id, status)
+    , m_batches(0)
+    , m_outstanding(0)
+    , m_done(false)
+{
+    this->set_status(HYPERDEX_ADMIN_SUCCESS);
+}
+
+pending_bulk_ingest :: ~pending_bulk_ingest() throw ()
+{
+}
+
+void
+pending_bulk_ingest :: send_batch(admin* adm,
+                                  const virtual_server_id& point_leader,
+                                  std::auto_ptr<e::buffer> msg)
+{
+    ++m_batches;
+    send(adm, point_leader, msg);
+}
+
+bool
+pending_bulk_ingest :: can_yield()
+{
+    return m_outstanding == 0 && !m_done;
+}
+
+bool
+pending_bulk_ingest :: yield(hyperdex_admin_returncode* status)
+{
+    *status = HYPERDEX_ADMIN_SUCCESS;
+    m_done = true;
+    return true;
+}
+
+void
+pending_bulk_ingest :: handle_sent_to(const server_id&)
+{
+    ++m_outstanding;
+}
+
+void
+pending_bulk_ingest :: handle_failure(const server_id& si)
+{
+    assert(m_outstanding > 0);
+    --m_outstanding;
+    YIELDING_ERROR(SERVERERROR) << "communication with " << si << " failed";
+}
+
+bool
+pending_bulk_ingest :: handle_message(admin*,
+                                      const server_id& si,
+                                      network_msgtype mt,
+                                      std::auto_ptr<e::buffer> msg,
+                                      e::unpacker up,
+                                      hyperdex_admin_returncode* status)
+{
+    *status = HYPERDEX_ADMIN_SUCCESS;
+    assert(m_outstanding > 0);
+    --m_outstanding;
+
+    if (mt != BULK_INGEST)
+    {
+        YIELDING_ERROR(SERVERERROR) << "server " << si << " responded to BULK_INGEST with " << mt;
+        return true;
+    }
+
+    uint16_t rt;
+    uint64_t b;
+    up = up >> rt >> b;
+
+    if (up.error() || b >= m_batches)
+    {
+        YIELDING_ERROR(SERVERERROR) << "communication error: server "
+                                    << si << " sent corrupt message="
+                                    << msg->as_slice().hex()
+                                    << " in response to a BULK_INGEST";
+        return true;
+    }
+
+    network_returncode rc = static_cast<network_returncode>(rt);
+
+    if (rc != NET_SUCCESS)
+    {
+        YIELDING_ERROR(SERVERERROR) << "bulk ingest on server " << si
+                                    << " failed with code " << rt
+                                    << "; see the server's log for details";
+    }
+
+    return true;
+}
+
+bool
+pending_bulk_ingest :: send(admin* adm, const virtual_server_id& vsi,
+                            std::auto_ptr<e::buffer> msg)
+{
+    uint64_t nonce = adm->m_next_server_nonce;
+    ++adm->m_next_server_nonce;
+    hyperdex_admin_returncode status;
+
+    if (!adm->send(BULK_INGEST, adm->m_config.get_server_id(vsi), vsi,
+                   nonce, msg, this, &status))
+    {
+        YIELDING_ERROR(SERVERERROR) << "could not send a BULK_INGEST to " << vsi
+                                    << ": " << adm->error_message();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef hyperdex_admin_pending_bulk_ingest_h_
+#define hyperdex_admin_pending_bulk_ingest_h_
+
+// e
+#include <e/buffer.h>
+
+// HyperDex
+#include "admin/pending.h"
+
+BEGIN_HYPERDEX_NAMESPACE
+
+// Each batch holds the objects of one region and goes to the region's point
+// leader, which passes it down the chain.  The point leader answers once the
+// tail has it.  The operation completes when every batch is answered.
+class pending_bulk_ingest : public pending
+{
+    public:
+        pending_bulk_ingest(uint64_t admin_visible_id,
+                            hyperdex_admin_returncode* status);
+        virtual ~pending_bulk_ingest() throw ();
+
+    public:
+        // msg is a BULK_INGEST whose batch number is the value returned
+        uint64_t next_batch() const { return m_batches; }
+        void send_batch(admin* adm, const virtual_server_id& point_leader,
+                        std::auto_ptr<e::buffer> msg);
+        // false if nothing could be sent
+        bool has_outstanding() const { return m_outstanding > 0; }
+
+    // return to admin
+    public:
+        virtual bool can_yield();
+        virtual bool yield(hyperdex_admin_returncode* status);
+
+    // events
+    public:
+        virtual void handle_sent_to(const server_id& si);
+        virtual void handle_failure(const server_id& si);
+        virtual bool handle_message(admin* adm,
+                                    const server_id& si,
+                                    network_msgtype mt,
+                                    std::auto_ptr<e::buffer> msg,
+                                    e::unpacker up,
+                                    hyperdex_admin_returncode* status);
+
+    private:
+        bool send(admin* adm, const virtual_server_id& vsi,
+                  std::auto_ptr<e::buffer> msg);
+
+    private:
+        pending_bulk_ingest(const pending_bulk_ingest& other);
+        pending_bulk_ingest& operator = (const pending_bulk_ingest& rhs);
+
+    private:
+        uint64_t m_batches;
+        size_t m_outstanding;
+        bool m_done;
+};
+
+END_HYPERDEX_NAMESPACE
+
+#endif // hyperdex_admin_pending_bulk_ingest_h_
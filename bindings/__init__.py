@@ -244,8 +244,10 @@ Client = [
     Method('group_map_atomic_max', AsyncCall, (SpaceName, Predicates, MapAttributes), (Status, Count)),
     Method('uxact_atomic_max', MicrotransactionCall, (Microtransaction, Attributes), ()),
     Method('search', Iterator, (SpaceName, Predicates), (Status, Attributes)),
+    Method('search_partial', Iterator, (SpaceName, Predicates, AttributeNames), (Status, Attributes)),
     Method('search_describe', AsyncCall, (SpaceName, Predicates), (Status, Description)),
     Method('sorted_search', Iterator, (SpaceName, Predicates, SortBy, Limit, MaxMin), (Status, Attributes)),
+    Method('sorted_search_partial', Iterator, (SpaceName, Predicates, AttributeNames, SortBy, Limit, MaxMin), (Status, Attributes)),
     Method('count', AsyncCall, (SpaceName, Predicates), (Status, Count)),
 ]
 
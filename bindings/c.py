@@ -171,10 +171,14 @@ def generate_client_c_wrapper(x):
             func += '    return cl->get_partial(space, key, key_sz, attrnames, attrnames_sz, status, attrs, attrs_sz);\n'
         elif x.name == 'search':
             func += '    return cl->search(space, checks, checks_sz, status, attrs, attrs_sz);\n'
+        elif x.name == 'search_partial':
+            func += '    return cl->search_partial(space, checks, checks_sz, attrnames, attrnames_sz, status, attrs, attrs_sz);\n'
         elif x.name == 'search_describe':
             func += '    return cl->search_describe(space, checks, checks_sz, status, description);\n'
         elif x.name == 'sorted_search':
             func += '    return cl->sorted_search(space, checks, checks_sz, sort_by, limit, maxmin, status, attrs, attrs_sz);\n'
+        elif x.name == 'sorted_search_partial':
+            func += '    return cl->sorted_search_partial(space, checks, checks_sz, attrnames, attrnames_sz, sort_by, limit, maxmin, status, attrs, attrs_sz);\n'
         elif x.name == 'count':
             func += '    return cl->count(space, checks, checks_sz, status, count);\n'
         elif x.name.startswith('group_'):
@@ -385,6 +389,35 @@ struct hyperdex_client_attribute_check
     enum hyperpredicate predicate;
 };
 
+enum hyperdex_client_aggregate_function
+{
+    HYPERDEX_CLIENT_AGGREGATE_SUM       = 1,
+    HYPERDEX_CLIENT_AGGREGATE_MIN       = 2,
+    HYPERDEX_CLIENT_AGGREGATE_MAX       = 3,
+    HYPERDEX_CLIENT_AGGREGATE_AVG       = 4,
+    HYPERDEX_CLIENT_AGGREGATE_HISTOGRAM = 5
+};
+
+/* An aggregate over an int64, float, or timestamp attribute.  The caller
+ * fills in the inputs; the outputs are valid once the operation completes.
+ * int64 and timestamp attributes report through int_value, float attributes
+ * (and every AVG) through float_value.  A HISTOGRAM counts values into
+ * buckets_sz buckets of bucket_width, starting at bucket_start. */
+struct hyperdex_client_aggregate_spec
+{
+    /* inputs */
+    const char* attr; /* NULL-terminated */
+    enum hyperdex_client_aggregate_function function;
+    double bucket_start;
+    double bucket_width;
+    size_t buckets_sz;
+    uint64_t* buckets;
+    /* outputs */
+    uint64_t count;
+    int64_t int_value;
+    double float_value;
+};
+
 /* hyperdex_client_returncode occupies [8448, 8576) */
 enum hyperdex_client_returncode
 {
@@ -430,6 +463,24 @@ hyperdex_client_uxact_cond_commit(struct hyperdex_client* _cl,
                                 const char* key, size_t key_sz,
                                 const struct hyperdex_client_attribute_check *chks, size_t chks_sz);
 
+int64_t
+hyperdex_client_aggregate(struct hyperdex_client* client,
+                          const char* space,
+                          const struct hyperdex_client_attribute_check* checks, size_t checks_sz,
+                          struct hyperdex_client_aggregate_spec* aggs, size_t aggs_sz,
+                          enum hyperdex_client_returncode* status);
+
+/* Retrieve num_keys objects with one request per server.  statuses, attrs,
+ * and attrs_sz hold one entry per key; status reports the operation as a
+ * whole. */
+int64_t
+hyperdex_client_get_many(struct hyperdex_client* client,
+                         const char* space,
+                         const char** keys, const size_t* keys_sz, size_t num_keys,
+                         enum hyperdex_client_returncode* status,
+                         enum hyperdex_client_returncode* statuses,
+                         const struct hyperdex_client_attribute** attrs, size_t* attrs_sz);
+
 '''
 
 CLIENT_HEADER_FOOT = '''
@@ -437,12 +488,39 @@ int64_t
 hyperdex_client_loop(struct hyperdex_client* client, int timeout,
                      enum hyperdex_client_returncode* status);
 
+/* Reap up to n finished operations in one call.  Waits up to timeout for the
+ * first, then takes only those whose responses have already arrived.  ids[i]
+ * and statuses[i] are what the i-th call to hyperdex_client_loop would have
+ * returned.  Returns the number reaped, or -1 if none could be, with the
+ * reason in statuses[0].  An error met after some operations were reaped is
+ * returned by the next call. */
+int64_t
+hyperdex_client_loop_many(struct hyperdex_client* client, int timeout,
+                          int64_t* ids, enum hyperdex_client_returncode* statuses,
+                          size_t n);
+
 int
 hyperdex_client_poll_fd(struct hyperdex_client* client);
 
 int
 hyperdex_client_block(struct hyperdex_client* client, int timeout);
 
+/* Let many threads share the client.  Each thread's hyperdex_client_loop
+ * returns only the operations that thread issued.  Call before sharing.
+ * Returns -1 if the client cannot track its threads. */
+int
+hyperdex_client_set_thread_safe(struct hyperdex_client* client, int enabled);
+
+/* Hold small requests (get, get_partial, and atomic operations) and send each
+ * server's as one message.  Held requests go out on hyperdex_client_flush, on
+ * the next hyperdex_client_loop, or once enough accumulate.  Disabling
+ * corking flushes. */
+int
+hyperdex_client_set_corking(struct hyperdex_client* client, int enabled);
+
+int
+hyperdex_client_flush(struct hyperdex_client* client);
+
 enum hyperdatatype
 hyperdex_client_attribute_type(struct hyperdex_client* client,
                                const char* space, const char* name,
@@ -507,6 +585,7 @@ inline void return_void() {}
     SIGNAL_PROTECT; \\
     try \\
     { \\
+        hyperdex::client::api_guard _guard(cl); \\
         X \\
     } \\
     catch (std::bad_alloc& ba) \\
@@ -639,6 +718,7 @@ hyperdex_client_attribute_type(hyperdex_client* _cl,
 
     try
     {
+        hyperdex::client::api_guard _guard(cl);
         return cl->attribute_type(space, name, status);
     }
     catch (std::bad_alloc& ba)
@@ -670,6 +750,7 @@ hyperdex_client_clear_auth_context(struct hyperdex_client* _cl)
     FAKE_STATUS;
     SIGNAL_PROTECT_VOID;
     hyperdex::client* cl = reinterpret_cast<hyperdex::client*>(_cl);
+    hyperdex::client::api_guard _guard(cl);
     cl->clear_auth_context();
 }
 
@@ -680,6 +761,7 @@ hyperdex_client_set_auth_context(struct hyperdex_client* _cl,
     FAKE_STATUS;
     SIGNAL_PROTECT_VOID;
     hyperdex::client* cl = reinterpret_cast<hyperdex::client*>(_cl);
+    hyperdex::client::api_guard _guard(cl);
     cl->set_auth_context(macaroons, macaroons_sz);
 }
 
@@ -691,6 +773,7 @@ hyperdex_client_uxact_init(struct hyperdex_client* _cl,
 
     SIGNAL_PROTECT_ERR(NULL);
     hyperdex::client *cl = reinterpret_cast<hyperdex::client*>(_cl);
+    hyperdex::client::api_guard _guard(cl);
     hyperdex::microtransaction *tx = cl->uxact_init(space, status);
 
     return reinterpret_cast<struct hyperdex_client_microtransaction*>(tx);
@@ -737,6 +820,31 @@ hyperdex_client_uxact_cond_commit(struct hyperdex_client* _cl,
     );
 }
 
+HYPERDEX_API int64_t
+hyperdex_client_aggregate(struct hyperdex_client* _cl,
+                          const char* space,
+                          const struct hyperdex_client_attribute_check* checks, size_t checks_sz,
+                          struct hyperdex_client_aggregate_spec* aggs, size_t aggs_sz,
+                          enum hyperdex_client_returncode* status)
+{
+    C_WRAP_EXCEPT(
+    return cl->aggregate(space, checks, checks_sz, aggs, aggs_sz, status);
+    );
+}
+
+HYPERDEX_API int64_t
+hyperdex_client_get_many(struct hyperdex_client* _cl,
+                         const char* space,
+                         const char** keys, const size_t* keys_sz, size_t num_keys,
+                         enum hyperdex_client_returncode* status,
+                         enum hyperdex_client_returncode* statuses,
+                         const struct hyperdex_client_attribute** attrs, size_t* attrs_sz)
+{
+    C_WRAP_EXCEPT(
+    return cl->get_many(space, keys, keys_sz, num_keys, status, statuses, attrs, attrs_sz);
+    );
+}
+
 '''
 
 CLIENT_WRAPPER_FOOT = '''
@@ -749,6 +857,17 @@ hyperdex_client_loop(hyperdex_client* _cl, int timeout,
     );
 }
 
+HYPERDEX_API int64_t
+hyperdex_client_loop_many(hyperdex_client* _cl, int timeout,
+                          int64_t* ids, hyperdex_client_returncode* statuses,
+                          size_t n)
+{
+    hyperdex_client_returncode* status = statuses;
+    C_WRAP_EXCEPT(
+    return cl->loop_many(timeout, ids, statuses, n);
+    );
+}
+
 HYPERDEX_API int
 hyperdex_client_poll_fd(hyperdex_client* _cl)
 {
@@ -774,6 +893,36 @@ hyperdex_client_set_type_conversion(hyperdex_client* _cl, bool enabled)
     cl->set_type_conversion(enabled);
 }
 
+HYPERDEX_API int
+hyperdex_client_set_thread_safe(hyperdex_client* _cl, int enabled)
+{
+    FAKE_STATUS;
+    C_WRAP_EXCEPT(
+    cl->set_thread_safe(enabled != 0);
+    return 0;
+    );
+}
+
+HYPERDEX_API int
+hyperdex_client_set_corking(hyperdex_client* _cl, int enabled)
+{
+    FAKE_STATUS;
+    C_WRAP_EXCEPT(
+    cl->set_corking(enabled != 0);
+    return 0;
+    );
+}
+
+HYPERDEX_API int
+hyperdex_client_flush(hyperdex_client* _cl)
+{
+    FAKE_STATUS;
+    C_WRAP_EXCEPT(
+    cl->flush();
+    return 0;
+    );
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif // __cplusplus
@@ -806,6 +955,23 @@ struct hyperdex_admin_perf_counter
     uint64_t measurement;
 };
 
+/* laid out like struct hyperdex_client_attribute */
+struct hyperdex_admin_ingest_attribute
+{
+    const char* attr; /* NULL-terminated */
+    const char* value;
+    size_t value_sz;
+    enum hyperdatatype datatype;
+};
+
+struct hyperdex_admin_ingest_object
+{
+    const char* key;
+    size_t key_sz;
+    const struct hyperdex_admin_ingest_attribute* attrs;
+    size_t attrs_sz;
+};
+
 /* hyperdex_admin_returncode occupies [8704, 8832) */
 enum hyperdex_admin_returncode
 {
@@ -834,6 +1000,18 @@ hyperdex_admin_raw_backup(const char* host, uint16_t port,
                           const char* name,
                           enum hyperdex_admin_returncode* status);
 
+/* Write objects into every replica of their regions in large batches that
+ * travel down each region's chain, bypassing the per-key operations.  Meant
+ * for initial loads:  objects must not be written by clients while they are
+ * being ingested, and the space must have no secondary subspaces.  A key given
+ * more than once keeps its last value. */
+int64_t
+hyperdex_admin_bulk_ingest(struct hyperdex_admin* admin,
+                           const char* space,
+                           const struct hyperdex_admin_ingest_object* objects,
+                           size_t objects_sz,
+                           enum hyperdex_admin_returncode* status);
+
 const char*
 hyperdex_admin_error_message(struct hyperdex_admin* admin);
 const char*
@@ -953,6 +1131,19 @@ hyperdex_admin_loop(struct hyperdex_admin* _adm, int timeout,
     );
 }
 
+HYPERDEX_API int64_t
+hyperdex_admin_bulk_ingest(struct hyperdex_admin* _adm,
+                           const char* space,
+                           const struct hyperdex_admin_ingest_object* objects,
+                           size_t objects_sz,
+                           enum hyperdex_admin_returncode* status)
+{
+    C_WRAP_EXCEPT(
+    hyperdex::admin* adm = reinterpret_cast<hyperdex::admin*>(_adm);
+    return adm->bulk_ingest(space, objects, objects_sz, status);
+    );
+}
+
 HYPERDEX_API const char*
 hyperdex_admin_error_message(struct hyperdex_admin* _adm)
 {
@@ -139,10 +139,19 @@ CLIENT_HEADER_FOOT = '''
     public:
         int64_t loop(int timeout, hyperdex_client_returncode* status)
             { return hyperdex_client_loop(m_cl, timeout, status); }
+        int64_t loop_many(int timeout, int64_t* ids,
+                          hyperdex_client_returncode* statuses, size_t n)
+            { return hyperdex_client_loop_many(m_cl, timeout, ids, statuses, n); }
         int poll_fd()
             { return hyperdex_client_poll_fd(m_cl); }
         int block(int timeout)
             { return hyperdex_client_block(m_cl, timeout); }
+        int set_thread_safe(bool enabled)
+            { return hyperdex_client_set_thread_safe(m_cl, enabled ? 1 : 0); }
+        int set_corking(bool enabled)
+            { return hyperdex_client_set_corking(m_cl, enabled ? 1 : 0); }
+        int flush()
+            { return hyperdex_client_flush(m_cl); }
         std::string error_message()
             { return hyperdex_client_error_message(m_cl); }
         std::string error_location()
@@ -1736,6 +1736,66 @@ func (client *Client) IteratorSpacenamePredicatesStatusAttributes(stub func(clie
 	return
 }
 
+func (client *Client) IteratorSpacenamePredicatesAttributenamesStatusAttributes(stub func(client *C.struct_hyperdex_client, c_space *C.char, c_checks *C.struct_hyperdex_client_attribute_check, c_checks_sz C.size_t, c_attrnames **C.char, c_attrnames_sz C.size_t, c_status *C.enum_hyperdex_client_returncode, c_attrs **C.struct_hyperdex_client_attribute, c_attrs_sz *C.size_t) int64, spacename string, predicates []Predicate, attributenames AttributeNames) (attrs chan Attributes, errs chan Error) {
+	arena := C.hyperdex_ds_arena_create()
+	defer C.hyperdex_ds_arena_destroy(arena)
+	var c_space *C.char
+	var c_checks *C.struct_hyperdex_client_attribute_check
+	var c_checks_sz C.size_t
+	var c_attrnames **C.char
+	var c_attrnames_sz C.size_t
+	var er error
+	var c_iter cIterator
+	c_iter = cIterator{C.HYPERDEX_CLIENT_GARBAGE, nil, 0, make(chan Attributes, 10), make(chan Error, 10)}
+	attrs = c_iter.attrChan
+	errs = c_iter.errChan
+	er = client.convertSpacename(arena, spacename, &c_space)
+	if er != nil {
+		err := Error{Status(WRONGTYPE), er.Error(), ""}
+		errs<-err
+		close(attrs)
+		close(errs)
+		return
+	}
+	er = client.convertPredicates(arena, predicates, &c_checks, &c_checks_sz)
+	if er != nil {
+		err := Error{Status(WRONGTYPE), er.Error(), ""}
+		errs<-err
+		close(attrs)
+		close(errs)
+		return
+	}
+	er = client.convertAttributenames(arena, attributenames, &c_attrnames, &c_attrnames_sz)
+	if er != nil {
+		err := Error{Status(WRONGTYPE), er.Error(), ""}
+		errs<-err
+		close(attrs)
+		close(errs)
+		return
+	}
+	var err Error
+	client.mutex.Lock()
+	inner := client.clients[client.counter%uint64(len(client.clients))]
+	client.counter++
+	client.mutex.Unlock()
+	inner.mutex.Lock()
+	reqid := stub(inner.ptr, c_space, c_checks, c_checks_sz, c_attrnames, c_attrnames_sz, &c_iter.status, &c_iter.attrs, &c_iter.attrs_sz)
+	if reqid >= 0 {
+		inner.searches[reqid] = &c_iter
+	} else {
+		err = Error{Status(c_iter.status),
+		            C.GoString(C.hyperdex_client_error_message(inner.ptr)),
+		            C.GoString(C.hyperdex_client_error_location(inner.ptr))}
+	}
+	inner.mutex.Unlock()
+	if reqid < 0 {
+		errs<-err
+		close(attrs)
+		close(errs)
+	}
+	return
+}
+
 func (client *Client) AsynccallSpacenamePredicatesStatusDescription(stub func(client *C.struct_hyperdex_client, c_space *C.char, c_checks *C.struct_hyperdex_client_attribute_check, c_checks_sz C.size_t, c_status *C.enum_hyperdex_client_returncode, c_description **C.char) int64, spacename string, predicates []Predicate) (desc string, err *Error) {
 	arena := C.hyperdex_ds_arena_create()
 	defer C.hyperdex_ds_arena_destroy(arena)
@@ -1861,6 +1921,93 @@ func (client *Client) IteratorSpacenamePredicatesSortbyLimitMaxminStatusAttribut
 	return
 }
 
+func (client *Client) IteratorSpacenamePredicatesAttributenamesSortbyLimitMaxminStatusAttributes(stub func(client *C.struct_hyperdex_client, c_space *C.char, c_checks *C.struct_hyperdex_client_attribute_check, c_checks_sz C.size_t, c_attrnames **C.char, c_attrnames_sz C.size_t, c_sort_by *C.char, c_limit C.uint64_t, c_maxmin C.int, c_status *C.enum_hyperdex_client_returncode, c_attrs **C.struct_hyperdex_client_attribute, c_attrs_sz *C.size_t) int64, spacename string, predicates []Predicate, attributenames AttributeNames, sortby string, limit uint32, maxmin string) (attrs chan Attributes, errs chan Error) {
+	arena := C.hyperdex_ds_arena_create()
+	defer C.hyperdex_ds_arena_destroy(arena)
+	var c_space *C.char
+	var c_checks *C.struct_hyperdex_client_attribute_check
+	var c_checks_sz C.size_t
+	var c_attrnames **C.char
+	var c_attrnames_sz C.size_t
+	var c_sort_by *C.char
+	var c_limit C.uint64_t
+	var c_maxmin C.int
+	var er error
+	var c_iter cIterator
+	c_iter = cIterator{C.HYPERDEX_CLIENT_GARBAGE, nil, 0, make(chan Attributes, 10), make(chan Error, 10)}
+	attrs = c_iter.attrChan
+	errs = c_iter.errChan
+	er = client.convertSpacename(arena, spacename, &c_space)
+	if er != nil {
+		err := Error{Status(WRONGTYPE), er.Error(), ""}
+		errs<-err
+		close(attrs)
+		close(errs)
+		return
+	}
+	er = client.convertPredicates(arena, predicates, &c_checks, &c_checks_sz)
+	if er != nil {
+		err := Error{Status(WRONGTYPE), er.Error(), ""}
+		errs<-err
+		close(attrs)
+		close(errs)
+		return
+	}
+	er = client.convertAttributenames(arena, attributenames, &c_attrnames, &c_attrnames_sz)
+	if er != nil {
+		err := Error{Status(WRONGTYPE), er.Error(), ""}
+		errs<-err
+		close(attrs)
+		close(errs)
+		return
+	}
+	er = client.convertSortby(arena, sortby, &c_sort_by)
+	if er != nil {
+		err := Error{Status(WRONGTYPE), er.Error(), ""}
+		errs<-err
+		close(attrs)
+		close(errs)
+		return
+	}
+	er = client.convertLimit(arena, limit, &c_limit)
+	if er != nil {
+		err := Error{Status(WRONGTYPE), er.Error(), ""}
+		errs<-err
+		close(attrs)
+		close(errs)
+		return
+	}
+	er = client.convertMaxmin(arena, maxmin, &c_maxmin)
+	if er != nil {
+		err := Error{Status(WRONGTYPE), er.Error(), ""}
+		errs<-err
+		close(attrs)
+		close(errs)
+		return
+	}
+	var err Error
+	client.mutex.Lock()
+	inner := client.clients[client.counter%uint64(len(client.clients))]
+	client.counter++
+	client.mutex.Unlock()
+	inner.mutex.Lock()
+	reqid := stub(inner.ptr, c_space, c_checks, c_checks_sz, c_attrnames, c_attrnames_sz, c_sort_by, c_limit, c_maxmin, &c_iter.status, &c_iter.attrs, &c_iter.attrs_sz)
+	if reqid >= 0 {
+		inner.searches[reqid] = &c_iter
+	} else {
+		err = Error{Status(c_iter.status),
+		            C.GoString(C.hyperdex_client_error_message(inner.ptr)),
+		            C.GoString(C.hyperdex_client_error_location(inner.ptr))}
+	}
+	inner.mutex.Unlock()
+	if reqid < 0 {
+		errs<-err
+		close(attrs)
+		close(errs)
+	}
+	return
+}
+
 func stub_get(client *C.struct_hyperdex_client, space *C.char, key *C.char, key_sz C.size_t, status *C.enum_hyperdex_client_returncode, attrs **C.struct_hyperdex_client_attribute, attrs_sz *C.size_t) int64 {
 	return int64(C.hyperdex_client_get(client, space, key, key_sz, status, attrs, attrs_sz))
 }
@@ -2694,6 +2841,13 @@ func (client *Client) Search(spacename string, predicates []Predicate) (attrs ch
 	return client.IteratorSpacenamePredicatesStatusAttributes(stub_search, spacename, predicates)
 }
 
+func stub_search_partial(client *C.struct_hyperdex_client, space *C.char, checks *C.struct_hyperdex_client_attribute_check, checks_sz C.size_t, attrnames **C.char, attrnames_sz C.size_t, status *C.enum_hyperdex_client_returncode, attrs **C.struct_hyperdex_client_attribute, attrs_sz *C.size_t) int64 {
+	return int64(C.hyperdex_client_search_partial(client, space, checks, checks_sz, attrnames, attrnames_sz, status, attrs, attrs_sz))
+}
+func (client *Client) SearchPartial(spacename string, predicates []Predicate, attributenames AttributeNames) (attrs chan Attributes, errs chan Error) {
+	return client.IteratorSpacenamePredicatesAttributenamesStatusAttributes(stub_search_partial, spacename, predicates, attributenames)
+}
+
 func stub_search_describe(client *C.struct_hyperdex_client, space *C.char, checks *C.struct_hyperdex_client_attribute_check, checks_sz C.size_t, status *C.enum_hyperdex_client_returncode, description **C.char) int64 {
 	return int64(C.hyperdex_client_search_describe(client, space, checks, checks_sz, status, description))
 }
@@ -2708,6 +2862,13 @@ func (client *Client) SortedSearch(spacename string, predicates []Predicate, sor
 	return client.IteratorSpacenamePredicatesSortbyLimitMaxminStatusAttributes(stub_sorted_search, spacename, predicates, sortby, limit, maxmin)
 }
 
+func stub_sorted_search_partial(client *C.struct_hyperdex_client, space *C.char, checks *C.struct_hyperdex_client_attribute_check, checks_sz C.size_t, attrnames **C.char, attrnames_sz C.size_t, sort_by *C.char, limit C.uint64_t, maxmin C.int, status *C.enum_hyperdex_client_returncode, attrs **C.struct_hyperdex_client_attribute, attrs_sz *C.size_t) int64 {
+	return int64(C.hyperdex_client_sorted_search_partial(client, space, checks, checks_sz, attrnames, attrnames_sz, sort_by, limit, maxmin, status, attrs, attrs_sz))
+}
+func (client *Client) SortedSearchPartial(spacename string, predicates []Predicate, attributenames AttributeNames, sortby string, limit uint32, maxmin string) (attrs chan Attributes, errs chan Error) {
+	return client.IteratorSpacenamePredicatesAttributenamesSortbyLimitMaxminStatusAttributes(stub_sorted_search_partial, spacename, predicates, attributenames, sortby, limit, maxmin)
+}
+
 func stub_count(client *C.struct_hyperdex_client, space *C.char, checks *C.struct_hyperdex_client_attribute_check, checks_sz C.size_t, status *C.enum_hyperdex_client_returncode, count *C.uint64_t) int64 {
 	return int64(C.hyperdex_client_count(client, space, checks, checks_sz, status, count))
 }
@@ -388,6 +388,7 @@ JAVA_HEAD = '''
 
 package org.hyperdex.client;
 
+import java.util.ArrayList;
 import java.util.List;
 import java.util.Map;
 import java.util.HashMap;
@@ -450,6 +451,26 @@ public class Client
         return o;
     }
 
+    public List<Operation> loop_many(int max) throws HyperDexClientException
+    {
+        long[] ids = new long[max];
+        int n = inner_loop_many(ids);
+        List<Operation> finished = new ArrayList<Operation>(n);
+
+        for (int i = 0; i < n; ++i)
+        {
+            Operation o = ops.get(ids[i]);
+
+            if (o != null)
+            {
+                o.callback();
+                finished.add(o);
+            }
+        }
+
+        return finished;
+    }
+
     /* cached IDs */
     private static native void initialize();
     private static native void terminate();
@@ -458,6 +479,7 @@ public class Client
     private native void _destroy();
     /* utilities */
     private native long inner_loop() throws HyperDexClientException;
+    private native int inner_loop_many(long[] ids) throws HyperDexClientException;
     private void add_op(long l, Operation op)
     {
         ops.put(l, op);
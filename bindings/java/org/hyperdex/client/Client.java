@@ -29,6 +29,7 @@
 
 package org.hyperdex.client;
 
+import java.util.ArrayList;
 import java.util.List;
 import java.util.Map;
 import java.util.HashMap;
@@ -91,6 +92,26 @@ public class Client
         return o;
     }
 
+    public List<Operation> loop_many(int max) throws HyperDexClientException
+    {
+        long[] ids = new long[max];
+        int n = inner_loop_many(ids);
+        List<Operation> finished = new ArrayList<Operation>(n);
+
+        for (int i = 0; i < n; ++i)
+        {
+            Operation o = ops.get(ids[i]);
+
+            if (o != null)
+            {
+                o.callback();
+                finished.add(o);
+            }
+        }
+
+        return finished;
+    }
+
     /* cached IDs */
     private static native void initialize();
     private static native void terminate();
@@ -99,6 +120,7 @@ public class Client
     private native void _destroy();
     /* utilities */
     private native long inner_loop() throws HyperDexClientException;
+    private native int inner_loop_many(long[] ids) throws HyperDexClientException;
     private void add_op(long l, Operation op)
     {
         ops.put(l, op);
@@ -818,6 +840,8 @@ public class Client
 
     public native Iterator search(String spacename, Map<String, Object> predicates);
 
+    public native Iterator search_partial(String spacename, Map<String, Object> predicates, List<String> attributenames);
+
     public native Deferred async_search_describe(String spacename, Map<String, Object> predicates) throws HyperDexClientException;
     public String search_describe(String spacename, Map<String, Object> predicates) throws HyperDexClientException
     {
@@ -826,6 +850,8 @@ public class Client
 
     public native Iterator sorted_search(String spacename, Map<String, Object> predicates, String sortby, int limit, boolean maxmin);
 
+    public native Iterator sorted_search_partial(String spacename, Map<String, Object> predicates, List<String> attributenames, String sortby, int limit, boolean maxmin);
+
     public native Deferred async_count(String spacename, Map<String, Object> predicates) throws HyperDexClientException;
     public Long count(String spacename, Map<String, Object> predicates) throws HyperDexClientException
     {
@@ -28,6 +28,7 @@
 
 /* C */
 #include <assert.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* HyperDex */
@@ -2383,4 +2384,50 @@ Java_org_hyperdex_client_Client_inner_1loop(JNIEnv* env, jobject client)
     return y;
 }
 
+JNIEXPORT HYPERDEX_API jint JNICALL
+Java_org_hyperdex_client_Client_inner_1loop_1many(JNIEnv* env, jobject client, jlongArray ids)
+{
+    struct hyperdex_client* ptr;
+    jsize n;
+    int64_t* x;
+    enum hyperdex_client_returncode* rc;
+    int64_t ret;
+    jlong y;
+    jsize i;
+
+    ptr = hyperdex_get_client_ptr(env, client);
+    n = (*env)->GetArrayLength(env, ids);
+    x = malloc(sizeof(int64_t) * (n > 0 ? n : 1));
+    rc = malloc(sizeof(enum hyperdex_client_returncode) * (n > 0 ? n : 1));
+
+    if (!x || !rc)
+    {
+        free(x);
+        free(rc);
+        hyperdex_java_out_of_memory(env);
+        return -1;
+    }
+
+    ret = hyperdex_client_loop_many(ptr, -1, x, rc, n);
+
+    if (ret < 0)
+    {
+        hyperdex_java_client_throw_exception(env, rc[0], hyperdex_client_error_message(ptr));
+        free(x);
+        free(rc);
+        return -1;
+    }
+
+    for (i = 0; i < ret; ++i)
+    {
+        y = (jlong)x[i];
+        assert(x[i] == y);
+        (*env)->SetLongArrayRegion(env, ids, i, 1, &y);
+    }
+
+    free(x);
+    free(rc);
+    return (jint)ret;
+}
+
 #include "bindings/java/org_hyperdex_client_Client.definitions.c"
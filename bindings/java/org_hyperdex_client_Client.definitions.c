@@ -477,6 +477,44 @@ hyperdex_java_client_iterator__spacename_predicates__status_attributes(JNIEnv* e
     return op;
 }
 
+JNIEXPORT HYPERDEX_API jobject JNICALL
+hyperdex_java_client_iterator__spacename_predicates_attributenames__status_attributes(JNIEnv* env, jobject obj, int64_t (*f)(struct hyperdex_client* client, const char* space, const struct hyperdex_client_attribute_check* checks, size_t checks_sz, const char** attrnames, size_t attrnames_sz, enum hyperdex_client_returncode* status, const struct hyperdex_client_attribute** attrs, size_t* attrs_sz), jstring spacename, jobject predicates, jobject attributenames);
+
+JNIEXPORT HYPERDEX_API jobject JNICALL
+hyperdex_java_client_iterator__spacename_predicates_attributenames__status_attributes(JNIEnv* env, jobject obj, int64_t (*f)(struct hyperdex_client* client, const char* space, const struct hyperdex_client_attribute_check* checks, size_t checks_sz, const char** attrnames, size_t attrnames_sz, enum hyperdex_client_returncode* status, const struct hyperdex_client_attribute** attrs, size_t* attrs_sz), jstring spacename, jobject predicates, jobject attributenames)
+{
+    const char* in_space;
+    const struct hyperdex_client_attribute_check* in_checks;
+    size_t in_checks_sz;
+    const char** in_attrnames;
+    size_t in_attrnames_sz;
+    int success = 0;
+    struct hyperdex_client* client = hyperdex_get_client_ptr(env, obj);
+    jobject op = (*env)->NewObject(env, _iterator, _iterator_init, obj);
+    struct hyperdex_java_client_iterator* o = NULL;
+    ERROR_CHECK(0);
+    o = hyperdex_get_iterator_ptr(env, op);
+    ERROR_CHECK(0);
+    success = hyperdex_java_client_convert_spacename(env, obj, o->arena, spacename, &in_space);
+    if (success < 0) return 0;
+    success = hyperdex_java_client_convert_predicates(env, obj, o->arena, predicates, &in_checks, &in_checks_sz);
+    if (success < 0) return 0;
+    success = hyperdex_java_client_convert_attributenames(env, obj, o->arena, attributenames, &in_attrnames, &in_attrnames_sz);
+    if (success < 0) return 0;
+    o->reqid = f(client, in_space, in_checks, in_checks_sz, in_attrnames, in_attrnames_sz, &o->status, &o->attrs, &o->attrs_sz);
+
+    if (o->reqid < 0)
+    {
+        hyperdex_java_client_throw_exception(env, o->status, hyperdex_client_error_message(client));
+        return 0;
+    }
+
+    o->encode_return = hyperdex_java_client_iterator_encode_status_attributes;
+    (*env)->CallObjectMethod(env, obj, _client_add_op, o->reqid, op);
+    ERROR_CHECK(0);
+    return op;
+}
+
 JNIEXPORT HYPERDEX_API jobject JNICALL
 hyperdex_java_client_asynccall__spacename_predicates__status_description(JNIEnv* env, jobject obj, int64_t (*f)(struct hyperdex_client* client, const char* space, const struct hyperdex_client_attribute_check* checks, size_t checks_sz, enum hyperdex_client_returncode* status, const char** description), jstring spacename, jobject predicates);
 
@@ -553,6 +591,53 @@ hyperdex_java_client_iterator__spacename_predicates_sortby_limit_maxmin__status_
     ERROR_CHECK(0);
     return op;
 }
+
+JNIEXPORT HYPERDEX_API jobject JNICALL
+hyperdex_java_client_iterator__spacename_predicates_attributenames_sortby_limit_maxmin__status_attributes(JNIEnv* env, jobject obj, int64_t (*f)(struct hyperdex_client* client, const char* space, const struct hyperdex_client_attribute_check* checks, size_t checks_sz, const char** attrnames, size_t attrnames_sz, const char* sort_by, uint64_t limit, int maxmin, enum hyperdex_client_returncode* status, const struct hyperdex_client_attribute** attrs, size_t* attrs_sz), jstring spacename, jobject predicates, jobject attributenames, jstring sortby, jint limit, jboolean maxmin);
+
+JNIEXPORT HYPERDEX_API jobject JNICALL
+hyperdex_java_client_iterator__spacename_predicates_attributenames_sortby_limit_maxmin__status_attributes(JNIEnv* env, jobject obj, int64_t (*f)(struct hyperdex_client* client, const char* space, const struct hyperdex_client_attribute_check* checks, size_t checks_sz, const char** attrnames, size_t attrnames_sz, const char* sort_by, uint64_t limit, int maxmin, enum hyperdex_client_returncode* status, const struct hyperdex_client_attribute** attrs, size_t* attrs_sz), jstring spacename, jobject predicates, jobject attributenames, jstring sortby, jint limit, jboolean maxmin)
+{
+    const char* in_space;
+    const struct hyperdex_client_attribute_check* in_checks;
+    size_t in_checks_sz;
+    const char** in_attrnames;
+    size_t in_attrnames_sz;
+    const char* in_sort_by;
+    uint64_t in_limit;
+    int in_maxmin;
+    int success = 0;
+    struct hyperdex_client* client = hyperdex_get_client_ptr(env, obj);
+    jobject op = (*env)->NewObject(env, _iterator, _iterator_init, obj);
+    struct hyperdex_java_client_iterator* o = NULL;
+    ERROR_CHECK(0);
+    o = hyperdex_get_iterator_ptr(env, op);
+    ERROR_CHECK(0);
+    success = hyperdex_java_client_convert_spacename(env, obj, o->arena, spacename, &in_space);
+    if (success < 0) return 0;
+    success = hyperdex_java_client_convert_predicates(env, obj, o->arena, predicates, &in_checks, &in_checks_sz);
+    if (success < 0) return 0;
+    success = hyperdex_java_client_convert_attributenames(env, obj, o->arena, attributenames, &in_attrnames, &in_attrnames_sz);
+    if (success < 0) return 0;
+    success = hyperdex_java_client_convert_sortby(env, obj, o->arena, sortby, &in_sort_by);
+    if (success < 0) return 0;
+    success = hyperdex_java_client_convert_limit(env, obj, o->arena, limit, &in_limit);
+    if (success < 0) return 0;
+    success = hyperdex_java_client_convert_maxmin(env, obj, o->arena, maxmin, &in_maxmin);
+    if (success < 0) return 0;
+    o->reqid = f(client, in_space, in_checks, in_checks_sz, in_attrnames, in_attrnames_sz, in_sort_by, in_limit, in_maxmin, &o->status, &o->attrs, &o->attrs_sz);
+
+    if (o->reqid < 0)
+    {
+        hyperdex_java_client_throw_exception(env, o->status, hyperdex_client_error_message(client));
+        return 0;
+    }
+
+    o->encode_return = hyperdex_java_client_iterator_encode_status_attributes;
+    (*env)->CallObjectMethod(env, obj, _client_add_op, o->reqid, op);
+    ERROR_CHECK(0);
+    return op;
+}
 JNIEXPORT HYPERDEX_API jobject JNICALL
 Java_org_hyperdex_client_Client_async_1get(JNIEnv* env, jobject obj, jstring spacename, jobject key)
 {
@@ -1267,6 +1352,12 @@ Java_org_hyperdex_client_Client_search(JNIEnv* env, jobject obj, jstring spacena
     return hyperdex_java_client_iterator__spacename_predicates__status_attributes(env, obj, hyperdex_client_search, spacename, predicates);
 }
 
+JNIEXPORT HYPERDEX_API jobject JNICALL
+Java_org_hyperdex_client_Client_search_1partial(JNIEnv* env, jobject obj, jstring spacename, jobject predicates, jobject attributenames)
+{
+    return hyperdex_java_client_iterator__spacename_predicates_attributenames__status_attributes(env, obj, hyperdex_client_search_partial, spacename, predicates, attributenames);
+}
+
 JNIEXPORT HYPERDEX_API jobject JNICALL
 Java_org_hyperdex_client_Client_async_1search_1describe(JNIEnv* env, jobject obj, jstring spacename, jobject predicates)
 {
@@ -1279,6 +1370,12 @@ Java_org_hyperdex_client_Client_sorted_1search(JNIEnv* env, jobject obj, jstring
     return hyperdex_java_client_iterator__spacename_predicates_sortby_limit_maxmin__status_attributes(env, obj, hyperdex_client_sorted_search, spacename, predicates, sortby, limit, maxmin);
 }
 
+JNIEXPORT HYPERDEX_API jobject JNICALL
+Java_org_hyperdex_client_Client_sorted_1search_1partial(JNIEnv* env, jobject obj, jstring spacename, jobject predicates, jobject attributenames, jstring sortby, jint limit, jboolean maxmin)
+{
+    return hyperdex_java_client_iterator__spacename_predicates_attributenames_sortby_limit_maxmin__status_attributes(env, obj, hyperdex_client_sorted_search_partial, spacename, predicates, attributenames, sortby, limit, maxmin);
+}
+
 JNIEXPORT HYPERDEX_API jobject JNICALL
 Java_org_hyperdex_client_Client_async_1count(JNIEnv* env, jobject obj, jstring spacename, jobject predicates)
 {
@@ -47,6 +47,14 @@ JNIEXPORT HYPERDEX_API void JNICALL Java_org_hyperdex_client_Client__1destroy
 JNIEXPORT HYPERDEX_API jlong JNICALL Java_org_hyperdex_client_Client_inner_1loop
   (JNIEnv *, jobject);
 
+/*
+ * Class:     org_hyperdex_client_Client
+ * Method:    inner_loop_many
+ * Signature: ([J)I
+ */
+JNIEXPORT HYPERDEX_API jint JNICALL Java_org_hyperdex_client_Client_inner_1loop_1many
+  (JNIEnv *, jobject, jlongArray);
+
 /*
  * Class:     org_hyperdex_client_Client
  * Method:    async_get
@@ -999,6 +1007,14 @@ JNIEXPORT HYPERDEX_API jobject JNICALL Java_org_hyperdex_client_Client_async_1gr
 JNIEXPORT HYPERDEX_API jobject JNICALL Java_org_hyperdex_client_Client_search
   (JNIEnv *, jobject, jstring, jobject);
 
+/*
+ * Class:     org_hyperdex_client_Client
+ * Method:    search_partial
+ * Signature: (Ljava/lang/String;Ljava/util/Map;Ljava/util/List;)Lorg/hyperdex/client/Iterator;
+ */
+JNIEXPORT HYPERDEX_API jobject JNICALL Java_org_hyperdex_client_Client_search_1partial
+  (JNIEnv *, jobject, jstring, jobject, jobject);
+
 /*
  * Class:     org_hyperdex_client_Client
  * Method:    async_search_describe
@@ -1015,6 +1031,14 @@ JNIEXPORT HYPERDEX_API jobject JNICALL Java_org_hyperdex_client_Client_async_1se
 JNIEXPORT HYPERDEX_API jobject JNICALL Java_org_hyperdex_client_Client_sorted_1search
   (JNIEnv *, jobject, jstring, jobject, jstring, jint, jboolean);
 
+/*
+ * Class:     org_hyperdex_client_Client
+ * Method:    sorted_search_partial
+ * Signature: (Ljava/lang/String;Ljava/util/Map;Ljava/util/List;Ljava/lang/String;IZ)Lorg/hyperdex/client/Iterator;
+ */
+JNIEXPORT HYPERDEX_API jobject JNICALL Java_org_hyperdex_client_Client_sorted_1search_1partial
+  (JNIEnv *, jobject, jstring, jobject, jobject, jstring, jint, jboolean);
+
 /*
  * Class:     org_hyperdex_client_Client
  * Method:    async_count
@@ -48,6 +48,9 @@
 
 #define HYPERDEX_NODE_INCLUDED_CLIENT_CC
 
+// how many finished operations to reap per wakeup of the event loop
+#define HYPERDEX_NODE_LOOP_BATCH 64
+
 namespace hyperdex
 {
 namespace nodejs
@@ -76,6 +79,7 @@ class HyperDexClient : public node::ObjectWrap
         static v8::Handle<v8::Value> asSet(const v8::Arguments& args);
         static v8::Handle<v8::Value> asMap(const v8::Arguments& args);
         static v8::Handle<v8::Value> loop(const v8::Arguments& args);
+        static v8::Handle<v8::Value> loop_many(const v8::Arguments& args);
         static v8::Handle<v8::Value> loop_error(const v8::Arguments& args);
 
         static v8::Handle<v8::Value> Equals(const v8::Arguments& args);
@@ -94,7 +98,7 @@ class HyperDexClient : public node::ObjectWrap
     public:
         hyperdex_client* client() { return m_cl; }
         void add(int64_t reqid, e::intrusive_ptr<Operation> op);
-        void loop(int timeout);
+        void loop(int timeout, size_t max);
         void poll_start();
         void poll_stop();
 
@@ -371,6 +375,7 @@ HyperDexClient :: Init(v8::Handle<v8::Object> target)
     NODE_SET_PROTOTYPE_METHOD(tpl, "Contains", HyperDexClient::Contains);
 
     NODE_SET_PROTOTYPE_METHOD(tpl, "loop", HyperDexClient::loop);
+    NODE_SET_PROTOTYPE_METHOD(tpl, "loop_many", HyperDexClient::loop_many);
 #include "client.prototypes.cc"
 
     ctor = v8::Persistent<v8::Function>::New(tpl->GetFunction());
@@ -477,12 +482,13 @@ HyperDexClient :: add(int64_t reqid, e::intrusive_ptr<Operation> op)
 }
 
 void
-HyperDexClient :: loop(int timeout)
+HyperDexClient :: loop(int timeout, size_t max)
 {
-    enum hyperdex_client_returncode rc;
-    int64_t ret = hyperdex_client_loop(m_cl, timeout, &rc);
+    std::vector<int64_t> ids(max);
+    std::vector<hyperdex_client_returncode> rcs(max);
+    int64_t ret = hyperdex_client_loop_many(m_cl, timeout, &ids[0], &rcs[0], max);
 
-    if (ret < 0 && timeout == 0 && rc == HYPERDEX_CLIENT_TIMEOUT)
+    if (ret < 0 && timeout == 0 && rcs[0] == HYPERDEX_CLIENT_TIMEOUT)
     {
         return;
     }
@@ -492,20 +498,23 @@ HyperDexClient :: loop(int timeout)
         v8::Local<v8::Object> obj = v8::Local<v8::Object>::New(m_callback);
         v8::Local<v8::Function> callback
             = obj->Get(v8::String::NewSymbol("callback")).As<v8::Function>();
-        v8::Local<v8::Value> err = Operation::error_from_status(m_cl, rc);
+        v8::Local<v8::Value> err = Operation::error_from_status(m_cl, rcs[0]);
         v8::Handle<v8::Value> argv[] = { err };
         node::MakeCallback(v8::Context::GetCurrent()->Global(), callback, 1, argv);
         return;
     }
 
-    std::map<int64_t, e::intrusive_ptr<Operation> >::iterator it;
-    it = m_ops.find(ret);
-    assert(it != m_ops.end());
-    (*it->second.*it->second->encode_return)();
-
-    if (it->second->finished)
+    for (int64_t i = 0; i < ret; ++i)
     {
-        m_ops.erase(it);
+        std::map<int64_t, e::intrusive_ptr<Operation> >::iterator it;
+        it = m_ops.find(ids[i]);
+        assert(it != m_ops.end());
+        (*it->second.*it->second->encode_return)();
+
+        if (it->second->finished)
+        {
+            m_ops.erase(it);
+        }
     }
 
     if (m_ops.empty())
@@ -545,7 +554,7 @@ HyperDexClient :: poll_callback(uv_poll_t* watcher, int status, int revents)
 
     if (cl)
     {
-        cl->loop(0);
+        cl->loop(0, HYPERDEX_NODE_LOOP_BATCH);
     }
 }
 
@@ -572,7 +581,29 @@ HyperDexClient :: loop(const v8::Arguments& args)
     }
 
     HyperDexClient* client = node::ObjectWrap::Unwrap<HyperDexClient>(args.This());
-    client->loop(timeout);
+    client->loop(timeout, 1);
+    return scope.Close(v8::Undefined());
+}
+
+v8::Handle<v8::Value>
+HyperDexClient :: loop_many(const v8::Arguments& args)
+{
+    v8::HandleScope scope;
+    int timeout = -1;
+    size_t max = HYPERDEX_NODE_LOOP_BATCH;
+
+    if (args.Length() > 0 && args[0]->IsNumber() && args[0]->IntegerValue() > 0)
+    {
+        max = args[0]->IntegerValue();
+    }
+
+    if (args.Length() > 1 && args[1]->IsNumber())
+    {
+        timeout = args[1]->IntegerValue();
+    }
+
+    HyperDexClient* client = node::ObjectWrap::Unwrap<HyperDexClient>(args.This());
+    client->loop(timeout, max);
     return scope.Close(v8::Undefined());
 }
 
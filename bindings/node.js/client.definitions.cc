@@ -629,6 +629,54 @@ HyperDexClient :: iterator__spacename_predicates__status_attributes(int64_t (*f)
     return scope.Close(v8::Undefined());
 }
 
+v8::Handle<v8::Value>
+HyperDexClient :: iterator__spacename_predicates_attributenames__status_attributes(int64_t (*f)(struct hyperdex_client* client, const char* space, const struct hyperdex_client_attribute_check* checks, size_t checks_sz, const char** attrnames, size_t attrnames_sz, enum hyperdex_client_returncode* status, const struct hyperdex_client_attribute** attrs, size_t* attrs_sz), const v8::Arguments& args)
+{
+    v8::HandleScope scope;
+    v8::Local<v8::Object> client_obj = args.This();
+    HyperDexClient* client = node::ObjectWrap::Unwrap<HyperDexClient>(client_obj);
+    e::intrusive_ptr<Operation> op(new Operation(client_obj, client));
+    v8::Local<v8::Function> func = args[3].As<v8::Function>();
+
+    if (func.IsEmpty() || !func->IsFunction())
+    {
+        v8::ThrowException(v8::String::New("Callback must be a function"));
+        return scope.Close(v8::Undefined());
+    }
+
+    v8::Local<v8::Function> done = args[4].As<v8::Function>();
+
+    if (done.IsEmpty() || !done->IsFunction())
+    {
+        v8::ThrowException(v8::String::New("Callback must be a function"));
+        return scope.Close(v8::Undefined());
+    }
+
+    if (!op->set_callback(func, done)) { return scope.Close(v8::Undefined()); }
+    const char* in_space;
+    v8::Local<v8::Value> spacename = args[0];
+    if (!op->convert_spacename(spacename, &in_space)) return scope.Close(v8::Undefined());
+    const struct hyperdex_client_attribute_check* in_checks;
+    size_t in_checks_sz;
+    v8::Local<v8::Value> predicates = args[1];
+    if (!op->convert_predicates(predicates, &in_checks, &in_checks_sz)) return scope.Close(v8::Undefined());
+    const char** in_attrnames;
+    size_t in_attrnames_sz;
+    v8::Local<v8::Value> attributenames = args[2];
+    if (!op->convert_attributenames(attributenames, &in_attrnames, &in_attrnames_sz)) return scope.Close(v8::Undefined());
+    op->reqid = f(client->client(), in_space, in_checks, in_checks_sz, in_attrnames, in_attrnames_sz, &op->status, &op->attrs, &op->attrs_sz);
+
+    if (op->reqid < 0)
+    {
+        op->callback_error_from_status();
+        return scope.Close(v8::Undefined());
+    }
+
+    op->encode_return = &Operation::encode_iterator_status_attributes;
+    client->add(op->reqid, op);
+    return scope.Close(v8::Undefined());
+}
+
 v8::Handle<v8::Value>
 HyperDexClient :: asynccall__spacename_predicates__status_description(int64_t (*f)(struct hyperdex_client* client, const char* space, const struct hyperdex_client_attribute_check* checks, size_t checks_sz, enum hyperdex_client_returncode* status, const char** description), const v8::Arguments& args)
 {
@@ -729,6 +777,63 @@ HyperDexClient :: iterator__spacename_predicates_sortby_limit_maxmin__status_att
     return scope.Close(v8::Undefined());
 }
 
+v8::Handle<v8::Value>
+HyperDexClient :: iterator__spacename_predicates_attributenames_sortby_limit_maxmin__status_attributes(int64_t (*f)(struct hyperdex_client* client, const char* space, const struct hyperdex_client_attribute_check* checks, size_t checks_sz, const char** attrnames, size_t attrnames_sz, const char* sort_by, uint64_t limit, int maxmin, enum hyperdex_client_returncode* status, const struct hyperdex_client_attribute** attrs, size_t* attrs_sz), const v8::Arguments& args)
+{
+    v8::HandleScope scope;
+    v8::Local<v8::Object> client_obj = args.This();
+    HyperDexClient* client = node::ObjectWrap::Unwrap<HyperDexClient>(client_obj);
+    e::intrusive_ptr<Operation> op(new Operation(client_obj, client));
+    v8::Local<v8::Function> func = args[6].As<v8::Function>();
+
+    if (func.IsEmpty() || !func->IsFunction())
+    {
+        v8::ThrowException(v8::String::New("Callback must be a function"));
+        return scope.Close(v8::Undefined());
+    }
+
+    v8::Local<v8::Function> done = args[7].As<v8::Function>();
+
+    if (done.IsEmpty() || !done->IsFunction())
+    {
+        v8::ThrowException(v8::String::New("Callback must be a function"));
+        return scope.Close(v8::Undefined());
+    }
+
+    if (!op->set_callback(func, done)) { return scope.Close(v8::Undefined()); }
+    const char* in_space;
+    v8::Local<v8::Value> spacename = args[0];
+    if (!op->convert_spacename(spacename, &in_space)) return scope.Close(v8::Undefined());
+    const struct hyperdex_client_attribute_check* in_checks;
+    size_t in_checks_sz;
+    v8::Local<v8::Value> predicates = args[1];
+    if (!op->convert_predicates(predicates, &in_checks, &in_checks_sz)) return scope.Close(v8::Undefined());
+    const char** in_attrnames;
+    size_t in_attrnames_sz;
+    v8::Local<v8::Value> attributenames = args[2];
+    if (!op->convert_attributenames(attributenames, &in_attrnames, &in_attrnames_sz)) return scope.Close(v8::Undefined());
+    const char* in_sort_by;
+    v8::Local<v8::Value> sortby = args[3];
+    if (!op->convert_sortby(sortby, &in_sort_by)) return scope.Close(v8::Undefined());
+    uint64_t in_limit;
+    v8::Local<v8::Value> limit = args[4];
+    if (!op->convert_limit(limit, &in_limit)) return scope.Close(v8::Undefined());
+    int in_maxmin;
+    v8::Local<v8::Value> maxmin = args[5];
+    if (!op->convert_maxmin(maxmin, &in_maxmin)) return scope.Close(v8::Undefined());
+    op->reqid = f(client->client(), in_space, in_checks, in_checks_sz, in_attrnames, in_attrnames_sz, in_sort_by, in_limit, in_maxmin, &op->status, &op->attrs, &op->attrs_sz);
+
+    if (op->reqid < 0)
+    {
+        op->callback_error_from_status();
+        return scope.Close(v8::Undefined());
+    }
+
+    op->encode_return = &Operation::encode_iterator_status_attributes;
+    client->add(op->reqid, op);
+    return scope.Close(v8::Undefined());
+}
+
 
 v8::Handle<v8::Value>
 HyperDexClient :: get(const v8::Arguments& args)
@@ -1444,6 +1549,12 @@ HyperDexClient :: search(const v8::Arguments& args)
     return iterator__spacename_predicates__status_attributes(hyperdex_client_search, args);
 }
 
+v8::Handle<v8::Value>
+HyperDexClient :: search_partial(const v8::Arguments& args)
+{
+    return iterator__spacename_predicates_attributenames__status_attributes(hyperdex_client_search_partial, args);
+}
+
 v8::Handle<v8::Value>
 HyperDexClient :: search_describe(const v8::Arguments& args)
 {
@@ -1456,6 +1567,12 @@ HyperDexClient :: sorted_search(const v8::Arguments& args)
     return iterator__spacename_predicates_sortby_limit_maxmin__status_attributes(hyperdex_client_sorted_search, args);
 }
 
+v8::Handle<v8::Value>
+HyperDexClient :: sorted_search_partial(const v8::Arguments& args)
+{
+    return iterator__spacename_predicates_attributenames_sortby_limit_maxmin__status_attributes(hyperdex_client_sorted_search_partial, args);
+}
+
 v8::Handle<v8::Value>
 HyperDexClient :: count(const v8::Arguments& args)
 {
@@ -147,8 +147,10 @@ NODE_SET_PROTOTYPE_METHOD(tpl, "map_atomic_max", HyperDexClient::map_atomic_max)
 NODE_SET_PROTOTYPE_METHOD(tpl, "cond_map_atomic_max", HyperDexClient::cond_map_atomic_max);
 NODE_SET_PROTOTYPE_METHOD(tpl, "group_map_atomic_max", HyperDexClient::group_map_atomic_max);
 NODE_SET_PROTOTYPE_METHOD(tpl, "search", HyperDexClient::search);
+NODE_SET_PROTOTYPE_METHOD(tpl, "search_partial", HyperDexClient::search_partial);
 NODE_SET_PROTOTYPE_METHOD(tpl, "search_describe", HyperDexClient::search_describe);
 NODE_SET_PROTOTYPE_METHOD(tpl, "sorted_search", HyperDexClient::sorted_search);
+NODE_SET_PROTOTYPE_METHOD(tpl, "sorted_search_partial", HyperDexClient::sorted_search_partial);
 NODE_SET_PROTOTYPE_METHOD(tpl, "count", HyperDexClient::count);
 
 #endif // HYPERDEX_NODE_INCLUDED_CLIENT_CC
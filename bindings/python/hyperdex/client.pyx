@@ -168,6 +168,7 @@ cdef extern from "hyperdex/client.h":
     int64_t hyperdex_client_uxact_group_commit(hyperdex_client* _cl, hyperdex_client_microtransaction *utx, const hyperdex_client_attribute_check *chks, size_t chks_sz, uint64_t* count)
     void hyperdex_client_destroy(hyperdex_client* client)
     int64_t hyperdex_client_loop(hyperdex_client* client, int timeout, hyperdex_client_returncode* status)
+    int64_t hyperdex_client_loop_many(hyperdex_client* client, int timeout, int64_t* ids, hyperdex_client_returncode* statuses, size_t n)
     void hyperdex_client_destroy_attrs(hyperdex_client_attribute* attrs, size_t attrs_sz)
     char* hyperdex_client_error_message(hyperdex_client* client)
     char* hyperdex_client_error_location(hyperdex_client* client)
@@ -311,8 +312,10 @@ cdef extern from "hyperdex/client.h":
     int64_t hyperdex_client_group_map_atomic_max(hyperdex_client* client, const char* space, const hyperdex_client_attribute_check* checks, size_t checks_sz, const hyperdex_client_map_attribute* mapattrs, size_t mapattrs_sz, hyperdex_client_returncode* status, uint64_t* count)
     int64_t hyperdex_client_uxact_atomic_max(hyperdex_client* client, hyperdex_client_microtransaction* microtransaction, const hyperdex_client_attribute* attrs, size_t attrs_sz)
     int64_t hyperdex_client_search(hyperdex_client* client, const char* space, const hyperdex_client_attribute_check* checks, size_t checks_sz, hyperdex_client_returncode* status, const hyperdex_client_attribute** attrs, size_t* attrs_sz)
+    int64_t hyperdex_client_search_partial(hyperdex_client* client, const char* space, const hyperdex_client_attribute_check* checks, size_t checks_sz, const char** attrnames, size_t attrnames_sz, hyperdex_client_returncode* status, const hyperdex_client_attribute** attrs, size_t* attrs_sz)
     int64_t hyperdex_client_search_describe(hyperdex_client* client, const char* space, const hyperdex_client_attribute_check* checks, size_t checks_sz, hyperdex_client_returncode* status, const char** description)
     int64_t hyperdex_client_sorted_search(hyperdex_client* client, const char* space, const hyperdex_client_attribute_check* checks, size_t checks_sz, const char* sort_by, uint64_t limit, int maxmin, hyperdex_client_returncode* status, const hyperdex_client_attribute** attrs, size_t* attrs_sz)
+    int64_t hyperdex_client_sorted_search_partial(hyperdex_client* client, const char* space, const hyperdex_client_attribute_check* checks, size_t checks_sz, const char** attrnames, size_t attrnames_sz, const char* sort_by, uint64_t limit, int maxmin, hyperdex_client_returncode* status, const hyperdex_client_attribute** attrs, size_t* attrs_sz)
     int64_t hyperdex_client_count(hyperdex_client* client, const char* space, const hyperdex_client_attribute_check* checks, size_t checks_sz, hyperdex_client_returncode* status, uint64_t* count)
     # End Automatically Generated Prototypes
 
@@ -403,8 +406,10 @@ ctypedef int64_t asynccall__spacename_key_mapattributes__status_fptr(hyperdex_cl
 ctypedef int64_t asynccall__spacename_key_predicates_mapattributes__status_fptr(hyperdex_client* client, const char* space, const char* key, size_t key_sz, const hyperdex_client_attribute_check* checks, size_t checks_sz, const hyperdex_client_map_attribute* mapattrs, size_t mapattrs_sz, hyperdex_client_returncode* status)
 ctypedef int64_t asynccall__spacename_predicates_mapattributes__status_count_fptr(hyperdex_client* client, const char* space, const hyperdex_client_attribute_check* checks, size_t checks_sz, const hyperdex_client_map_attribute* mapattrs, size_t mapattrs_sz, hyperdex_client_returncode* status, uint64_t* count)
 ctypedef int64_t iterator__spacename_predicates__status_attributes_fptr(hyperdex_client* client, const char* space, const hyperdex_client_attribute_check* checks, size_t checks_sz, hyperdex_client_returncode* status, const hyperdex_client_attribute** attrs, size_t* attrs_sz)
+ctypedef int64_t iterator__spacename_predicates_attributenames__status_attributes_fptr(hyperdex_client* client, const char* space, const hyperdex_client_attribute_check* checks, size_t checks_sz, const char** attrnames, size_t attrnames_sz, hyperdex_client_returncode* status, const hyperdex_client_attribute** attrs, size_t* attrs_sz)
 ctypedef int64_t asynccall__spacename_predicates__status_description_fptr(hyperdex_client* client, const char* space, const hyperdex_client_attribute_check* checks, size_t checks_sz, hyperdex_client_returncode* status, const char** description)
 ctypedef int64_t iterator__spacename_predicates_sortby_limit_maxmin__status_attributes_fptr(hyperdex_client* client, const char* space, const hyperdex_client_attribute_check* checks, size_t checks_sz, const char* sort_by, uint64_t limit, int maxmin, hyperdex_client_returncode* status, const hyperdex_client_attribute** attrs, size_t* attrs_sz)
+ctypedef int64_t iterator__spacename_predicates_attributenames_sortby_limit_maxmin__status_attributes_fptr(hyperdex_client* client, const char* space, const hyperdex_client_attribute_check* checks, size_t checks_sz, const char** attrnames, size_t attrnames_sz, const char* sort_by, uint64_t limit, int maxmin, hyperdex_client_returncode* status, const hyperdex_client_attribute** attrs, size_t* attrs_sz)
 # End Automatically Generated Function Pointers
 
 
@@ -1545,6 +1550,33 @@ cdef class Client:
             op._callback()
             return op
             
+    def loop_many(self, size_t n=64, int timeout=-1):
+        cdef int64_t* ids = NULL
+        cdef hyperdex_client_returncode* statuses = NULL
+        if n == 0:
+            return []
+        ids = <int64_t*>malloc(sizeof(int64_t) * n)
+        statuses = <hyperdex_client_returncode*>malloc(sizeof(hyperdex_client_returncode) * n)
+        if ids == NULL or statuses == NULL:
+            free(ids)
+            free(statuses)
+            raise MemoryError()
+        try:
+            ret = hyperdex_client_loop_many(self.client, timeout, ids, statuses, n)
+            if ret < 0:
+                raise HyperDexClientException(statuses[0], hyperdex_client_error_message(self.client))
+            finished = []
+            for i in range(ret):
+                assert ids[i] in self.ops
+                op = self.ops[ids[i]]
+                # As in loop(), op._callback() may remove it from self.ops.
+                op._callback()
+                finished.append(op)
+            return finished
+        finally:
+            free(ids)
+            free(statuses)
+
     def microtransaction_init(self, bytes spacename):
         return Microtransaction(self, spacename)
 
@@ -1769,6 +1801,23 @@ cdef class Client:
         self.ops[it.reqid] = it
         return it
 
+    cdef iterator__spacename_predicates_attributenames__status_attributes(self, iterator__spacename_predicates_attributenames__status_attributes_fptr f, bytes spacename, dict predicates, attributenames):
+        cdef Iterator it = Iterator(self)
+        cdef const char* in_space
+        cdef hyperdex_client_attribute_check* in_checks
+        cdef size_t in_checks_sz
+        cdef const char** in_attrnames
+        cdef size_t in_attrnames_sz
+        self.convert_spacename(it.arena, spacename, &in_space);
+        self.convert_predicates(it.arena, predicates, &in_checks, &in_checks_sz);
+        self.convert_attributenames(it.arena, attributenames, &in_attrnames, &in_attrnames_sz);
+        it.reqid = f(self.client, in_space, in_checks, in_checks_sz, in_attrnames, in_attrnames_sz, &it.status, &it.attrs, &it.attrs_sz);
+        if it.reqid < 0:
+            raise HyperDexClientException(it.status, hyperdex_client_error_message(self.client))
+        it.encode_return = hyperdex_python_client_iterator_encode_status_attributes
+        self.ops[it.reqid] = it
+        return it
+
     cdef asynccall__spacename_predicates__status_description(self, asynccall__spacename_predicates__status_description_fptr f, bytes spacename, dict predicates, auth=None):
         cdef Deferred d = Deferred(self)
         cdef const char* in_space
@@ -1805,6 +1854,29 @@ cdef class Client:
         self.ops[it.reqid] = it
         return it
 
+    cdef iterator__spacename_predicates_attributenames_sortby_limit_maxmin__status_attributes(self, iterator__spacename_predicates_attributenames_sortby_limit_maxmin__status_attributes_fptr f, bytes spacename, dict predicates, attributenames, bytes sortby, int limit, str maxmin):
+        cdef Iterator it = Iterator(self)
+        cdef const char* in_space
+        cdef hyperdex_client_attribute_check* in_checks
+        cdef size_t in_checks_sz
+        cdef const char** in_attrnames
+        cdef size_t in_attrnames_sz
+        cdef const char* in_sort_by
+        cdef uint64_t in_limit
+        cdef int in_maxmin
+        self.convert_spacename(it.arena, spacename, &in_space);
+        self.convert_predicates(it.arena, predicates, &in_checks, &in_checks_sz);
+        self.convert_attributenames(it.arena, attributenames, &in_attrnames, &in_attrnames_sz);
+        self.convert_sortby(it.arena, sortby, &in_sort_by);
+        self.convert_limit(it.arena, limit, &in_limit);
+        self.convert_maxmin(it.arena, maxmin, &in_maxmin);
+        it.reqid = f(self.client, in_space, in_checks, in_checks_sz, in_attrnames, in_attrnames_sz, in_sort_by, in_limit, in_maxmin, &it.status, &it.attrs, &it.attrs_sz);
+        if it.reqid < 0:
+            raise HyperDexClientException(it.status, hyperdex_client_error_message(self.client))
+        it.encode_return = hyperdex_python_client_iterator_encode_status_attributes
+        self.ops[it.reqid] = it
+        return it
+
     def async_get(self, bytes spacename, key, auth=None):
         return self.asynccall__spacename_key__status_attributes(hyperdex_client_get, spacename, key, auth)
     def get(self, bytes spacename, key, auth=None):
@@ -2400,6 +2472,9 @@ cdef class Client:
     def search(self, bytes spacename, dict predicates):
         return self.iterator__spacename_predicates__status_attributes(hyperdex_client_search, spacename, predicates)
 
+    def search_partial(self, bytes spacename, dict predicates, attributenames):
+        return self.iterator__spacename_predicates_attributenames__status_attributes(hyperdex_client_search_partial, spacename, predicates, attributenames)
+
     def async_search_describe(self, bytes spacename, dict predicates, auth=None):
         return self.asynccall__spacename_predicates__status_description(hyperdex_client_search_describe, spacename, predicates, auth)
     def search_describe(self, bytes spacename, dict predicates, auth=None):
@@ -2408,6 +2483,9 @@ cdef class Client:
     def sorted_search(self, bytes spacename, dict predicates, bytes sortby, int limit, str maxmin):
         return self.iterator__spacename_predicates_sortby_limit_maxmin__status_attributes(hyperdex_client_sorted_search, spacename, predicates, sortby, limit, maxmin)
 
+    def sorted_search_partial(self, bytes spacename, dict predicates, attributenames, bytes sortby, int limit, str maxmin):
+        return self.iterator__spacename_predicates_attributenames_sortby_limit_maxmin__status_attributes(hyperdex_client_sorted_search_partial, spacename, predicates, attributenames, sortby, limit, maxmin)
+
     def async_count(self, bytes spacename, dict predicates, auth=None):
         return self.asynccall__spacename_predicates__status_count(hyperdex_client_count, spacename, predicates, auth)
     def count(self, bytes spacename, dict predicates, auth=None):
@@ -393,6 +393,37 @@ hyperdex_ruby_client_iterator__spacename_predicates__status_attributes(int64_t (
     return op;
 }
 
+static VALUE
+hyperdex_ruby_client_iterator__spacename_predicates_attributenames__status_attributes(int64_t (*f)(struct hyperdex_client* client, const char* space, const struct hyperdex_client_attribute_check* checks, size_t checks_sz, const char** attrnames, size_t attrnames_sz, enum hyperdex_client_returncode* status, const struct hyperdex_client_attribute** attrs, size_t* attrs_sz), VALUE self, VALUE spacename, VALUE predicates, VALUE attributenames)
+{
+    VALUE op;
+    const char* in_space;
+    const struct hyperdex_client_attribute_check* in_checks;
+    size_t in_checks_sz;
+    const char** in_attrnames;
+    size_t in_attrnames_sz;
+    struct hyperdex_client* client;
+    struct hyperdex_ruby_client_iterator* o;
+    op = rb_class_new_instance(1, &self, class_iterator);
+    rb_iv_set(self, "tmp", op);
+    Data_Get_Struct(self, struct hyperdex_client, client);
+    Data_Get_Struct(op, struct hyperdex_ruby_client_iterator, o);
+    hyperdex_ruby_client_convert_spacename(o->arena, spacename, &in_space);
+    hyperdex_ruby_client_convert_predicates(o->arena, predicates, &in_checks, &in_checks_sz);
+    hyperdex_ruby_client_convert_attributenames(o->arena, attributenames, &in_attrnames, &in_attrnames_sz);
+    o->reqid = f(client, in_space, in_checks, in_checks_sz, in_attrnames, in_attrnames_sz, &o->status, &o->attrs, &o->attrs_sz);
+
+    if (o->reqid < 0)
+    {
+        hyperdex_ruby_client_throw_exception(o->status, hyperdex_client_error_message(client));
+    }
+
+    o->encode_return = hyperdex_ruby_client_iterator_encode_status_attributes;
+    rb_hash_aset(rb_iv_get(self, "ops"), LONG2NUM(o->reqid), op);
+    rb_iv_set(self, "tmp", Qnil);
+    return op;
+}
+
 static VALUE
 hyperdex_ruby_client_asynccall__spacename_predicates__status_description(int64_t (*f)(struct hyperdex_client* client, const char* space, const struct hyperdex_client_attribute_check* checks, size_t checks_sz, enum hyperdex_client_returncode* status, const char** description), VALUE self, VALUE spacename, VALUE predicates)
 {
@@ -454,6 +485,43 @@ hyperdex_ruby_client_iterator__spacename_predicates_sortby_limit_maxmin__status_
     rb_iv_set(self, "tmp", Qnil);
     return op;
 }
+
+static VALUE
+hyperdex_ruby_client_iterator__spacename_predicates_attributenames_sortby_limit_maxmin__status_attributes(int64_t (*f)(struct hyperdex_client* client, const char* space, const struct hyperdex_client_attribute_check* checks, size_t checks_sz, const char** attrnames, size_t attrnames_sz, const char* sort_by, uint64_t limit, int maxmin, enum hyperdex_client_returncode* status, const struct hyperdex_client_attribute** attrs, size_t* attrs_sz), VALUE self, VALUE spacename, VALUE predicates, VALUE attributenames, VALUE sortby, VALUE limit, VALUE maxmin)
+{
+    VALUE op;
+    const char* in_space;
+    const struct hyperdex_client_attribute_check* in_checks;
+    size_t in_checks_sz;
+    const char** in_attrnames;
+    size_t in_attrnames_sz;
+    const char* in_sort_by;
+    uint64_t in_limit;
+    int in_maxmin;
+    struct hyperdex_client* client;
+    struct hyperdex_ruby_client_iterator* o;
+    op = rb_class_new_instance(1, &self, class_iterator);
+    rb_iv_set(self, "tmp", op);
+    Data_Get_Struct(self, struct hyperdex_client, client);
+    Data_Get_Struct(op, struct hyperdex_ruby_client_iterator, o);
+    hyperdex_ruby_client_convert_spacename(o->arena, spacename, &in_space);
+    hyperdex_ruby_client_convert_predicates(o->arena, predicates, &in_checks, &in_checks_sz);
+    hyperdex_ruby_client_convert_attributenames(o->arena, attributenames, &in_attrnames, &in_attrnames_sz);
+    hyperdex_ruby_client_convert_sortby(o->arena, sortby, &in_sort_by);
+    hyperdex_ruby_client_convert_limit(o->arena, limit, &in_limit);
+    hyperdex_ruby_client_convert_maxmin(o->arena, maxmin, &in_maxmin);
+    o->reqid = f(client, in_space, in_checks, in_checks_sz, in_attrnames, in_attrnames_sz, in_sort_by, in_limit, in_maxmin, &o->status, &o->attrs, &o->attrs_sz);
+
+    if (o->reqid < 0)
+    {
+        hyperdex_ruby_client_throw_exception(o->status, hyperdex_client_error_message(client));
+    }
+
+    o->encode_return = hyperdex_ruby_client_iterator_encode_status_attributes;
+    rb_hash_aset(rb_iv_get(self, "ops"), LONG2NUM(o->reqid), op);
+    rb_iv_set(self, "tmp", Qnil);
+    return op;
+}
 static VALUE
 hyperdex_ruby_client_get(VALUE self, VALUE spacename, VALUE key)
 {
@@ -1876,6 +1944,12 @@ hyperdex_ruby_client_search(VALUE self, VALUE spacename, VALUE predicates)
     return hyperdex_ruby_client_iterator__spacename_predicates__status_attributes(hyperdex_client_search, self, spacename, predicates);
 }
 
+static VALUE
+hyperdex_ruby_client_search_partial(VALUE self, VALUE spacename, VALUE predicates, VALUE attributenames)
+{
+    return hyperdex_ruby_client_iterator__spacename_predicates_attributenames__status_attributes(hyperdex_client_search_partial, self, spacename, predicates, attributenames);
+}
+
 static VALUE
 hyperdex_ruby_client_search_describe(VALUE self, VALUE spacename, VALUE predicates)
 {
@@ -1894,6 +1968,12 @@ hyperdex_ruby_client_sorted_search(VALUE self, VALUE spacename, VALUE predicates
     return hyperdex_ruby_client_iterator__spacename_predicates_sortby_limit_maxmin__status_attributes(hyperdex_client_sorted_search, self, spacename, predicates, sortby, limit, maxmin);
 }
 
+static VALUE
+hyperdex_ruby_client_sorted_search_partial(VALUE self, VALUE spacename, VALUE predicates, VALUE attributenames, VALUE sortby, VALUE limit, VALUE maxmin)
+{
+    return hyperdex_ruby_client_iterator__spacename_predicates_attributenames_sortby_limit_maxmin__status_attributes(hyperdex_client_sorted_search_partial, self, spacename, predicates, attributenames, sortby, limit, maxmin);
+}
+
 static VALUE
 hyperdex_ruby_client_count(VALUE self, VALUE spacename, VALUE predicates)
 {
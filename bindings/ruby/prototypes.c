@@ -264,8 +264,10 @@ rb_define_method(class_client, "cond_map_atomic_max", hyperdex_ruby_client_wait_
 rb_define_method(class_client, "async_group_map_atomic_max", hyperdex_ruby_client_group_map_atomic_max, 3);
 rb_define_method(class_client, "group_map_atomic_max", hyperdex_ruby_client_wait_group_map_atomic_max, 3);
 rb_define_method(class_client, "search", hyperdex_ruby_client_search, 2);
+rb_define_method(class_client, "search_partial", hyperdex_ruby_client_search_partial, 3);
 rb_define_method(class_client, "async_search_describe", hyperdex_ruby_client_search_describe, 2);
 rb_define_method(class_client, "search_describe", hyperdex_ruby_client_wait_search_describe, 2);
 rb_define_method(class_client, "sorted_search", hyperdex_ruby_client_sorted_search, 5);
+rb_define_method(class_client, "sorted_search_partial", hyperdex_ruby_client_sorted_search_partial, 6);
 rb_define_method(class_client, "async_count", hyperdex_ruby_client_count, 2);
 rb_define_method(class_client, "count", hyperdex_ruby_client_wait_count, 2);
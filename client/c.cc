@@ -62,6 +62,7 @@ inline void return_void() {}
     SIGNAL_PROTECT; \
     try \
     { \
+        hyperdex::client::api_guard _guard(cl); \
         X \
     } \
     catch (std::bad_alloc& ba) \
@@ -194,6 +195,7 @@ hyperdex_client_attribute_type(hyperdex_client* _cl,
 
     try
     {
+        hyperdex::client::api_guard _guard(cl);
         return cl->attribute_type(space, name, status);
     }
     catch (std::bad_alloc& ba)
@@ -225,6 +227,7 @@ hyperdex_client_clear_auth_context(struct hyperdex_client* _cl)
     FAKE_STATUS;
     SIGNAL_PROTECT_VOID;
     hyperdex::client* cl = reinterpret_cast<hyperdex::client*>(_cl);
+    hyperdex::client::api_guard _guard(cl);
     cl->clear_auth_context();
 }
 
@@ -235,6 +238,7 @@ hyperdex_client_set_auth_context(struct hyperdex_client* _cl,
     FAKE_STATUS;
     SIGNAL_PROTECT_VOID;
     hyperdex::client* cl = reinterpret_cast<hyperdex::client*>(_cl);
+    hyperdex::client::api_guard _guard(cl);
     cl->set_auth_context(macaroons, macaroons_sz);
 }
 
@@ -246,6 +250,7 @@ hyperdex_client_uxact_init(struct hyperdex_client* _cl,
 
     SIGNAL_PROTECT_ERR(NULL);
     hyperdex::client *cl = reinterpret_cast<hyperdex::client*>(_cl);
+    hyperdex::client::api_guard _guard(cl);
     hyperdex::microtransaction *tx = cl->uxact_init(space, status);
 
     return reinterpret_cast<struct hyperdex_client_microtransaction*>(tx);
@@ -292,6 +297,31 @@ hyperdex_client_uxact_cond_commit(struct hyperdex_client* _cl,
     );
 }
 
+HYPERDEX_API int64_t
+hyperdex_client_aggregate(struct hyperdex_client* _cl,
+                          const char* space,
+                          const struct hyperdex_client_attribute_check* checks, size_t checks_sz,
+                          struct hyperdex_client_aggregate_spec* aggs, size_t aggs_sz,
+                          enum hyperdex_client_returncode* status)
+{
+    C_WRAP_EXCEPT(
+    return cl->aggregate(space, checks, checks_sz, aggs, aggs_sz, status);
+    );
+}
+
+HYPERDEX_API int64_t
+hyperdex_client_get_many(struct hyperdex_client* _cl,
+                         const char* space,
+                         const char** keys, const size_t* keys_sz, size_t num_keys,
+                         enum hyperdex_client_returncode* status,
+                         enum hyperdex_client_returncode* statuses,
+                         const struct hyperdex_client_attribute** attrs, size_t* attrs_sz)
+{
+    C_WRAP_EXCEPT(
+    return cl->get_many(space, keys, keys_sz, num_keys, status, statuses, attrs, attrs_sz);
+    );
+}
+
 HYPERDEX_API int64_t
 hyperdex_client_get(struct hyperdex_client* _cl,
                     const char* space,
@@ -2265,6 +2295,19 @@ hyperdex_client_search(struct hyperdex_client* _cl,
     );
 }
 
+HYPERDEX_API int64_t
+hyperdex_client_search_partial(struct hyperdex_client* _cl,
+                               const char* space,
+                               const struct hyperdex_client_attribute_check* checks, size_t checks_sz,
+                               const char** attrnames, size_t attrnames_sz,
+                               enum hyperdex_client_returncode* status,
+                               const struct hyperdex_client_attribute** attrs, size_t* attrs_sz)
+{
+    C_WRAP_EXCEPT(
+    return cl->search_partial(space, checks, checks_sz, attrnames, attrnames_sz, status, attrs, attrs_sz);
+    );
+}
+
 HYPERDEX_API int64_t
 hyperdex_client_search_describe(struct hyperdex_client* _cl,
                                 const char* space,
@@ -2292,6 +2335,22 @@ hyperdex_client_sorted_search(struct hyperdex_client* _cl,
     );
 }
 
+HYPERDEX_API int64_t
+hyperdex_client_sorted_search_partial(struct hyperdex_client* _cl,
+                                      const char* space,
+                                      const struct hyperdex_client_attribute_check* checks, size_t checks_sz,
+                                      const char** attrnames, size_t attrnames_sz,
+                                      const char* sort_by,
+                                      uint64_t limit,
+                                      int maxmin,
+                                      enum hyperdex_client_returncode* status,
+                                      const struct hyperdex_client_attribute** attrs, size_t* attrs_sz)
+{
+    C_WRAP_EXCEPT(
+    return cl->sorted_search_partial(space, checks, checks_sz, attrnames, attrnames_sz, sort_by, limit, maxmin, status, attrs, attrs_sz);
+    );
+}
+
 HYPERDEX_API int64_t
 hyperdex_client_count(struct hyperdex_client* _cl,
                       const char* space,
@@ -2313,6 +2372,17 @@ hyperdex_client_loop(hyperdex_client* _cl, int timeout,
     );
 }
 
+HYPERDEX_API int64_t
+hyperdex_client_loop_many(hyperdex_client* _cl, int timeout,
+                          int64_t* ids, hyperdex_client_returncode* statuses,
+                          size_t n)
+{
+    hyperdex_client_returncode* status = statuses;
+    C_WRAP_EXCEPT(
+    return cl->loop_many(timeout, ids, statuses, n);
+    );
+}
+
 HYPERDEX_API int
 hyperdex_client_poll_fd(hyperdex_client* _cl)
 {
@@ -2338,6 +2408,36 @@ hyperdex_client_set_type_conversion(hyperdex_client* _cl, bool enabled)
     cl->set_type_conversion(enabled);
 }
 
+HYPERDEX_API int
+hyperdex_client_set_thread_safe(hyperdex_client* _cl, int enabled)
+{
+    FAKE_STATUS;
+    C_WRAP_EXCEPT(
+    cl->set_thread_safe(enabled != 0);
+    return 0;
+    );
+}
+
+HYPERDEX_API int
+hyperdex_client_set_corking(hyperdex_client* _cl, int enabled)
+{
+    FAKE_STATUS;
+    C_WRAP_EXCEPT(
+    cl->set_corking(enabled != 0);
+    return 0;
+    );
+}
+
+HYPERDEX_API int
+hyperdex_client_flush(hyperdex_client* _cl)
+{
+    FAKE_STATUS;
+    C_WRAP_EXCEPT(
+    cl->flush();
+    return 0;
+    );
+}
+
 #ifdef __cplusplus
 } // extern "C"
 #endif // __cplusplus
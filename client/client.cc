@@ -27,12 +27,18 @@
 
 #define __STDC_LIMIT_MACROS
 
+// C
+#include <errno.h>
+
 // POSIX
 #include <poll.h>
 
 // STL
 #include <algorithm>
 
+// po6
+#include <po6/time.h>
+
 // e
 #include <e/intrusive_ptr.h>
 #include <e/strescape.h>
@@ -50,12 +56,15 @@
 #include "common/macros.h"
 #include "common/network_msgtype.h"
 #include "common/serialization.h"
+#include "cityhash/city.h"
 #include "client/client.h"
 #include "client/constants.h"
+#include "client/pending_aggregate.h"
 #include "client/pending_atomic.h"
 #include "client/pending_group_atomic.h"
 #include "client/pending_count.h"
 #include "client/pending_get.h"
+#include "client/pending_get_many.h"
 #include "client/pending_get_partial.h"
 #include "client/pending_search.h"
 #include "client/pending_search_describe.h"
@@ -100,9 +109,25 @@ client :: client(const char* coordinator, uint16_t port)
     , m_yielding()
     , m_yielded()
     , m_last_error()
+    , m_deferred_status(HYPERDEX_CLIENT_SUCCESS)
+    , m_deferred_error()
     , m_macaroons(NULL)
     , m_macaroons_sz(0)
     , m_convert_types(true)
+    , m_next_replica(0)
+    , m_read_versions()
+    , m_corking(false)
+    , m_corked()
+    , m_thread_safe(false)
+    , m_mtx()
+    , m_cond(&m_mtx)
+    , m_wakeup()
+    , m_thread_key()
+    , m_caller(NULL)
+    , m_threads()
+    , m_owners()
+    , m_polling(false)
+    , m_waiters(0)
 {
     if (!m_coord)
     {
@@ -132,9 +157,25 @@ client :: client(const char* conn_str)
     , m_yielding()
     , m_yielded()
     , m_last_error()
+    , m_deferred_status(HYPERDEX_CLIENT_SUCCESS)
+    , m_deferred_error()
     , m_macaroons(NULL)
     , m_macaroons_sz(0)
     , m_convert_types(true)
+    , m_next_replica(0)
+    , m_read_versions()
+    , m_corking(false)
+    , m_corked()
+    , m_thread_safe(false)
+    , m_mtx()
+    , m_cond(&m_mtx)
+    , m_wakeup()
+    , m_thread_key()
+    , m_caller(NULL)
+    , m_threads()
+    , m_owners()
+    , m_polling(false)
+    , m_waiters(0)
 {
     if (!m_coord)
     {
@@ -147,6 +188,23 @@ client :: client(const char* conn_str)
 
 client :: ~client() throw ()
 {
+    while (!m_corked.empty())
+    {
+        drop_corked(m_corked.begin()->first);
+    }
+
+    // no thread may exit into thread_exited once the client is gone
+    if (m_wakeup.get())
+    {
+        pthread_key_delete(m_thread_key);
+    }
+
+    for (thread_set_t::iterator it = m_threads.begin();
+            it != m_threads.end(); ++it)
+    {
+        delete *it;
+    }
+
     replicant_client_destroy(m_coord);
 }
 
@@ -178,8 +236,8 @@ client :: get(const char* space, const char* _key, size_t _key_sz,
         return -1;
     }
 
-    e::intrusive_ptr<pending> op;
-    op = new pending_get(m_next_client_id++, status, attrs, attrs_sz);
+    pending_get* gop = new pending_get(m_next_client_id++, status, attrs, attrs_sz);
+    e::intrusive_ptr<pending> op(gop);
     size_t sz = HYPERDEX_CLIENT_HEADER_SIZE_REQ + pack_size(key);
     auth_wallet aw(m_macaroons, m_macaroons_sz);
 
@@ -196,9 +254,120 @@ client :: get(const char* space, const char* _key, size_t _key_sz,
         pa = pa << aw;
     }
 
+    if (sc->consistency == schema::CONSISTENCY_STALE)
+    {
+        gop->allow_stale(key, std::auto_ptr<e::buffer>(msg->copy()));
+        return send_stale_keyop(space, key, REQ_GET, msg, op, status);
+    }
+
     return send_keyop(space, key, REQ_GET, msg, op, status);
 }
 
+int64_t
+client :: get_many(const char* space,
+                   const char** keys, const size_t* keys_sz, size_t num_keys,
+                   hyperdex_client_returncode* status,
+                   hyperdex_client_returncode* statuses,
+                   const hyperdex_client_attribute** attrs, size_t* attrs_sz)
+{
+    if (!maintain_coord_connection(status))
+    {
+        return -1;
+    }
+
+    const schema* sc = m_config.get_schema(space);
+
+    if (!sc)
+    {
+        ERROR(UNKNOWNSPACE) << "space \"" << e::strescape(space) << "\" does not exist";
+        return -1;
+    }
+
+    datatype_info* di = datatype_info::lookup(sc->attrs[0].type);
+    assert(di);
+
+    for (size_t i = 0; i < num_keys; ++i)
+    {
+        if (!di->validate(e::slice(keys[i], keys_sz[i])))
+        {
+            ERROR(WRONGTYPE) << "key must be type " << sc->attrs[0].type;
+            return -1;
+        }
+    }
+
+    // group the keys by the server that leads them
+    std::vector<std::pair<virtual_server_id, size_t> > leaders;
+    leaders.reserve(num_keys);
+
+    for (size_t i = 0; i < num_keys; ++i)
+    {
+        statuses[i] = HYPERDEX_CLIENT_GARBAGE;
+        attrs[i] = NULL;
+        attrs_sz[i] = 0;
+        virtual_server_id vsi = m_config.point_leader(space, e::slice(keys[i], keys_sz[i]));
+
+        if (vsi == virtual_server_id())
+        {
+            statuses[i] = HYPERDEX_CLIENT_OFFLINE;
+            continue;
+        }
+
+        leaders.push_back(std::make_pair(vsi, i));
+    }
+
+    std::sort(leaders.begin(), leaders.end());
+    pending_get_many* gm = new pending_get_many(m_next_client_id++, status, statuses, attrs, attrs_sz);
+    e::intrusive_ptr<pending> op(gm);
+    auth_wallet aw(m_macaroons, m_macaroons_sz);
+    size_t start = 0;
+
+    while (start < leaders.size())
+    {
+        const virtual_server_id vsi(leaders[start].first);
+        std::vector<size_t> idxs;
+        std::vector<e::slice> server_keys;
+
+        for (; start < leaders.size() && leaders[start].first == vsi; ++start)
+        {
+            size_t idx = leaders[start].second;
+            idxs.push_back(idx);
+            server_keys.push_back(e::slice(keys[idx], keys_sz[idx]));
+        }
+
+        size_t sz = HYPERDEX_CLIENT_HEADER_SIZE_REQ + pack_size(server_keys);
+
+        if (m_macaroons_sz)
+        {
+            sz += pack_size(aw);
+        }
+
+        std::auto_ptr<e::buffer> msg(e::buffer::create(sz));
+        e::packer pa = msg->pack_at(HYPERDEX_CLIENT_HEADER_SIZE_REQ) << server_keys;
+
+        if (m_macaroons_sz)
+        {
+            pa = pa << aw;
+        }
+
+        gm->add_server(vsi, idxs);
+        pending_server_pair psp(m_config.get_server_id(vsi), vsi, op);
+
+        if (!send(REQ_GET_MANY, vsi, m_next_server_nonce++, msg, op, status))
+        {
+            m_failed.push_back(psp);
+            leg_added(op);
+        }
+    }
+
+    // every key was offline; nothing will come back from the servers
+    if (leaders.empty())
+    {
+        m_yieldable.push_back(op);
+    }
+
+    return op->client_visible_id();
+}
+
 int64_t
 client :: get_partial(const char* space, const char* _key, size_t _key_sz,
                       const char** attrnames, size_t attrnames_sz,
@@ -253,8 +422,14 @@ client :: get_partial(const char* space, const char* _key, size_t _key_sz,
         return -1;
     }
 
-    e::intrusive_ptr<pending> op;
-    op = new pending_get_partial(m_next_client_id++, status, attrs, attrs_sz);
+    // stale reads need the version to stay monotonic
+    if (sc->consistency == schema::CONSISTENCY_STALE)
+    {
+        attrnums.push_back(HYPERDEX_ATTRIBUTE_VERSION);
+    }
+
+    pending_get_partial* gop = new pending_get_partial(m_next_client_id++, status, attrs, attrs_sz);
+    e::intrusive_ptr<pending> op(gop);
     size_t sz = HYPERDEX_CLIENT_HEADER_SIZE_REQ
               + pack_size(key)
               + sizeof(uint64_t) + attrnums.size() * sizeof(uint16_t);
@@ -274,6 +449,12 @@ client :: get_partial(const char* space, const char* _key, size_t _key_sz,
         pa = pa << aw;
     }
 
+    if (sc->consistency == schema::CONSISTENCY_STALE)
+    {
+        gop->allow_stale(key, std::auto_ptr<e::buffer>(msg->copy()));
+        return send_stale_keyop(space, key, REQ_GET_PARTIAL, msg, op, status);
+    }
+
     return send_keyop(space, key, REQ_GET_PARTIAL, msg, op, status);
 }
 
@@ -302,16 +483,39 @@ client :: search(const char* space,
                  const hyperdex_client_attribute_check* chks, size_t chks_sz,
                  hyperdex_client_returncode* status,
                  const hyperdex_client_attribute** attrs, size_t* attrs_sz)
+{
+    return search_partial(space, chks, chks_sz, NULL, 0, status, attrs, attrs_sz);
+}
+
+int64_t
+client :: search_partial(const char* space,
+                         const hyperdex_client_attribute_check* chks, size_t chks_sz,
+                         const char** attrnames, size_t attrnames_sz,
+                         hyperdex_client_returncode* status,
+                         const hyperdex_client_attribute** attrs, size_t* attrs_sz)
 {
     SEARCH_BOILERPLATE
+    std::vector<uint16_t> projection;
+
+    if (!prepare_projection(*sc, space, attrnames, attrnames_sz, status, &projection))
+    {
+        return -1 - chks_sz;
+    }
+
     int64_t client_id = m_next_client_id++;
     e::intrusive_ptr<pending_aggregation> op;
-    op = new pending_search(client_id, status, attrs, attrs_sz);
+    op = new pending_search(this, client_id, projection, status, attrs, attrs_sz);
+    const uint64_t batch_items = HYPERDEX_CLIENT_SEARCH_BATCH_ITEMS;
+    const uint64_t batch_bytes = HYPERDEX_CLIENT_SEARCH_BATCH_BYTES;
     size_t sz = HYPERDEX_CLIENT_HEADER_SIZE_REQ
               + sizeof(uint64_t)
-              + pack_size(checks);
+              + pack_size(checks)
+              + sizeof(uint64_t)
+              + sizeof(uint64_t)
+              + pack_size(projection);
     std::auto_ptr<e::buffer> msg(e::buffer::create(sz));
-    msg->pack_at(HYPERDEX_CLIENT_HEADER_SIZE_REQ) << client_id << checks;
+    msg->pack_at(HYPERDEX_CLIENT_HEADER_SIZE_REQ)
+        << client_id << checks << batch_items << batch_bytes << projection;
     return perform_aggregation(servers, op, REQ_SEARCH_START, msg, status);
 }
 
@@ -339,6 +543,21 @@ client :: sorted_search(const char* space,
                         bool maximize,
                         hyperdex_client_returncode* status,
                         const hyperdex_client_attribute** attrs, size_t* attrs_sz)
+{
+    return sorted_search_partial(space, chks, chks_sz, NULL, 0,
+                                 sort_by, limit, maximize,
+                                 status, attrs, attrs_sz);
+}
+
+int64_t
+client :: sorted_search_partial(const char* space,
+                                const hyperdex_client_attribute_check* chks, size_t chks_sz,
+                                const char** attrnames, size_t attrnames_sz,
+                                const char* sort_by,
+                                uint64_t limit,
+                                bool maximize,
+                                hyperdex_client_returncode* status,
+                                const hyperdex_client_attribute** attrs, size_t* attrs_sz)
 {
     SEARCH_BOILERPLATE
     uint16_t sort_by_num = sc->lookup_attr(sort_by);
@@ -361,17 +580,46 @@ client :: sorted_search(const char* space,
         return -1 - chks_sz;
     }
 
+    std::vector<uint16_t> wanted;
+
+    if (!prepare_projection(*sc, space, attrnames, attrnames_sz, status, &wanted))
+    {
+        return -1 - chks_sz;
+    }
+
+    // servers return the sort attribute too, so the client can merge them
+    std::vector<uint16_t> projection(wanted);
+
+    if (!projection.empty() && sort_by_num != 0 &&
+        !std::binary_search(projection.begin(), projection.end(), sort_by_num))
+    {
+        projection.push_back(sort_by_num);
+        std::sort(projection.begin(), projection.end());
+    }
+
     int64_t client_id = m_next_client_id++;
-    e::intrusive_ptr<pending_aggregation> op;
-    op = new pending_sorted_search(this, client_id, maximize, limit, sort_by_num, di, status, attrs, attrs_sz);
     int8_t max = maximize ? 1 : 0;
+
+    // With more than one region, ask for keys and sort values first and
+    // fetch only the objects that make the global cut.
+    if (servers.size() > 1)
+    {
+        max |= 2;
+    }
+
     size_t sz = HYPERDEX_CLIENT_HEADER_SIZE_REQ
               + pack_size(checks)
               + sizeof(limit)
               + sizeof(sort_by_num)
-              + sizeof(max);
+              + sizeof(max)
+              + pack_size(projection);
     std::auto_ptr<e::buffer> msg(e::buffer::create(sz));
-    msg->pack_at(HYPERDEX_CLIENT_HEADER_SIZE_REQ) << checks << limit << sort_by_num << max;
+    msg->pack_at(HYPERDEX_CLIENT_HEADER_SIZE_REQ)
+        << checks << limit << sort_by_num << max << projection;
+    e::intrusive_ptr<pending_aggregation> op;
+    op = new pending_sorted_search(this, client_id, maximize, limit, sort_by_num, di,
+                                   std::auto_ptr<e::buffer>(msg->copy()), wanted,
+                                   status, attrs, attrs_sz);
     return perform_aggregation(servers, op, REQ_SORTED_SEARCH, msg, status);
 }
 
@@ -392,6 +640,69 @@ client :: count(const char* space,
     return perform_aggregation(servers, op, REQ_COUNT, msg, status);
 }
 
+int64_t
+client :: aggregate(const char* space,
+                    const hyperdex_client_attribute_check* chks, size_t chks_sz,
+                    hyperdex_client_aggregate_spec* aggs, size_t aggs_sz,
+                    hyperdex_client_returncode* status)
+{
+    SEARCH_BOILERPLATE
+    std::vector<hyperdex::aggregate> wire(aggs_sz);
+    std::vector<hyperdatatype> types(aggs_sz);
+
+    for (size_t i = 0; i < aggs_sz; ++i)
+    {
+        uint16_t attr = sc->lookup_attr(aggs[i].attr);
+
+        if (attr >= sc->attrs_sz)
+        {
+            ERROR(UNKNOWNATTR) << "attribute \"" << e::strescape(aggs[i].attr)
+                               << "\" is not an attribute in space \""
+                               << e::strescape(space) << "\"";
+            return -1 - chks_sz;
+        }
+
+        if (attr == 0)
+        {
+            ERROR(DONTUSEKEY) << "cannot aggregate over the key (\""
+                              << e::strescape(aggs[i].attr) << "\")";
+            return -1 - chks_sz;
+        }
+
+        wire[i].attr = attr;
+        wire[i].function = aggs[i].function;
+        wire[i].bucket_start = aggs[i].bucket_start;
+        wire[i].bucket_width = aggs[i].bucket_width;
+        wire[i].buckets = aggs[i].function == HYPERDEX_CLIENT_AGGREGATE_HISTOGRAM
+                        ? aggs[i].buckets_sz : 0;
+        types[i] = sc->attrs[attr].type;
+
+        if (!validate_aggregate(*sc, wire[i]))
+        {
+            ERROR(WRONGTYPE) << "cannot compute aggregate " << aggs[i].function
+                             << " over attribute \"" << e::strescape(aggs[i].attr)
+                             << "\" of type " << types[i];
+            return -1 - chks_sz;
+        }
+    }
+
+    int64_t client_id = m_next_client_id++;
+    e::intrusive_ptr<pending_aggregation> op;
+    op = new pending_aggregate(client_id, status, wire, types, aggs);
+    size_t sz = HYPERDEX_CLIENT_HEADER_SIZE_REQ
+              + pack_size(checks)
+              + sizeof(uint32_t);
+
+    for (size_t i = 0; i < wire.size(); ++i)
+    {
+        sz += pack_size(wire[i]);
+    }
+
+    std::auto_ptr<e::buffer> msg(e::buffer::create(sz));
+    msg->pack_at(HYPERDEX_CLIENT_HEADER_SIZE_REQ) << checks << wire;
+    return perform_aggregation(servers, op, REQ_AGGREGATE, msg, status);
+}
+
 int64_t
 client :: perform_funcall(const hyperdex_client_keyop_info* opinfo,
                           const char* space, const char* _key, size_t _key_sz,
@@ -499,6 +810,20 @@ client :: loop(int timeout, hyperdex_client_returncode* status)
 {
     *status = HYPERDEX_CLIENT_SUCCESS;
     m_last_error = e::error();
+    flush();
+
+    if (m_thread_safe)
+    {
+        return loop_threaded(timeout, status);
+    }
+
+    if (m_deferred_status != HYPERDEX_CLIENT_SUCCESS)
+    {
+        *status = m_deferred_status;
+        m_last_error = m_deferred_error;
+        m_deferred_status = HYPERDEX_CLIENT_SUCCESS;
+        return -1;
+    }
 
     while (m_yielding ||
            !m_failed.empty() ||
@@ -553,89 +878,8 @@ client :: loop(int timeout, hyperdex_client_returncode* status)
             return -1;
         }
 
-        uint64_t sid_num;
-        std::auto_ptr<e::buffer> msg;
-        m_busybee.set_timeout(timeout);
-        busybee_returncode rc = m_busybee.recv(&sid_num, &msg);
-        server_id id(sid_num);
-
-        switch (rc)
-        {
-            case BUSYBEE_SUCCESS:
-                break;
-            case BUSYBEE_INTERRUPTED:
-                ERROR(INTERRUPTED) << "signal received";
-                return -1;
-            case BUSYBEE_TIMEOUT:
-                ERROR(TIMEOUT) << "operation timed out";
-                return -1;
-            case BUSYBEE_DISRUPTED:
-                handle_disruption(id);
-                continue;
-            case BUSYBEE_EXTERNAL:
-                continue;
-            BUSYBEE_ERROR_CASE(POLLFAILED);
-            BUSYBEE_ERROR_CASE(ADDFDFAIL);
-            BUSYBEE_ERROR_CASE(SHUTDOWN);
-            default:
-                ERROR(INTERNAL) << "internal error: BusyBee unexpectedly returned "
-                                << (unsigned) rc << ": please file a bug";
-                return -1;
-        }
-
-        e::unpacker up = msg->unpack_from(BUSYBEE_HEADER_SIZE);
-        uint8_t mt;
-        virtual_server_id vfrom;
-        int64_t nonce;
-        up = up >> mt >> vfrom >> nonce;
-
-        if (up.error())
-        {
-            ERROR(SERVERERROR) << "communication error: server "
-                               << sid_num << " sent message="
-                               << msg->as_slice().hex()
-                               << " with invalid header";
-            return -1;
-        }
-
-        network_msgtype msg_type = static_cast<network_msgtype>(mt);
-        pending_map_t::iterator it = m_pending_ops.find(nonce);
-
-        if (it == m_pending_ops.end())
-        {
-            continue;
-        }
-
-        const pending_server_pair psp(it->second);
-        e::intrusive_ptr<pending> op = psp.op;
-        m_pending_ops.erase(it);
-
-        if (msg_type == CONFIGMISMATCH)
-        {
-            m_failed.push_back(psp);
-            continue;
-        }
-
-        if (vfrom == psp.vsi &&
-            id == psp.si &&
-            m_config.get_server_id(vfrom) == id)
-        {
-            if (!op->handle_message(this, id, vfrom, msg_type, msg, up, status, &m_last_error))
-            {
-                return -1;
-            }
-
-            m_yielding = psp.op;
-        }
-        else
+        if (!recv_one(timeout, status))
         {
-            ERROR(SERVERERROR) << "wrong server replied for nonce=" << nonce
-                               << ": expected it to come from "
-                               << psp.vsi << "/" << psp.si
-                               << "; it came from "
-                               << vfrom << "/" << id
-                               << "; our config says that virtual_id should map to "
-                               << m_config.get_server_id(vfrom);
             return -1;
         }
     }
@@ -674,6 +918,73 @@ client :: loop(int timeout, hyperdex_client_returncode* status)
     return -1;
 }
 
+int64_t
+client :: loop_many(int timeout, int64_t* ids,
+                    hyperdex_client_returncode* statuses, size_t n)
+{
+    size_t reaped = 0;
+    e::error last_error;
+
+    while (reaped < n)
+    {
+        // Once something is in hand, take only responses BusyBee has already
+        // read, skipping the coordinator and flagfd upkeep of a full loop.
+        if (reaped > 0 && !m_thread_safe &&
+            !m_yielding.get() && m_yieldable.empty() && m_failed.empty())
+        {
+            if (m_pending_ops.empty())
+            {
+                break;
+            }
+
+            if (recv_one(0, &statuses[reaped]))
+            {
+                continue;
+            }
+        }
+        else
+        {
+            ids[reaped] = loop(reaped == 0 ? timeout : 0, &statuses[reaped]);
+
+            if (ids[reaped] >= 0)
+            {
+                last_error = m_last_error;
+                ++reaped;
+                continue;
+            }
+
+            if (reaped == 0)
+            {
+                return -1;
+            }
+        }
+
+        // running out of responses is expected; a real error is held for the
+        // next call so the operations already reaped are not lost.  Other
+        // threads must not see it, so thread-safe clients queue it with the
+        // caller's own failures.
+        if (statuses[reaped] != HYPERDEX_CLIENT_TIMEOUT &&
+            statuses[reaped] != HYPERDEX_CLIENT_NONEPENDING)
+        {
+            if (m_thread_safe)
+            {
+                this_thread()->failures.push_back(std::make_pair(statuses[reaped], m_last_error));
+            }
+            else
+            {
+                m_deferred_status = statuses[reaped];
+                m_deferred_error = m_last_error;
+                m_flagfd.set();
+            }
+        }
+
+        break;
+    }
+
+    m_last_error = last_error;
+    return reaped;
+}
+
 int
 client :: poll_fd()
 {
@@ -685,7 +996,8 @@ client :: adjust_flagfd()
 {
     if (!m_failed.empty() ||
         !m_yieldable.empty() ||
-        m_yielding.get())
+        m_yielding.get() ||
+        m_deferred_status != HYPERDEX_CLIENT_SUCCESS)
     {
         m_flagfd.set();
     }
@@ -700,27 +1012,64 @@ client :: block(int timeout)
     pfd.fd = m_busybee.poll_fd();
     pfd.events = POLLIN|POLLHUP;
     pfd.revents = 0;
-    return ::poll(&pfd, 1, timeout) >= 0 ? 0 : -1;
+    flush();
+
+    // the caller's api_guard holds m_mtx; don't sleep with it
+    if (m_thread_safe)
+    {
+        m_mtx.unlock();
+    }
+
+    int ret = ::poll(&pfd, 1, timeout);
+
+    if (m_thread_safe)
+    {
+        m_mtx.lock();
+    }
+
+    return ret >= 0 ? 0 : -1;
 }
 
 const char*
 client :: error_message()
 {
+    if (m_thread_safe)
+    {
+        po6::threads::mutex::hold hold(&m_mtx);
+        return this_thread()->last_error.msg();
+    }
+
     return m_last_error.msg();
 }
 
 const char*
 client :: error_location()
 {
+    if (m_thread_safe)
+    {
+        po6::threads::mutex::hold hold(&m_mtx);
+        return this_thread()->last_error.loc();
+    }
+
     return m_last_error.loc();
 }
 
 void
 client :: set_error_message(const char* msg)
 {
-    m_last_error = e::error();
-    m_last_error.set_loc(__FILE__, __LINE__);
-    m_last_error.set_msg() << msg;
+    e::error err;
+    err.set_loc(__FILE__, __LINE__);
+    err.set_msg() << msg;
+
+    if (m_thread_safe)
+    {
+        po6::threads::mutex::hold hold(&m_mtx);
+        this_thread()->last_error = err;
+    }
+    else
+    {
+        m_last_error = err;
+    }
 }
 
 hyperdatatype
@@ -1009,13 +1358,50 @@ client :: prepare_funcs(const char* space, const schema& sc,
     return mapattrs_sz;
 }
 
-size_t
-client :: prepare_searchop(const schema& sc,
-                           const char* space,
-                           const hyperdex_client_attribute_check* chks, size_t chks_sz,
-                           e::arena* memory,
-                           hyperdex_client_returncode* status,
-                           std::vector<attribute_check>* checks,
+bool
+client :: prepare_projection(const schema& sc,
+                             const char* space,
+                             const char** attrnames, size_t attrnames_sz,
+                             hyperdex_client_returncode* status,
+                             std::vector<uint16_t>* projection)
+{
+    projection->clear();
+
+    for (size_t i = 0; i < attrnames_sz; ++i)
+    {
+        uint16_t attr = sc.lookup_attr(attrnames[i]);
+
+        if (attr >= sc.attrs_sz)
+        {
+            ERROR(UNKNOWNATTR) << "attribute \"" << e::strescape(attrnames[i])
+                               << "\" is not an attribute in space \""
+                               << e::strescape(space) << "\"";
+            return false;
+        }
+
+        if (attr == 0)
+        {
+            ERROR(DONTUSEKEY) << "don't specify the key (\"" << e::strescape(attrnames[i])
+                              << "\") in the attributes to return from space \""
+                              << e::strescape(space) << "\"; it is always returned";
+            return false;
+        }
+
+        projection->push_back(attr);
+    }
+
+    std::sort(projection->begin(), projection->end());
+    projection->erase(std::unique(projection->begin(), projection->end()), projection->end());
+    return true;
+}
+
+size_t
+client :: prepare_searchop(const schema& sc,
+                           const char* space,
+                           const hyperdex_client_attribute_check* chks, size_t chks_sz,
+                           e::arena* memory,
+                           hyperdex_client_returncode* status,
+                           std::vector<attribute_check>* checks,
                            std::vector<virtual_server_id>* servers)
 {
     size_t num_checks = prepare_checks(space, sc, chks, chks_sz, memory, status, checks);
@@ -1112,6 +1498,7 @@ client :: perform_aggregation(const std::vector<virtual_server_id>& servers,
         if (!send(mt, psp.vsi, nonce, msg_copy, op, status))
         {
             m_failed.push_back(psp);
+            leg_added(op);
         }
     }
 
@@ -1203,6 +1590,33 @@ client :: send(network_msgtype mt,
     msg->pack_at(BUSYBEE_HEADER_SIZE)
         << type << flags << version << to << nonce;
     server_id id = m_config.get_server_id(to);
+
+    // the daemon unpacks only these from a REQ_BATCH
+    if (m_corking &&
+        (mt == REQ_GET || mt == REQ_GET_PARTIAL || mt == REQ_ATOMIC))
+    {
+        corked_requests* cr = &m_corked[id];
+        cr->bytes += sizeof(uint32_t) + msg->size() - BUSYBEE_HEADER_SIZE;
+        cr->msgs.push_back(msg.get());
+        msg.release();
+        op->handle_sent_to(id, to);
+        m_pending_ops.insert(std::make_pair(nonce, pending_server_pair(id, to, op)));
+        leg_added(op);
+
+        if (cr->bytes >= HYPERDEX_CLIENT_CORK_BYTES)
+        {
+            flush_corked(id);
+        }
+
+        return true;
+    }
+
+    // keep requests to a server in the order they were issued
+    if (m_corked.find(id) != m_corked.end())
+    {
+        flush_corked(id);
+    }
+
     m_busybee.set_timeout(-1);
     busybee_returncode rc = m_busybee.send(id.get(), msg);
 
@@ -1211,6 +1625,7 @@ client :: send(network_msgtype mt,
         case BUSYBEE_SUCCESS:
             op->handle_sent_to(id, to);
             m_pending_ops.insert(std::make_pair(nonce, pending_server_pair(id, to, op)));
+            leg_added(op);
             return true;
         case BUSYBEE_DISRUPTED:
             handle_disruption(id);
@@ -1261,9 +1676,93 @@ client :: send_keyop(const char* space,
     }
 }
 
+int64_t
+client :: send_stale_keyop(const char* space,
+                           const e::slice& key,
+                           network_msgtype mt,
+                           std::auto_ptr<e::buffer> msg,
+                           e::intrusive_ptr<pending> op,
+                           hyperdex_client_returncode* status)
+{
+    virtual_server_id vsi = m_config.key_replica(space, key, m_next_replica++);
+
+    if (vsi == virtual_server_id())
+    {
+        ERROR(OFFLINE) << "all servers for key \""
+                       << e::strescape(std::string(reinterpret_cast<const char*>(key.data()), key.size()))
+                       << "\" in space \"" << e::strescape(space)
+                       << "\" are offline: bring one or more online to remedy the issue";
+        return -1;
+    }
+
+    int64_t nonce = m_next_server_nonce++;
+
+    if (send(mt, vsi, nonce, msg, op, status))
+    {
+        return op->client_visible_id();
+    }
+    else
+    {
+        ERROR(RECONFIGURE) << "could not send " << mt << " to " << vsi;
+        return -1;
+    }
+}
+
+bool
+client :: read_is_stale(const virtual_server_id& vsi, const e::slice& key,
+                        bool found, uint64_t version)
+{
+    const region_id ri = m_config.get_region_id(vsi);
+
+    if (m_read_versions.empty())
+    {
+        m_read_versions.resize(HYPERDEX_CLIENT_READ_VERSIONS,
+                               std::make_pair(uint64_t(0), uint64_t(0)));
+    }
+
+    const uint64_t h = CityHash64WithSeed(reinterpret_cast<const char*>(key.data()),
+                                          key.size(), ri.get());
+    std::pair<uint64_t, uint64_t>* slot = &m_read_versions[h % m_read_versions.size()];
+
+    // The point leader is never behind.  A slot that belongs to another
+    // object tells us nothing about this one, so it is simply taken over.
+    if (slot->first == h && vsi != m_config.point_leader(ri, key))
+    {
+        if ((found && version < slot->second) ||
+            (!found && slot->second > 0))
+        {
+            return true;
+        }
+    }
+
+    slot->first = h;
+    slot->second = found ? version : 0;
+    return false;
+}
+
+bool
+client :: reread_from_leader(pending* op, network_msgtype mt,
+                             const virtual_server_id& vsi,
+                             const e::slice& key,
+                             const e::buffer& request)
+{
+    const region_id ri = m_config.get_region_id(vsi);
+    virtual_server_id leader = m_config.point_leader(ri, key);
+
+    if (leader == virtual_server_id())
+    {
+        return false;
+    }
+
+    hyperdex_client_returncode status;
+    std::auto_ptr<e::buffer> msg(request.copy());
+    return send(mt, leader, m_next_server_nonce++, msg, e::intrusive_ptr<pending>(op), &status);
+}
+
 void
 client :: handle_disruption(const server_id& si)
 {
+    drop_corked(si);
     pending_map_t::iterator it = m_pending_ops.begin();
 
     while (it != m_pending_ops.end())
@@ -1284,6 +1783,436 @@ client :: handle_disruption(const server_id& si)
     m_busybee.drop(si.get());
 }
 
+bool
+client :: recv_one(int timeout, hyperdex_client_returncode* status)
+{
+    // requests corked since the last receive (e.g., reads retried at the
+    // point leader from within handle_message) must not wait behind it
+    flush();
+    uint64_t sid_num;
+    std::auto_ptr<e::buffer> msg;
+    m_busybee.set_timeout(timeout);
+    busybee_returncode rc = m_busybee.recv(&sid_num, &msg);
+    server_id id(sid_num);
+
+    switch (rc)
+    {
+        case BUSYBEE_SUCCESS:
+            break;
+        case BUSYBEE_INTERRUPTED:
+            ERROR(INTERRUPTED) << "signal received";
+            return false;
+        case BUSYBEE_TIMEOUT:
+            ERROR(TIMEOUT) << "operation timed out";
+            return false;
+        case BUSYBEE_DISRUPTED:
+            handle_disruption(id);
+            return true;
+        case BUSYBEE_EXTERNAL:
+            return maintain_coord_connection(status);
+        BUSYBEE_ERROR_CASE_FALSE(POLLFAILED);
+        BUSYBEE_ERROR_CASE_FALSE(ADDFDFAIL);
+        BUSYBEE_ERROR_CASE_FALSE(SHUTDOWN);
+        default:
+            ERROR(INTERNAL) << "internal error: BusyBee unexpectedly returned "
+                            << (unsigned) rc << ": please file a bug";
+            return false;
+    }
+
+    e::unpacker up = msg->unpack_from(BUSYBEE_HEADER_SIZE);
+    uint8_t mt;
+    virtual_server_id vfrom;
+    int64_t nonce;
+    up = up >> mt >> vfrom >> nonce;
+
+    if (up.error())
+    {
+        ERROR(SERVERERROR) << "communication error: server "
+                           << sid_num << " sent message="
+                           << msg->as_slice().hex()
+                           << " with invalid header";
+        return false;
+    }
+
+    network_msgtype msg_type = static_cast<network_msgtype>(mt);
+    pending_map_t::iterator it = m_pending_ops.find(nonce);
+
+    if (it == m_pending_ops.end())
+    {
+        return true;
+    }
+
+    const pending_server_pair psp(it->second);
+    e::intrusive_ptr<pending> op = psp.op;
+    m_pending_ops.erase(it);
+
+    if (msg_type == CONFIGMISMATCH)
+    {
+        m_failed.push_back(psp);
+        return true;
+    }
+
+    leg_removed(op);
+
+    if (vfrom == psp.vsi &&
+        id == psp.si &&
+        m_config.get_server_id(vfrom) == id)
+    {
+        if (!op->handle_message(this, id, vfrom, msg_type, msg, up, status, &m_last_error))
+        {
+            const bool routed = route_failure(op, *status);
+            op_dropped(op);
+            return routed;
+        }
+
+        m_yieldable.push_back(op);
+        return true;
+    }
+    else
+    {
+        ERROR(SERVERERROR) << "wrong server replied for nonce=" << nonce
+                           << ": expected it to come from "
+                           << psp.vsi << "/" << psp.si
+                           << "; it came from "
+                           << vfrom << "/" << id
+                           << "; our config says that virtual_id should map to "
+                           << m_config.get_server_id(vfrom);
+        const bool routed = route_failure(op, *status);
+        op_dropped(op);
+        return routed;
+    }
+}
+
+
+int64_t
+client :: loop_threaded(int timeout, hyperdex_client_returncode* status)
+{
+    // The caller's api_guard holds m_mtx.  At most one thread at a time waits
+    // on the network on behalf of all of them; the rest sleep on m_cond until
+    // their own operations are routed to them.
+    thread_state* ts = this_thread();
+    const uint64_t deadline = timeout < 0 ? 0
+                            : po6::monotonic_time() + timeout * 1000000ULL;
+
+    while (true)
+    {
+        m_caller = ts;
+        route_completions(ts);
+
+        if (!ts->failures.empty())
+        {
+            *status = ts->failures.front().first;
+            m_last_error = ts->failures.front().second;
+            ts->failures.pop_front();
+            return -1;
+        }
+
+        if (ts->yielding)
+        {
+            if (!ts->yielding->can_yield())
+            {
+                ts->yielding = NULL;
+                continue;
+            }
+
+            if (!ts->yielding->yield(status, &m_last_error))
+            {
+                return -1;
+            }
+
+            int64_t client_id = ts->yielding->client_visible_id();
+            m_last_error = ts->yielding->error();
+
+            if (!ts->yielding->can_yield())
+            {
+                ts->yielded = ts->yielding;
+                ts->yielding = NULL;
+            }
+
+            return client_id;
+        }
+        else if (!ts->ready.empty())
+        {
+            ts->yielding = ts->ready.front();
+            ts->ready.pop_front();
+            continue;
+        }
+        else if (ts->legs == 0)
+        {
+            ERROR(NONEPENDING) << "no outstanding operations to process";
+            return -1;
+        }
+
+        const uint64_t now = po6::monotonic_time();
+        ts->yielded = NULL;
+
+        if (deadline > 0 && now >= deadline)
+        {
+            ERROR(TIMEOUT) << "operation timed out";
+            return -1;
+        }
+
+        if (m_polling)
+        {
+            // the poller must wake up in time for our deadline
+            if (deadline > 0)
+            {
+                m_wakeup->set();
+            }
+
+            ts->deadline = deadline;
+            ++m_waiters;
+            m_cond.wait();
+            --m_waiters;
+            ts->deadline = 0;
+            continue;
+        }
+
+        if (!maintain_coord_connection(status))
+        {
+            return -1;
+        }
+
+        if (!m_failed.empty())
+        {
+            continue;
+        }
+
+        uint64_t until = deadline;
+
+        for (thread_set_t::iterator it = m_threads.begin();
+                it != m_threads.end(); ++it)
+        {
+            if ((*it)->deadline > 0 &&
+                (until == 0 || (*it)->deadline < until))
+            {
+                until = (*it)->deadline;
+            }
+        }
+
+        int wait = -1;
+
+        if (until > 0)
+        {
+            wait = until > now ? static_cast<int>((until - now + 999999) / 1000000) : 0;
+        }
+
+        // nothing we wait for may sit in a cork buffer
+        flush();
+        pollfd pfds[2];
+        pfds[0].fd = m_busybee.poll_fd();
+        pfds[0].events = POLLIN|POLLHUP;
+        pfds[0].revents = 0;
+        pfds[1].fd = m_wakeup->poll_fd();
+        pfds[1].events = POLLIN;
+        pfds[1].revents = 0;
+        m_polling = true;
+        m_wakeup->clear();
+        m_flagfd.clear();
+        m_mtx.unlock();
+        int ret = ::poll(pfds, 2, wait);
+        m_mtx.lock();
+        m_polling = false;
+        m_caller = ts;
+
+        if (ret < 0 && errno != EINTR)
+        {
+            ERROR(POLLFAILED) << "poll failed";
+            return -1;
+        }
+
+        if (ret == 0)
+        {
+            // some thread's deadline passed; let it notice
+            if (m_waiters > 0)
+            {
+                m_cond.broadcast();
+            }
+
+            continue;
+        }
+
+        while (recv_one(0, status))
+        {
+        }
+
+        if (*status != HYPERDEX_CLIENT_TIMEOUT)
+        {
+            return -1;
+        }
+
+        *status = HYPERDEX_CLIENT_SUCCESS;
+        m_last_error = e::error();
+    }
+}
+
+client::thread_state*
+client :: this_thread()
+{
+    thread_state* existing = static_cast<thread_state*>(pthread_getspecific(m_thread_key));
+
+    if (existing)
+    {
+        return existing;
+    }
+
+    std::auto_ptr<thread_state> ts(new thread_state(this));
+
+    if (pthread_setspecific(m_thread_key, ts.get()) != 0)
+    {
+        throw std::bad_alloc();
+    }
+
+    m_threads.insert(ts.get());
+    return ts.release();
+}
+
+void
+client :: thread_exited(void* _ts)
+{
+    // keying thread state by thread rather than by pthread_t means a new
+    // thread that happens to reuse an old one's pthread_t starts afresh
+    thread_state* ts = static_cast<thread_state*>(_ts);
+    client* cl = ts->cl;
+    po6::threads::mutex::hold hold(&cl->m_mtx);
+    cl->m_threads.erase(ts);
+
+    // whatever the thread left outstanding goes to whoever reaps it
+    for (owner_map_t::iterator it = cl->m_owners.begin();
+            it != cl->m_owners.end(); )
+    {
+        if (it->second.ts == ts)
+        {
+            cl->m_owners.erase(it++);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    delete ts;
+}
+
+void
+client :: leg_added(const e::intrusive_ptr<pending>& op)
+{
+    if (!m_thread_safe)
+    {
+        return;
+    }
+
+    op_owner* oo = &m_owners[op->client_visible_id()];
+
+    // a read retried from within loop still belongs to its issuer
+    if (!oo->ts)
+    {
+        oo->ts = m_caller ? m_caller : this_thread();
+    }
+
+    ++oo->legs;
+    ++oo->ts->legs;
+}
+
+void
+client :: leg_removed(const e::intrusive_ptr<pending>& op)
+{
+    if (!m_thread_safe)
+    {
+        return;
+    }
+
+    owner_map_t::iterator it = m_owners.find(op->client_visible_id());
+
+    if (it == m_owners.end())
+    {
+        return;
+    }
+
+    assert(it->second.legs > 0);
+    assert(it->second.ts->legs > 0);
+    --it->second.legs;
+    --it->second.ts->legs;
+}
+
+void
+client :: op_dropped(const e::intrusive_ptr<pending>& op)
+{
+    if (!m_thread_safe)
+    {
+        return;
+    }
+
+    owner_map_t::iterator it = m_owners.find(op->client_visible_id());
+
+    if (it != m_owners.end() && it->second.legs == 0)
+    {
+        m_owners.erase(it);
+    }
+}
+
+void
+client :: route_completions(thread_state* self)
+{
+    bool others = false;
+
+    while (!m_failed.empty())
+    {
+        const pending_server_pair psp(m_failed.front());
+        m_failed.pop_front();
+        psp.op->handle_failure(psp.si, psp.vsi);
+        leg_removed(psp.op);
+        m_yieldable.push_back(psp.op);
+    }
+
+    while (!m_yieldable.empty())
+    {
+        e::intrusive_ptr<pending> op = m_yieldable.front();
+        m_yieldable.pop_front();
+        owner_map_t::iterator it = m_owners.find(op->client_visible_id());
+        thread_state* ts = it != m_owners.end() ? it->second.ts : self;
+        ts->ready.push_back(op);
+        others = others || ts != self;
+
+        if (it != m_owners.end() && it->second.legs == 0)
+        {
+            m_owners.erase(it);
+        }
+    }
+
+    if (others && m_waiters > 0)
+    {
+        m_cond.broadcast();
+    }
+}
+
+bool
+client :: route_failure(const e::intrusive_ptr<pending>& op,
+                        hyperdex_client_returncode status)
+{
+    if (!m_thread_safe)
+    {
+        return false;
+    }
+
+    owner_map_t::iterator it = m_owners.find(op->client_visible_id());
+
+    if (it == m_owners.end() || it->second.ts == m_caller)
+    {
+        return false;
+    }
+
+    it->second.ts->failures.push_back(std::make_pair(status, m_last_error));
+    m_last_error = e::error();
+
+    if (m_waiters > 0)
+    {
+        m_cond.broadcast();
+    }
+
+    return true;
+}
+
 microtransaction* client::uxact_init(const char* space, hyperdex_client_returncode *status)
 {
     if (!maintain_coord_connection(status))
@@ -1517,6 +2446,158 @@ client :: set_type_conversion(bool enabled)
     m_convert_types = enabled;
 }
 
+void
+client :: set_thread_safe(bool enabled)
+{
+    if (enabled && !m_wakeup.get())
+    {
+        std::auto_ptr<e::flagfd> wakeup(new e::flagfd());
+
+        if (pthread_key_create(&m_thread_key, &client::thread_exited) != 0)
+        {
+            throw std::bad_alloc();
+        }
+
+        m_wakeup = wakeup;
+    }
+
+    m_thread_safe = enabled;
+}
+
+void
+client :: set_corking(bool enabled)
+{
+    m_corking = enabled;
+
+    if (!m_corking)
+    {
+        flush();
+    }
+}
+
+void
+client :: flush()
+{
+    while (!m_corked.empty())
+    {
+        flush_corked(m_corked.begin()->first);
+    }
+}
+
+void
+client :: flush_corked(const server_id& si)
+{
+    cork_map_t::iterator it = m_corked.find(si);
+
+    if (it == m_corked.end())
+    {
+        return;
+    }
+
+    std::vector<e::buffer*> msgs;
+    msgs.swap(it->second.msgs);
+    const size_t bytes = it->second.bytes;
+    m_corked.erase(it);
+    std::auto_ptr<e::buffer> msg;
+
+    if (msgs.size() == 1)
+    {
+        msg.reset(msgs[0]);
+    }
+    else
+    {
+        const uint8_t type = static_cast<uint8_t>(REQ_BATCH);
+        const uint8_t flags = 0;
+        const uint64_t version = m_config.version();
+        const virtual_server_id to(UINT64_MAX);
+        const uint64_t nonce = 0;
+        const uint32_t count = msgs.size();
+        size_t sz = HYPERDEX_CLIENT_HEADER_SIZE_REQ + sizeof(uint32_t) + bytes;
+        msg.reset(e::buffer::create(sz));
+        e::packer pa = msg->pack_at(BUSYBEE_HEADER_SIZE);
+        pa = pa << type << flags << version << to << nonce << count;
+
+        for (size_t i = 0; i < msgs.size(); ++i)
+        {
+            e::slice body(msgs[i]->data() + BUSYBEE_HEADER_SIZE,
+                          msgs[i]->size() - BUSYBEE_HEADER_SIZE);
+            pa = pa << body;
+            delete msgs[i];
+        }
+    }
+
+    m_busybee.set_timeout(-1);
+    busybee_returncode rc = m_busybee.send(si.get(), msg);
+
+    // the requests' operations already count as sent; fail them the way a
+    // lost connection would
+    if (rc != BUSYBEE_SUCCESS)
+    {
+        handle_disruption(si);
+    }
+}
+
+void
+client :: drop_corked(const server_id& si)
+{
+    cork_map_t::iterator it = m_corked.find(si);
+
+    if (it == m_corked.end())
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < it->second.msgs.size(); ++i)
+    {
+        delete it->second.msgs[i];
+    }
+
+    m_corked.erase(it);
+}
+
+client :: api_guard :: api_guard(client* cl)
+    : m_cl(cl)
+    , m_locked(cl->m_thread_safe)
+    , m_first_id(0)
+{
+    if (m_locked)
+    {
+        m_cl->m_mtx.lock();
+        m_cl->m_caller = m_cl->this_thread();
+        m_first_id = m_cl->m_next_client_id;
+    }
+}
+
+client :: api_guard :: ~api_guard() throw ()
+{
+    if (!m_locked)
+    {
+        return;
+    }
+
+    thread_state* ts = m_cl->this_thread();
+
+    // operations that completed without ever reaching a server
+    for (std::list<e::intrusive_ptr<pending> >::iterator it = m_cl->m_yieldable.begin();
+            it != m_cl->m_yieldable.end(); ++it)
+    {
+        if ((*it)->client_visible_id() >= m_first_id)
+        {
+            m_cl->m_owners[(*it)->client_visible_id()].ts = ts;
+        }
+    }
+
+    ts->last_error = m_cl->m_last_error;
+    m_cl->m_caller = NULL;
+
+    if (m_cl->m_waiters > 0)
+    {
+        m_cl->m_cond.broadcast();
+    }
+
+    m_cl->m_mtx.unlock();
+}
+
 int64_t
 microtransaction::generate_message(size_t header_sz, size_t footer_sz,
                                    const std::vector<attribute_check>& checks,
@@ -30,9 +30,17 @@
 #ifndef hyperdex_client_client_h_
 #define hyperdex_client_client_h_
 
+// POSIX
+#include <pthread.h>
+
 // STL
 #include <map>
 #include <list>
+#include <set>
+
+// po6
+#include <po6/threads/cond.h>
+#include <po6/threads/mutex.h>
 
 // BusyBee
 #include <busybee_st.h>
@@ -90,6 +98,12 @@ class client
         int64_t get(const char* space, const char* key, size_t key_sz,
                     hyperdex_client_returncode* status,
                     const hyperdex_client_attribute** attrs, size_t* attrs_sz);
+        // statuses, attrs and attrs_sz each have one entry per key
+        int64_t get_many(const char* space,
+                         const char** keys, const size_t* keys_sz, size_t num_keys,
+                         hyperdex_client_returncode* status,
+                         hyperdex_client_returncode* statuses,
+                         const hyperdex_client_attribute** attrs, size_t* attrs_sz);
         int64_t get_partial(const char* space, const char* key, size_t key_sz,
                             const char** attrnames, size_t attrnames_sz,
                             hyperdex_client_returncode* status,
@@ -98,6 +112,11 @@ class client
                        const hyperdex_client_attribute_check* checks, size_t checks_sz,
                        hyperdex_client_returncode* status,
                        const hyperdex_client_attribute** attrs, size_t* attrs_sz);
+        int64_t search_partial(const char* space,
+                               const hyperdex_client_attribute_check* checks, size_t checks_sz,
+                               const char** attrnames, size_t attrnames_sz,
+                               hyperdex_client_returncode* status,
+                               const hyperdex_client_attribute** attrs, size_t* attrs_sz);
         int64_t search_describe(const char* space,
                                 const hyperdex_client_attribute_check* checks, size_t checks_sz,
                                 hyperdex_client_returncode* status, const char** description);
@@ -108,12 +127,24 @@ class client
                               bool maximize,
                               hyperdex_client_returncode* status,
                               const hyperdex_client_attribute** attrs, size_t* attrs_sz);
+        int64_t sorted_search_partial(const char* space,
+                                      const hyperdex_client_attribute_check* checks, size_t checks_sz,
+                                      const char** attrnames, size_t attrnames_sz,
+                                      const char* sort_by,
+                                      uint64_t limit,
+                                      bool maximize,
+                                      hyperdex_client_returncode* status,
+                                      const hyperdex_client_attribute** attrs, size_t* attrs_sz);
         int64_t group_del(const char* space,
                           const hyperdex_client_attribute_check* checks, size_t checks_sz,
                           hyperdex_client_returncode* status);
         int64_t count(const char* space,
                       const hyperdex_client_attribute_check* checks, size_t checks_sz,
                       hyperdex_client_returncode* status, uint64_t* result);
+        int64_t aggregate(const char* space,
+                          const hyperdex_client_attribute_check* checks, size_t checks_sz,
+                          hyperdex_client_aggregate_spec* aggs, size_t aggs_sz,
+                          hyperdex_client_returncode* status);
 
         // General keyop call
         // This will be called by the bindings from c.cc
@@ -161,6 +192,11 @@ class client
 
         // looping/polling
         int64_t loop(int timeout, hyperdex_client_returncode* status);
+        // Reap up to n operations, waiting up to timeout for the first;
+        // ids[i]/statuses[i] are what the i-th call to loop would return.
+        // Returns how many were reaped, or -1 (see statuses[0]) if none were.
+        int64_t loop_many(int timeout, int64_t* ids,
+                          hyperdex_client_returncode* statuses, size_t n);
         // Return the fildescriptor that hyperdex uses for networking
         int poll_fd();
         // Ensure the flagfd is set correctly
@@ -176,6 +212,17 @@ class client
                                      hyperdex_client_returncode* status);
         // enable or disable type conversion on the client-side
         void set_type_conversion(bool enabled);
+        // let many threads share this client; call before sharing it
+        // throws std::bad_alloc if the client cannot track its threads
+        void set_thread_safe(bool enabled);
+        // hold small requests and send those for the same server together
+        // on flush, on loop, or once HYPERDEX_CLIENT_CORK_BYTES accumulate
+        void set_corking(bool enabled);
+        void flush();
+
+    public:
+        // serializes one call into the client when it is thread safe
+        class api_guard;
 
     private:
         struct pending_server_pair
@@ -193,7 +240,46 @@ class client
         };
         typedef std::map<uint64_t, pending_server_pair> pending_map_t;
         typedef std::list<pending_server_pair> pending_queue_t;
+        // what each thread sharing the client sees of it; lives in
+        // m_thread_key until the thread exits
+        struct thread_state
+        {
+            thread_state(client* c)
+                : cl(c), ready(), failures(), yielding(), yielded(), last_error(), deadline(0), legs(0) {}
+            ~thread_state() throw () {}
+            client* cl;
+            std::list<e::intrusive_ptr<pending> > ready;
+            // this thread's operations that failed in another thread's loop
+            std::list<std::pair<hyperdex_client_returncode, e::error> > failures;
+            e::intrusive_ptr<pending> yielding;
+            e::intrusive_ptr<pending> yielded;
+            e::error last_error;
+            uint64_t deadline;
+            uint64_t legs;
+
+            private:
+                thread_state(const thread_state&);
+                thread_state& operator = (const thread_state&);
+        };
+        struct op_owner
+        {
+            op_owner() : ts(NULL), legs(0) {}
+            thread_state* ts;
+            uint64_t legs;
+        };
+        typedef std::set<thread_state*> thread_set_t;
+        typedef std::map<int64_t, op_owner> owner_map_t;
+        // requests held for one server while corking
+        struct corked_requests
+        {
+            corked_requests() : msgs(), bytes(0) {}
+            ~corked_requests() throw () {}
+            std::vector<e::buffer*> msgs;
+            size_t bytes;
+        };
+        typedef std::map<server_id, corked_requests> cork_map_t;
         friend class pending_get;
+        friend class pending_get_many;
         friend class pending_get_partial;
         friend class pending_search;
         friend class pending_sorted_search;
@@ -223,6 +309,12 @@ class client
                                 hyperdex_client_returncode* status,
                                 std::vector<attribute_check>* checks,
                                 std::vector<virtual_server_id>* servers);
+        // resolve attrnames to a sorted list of attribute numbers
+        bool prepare_projection(const schema& sc,
+                                const char* space,
+                                const char** attrnames, size_t attrnames_sz,
+                                hyperdex_client_returncode* status,
+                                std::vector<uint16_t>* projection);
         int64_t perform_funcall(const char* space, const schema* sc,
                                 const hyperdex_client_keyop_info* opinfo,
                                 const hyperdex_client_attribute_check* chks, size_t chks_sz,
@@ -251,6 +343,39 @@ class client
                            e::intrusive_ptr<pending> op,
                            hyperdex_client_returncode* status);
         void handle_disruption(const server_id& si);
+        // reads of spaces "with consistency stale" go to any replica of the
+        // key; one that answers with an older version than this client has
+        // already seen is retried at the point leader
+        int64_t send_stale_keyop(const char* space,
+                                 const e::slice& key,
+                                 network_msgtype mt,
+                                 std::auto_ptr<e::buffer> msg,
+                                 e::intrusive_ptr<pending> op,
+                                 hyperdex_client_returncode* status);
+        bool read_is_stale(const virtual_server_id& vsi, const e::slice& key,
+                           bool found, uint64_t version);
+        bool reread_from_leader(pending* op, network_msgtype mt,
+                                const virtual_server_id& vsi,
+                                const e::slice& key,
+                                const e::buffer& request);
+        // receive one message and hand it to its operation
+        bool recv_one(int timeout, hyperdex_client_returncode* status);
+        // send what is corked for si, as one REQ_BATCH if there is more
+        // than one request; failures fail the requests' operations
+        void flush_corked(const server_id& si);
+        void drop_corked(const server_id& si);
+        // thread-safe mode
+        int64_t loop_threaded(int timeout, hyperdex_client_returncode* status);
+        thread_state* this_thread();
+        static void thread_exited(void* ts);
+        void leg_added(const e::intrusive_ptr<pending>& op);
+        void leg_removed(const e::intrusive_ptr<pending>& op);
+        void op_dropped(const e::intrusive_ptr<pending>& op);
+        void route_completions(thread_state* self);
+        // hand the failure in m_last_error to the thread that owns op;
+        // false if that thread is the caller
+        bool route_failure(const e::intrusive_ptr<pending>& op,
+                           hyperdex_client_returncode status);
 
     private:
         replicant_client* m_coord;
@@ -275,15 +400,53 @@ class client
         e::intrusive_ptr<pending> m_yielded;
         // misc
         e::error m_last_error;
+        // an error loop_many met after reaping; reported by the next loop
+        // (thread-safe clients use the thread's failures instead)
+        hyperdex_client_returncode m_deferred_status;
+        e::error m_deferred_error;
         const char** m_macaroons;
         size_t m_macaroons_sz;
         bool m_convert_types;
+        // stale-ok reads
+        uint64_t m_next_replica;
+        std::vector<std::pair<uint64_t, uint64_t> > m_read_versions;
+        // corking
+        bool m_corking;
+        cork_map_t m_corked;
+        // thread-safe mode; everything above is protected by m_mtx
+        bool m_thread_safe;
+        po6::threads::mutex m_mtx;
+        po6::threads::cond m_cond;
+        // m_thread_key exists once m_wakeup does
+        std::auto_ptr<e::flagfd> m_wakeup;
+        pthread_key_t m_thread_key;
+        thread_state* m_caller;
+        thread_set_t m_threads;
+        owner_map_t m_owners;
+        bool m_polling;
+        uint64_t m_waiters;
 
     private:
         client(const client&);
         client& operator = (const client&);
 };
 
+class client::api_guard
+{
+    public:
+        api_guard(client* cl);
+        ~api_guard() throw ();
+
+    private:
+        client* m_cl;
+        bool m_locked;
+        int64_t m_first_id;
+
+    private:
+        api_guard(const api_guard&);
+        api_guard& operator = (const api_guard&);
+};
+
 END_HYPERDEX_NAMESPACE
 
 #endif // hyperdex_client_client_h_
@@ -42,4 +42,16 @@
                                       + sizeof(uint64_t) /*vidt*/ \
                                       + sizeof(uint64_t) /*nonce*/)
 
+// How much a daemon may pack into a single RESP_SEARCH_BATCH
+#define HYPERDEX_CLIENT_SEARCH_BATCH_ITEMS 1024
+#define HYPERDEX_CLIENT_SEARCH_BATCH_BYTES (1024 * 1024)
+
+// How many bytes of requests a corking client holds for one server before
+// sending them
+#define HYPERDEX_CLIENT_CORK_BYTES (64 * 1024)
+
+// How many objects' versions a client remembers to keep reads of spaces
+// "with consistency stale" monotonic
+#define HYPERDEX_CLIENT_READ_VERSIONS 4096
+
 #endif // hyperdex_client_constants_h_
@@ -0,0 +1,187 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+// STL
+#include <algorithm>
+
+// HyperDex
+#include "client/pending_aggregate.h"
+
+using hyperdex::pending_aggregate;
+
+pending_aggregate :: pending_aggregate(uint64_t id,
+                                       hyperdex_client_returncode* status,
+                                       const std::vector<aggregate>& aggs,
+                                       const std::vector<hyperdatatype>& types,
+                                       hyperdex_client_aggregate_spec* results)
+    : pending_aggregation(id, status)
+    , m_aggs(aggs)
+    , m_types(types)
+    , m_states()
+    , m_results(results)
+    , m_done(false)
+{
+    for (size_t i = 0; i < m_aggs.size(); ++i)
+    {
+        m_states.push_back(aggregate_state(m_aggs[i]));
+    }
+
+    set_status(HYPERDEX_CLIENT_SUCCESS);
+    set_error(e::error());
+}
+
+pending_aggregate :: ~pending_aggregate() throw ()
+{
+}
+
+bool
+pending_aggregate :: can_yield()
+{
+    return this->aggregation_done() && !m_done;
+}
+
+bool
+pending_aggregate :: yield(hyperdex_client_returncode* status, e::error* err)
+{
+    *status = HYPERDEX_CLIENT_SUCCESS;
+    *err = e::error();
+    assert(this->can_yield());
+    m_done = true;
+    fill_results();
+    return true;
+}
+
+void
+pending_aggregate :: handle_failure(const server_id& si,
+                                    const virtual_server_id& vsi)
+{
+    PENDING_ERROR(RECONFIGURE) << "reconfiguration affecting "
+                               << vsi << "/" << si;
+    return pending_aggregation::handle_failure(si, vsi);
+}
+
+bool
+pending_aggregate :: handle_message(client* cl,
+                                    const server_id& si,
+                                    const virtual_server_id& vsi,
+                                    network_msgtype mt,
+                                    std::auto_ptr<e::buffer> msg,
+                                    e::unpacker up,
+                                    hyperdex_client_returncode* status,
+                                    e::error* err)
+{
+    bool handled = pending_aggregation::handle_message(cl, si, vsi, mt, std::auto_ptr<e::buffer>(), up, status, err);
+    assert(handled);
+
+    *status = HYPERDEX_CLIENT_SUCCESS;
+    *err = e::error();
+
+    if (mt != RESP_AGGREGATE)
+    {
+        PENDING_ERROR(SERVERERROR) << "server " << vsi << " responded to AGGREGATE with " << mt;
+        return true;
+    }
+
+    std::vector<aggregate_state> states;
+    up = up >> states;
+
+    if (up.error())
+    {
+        PENDING_ERROR(SERVERERROR) << "communication error: server "
+                                   << vsi << " sent corrupt message="
+                                   << msg->as_slice().hex()
+                                   << " in response to an AGGREGATE";
+        return true;
+    }
+
+    if (states.size() != m_states.size())
+    {
+        PENDING_ERROR(SERVERERROR) << "server " << vsi << " could not compute the aggregate";
+        return true;
+    }
+
+    for (size_t i = 0; i < m_states.size(); ++i)
+    {
+        m_states[i].merge(states[i]);
+    }
+
+    // Don't set the status or error so that errors will carry through.  It was
+    // set to the success state in the constructor
+    return true;
+}
+
+void
+pending_aggregate :: fill_results()
+{
+    for (size_t i = 0; i < m_aggs.size(); ++i)
+    {
+        const aggregate_state& st(m_states[i]);
+        hyperdex_client_aggregate_spec* r = m_results + i;
+        bool is_float = m_types[i] == HYPERDATATYPE_FLOAT;
+        r->count = st.count;
+        r->int_value = 0;
+        r->float_value = 0;
+
+        if (!is_float && st.overflow &&
+            (m_aggs[i].function == aggregate::SUM ||
+             m_aggs[i].function == aggregate::AVG))
+        {
+            PENDING_ERROR(OVERFLOW) << "sum of attribute overflows an int64";
+        }
+
+        switch (m_aggs[i].function)
+        {
+            case aggregate::SUM:
+                r->int_value = st.int_sum;
+                r->float_value = st.float_sum;
+                break;
+            case aggregate::MIN:
+                r->int_value = st.count ? st.int_min : 0;
+                r->float_value = st.count ? st.float_min : 0;
+                break;
+            case aggregate::MAX:
+                r->int_value = st.count ? st.int_max : 0;
+                r->float_value = st.count ? st.float_max : 0;
+                break;
+            case aggregate::AVG:
+                if (st.count)
+                {
+                    r->float_value = is_float ? st.float_sum : st.int_sum;
+                    r->float_value /= st.count;
+                }
+                break;
+            case aggregate::HISTOGRAM:
+                std::copy(st.buckets.begin(),
+                          st.buckets.begin() + std::min(st.buckets.size(), r->buckets_sz),
+                          r->buckets);
+                break;
+            default:
+                break;
+        }
+    }
+}
@@ -41,6 +41,8 @@ pending_get :: pending_get(uint64_t id,
     , m_state(INITIALIZED)
     , m_attrs(attrs)
     , m_attrs_sz(attrs_sz)
+    , m_key()
+    , m_request()
 {
 }
 
@@ -48,10 +50,18 @@ pending_get :: ~pending_get() throw ()
 {
 }
 
+void
+pending_get :: allow_stale(const e::slice& key, std::auto_ptr<e::buffer> request)
+{
+    m_key.assign(reinterpret_cast<const char*>(key.data()), key.size());
+    m_request = request;
+}
+
 bool
 pending_get :: can_yield()
 {
-    assert(m_state == RECV || m_state == YIELDED);
+    // SENT when a stale read was retried at the point leader
+    assert(m_state != INITIALIZED);
     return m_state == RECV;
 }
 
@@ -114,6 +124,39 @@ pending_get :: handle_message(client* cl,
         return true;
     }
 
+    std::vector<e::slice> value;
+    uint64_t version = 0;
+    bool has_version = false;
+
+    if (response == NET_SUCCESS)
+    {
+        up = up >> value;
+
+        // servers that predate stale reads send no version
+        if (!up.error() && up.remain() >= sizeof(uint64_t))
+        {
+            up = up >> version;
+            has_version = true;
+        }
+    }
+
+    if (m_request.get() && !up.error() &&
+        ((response == NET_SUCCESS && has_version) || response == NET_NOTFOUND) &&
+        cl->read_is_stale(vsi, e::slice(m_key), response == NET_SUCCESS, version))
+    {
+        m_state = INITIALIZED;
+
+        if (cl->reread_from_leader(this, REQ_GET, vsi, e::slice(m_key), *m_request))
+        {
+            return true;
+        }
+
+        m_state = RECV;
+        PENDING_ERROR(RECONFIGURE) << "server " << vsi << " is behind this client"
+                                   << " and the point leader is unreachable";
+        return true;
+    }
+
     switch (static_cast<network_returncode>(response))
     {
         case NET_SUCCESS:
@@ -162,9 +205,6 @@ pending_get :: handle_message(client* cl,
             return true;
     }
 
-    std::vector<e::slice> value;
-    up = up >> value;
-
     if (up.error())
     {
         PENDING_ERROR(SERVERERROR) << "communication error: server "
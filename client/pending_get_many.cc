@@ -0,0 +1,236 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+// HyperDex
+#include "common/network_returncode.h"
+#include "client/client.h"
+#include "client/pending_get_many.h"
+#include "client/util.h"
+
+using hyperdex::pending_get_many;
+
+pending_get_many :: pending_get_many(uint64_t id,
+                                     hyperdex_client_returncode* status,
+                                     hyperdex_client_returncode* statuses,
+                                     const hyperdex_client_attribute** attrs,
+                                     size_t* attrs_sz)
+    : pending_aggregation(id, status)
+    , m_statuses(statuses)
+    , m_attrs(attrs)
+    , m_attrs_sz(attrs_sz)
+    , m_servers()
+    , m_done(false)
+{
+    set_status(HYPERDEX_CLIENT_SUCCESS);
+    set_error(e::error());
+}
+
+pending_get_many :: ~pending_get_many() throw ()
+{
+}
+
+void
+pending_get_many :: add_server(const virtual_server_id& vsi,
+                               const std::vector<size_t>& keys)
+{
+    m_servers.push_back(std::make_pair(vsi, keys));
+}
+
+bool
+pending_get_many :: can_yield()
+{
+    return this->aggregation_done() && !m_done;
+}
+
+bool
+pending_get_many :: yield(hyperdex_client_returncode* status, e::error* err)
+{
+    *status = HYPERDEX_CLIENT_SUCCESS;
+    *err = e::error();
+    assert(this->can_yield());
+    m_done = true;
+    return true;
+}
+
+void
+pending_get_many :: handle_failure(const server_id& si,
+                                   const virtual_server_id& vsi)
+{
+    fail_keys(vsi, HYPERDEX_CLIENT_RECONFIGURE);
+    PENDING_ERROR(RECONFIGURE) << "reconfiguration affecting "
+                               << vsi << "/" << si;
+    return pending_aggregation::handle_failure(si, vsi);
+}
+
+bool
+pending_get_many :: handle_message(client* cl,
+                                   const server_id& si,
+                                   const virtual_server_id& vsi,
+                                   network_msgtype mt,
+                                   std::auto_ptr<e::buffer> msg,
+                                   e::unpacker up,
+                                   hyperdex_client_returncode* status,
+                                   e::error* err)
+{
+    bool handled = pending_aggregation::handle_message(cl, si, vsi, mt, std::auto_ptr<e::buffer>(), up, status, err);
+    assert(handled);
+
+    *status = HYPERDEX_CLIENT_SUCCESS;
+    *err = e::error();
+    const std::vector<size_t>* keys = keys_for(vsi);
+
+    if (!keys)
+    {
+        return true;
+    }
+
+    if (mt != RESP_GET_MANY)
+    {
+        fail_keys(vsi, HYPERDEX_CLIENT_SERVERERROR);
+        PENDING_ERROR(SERVERERROR) << "server " << vsi << " responded to GET_MANY with " << mt;
+        return true;
+    }
+
+    uint32_t num;
+    up = up >> num;
+
+    if (up.error() || num != keys->size())
+    {
+        fail_keys(vsi, HYPERDEX_CLIENT_SERVERERROR);
+        PENDING_ERROR(SERVERERROR) << "communication error: server "
+                                   << vsi << " sent corrupt message="
+                                   << msg->as_slice().hex()
+                                   << " in response to a GET_MANY";
+        return true;
+    }
+
+    for (size_t i = 0; i < keys->size(); ++i)
+    {
+        const size_t idx = (*keys)[i];
+        uint16_t response;
+        up = up >> response;
+
+        if (up.error())
+        {
+            fail_keys(vsi, HYPERDEX_CLIENT_SERVERERROR);
+            PENDING_ERROR(SERVERERROR) << "communication error: server "
+                                       << vsi << " sent corrupt message="
+                                       << msg->as_slice().hex()
+                                       << " in response to a GET_MANY";
+            return true;
+        }
+
+        switch (static_cast<network_returncode>(response))
+        {
+            case NET_SUCCESS:
+                break;
+            case NET_NOTFOUND:
+                m_statuses[idx] = HYPERDEX_CLIENT_NOTFOUND;
+                continue;
+            case NET_NOTUS:
+                m_statuses[idx] = HYPERDEX_CLIENT_RECONFIGURE;
+                continue;
+            case NET_UNAUTHORIZED:
+                m_statuses[idx] = HYPERDEX_CLIENT_UNAUTHORIZED;
+                continue;
+            case NET_BADDIMSPEC:
+            case NET_READONLY:
+            case NET_SERVERERROR:
+            case NET_CMPFAIL:
+            case NET_OVERFLOW:
+            default:
+                m_statuses[idx] = HYPERDEX_CLIENT_SERVERERROR;
+                continue;
+        }
+
+        std::vector<e::slice> value;
+        up = up >> value;
+
+        if (up.error())
+        {
+            fail_keys(vsi, HYPERDEX_CLIENT_SERVERERROR);
+            PENDING_ERROR(SERVERERROR) << "communication error: server "
+                                       << vsi << " sent corrupt message="
+                                       << msg->as_slice().hex()
+                                       << " in response to a GET_MANY";
+            return true;
+        }
+
+        hyperdex_client_returncode op_status;
+        e::error op_error;
+
+        if (!value_to_attributes(cl->m_config,
+                                 cl->m_config.get_region_id(vsi),
+                                 NULL, 0, value, &op_status, &op_error,
+                                 m_attrs + idx, m_attrs_sz + idx,
+                                 cl->m_convert_types))
+        {
+            m_statuses[idx] = op_status;
+            set_error(op_error);
+            continue;
+        }
+
+        m_statuses[idx] = HYPERDEX_CLIENT_SUCCESS;
+    }
+
+    // Don't set the status or error so that errors will carry through.  It was
+    // set to the success state in the constructor
+    return true;
+}
+
+const std::vector<size_t>*
+pending_get_many :: keys_for(const virtual_server_id& vsi)
+{
+    for (size_t i = 0; i < m_servers.size(); ++i)
+    {
+        if (m_servers[i].first == vsi)
+        {
+            return &m_servers[i].second;
+        }
+    }
+
+    return NULL;
+}
+
+void
+pending_get_many :: fail_keys(const virtual_server_id& vsi,
+                              hyperdex_client_returncode rc)
+{
+    const std::vector<size_t>* keys = keys_for(vsi);
+
+    for (size_t i = 0; keys && i < keys->size(); ++i)
+    {
+        const size_t idx = (*keys)[i];
+
+        // keys decoded before a reply turned out corrupt keep their result
+        if (m_statuses[idx] == HYPERDEX_CLIENT_GARBAGE)
+        {
+            m_statuses[idx] = rc;
+        }
+    }
+}
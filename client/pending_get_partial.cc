@@ -25,6 +25,9 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+// e
+#include <e/endian.h>
+
 // HyperClient
 #include "common/network_returncode.h"
 #include "client/client.h"
@@ -41,6 +44,8 @@ pending_get_partial :: pending_get_partial(uint64_t id,
     , m_state(INITIALIZED)
     , m_attrs(attrs)
     , m_attrs_sz(attrs_sz)
+    , m_key()
+    , m_request()
 {
 }
 
@@ -48,10 +53,18 @@ pending_get_partial :: ~pending_get_partial() throw ()
 {
 }
 
+void
+pending_get_partial :: allow_stale(const e::slice& key, std::auto_ptr<e::buffer> request)
+{
+    m_key.assign(reinterpret_cast<const char*>(key.data()), key.size());
+    m_request = request;
+}
+
 bool
 pending_get_partial :: can_yield()
 {
-    assert(m_state == RECV || m_state == YIELDED);
+    // SENT when a stale read was retried at the point leader
+    assert(m_state != INITIALIZED);
     return m_state == RECV;
 }
 
@@ -114,6 +127,46 @@ pending_get_partial :: handle_message(client* cl,
         return true;
     }
 
+    std::vector<std::pair<uint16_t, e::slice> > value;
+    uint64_t version = 0;
+    // servers that predate stale reads send no version
+    bool has_version = false;
+
+    while (response == NET_SUCCESS && up.remain() && !up.error())
+    {
+        uint16_t attr_n;
+        e::slice attr_s;
+        up = up >> attr_n >> attr_s;
+
+        if (attr_n == HYPERDEX_ATTRIBUTE_VERSION &&
+            attr_s.size() == sizeof(uint64_t))
+        {
+            e::unpack64be(attr_s.data(), &version);
+            has_version = true;
+        }
+        else
+        {
+            value.push_back(std::make_pair(attr_n, attr_s));
+        }
+    }
+
+    if (m_request.get() && !up.error() &&
+        ((response == NET_SUCCESS && has_version) || response == NET_NOTFOUND) &&
+        cl->read_is_stale(vsi, e::slice(m_key), response == NET_SUCCESS, version))
+    {
+        m_state = INITIALIZED;
+
+        if (cl->reread_from_leader(this, REQ_GET_PARTIAL, vsi, e::slice(m_key), *m_request))
+        {
+            return true;
+        }
+
+        m_state = RECV;
+        PENDING_ERROR(RECONFIGURE) << "server " << vsi << " is behind this client"
+                                   << " and the point leader is unreachable";
+        return true;
+    }
+
     switch (static_cast<network_returncode>(response))
     {
         case NET_SUCCESS:
@@ -162,16 +215,6 @@ pending_get_partial :: handle_message(client* cl,
             return true;
     }
 
-    std::vector<std::pair<uint16_t, e::slice> > value;
-
-    while (up.remain() && !up.error())
-    {
-        uint16_t attr_n;
-        e::slice attr_s;
-        up = up >> attr_n >> attr_s;
-        value.push_back(std::make_pair(attr_n, attr_s));
-    }
-
     if (up.error())
     {
         PENDING_ERROR(SERVERERROR) << "communication error: server "
@@ -28,6 +28,9 @@
 #ifndef hyperdex_client_pending_get_partial_h_
 #define hyperdex_client_pending_get_partial_h_
 
+// STL
+#include <string>
+
 // HyperDex
 #include "namespace.h"
 #include "client/pending.h"
@@ -42,6 +45,11 @@ class pending_get_partial : public pending
                             const hyperdex_client_attribute** attrs, size_t* attrs_sz);
         virtual ~pending_get_partial() throw ();
 
+    public:
+        // the read may be served by any replica; request is kept to retry
+        // it at the point leader
+        void allow_stale(const e::slice& key, std::auto_ptr<e::buffer> request);
+
     // return to client
     public:
         virtual bool can_yield();
@@ -71,6 +79,8 @@ class pending_get_partial : public pending
         enum { INITIALIZED, SENT, RECV, YIELDED } m_state;
         const hyperdex_client_attribute** m_attrs;
         size_t* m_attrs_sz;
+        std::string m_key;
+        std::auto_ptr<e::buffer> m_request;
 };
 
 END_HYPERDEX_NAMESPACE
@@ -33,14 +33,19 @@
 
 using hyperdex::pending_search;
 
-pending_search :: pending_search(uint64_t id,
+pending_search :: pending_search(client* cl,
+                                 uint64_t id,
+                                 const std::vector<uint16_t>& projection,
                                  hyperdex_client_returncode* status,
                                  const hyperdex_client_attribute** attrs, size_t* attrs_sz)
     : pending_aggregation(id, status)
+    , m_cl(cl)
+    , m_projection(projection)
     , m_attrs(attrs)
     , m_attrs_sz(attrs_sz)
     , m_yield(false)
     , m_done(false)
+    , m_items()
 {
     *m_attrs = NULL;
     *m_attrs_sz = 0;
@@ -53,7 +58,7 @@ pending_search :: ~pending_search() throw ()
 bool
 pending_search :: can_yield()
 {
-    return m_yield;
+    return m_yield || !m_items.empty();
 }
 
 bool
@@ -61,9 +66,42 @@ pending_search :: yield(hyperdex_client_returncode* status, e::error* err)
 {
     *status = HYPERDEX_CLIENT_SUCCESS;
     *err = e::error();
+
+    if (!m_yield && !m_items.empty())
+    {
+        const item& it(m_items.front());
+        hyperdex_client_returncode op_status;
+        e::error op_error;
+
+        if (!value_to_attributes(m_cl->m_config, it.ri,
+                                 it.key.data(), it.key.size(), it.value,
+                                 m_projection, m_projection,
+                                 &op_status, &op_error, m_attrs, m_attrs_sz,
+                                 m_cl->m_convert_types))
+        {
+            set_status(op_status);
+            set_error(op_error);
+        }
+        else
+        {
+            set_status(HYPERDEX_CLIENT_SUCCESS);
+            set_error(e::error());
+        }
+
+        m_items.pop_front();
+
+        if (m_items.empty() && this->aggregation_done() && !m_done)
+        {
+            m_yield = true;
+            m_done = true;
+        }
+
+        return true;
+    }
+
     m_yield = false;
 
-    if (this->aggregation_done() && !m_done)
+    if (this->aggregation_done() && m_items.empty() && !m_done)
     {
         m_yield = true;
         m_done = true;
@@ -104,7 +142,52 @@ pending_search :: handle_message(client* cl,
 
     if (mt == RESP_SEARCH_DONE)
     {
-        if (this->aggregation_done())
+        if (this->aggregation_done() && m_items.empty())
+        {
+            m_yield = true;
+            m_done = true;
+        }
+
+        return true;
+    }
+    else if (mt == RESP_SEARCH_BATCH)
+    {
+        uint8_t flags = 0;
+        uint64_t num_items = 0;
+        up = up >> flags >> num_items;
+        region_id ri(cl->m_config.get_region_id(vsi));
+        e::compat::shared_ptr<e::buffer> backing(msg.release());
+        std::list<item> items;
+
+        for (uint64_t i = 0; !up.error() && i < num_items; ++i)
+        {
+            e::slice key;
+            std::vector<e::slice> value;
+            up = up >> key >> value;
+            items.push_back(item(ri, key, value, backing));
+        }
+
+        if (up.error())
+        {
+            PENDING_ERROR(SERVERERROR) << "communication error: server "
+                                       << vsi << " sent corrupt message="
+                                       << backing->as_slice().hex()
+                                       << " in response to a SEARCH";
+            m_yield = true;
+            return true;
+        }
+
+        m_items.splice(m_items.end(), items);
+        const bool done = flags & 0x1;
+
+        // Ask for the next batch now, so that it is in flight while the
+        // application consumes this one.
+        if (!done && !send_next(cl, vsi, status))
+        {
+            return true;
+        }
+
+        if (done && this->aggregation_done() && m_items.empty())
         {
             m_yield = true;
             m_done = true;
@@ -139,6 +222,7 @@ pending_search :: handle_message(client* cl,
     if (!value_to_attributes(cl->m_config,
                              cl->m_config.get_region_id(vsi),
                              key.data(), key.size(), value,
+                             m_projection, m_projection,
                              &op_status, &op_error, m_attrs, m_attrs_sz, cl->m_convert_types))
     {
         set_status(op_status);
@@ -147,6 +231,21 @@ pending_search :: handle_message(client* cl,
         return true;
     }
 
+    if (!send_next(cl, vsi, status))
+    {
+        return true;
+    }
+
+    set_status(HYPERDEX_CLIENT_SUCCESS);
+    set_error(e::error());
+    m_yield = true;
+    return true;
+}
+
+bool
+pending_search :: send_next(client* cl, const virtual_server_id& vsi,
+                            hyperdex_client_returncode* status)
+{
     std::auto_ptr<e::buffer> smsg(e::buffer::create(HYPERDEX_CLIENT_HEADER_SIZE_REQ + sizeof(uint64_t)));
     smsg->pack_at(HYPERDEX_CLIENT_HEADER_SIZE_REQ) << static_cast<uint64_t>(client_visible_id());
 
@@ -154,11 +253,53 @@ pending_search :: handle_message(client* cl,
     {
         PENDING_ERROR(RECONFIGURE) << "could not send SEARCH_NEXT to " << vsi;
         m_yield = true;
-        return true;
+        return false;
     }
 
-    set_status(HYPERDEX_CLIENT_SUCCESS);
-    set_error(e::error());
-    m_yield = true;
     return true;
 }
+
+pending_search :: item :: item()
+    : ri()
+    , key()
+    , value()
+    , backing()
+{
+}
+
+pending_search :: item :: item(const region_id& _ri,
+                               const e::slice& _key,
+                               const std::vector<e::slice>& _value,
+                               e::compat::shared_ptr<e::buffer> _backing)
+    : ri(_ri)
+    , key(_key)
+    , value(_value)
+    , backing(_backing)
+{
+}
+
+pending_search :: item :: item(const item& other)
+    : ri(other.ri)
+    , key(other.key)
+    , value(other.value)
+    , backing(other.backing)
+{
+}
+
+pending_search :: item :: ~item() throw ()
+{
+}
+
+pending_search::item&
+pending_search :: item :: operator = (const item& other)
+{
+    if (this != &other)
+    {
+        ri = other.ri;
+        key = other.key;
+        value = other.value;
+        backing = other.backing;
+    }
+
+    return *this;
+}
@@ -28,6 +28,13 @@
 #ifndef hyperdex_client_pending_search_h_
 #define hyperdex_client_pending_search_h_
 
+// STL
+#include <list>
+#include <vector>
+
+// e
+#include <e/compat.h>
+
 // HyperDex
 #include "namespace.h"
 #include "client/pending_aggregation.h"
@@ -37,7 +44,9 @@ BEGIN_HYPERDEX_NAMESPACE
 class pending_search : public pending_aggregation
 {
     public:
-        pending_search(uint64_t client_visible_id,
+        pending_search(client* cl,
+                       uint64_t client_visible_id,
+                       const std::vector<uint16_t>& projection,
                        hyperdex_client_returncode* status,
                        const hyperdex_client_attribute** attrs, size_t* attrs_sz);
         virtual ~pending_search() throw ();
@@ -60,16 +69,49 @@ class pending_search : public pending_aggregation
                                     hyperdex_client_returncode* status,
                                     e::error* error);
 
+    public:
+        class item;
+
     // noncopyable
     private:
         pending_search(const pending_search& other);
         pending_search& operator = (const pending_search& rhs);
 
     private:
+        bool send_next(client* cl, const virtual_server_id& vsi,
+                       hyperdex_client_returncode* status);
+
+    private:
+        client* m_cl;
+        // attributes to return besides the key; empty means all
+        const std::vector<uint16_t> m_projection;
         const hyperdex_client_attribute** m_attrs;
         size_t* m_attrs_sz;
         bool m_yield;
         bool m_done;
+        // items received in a RESP_SEARCH_BATCH, but not yet returned
+        std::list<item> m_items;
+};
+
+class pending_search :: item
+{
+    public:
+        item();
+        item(const region_id& ri,
+             const e::slice& key,
+             const std::vector<e::slice>& value,
+             e::compat::shared_ptr<e::buffer> backing);
+        item(const item&);
+        ~item() throw ();
+
+    public:
+        item& operator = (const item&);
+
+    public:
+        region_id ri;
+        e::slice key;
+        std::vector<e::slice> value;
+        e::compat::shared_ptr<e::buffer> backing;
 };
 
 END_HYPERDEX_NAMESPACE
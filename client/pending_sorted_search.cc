@@ -29,7 +29,9 @@
 #include <algorithm>
 
 // HyperDex
+#include "common/serialization.h"
 #include "client/client.h"
+#include "client/constants.h"
 #include "client/pending_sorted_search.h"
 #include "client/util.h"
 
@@ -42,6 +44,8 @@ pending_sorted_search :: pending_sorted_search(client* cl,
                                                uint64_t limit,
                                                uint16_t sort_by_idx,
                                                datatype_info* sort_by_di,
+                                               std::auto_ptr<e::buffer> request,
+                                               const std::vector<uint16_t>& wanted,
                                                hyperdex_client_returncode* status,
                                                const hyperdex_client_attribute** attrs,
                                                size_t* attrs_sz)
@@ -55,9 +59,28 @@ pending_sorted_search :: pending_sorted_search(client* cl,
     , m_sort_by_di(sort_by_di)
     , m_attrs(attrs)
     , m_attrs_sz(attrs_sz)
+    , m_request(request)
+    , m_checks()
+    , m_projection()
+    , m_wanted(wanted)
+    , m_sort_by_pos(sort_by_idx)
+    , m_candidates()
+    , m_next_candidate(0)
     , m_results()
     , m_results_idx()
 {
+    uint64_t _limit;
+    uint16_t _sort_by;
+    int8_t _flags;
+    e::unpacker up = m_request->unpack_from(HYPERDEX_CLIENT_HEADER_SIZE_REQ);
+    up = up >> m_checks >> _limit >> _sort_by >> _flags >> m_projection;
+    assert(!up.error());
+
+    if (!m_projection.empty() && m_sort_by_idx > 0)
+    {
+        m_sort_by_pos = std::lower_bound(m_projection.begin(), m_projection.end(), m_sort_by_idx)
+                      - m_projection.begin() + 1;
+    }
 }
 
 pending_sorted_search :: ~pending_sorted_search() throw ()
@@ -93,7 +116,8 @@ pending_sorted_search :: yield(hyperdex_client_returncode* status, e::error* err
     ++m_results_idx;
 
     if (!value_to_attributes(m_cl->m_config, m_ri, key.data(), key.size(),
-                             value, &op_status, &op_error, m_attrs, m_attrs_sz, m_cl->m_convert_types))
+                             value, m_projection, m_wanted,
+                             &op_status, &op_error, m_attrs, m_attrs_sz, m_cl->m_convert_types))
     {
         set_status(op_status);
         set_error(op_error);
@@ -140,6 +164,8 @@ class sorted_search_comparator
     public:
         bool operator () (const pending_sorted_search::item& lhs,
                           const pending_sorted_search::item& rhs);
+        bool operator () (const pending_sorted_search::candidate& lhs,
+                          const pending_sorted_search::candidate& rhs);
 
     private:
         bool m_maximize;
@@ -187,6 +213,21 @@ sorted_search_comparator :: operator () (const pending_sorted_search::item& lhs,
     return m_maximize ? (cmp > 0) : (cmp < 0);
 }
 
+bool
+sorted_search_comparator :: operator () (const pending_sorted_search::candidate& lhs,
+                                         const pending_sorted_search::candidate& rhs)
+{
+    int cmp = m_sort_by_di->compare(lhs.attr, rhs.attr);
+    return m_maximize ? (cmp > 0) : (cmp < 0);
+}
+
+static bool
+compare_candidate_servers(const pending_sorted_search::candidate& lhs,
+                          const pending_sorted_search::candidate& rhs)
+{
+    return lhs.vsi < rhs.vsi;
+}
+
 bool
 pending_sorted_search :: handle_message(client* cl,
                                         const server_id& si,
@@ -203,30 +244,112 @@ pending_sorted_search :: handle_message(client* cl,
     *status = HYPERDEX_CLIENT_SUCCESS;
     *err = e::error();
 
-    if (mt != RESP_SORTED_SEARCH)
+    if (mt == RESP_SORTED_SEARCH_KEYS)
+    {
+        if (!handle_keys(vsi, msg, up))
+        {
+            return true;
+        }
+    }
+    else if (mt == RESP_SORTED_SEARCH)
+    {
+        if (!handle_objects(vsi, msg, up))
+        {
+            return true;
+        }
+    }
+    else
     {
         PENDING_ERROR(SERVERERROR) << "server " << vsi << " responded to SORTED_SEARCH with " << mt;
         m_yield = true;
         return true;
     }
 
+    m_yield = this->aggregation_done();
+    set_status(HYPERDEX_CLIENT_SUCCESS);
+    set_error(e::error());
+
+    // Fetch the best candidates once every server has sent its own.  A
+    // server may return fewer objects than asked for, because some were
+    // deleted or changed since the first phase; refill from the runners-up
+    // until there are enough results or no candidates left.
+    if (m_yield &&
+        m_results.size() < m_limit &&
+        m_next_candidate < m_candidates.size())
+    {
+        m_yield = false;
+
+        if (m_next_candidate == 0)
+        {
+            sorted_search_comparator ssc(m_maximize, m_sort_by_pos, m_sort_by_di);
+            std::sort(m_candidates.begin(), m_candidates.end(), ssc);
+        }
+
+        if (!send_fetches(cl, m_limit - m_results.size(), status))
+        {
+            return true;
+        }
+
+        m_yield = this->aggregation_done();
+    }
+
+    if (m_yield)
+    {
+        sorted_search_comparator ssc(m_maximize, m_sort_by_pos, m_sort_by_di);
+        std::sort(m_results.begin(), m_results.end(), ssc);
+    }
+
+    return true;
+}
+
+bool
+pending_sorted_search :: handle_keys(const virtual_server_id& vsi,
+                                     std::auto_ptr<e::buffer> msg,
+                                     e::unpacker up)
+{
     uint64_t num_results = 0;
     up = up >> num_results;
+    e::compat::shared_ptr<e::buffer> backing(msg.release());
+
+    // keep every candidate; those past the limit refill a short fetch
+    for (uint64_t i = 0; !up.error() && i < num_results; ++i)
+    {
+        e::slice key;
+        e::slice attr;
+        up = up >> key >> attr;
+
+        if (up.error())
+        {
+            break;
+        }
+
+        m_candidates.push_back(candidate(vsi, key, attr, backing));
+    }
 
     if (up.error())
     {
         PENDING_ERROR(SERVERERROR) << "communication error: server "
                                    << vsi << " sent corrupt message="
-                                   << msg->as_slice().hex()
+                                   << backing->as_slice().hex()
                                    << " in response to a SORTED_SEARCH";
         m_yield = true;
-        return true;
+        return false;
     }
 
-    sorted_search_comparator ssc(m_maximize, m_sort_by_idx, m_sort_by_di);
+    return true;
+}
+
+bool
+pending_sorted_search :: handle_objects(const virtual_server_id& vsi,
+                                        std::auto_ptr<e::buffer> msg,
+                                        e::unpacker up)
+{
+    uint64_t num_results = 0;
+    up = up >> num_results;
+    sorted_search_comparator ssc(m_maximize, m_sort_by_pos, m_sort_by_di);
     e::compat::shared_ptr<e::buffer> backing(msg.release());
 
-    for (uint64_t i = 0; i < num_results; ++i)
+    for (uint64_t i = 0; !up.error() && i < num_results; ++i)
     {
         e::slice key;
         std::vector<e::slice> value;
@@ -234,12 +357,16 @@ pending_sorted_search :: handle_message(client* cl,
 
         if (up.error())
         {
-            PENDING_ERROR(SERVERERROR) << "communication error: server "
-                                       << vsi << " sent corrupt message="
-                                       << msg->as_slice().hex()
-                                       << " in response to a SORTED_SEARCH";
+            break;
+        }
+
+        if (!project_value(*m_cl->m_config.get_schema(m_cl->m_config.get_region_id(vsi)),
+                           m_projection, &value))
+        {
+            PENDING_ERROR(SERVERERROR) << "server " << vsi << " returned an object with "
+                                       << value.size() << " attributes in response to a SORTED_SEARCH";
             m_yield = true;
-            return true;
+            return false;
         }
 
         m_results.push_back(item(key, value, backing));
@@ -252,13 +379,56 @@ pending_sorted_search :: handle_message(client* cl,
         }
     }
 
-    m_yield = this->aggregation_done();
-    set_status(HYPERDEX_CLIENT_SUCCESS);
-    set_error(e::error());
+    if (up.error())
+    {
+        PENDING_ERROR(SERVERERROR) << "communication error: server "
+                                   << vsi << " sent corrupt message="
+                                   << backing->as_slice().hex()
+                                   << " in response to a SORTED_SEARCH";
+        m_yield = true;
+        return false;
+    }
 
-    if (m_yield)
+    return true;
+}
+
+bool
+pending_sorted_search :: send_fetches(client* cl, size_t n,
+                                      hyperdex_client_returncode* status)
+{
+    n = std::min(n, m_candidates.size() - m_next_candidate);
+    std::vector<candidate> winners(m_candidates.begin() + m_next_candidate,
+                                   m_candidates.begin() + m_next_candidate + n);
+    m_next_candidate += n;
+    std::stable_sort(winners.begin(), winners.end(), compare_candidate_servers);
+    size_t start = 0;
+
+    while (start < winners.size())
     {
-        std::sort(m_results.begin(), m_results.end(), ssc);
+        size_t limit = start;
+        std::vector<e::slice> keys;
+
+        while (limit < winners.size() && winners[limit].vsi == winners[start].vsi)
+        {
+            keys.push_back(winners[limit].key);
+            ++limit;
+        }
+
+        size_t sz = HYPERDEX_CLIENT_HEADER_SIZE_REQ
+                  + pack_size(m_checks)
+                  + pack_size(keys)
+                  + pack_size(m_projection);
+        std::auto_ptr<e::buffer> msg(e::buffer::create(sz));
+        msg->pack_at(HYPERDEX_CLIENT_HEADER_SIZE_REQ) << m_checks << keys << m_projection;
+
+        if (!cl->send(REQ_SORTED_SEARCH_FETCH, winners[start].vsi, cl->m_next_server_nonce++, msg, this, status))
+        {
+            PENDING_ERROR(RECONFIGURE) << "could not send SORTED_SEARCH_FETCH to " << winners[start].vsi;
+            m_yield = true;
+            return false;
+        }
+
+        start = limit;
     }
 
     return true;
@@ -296,3 +466,48 @@ pending_sorted_search :: item :: operator = (const item& other)
 
     return *this;
 }
+
+pending_sorted_search :: candidate :: candidate()
+    : vsi()
+    , key()
+    , attr()
+    , backing()
+{
+}
+
+pending_sorted_search :: candidate :: candidate(const virtual_server_id& _vsi,
+                                                const e::slice& _key,
+                                                const e::slice& _attr,
+                                                e::compat::shared_ptr<e::buffer> _backing)
+    : vsi(_vsi)
+    , key(_key)
+    , attr(_attr)
+    , backing(_backing)
+{
+}
+
+pending_sorted_search :: candidate :: candidate(const candidate& other)
+    : vsi(other.vsi)
+    , key(other.key)
+    , attr(other.attr)
+    , backing(other.backing)
+{
+}
+
+pending_sorted_search :: candidate :: ~candidate() throw ()
+{
+}
+
+pending_sorted_search::candidate&
+pending_sorted_search :: candidate :: operator = (const candidate& other)
+{
+    if (this != &other)
+    {
+        vsi = other.vsi;
+        key = other.key;
+        attr = other.attr;
+        backing = other.backing;
+    }
+
+    return *this;
+}
@@ -28,11 +28,17 @@
 #ifndef hyperdex_client_pending_sorted_search_h_
 #define hyperdex_client_pending_sorted_search_h_
 
+// STL
+#include <memory>
+#include <vector>
+
 // e
+#include <e/buffer.h>
 #include <e/compat.h>
 
 // HyperDex
 #include "namespace.h"
+#include "common/attribute_check.h"
 #include "common/datatype_info.h"
 #include "client/pending_aggregation.h"
 
@@ -47,6 +53,8 @@ class pending_sorted_search : public pending_aggregation
                               uint64_t limit,
                               uint16_t sort_by_idx,
                               datatype_info* sort_by_di,
+                              std::auto_ptr<e::buffer> request,
+                              const std::vector<uint16_t>& wanted,
                               hyperdex_client_returncode* status,
                               const hyperdex_client_attribute** attrs,
                               size_t* attrs_sz);
@@ -74,6 +82,19 @@ class pending_sorted_search : public pending_aggregation
 
     public:
         class item;
+        class candidate;
+
+    private:
+        bool handle_keys(const virtual_server_id& vsi,
+                         std::auto_ptr<e::buffer> msg,
+                         e::unpacker up);
+        bool handle_objects(const virtual_server_id& vsi,
+                            std::auto_ptr<e::buffer> msg,
+                            e::unpacker up);
+        // ask each server for the full objects of the next n candidates in
+        // sorted order
+        bool send_fetches(client* cl, size_t n,
+                          hyperdex_client_returncode* status);
 
     // noncopyable
     private:
@@ -90,10 +111,41 @@ class pending_sorted_search : public pending_aggregation
         datatype_info* m_sort_by_di;
         const hyperdex_client_attribute** m_attrs;
         size_t* m_attrs_sz;
+        // the REQ_SORTED_SEARCH body; m_checks points into it
+        const std::auto_ptr<e::buffer> m_request;
+        std::vector<attribute_check> m_checks;
+        // attributes the servers return (empty means all), the subset the
+        // application asked for, and where the sort attribute is in values
+        std::vector<uint16_t> m_projection;
+        const std::vector<uint16_t> m_wanted;
+        uint16_t m_sort_by_pos;
+        std::vector<candidate> m_candidates;
+        size_t m_next_candidate;
         std::vector<item> m_results;
         size_t m_results_idx;
 };
 
+class pending_sorted_search :: candidate
+{
+    public:
+        candidate();
+        candidate(const virtual_server_id& vsi,
+                  const e::slice& key,
+                  const e::slice& attr,
+                  e::compat::shared_ptr<e::buffer> backing);
+        candidate(const candidate&);
+        ~candidate() throw ();
+
+    public:
+        candidate& operator = (const candidate&);
+
+    public:
+        virtual_server_id vsi;
+        e::slice key;
+        e::slice attr;
+        e::compat::shared_ptr<e::buffer> backing;
+};
+
 class pending_sorted_search :: item
 {
     public:
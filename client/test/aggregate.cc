@@ -0,0 +1,180 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#define __STDC_LIMIT_MACROS
+
+// C
+#include <stdint.h>
+
+// STL
+#include <memory>
+#include <vector>
+
+// e
+#include <e/buffer.h>
+
+// HyperDex
+#include "test/th.h"
+#include "common/aggregate.h"
+#include "common/datatype_float.h"
+#include "common/datatype_int64.h"
+#include "common/serialization.h"
+
+using hyperdex::aggregate;
+using hyperdex::aggregate_state;
+using hyperdex::datatype_float;
+using hyperdex::datatype_int64;
+
+namespace
+{
+
+aggregate
+histogram(double start, double width, uint64_t buckets)
+{
+    aggregate agg;
+    agg.attr = 1;
+    agg.function = aggregate::HISTOGRAM;
+    agg.bucket_start = start;
+    agg.bucket_width = width;
+    agg.buckets = buckets;
+    return agg;
+}
+
+void
+add_int(const aggregate& agg, aggregate_state* st, int64_t x)
+{
+    std::vector<char> scratch;
+    e::slice value;
+    datatype_int64::pack(x, &scratch, &value);
+    st->add(agg, HYPERDATATYPE_INT64, value);
+}
+
+void
+add_float(const aggregate& agg, aggregate_state* st, double x)
+{
+    std::vector<char> scratch;
+    e::slice value;
+    datatype_float::pack(x, &scratch, &value);
+    st->add(agg, HYPERDATATYPE_FLOAT, value);
+}
+
+} // namespace
+
+TEST(Aggregate, MergeInts)
+{
+    aggregate agg = histogram(0, 10, 4);
+    aggregate_state a(agg);
+    aggregate_state b(agg);
+    add_int(agg, &a, 5);
+    add_int(agg, &a, 15);
+    add_int(agg, &b, -3);
+    add_int(agg, &b, 35);
+    add_int(agg, &b, 100);
+    a.merge(b);
+    ASSERT_EQ(a.count, 5U);
+    ASSERT_EQ(a.int_sum, 152);
+    ASSERT_EQ(a.int_min, -3);
+    ASSERT_EQ(a.int_max, 100);
+    ASSERT_FALSE(a.overflow);
+    ASSERT_EQ(a.buckets.size(), 4U);
+    ASSERT_EQ(a.buckets[0], 1U);
+    ASSERT_EQ(a.buckets[1], 1U);
+    ASSERT_EQ(a.buckets[2], 0U);
+    ASSERT_EQ(a.buckets[3], 1U);
+}
+
+TEST(Aggregate, MergeFloats)
+{
+    aggregate agg = histogram(-1, 1, 2);
+    aggregate_state a(agg);
+    aggregate_state b(agg);
+    add_float(agg, &a, 0.5);
+    add_float(agg, &b, -0.5);
+    add_float(agg, &b, 4.0);
+    a.merge(b);
+    ASSERT_EQ(a.count, 3U);
+    ASSERT_EQ(a.float_sum, 4.0);
+    ASSERT_EQ(a.float_min, -0.5);
+    ASSERT_EQ(a.float_max, 4.0);
+    ASSERT_EQ(a.buckets[0], 1U);
+    ASSERT_EQ(a.buckets[1], 1U);
+}
+
+TEST(Aggregate, MergeEmpty)
+{
+    aggregate agg = histogram(0, 1, 1);
+    aggregate_state a(agg);
+    aggregate_state b(agg);
+    add_int(agg, &b, 7);
+    // an empty region must not disturb min or max in either direction
+    a.merge(b);
+    b.merge(aggregate_state(agg));
+    ASSERT_EQ(a.count, 1U);
+    ASSERT_EQ(a.int_min, 7);
+    ASSERT_EQ(a.int_max, 7);
+    ASSERT_EQ(b.int_min, 7);
+    ASSERT_EQ(b.int_max, 7);
+}
+
+TEST(Aggregate, MergeOverflow)
+{
+    aggregate agg;
+    agg.attr = 1;
+    agg.function = aggregate::SUM;
+    aggregate_state a(agg);
+    aggregate_state b(agg);
+    add_int(agg, &a, INT64_MAX);
+    add_int(agg, &b, 1);
+    ASSERT_FALSE(a.overflow);
+    ASSERT_FALSE(b.overflow);
+    a.merge(b);
+    ASSERT_TRUE(a.overflow);
+    // overflow sticks through later merges
+    aggregate_state c(agg);
+    c.merge(a);
+    ASSERT_TRUE(c.overflow);
+}
+
+TEST(Aggregate, PackUnpack)
+{
+    aggregate agg = histogram(2.5, 0.5, 3);
+    aggregate_state a(agg);
+    add_float(agg, &a, 2.75);
+    add_float(agg, &a, 3.25);
+    std::auto_ptr<e::buffer> buf(e::buffer::create(pack_size(a)));
+    buf->pack_at(0) << a;
+    aggregate_state b;
+    e::unpacker up = buf->unpack_from(0);
+    up = up >> b;
+    ASSERT_FALSE(up.error());
+    ASSERT_EQ(b.count, a.count);
+    ASSERT_EQ(b.float_sum, a.float_sum);
+    ASSERT_EQ(b.float_min, a.float_min);
+    ASSERT_EQ(b.float_max, a.float_max);
+    ASSERT_EQ(b.overflow, a.overflow);
+    ASSERT_TRUE(b.buckets == a.buckets);
+}
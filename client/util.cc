@@ -198,12 +198,13 @@ hyperdex :: value_to_attributes(const configuration& config,
 
     for (size_t i = 0; i < value.size(); ++i)
     {
-        if (sc->attrs[i + 1].type == HYPERDATATYPE_MACAROON_SECRET)
+        uint16_t attr = value[i].first;
+
+        if (sc->attrs[attr].type == HYPERDATATYPE_MACAROON_SECRET)
         {
             continue;
         }
 
-        uint16_t attr = value[i].first;
         ha.push_back(hyperdex_client_attribute());
         size_t attr_sz = strlen(sc->attrs[attr].name) + 1;
         ha.back().attr = data;
@@ -224,3 +225,80 @@ hyperdex :: value_to_attributes(const configuration& config,
     g.dismiss();
     return true;
 }
+
+bool
+hyperdex :: project_value(const schema& sc,
+                          const std::vector<uint16_t>& projection,
+                          std::vector<e::slice>* value)
+{
+    if (projection.empty() || value->size() == projection.size())
+    {
+        return true;
+    }
+
+    if (value->size() + 1 != sc.attrs_sz)
+    {
+        return false;
+    }
+
+    std::vector<e::slice> projected(projection.size());
+
+    for (size_t i = 0; i < projection.size(); ++i)
+    {
+        projected[i] = (*value)[projection[i] - 1];
+    }
+
+    value->swap(projected);
+    return true;
+}
+
+bool
+hyperdex :: value_to_attributes(const configuration& config,
+                                const region_id& rid,
+                                const uint8_t* key,
+                                size_t key_sz,
+                                const std::vector<e::slice>& _value,
+                                const std::vector<uint16_t>& projection,
+                                const std::vector<uint16_t>& wanted,
+                                hyperdex_client_returncode* op_status,
+                                e::error* op_error,
+                                const hyperdex_client_attribute** attrs,
+                                size_t* attrs_sz,
+                                bool convert_types)
+{
+    if (projection.empty())
+    {
+        return value_to_attributes(config, rid, key, key_sz, _value,
+                                   op_status, op_error, attrs, attrs_sz,
+                                   convert_types);
+    }
+
+    std::vector<e::slice> value(_value);
+    const schema* sc = config.get_schema(rid);
+
+    if (!project_value(*sc, projection, &value))
+    {
+        UTIL_ERROR(SERVERERROR) << "received object with " << value.size()
+                                << " attributes instead of " << projection.size();
+        return false;
+    }
+
+    std::vector<std::pair<uint16_t, e::slice> > pairs;
+    pairs.reserve(wanted.size() + 1);
+    pairs.push_back(std::make_pair(uint16_t(0), e::slice(key, key_sz)));
+    size_t p = 0;
+
+    for (size_t i = 0; i < wanted.size(); ++i)
+    {
+        while (p < projection.size() && projection[p] < wanted[i])
+        {
+            ++p;
+        }
+
+        assert(p < projection.size() && projection[p] == wanted[i]);
+        pairs.push_back(std::make_pair(wanted[i], value[p]));
+    }
+
+    return value_to_attributes(config, rid, pairs, op_status, op_error,
+                               attrs, attrs_sz, convert_types);
+}
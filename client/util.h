@@ -63,6 +63,31 @@ value_to_attributes(const configuration& config,
                     size_t* attrs_sz,
                     bool convert_types);
 
+// Reduce a value to the attributes in projection.  Servers that honour the
+// projection send exactly those attributes; older servers send the whole
+// object.  Returns false if value is neither.  An empty projection is a no-op.
+bool
+project_value(const schema& sc,
+              const std::vector<uint16_t>& projection,
+              std::vector<e::slice>* value);
+
+// Convert a search result holding the attributes in projection (see
+// project_value) to the key plus the attributes in wanted, which must be a
+// subset of projection.  An empty projection returns the whole object.
+bool
+value_to_attributes(const configuration& config,
+                    const region_id& rid,
+                    const uint8_t* key,
+                    size_t key_sz,
+                    const std::vector<e::slice>& value,
+                    const std::vector<uint16_t>& projection,
+                    const std::vector<uint16_t>& wanted,
+                    hyperdex_client_returncode* op_status,
+                    e::error* op_error,
+                    const hyperdex_client_attribute** attrs,
+                    size_t* attrs_sz,
+                    bool convert_types);
+
 END_HYPERDEX_NAMESPACE
 
 #endif // hyperdex_client_util_h_
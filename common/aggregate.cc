@@ -0,0 +1,276 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#define __STDC_LIMIT_MACROS
+
+// C
+#include <cmath>
+#include <cstring>
+
+// STL
+#include <algorithm>
+
+// e
+#include <e/safe_math.h>
+
+// HyperDex
+#include "common/aggregate.h"
+#include "common/datatype_float.h"
+#include "common/datatype_int64.h"
+#include "common/serialization.h"
+
+using hyperdex::aggregate;
+using hyperdex::aggregate_state;
+
+// Upper bound on the buckets in one histogram, so that a client cannot make
+// every server allocate arbitrary amounts of memory
+#define AGGREGATE_MAX_BUCKETS 65536
+
+aggregate :: aggregate()
+    : attr()
+    , function()
+    , bucket_start()
+    , bucket_width()
+    , buckets()
+{
+}
+
+aggregate :: ~aggregate() throw ()
+{
+}
+
+aggregate_state :: aggregate_state()
+    : count(0)
+    , int_sum(0)
+    , int_min(INT64_MAX)
+    , int_max(INT64_MIN)
+    , float_sum(0)
+    , float_min(HUGE_VAL)
+    , float_max(-HUGE_VAL)
+    , overflow(false)
+    , buckets()
+{
+}
+
+aggregate_state :: aggregate_state(const aggregate& agg)
+    : count(0)
+    , int_sum(0)
+    , int_min(INT64_MAX)
+    , int_max(INT64_MIN)
+    , float_sum(0)
+    , float_min(HUGE_VAL)
+    , float_max(-HUGE_VAL)
+    , overflow(false)
+    , buckets(agg.function == aggregate::HISTOGRAM ? agg.buckets : 0, 0)
+{
+}
+
+aggregate_state :: ~aggregate_state() throw ()
+{
+}
+
+void
+aggregate_state :: add(const aggregate& agg, hyperdatatype type, const e::slice& value)
+{
+    double x;
+    ++count;
+
+    if (type == HYPERDATATYPE_FLOAT)
+    {
+        x = datatype_float::unpack(value);
+        float_sum += x;
+        float_min = std::min(float_min, x);
+        float_max = std::max(float_max, x);
+    }
+    else
+    {
+        // timestamps share the int64 encoding
+        int64_t i = datatype_int64::unpack(value);
+        overflow = overflow || !e::safe_add(int_sum, i, &int_sum);
+        int_min = std::min(int_min, i);
+        int_max = std::max(int_max, i);
+        x = i;
+    }
+
+    if (buckets.empty() || agg.bucket_width <= 0)
+    {
+        return;
+    }
+
+    double b = floor((x - agg.bucket_start) / agg.bucket_width);
+
+    if (b >= 0 && b < buckets.size())
+    {
+        ++buckets[static_cast<size_t>(b)];
+    }
+}
+
+void
+aggregate_state :: merge(const aggregate_state& other)
+{
+    count += other.count;
+    overflow = overflow || other.overflow || !e::safe_add(int_sum, other.int_sum, &int_sum);
+    int_min = std::min(int_min, other.int_min);
+    int_max = std::max(int_max, other.int_max);
+    float_sum += other.float_sum;
+    float_min = std::min(float_min, other.float_min);
+    float_max = std::max(float_max, other.float_max);
+
+    for (size_t i = 0; i < buckets.size() && i < other.buckets.size(); ++i)
+    {
+        buckets[i] += other.buckets[i];
+    }
+}
+
+bool
+hyperdex :: validate_aggregate(const schema& sc, const aggregate& agg)
+{
+    if (agg.attr == 0 || agg.attr >= sc.attrs_sz)
+    {
+        return false;
+    }
+
+    hyperdatatype t = sc.attrs[agg.attr].type;
+
+    if (t != HYPERDATATYPE_INT64 &&
+        t != HYPERDATATYPE_FLOAT &&
+        CONTAINER_TYPE(t) != HYPERDATATYPE_TIMESTAMP_GENERIC)
+    {
+        return false;
+    }
+
+    switch (agg.function)
+    {
+        case aggregate::SUM:
+        case aggregate::MIN:
+        case aggregate::MAX:
+        case aggregate::AVG:
+            return true;
+        case aggregate::HISTOGRAM:
+            return agg.bucket_width > 0 &&
+                   agg.buckets > 0 &&
+                   agg.buckets <= AGGREGATE_MAX_BUCKETS;
+        default:
+            return false;
+    }
+}
+
+static uint64_t
+double_bits(double d)
+{
+    uint64_t u;
+    memmove(&u, &d, sizeof(u));
+    return u;
+}
+
+static double
+bits_double(uint64_t u)
+{
+    double d;
+    memmove(&d, &u, sizeof(d));
+    return d;
+}
+
+e::packer
+hyperdex :: operator << (e::packer lhs, const aggregate& rhs)
+{
+    return lhs << rhs.attr
+               << rhs.function
+               << double_bits(rhs.bucket_start)
+               << double_bits(rhs.bucket_width)
+               << rhs.buckets;
+}
+
+e::unpacker
+hyperdex :: operator >> (e::unpacker lhs, aggregate& rhs)
+{
+    uint64_t start = 0;
+    uint64_t width = 0;
+    lhs = lhs >> rhs.attr
+              >> rhs.function
+              >> start
+              >> width
+              >> rhs.buckets;
+    rhs.bucket_start = bits_double(start);
+    rhs.bucket_width = bits_double(width);
+    return lhs;
+}
+
+size_t
+hyperdex :: pack_size(const aggregate&)
+{
+    return sizeof(uint16_t)
+         + sizeof(uint8_t)
+         + 3 * sizeof(uint64_t);
+}
+
+e::packer
+hyperdex :: operator << (e::packer lhs, const aggregate_state& rhs)
+{
+    uint8_t overflow = rhs.overflow ? 1 : 0;
+    return lhs << rhs.count
+               << rhs.int_sum
+               << rhs.int_min
+               << rhs.int_max
+               << double_bits(rhs.float_sum)
+               << double_bits(rhs.float_min)
+               << double_bits(rhs.float_max)
+               << overflow
+               << rhs.buckets;
+}
+
+e::unpacker
+hyperdex :: operator >> (e::unpacker lhs, aggregate_state& rhs)
+{
+    uint64_t sum = 0;
+    uint64_t min = 0;
+    uint64_t max = 0;
+    uint8_t overflow = 0;
+    lhs = lhs >> rhs.count
+              >> rhs.int_sum
+              >> rhs.int_min
+              >> rhs.int_max
+              >> sum
+              >> min
+              >> max
+              >> overflow
+              >> rhs.buckets;
+    rhs.float_sum = bits_double(sum);
+    rhs.float_min = bits_double(min);
+    rhs.float_max = bits_double(max);
+    rhs.overflow = overflow != 0;
+    return lhs;
+}
+
+size_t
+hyperdex :: pack_size(const aggregate_state& rhs)
+{
+    return 7 * sizeof(uint64_t)
+         + sizeof(uint8_t)
+         + sizeof(uint32_t) + rhs.buckets.size() * sizeof(uint64_t);
+}
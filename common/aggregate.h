@@ -0,0 +1,121 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef hyperdex_common_aggregate_h_
+#define hyperdex_common_aggregate_h_
+
+// STL
+#include <vector>
+
+// e
+#include <e/serialization.h>
+#include <e/slice.h>
+
+// HyperDex
+#include "namespace.h"
+#include "hyperdex.h"
+#include "common/schema.h"
+
+BEGIN_HYPERDEX_NAMESPACE
+
+// An aggregate function over one int64, float, or timestamp attribute,
+// computed over every object that matches a search.
+class aggregate
+{
+    public:
+        enum function_t
+        {
+            SUM         = 1,
+            MIN         = 2,
+            MAX         = 3,
+            AVG         = 4,
+            HISTOGRAM   = 5
+        };
+
+    public:
+        aggregate();
+        ~aggregate() throw ();
+
+    public:
+        uint16_t attr;
+        uint8_t function;
+        // HISTOGRAM only:  buckets of equal width, starting at bucket_start;
+        // values outside of all buckets are counted, but not bucketed
+        double bucket_start;
+        double bucket_width;
+        uint64_t buckets;
+};
+
+// The partial result of an aggregate.  Each region computes one over its
+// objects, and the client merges them.
+class aggregate_state
+{
+    public:
+        aggregate_state();
+        aggregate_state(const aggregate& agg);
+        ~aggregate_state() throw ();
+
+    public:
+        // fold one attribute value of the given type into the state
+        void add(const aggregate& agg, hyperdatatype type, const e::slice& value);
+        void merge(const aggregate_state& other);
+
+    public:
+        uint64_t count;
+        // int64 and timestamp attributes fill in the int fields, float
+        // attributes the float ones
+        int64_t int_sum;
+        int64_t int_min;
+        int64_t int_max;
+        double float_sum;
+        double float_min;
+        double float_max;
+        bool overflow;
+        std::vector<uint64_t> buckets;
+};
+
+bool
+validate_aggregate(const schema& sc, const aggregate& agg);
+
+e::packer
+operator << (e::packer lhs, const aggregate& rhs);
+e::unpacker
+operator >> (e::unpacker lhs, aggregate& rhs);
+size_t
+pack_size(const aggregate& rhs);
+
+e::packer
+operator << (e::packer lhs, const aggregate_state& rhs);
+e::unpacker
+operator >> (e::unpacker lhs, aggregate_state& rhs);
+size_t
+pack_size(const aggregate_state& rhs);
+
+END_HYPERDEX_NAMESPACE
+
+#endif // hyperdex_common_aggregate_h_
@@ -32,6 +32,7 @@
 #include <sstream>
 
 // HyperDex
+#include "cityhash/city.h"
 #include "common/configuration.h"
 #include "common/configuration_flags.h"
 #include "common/hash.h"
@@ -65,6 +66,10 @@ configuration :: configuration()
     , m_tails_by_region()
     , m_next_by_virtual()
     , m_point_leaders_by_virtual()
+    , m_spaces_by_name()
+    , m_spaces_by_region()
+    , m_region_bounds()
+    , m_region_bounds_by_space()
     , m_spaces()
     , m_transfers()
 {
@@ -87,6 +92,10 @@ configuration :: configuration(const configuration& other)
     , m_tails_by_region(other.m_tails_by_region)
     , m_next_by_virtual(other.m_next_by_virtual)
     , m_point_leaders_by_virtual(other.m_point_leaders_by_virtual)
+    , m_spaces_by_name()
+    , m_spaces_by_region()
+    , m_region_bounds()
+    , m_region_bounds_by_space()
     , m_spaces(other.m_spaces)
     , m_transfers(other.m_transfers)
 {
@@ -204,12 +213,11 @@ configuration :: get_server_id(const virtual_server_id& id) const
 const schema*
 configuration :: get_schema(const char* sname) const
 {
-    for (size_t s = 0; s < m_spaces.size(); ++s)
+    size_t s = space_index(sname);
+
+    if (s < m_spaces.size())
     {
-        if (strcmp(sname, m_spaces[s].name) == 0)
-        {
-            return &m_spaces[s].sc;
-        }
+        return &m_spaces[s].sc;
     }
 
     return NULL;
@@ -427,70 +435,26 @@ configuration :: is_point_leader(const virtual_server_id& e) const
 virtual_server_id
 configuration :: point_leader(const char* sname, const e::slice& key) const
 {
-    for (size_t s = 0; s < m_spaces.size(); ++s)
-    {
-        if (strcmp(sname, m_spaces[s].name) != 0)
-        {
-            continue;
-        }
-
-        uint64_t h;
-        hash(m_spaces[s].sc, key, &h);
-
-        for (size_t pl = 0; pl < m_spaces[s].subspaces[0].regions.size(); ++pl)
-        {
-            if (m_spaces[s].subspaces[0].regions[pl].lower_coord[0] <= h &&
-                h <= m_spaces[s].subspaces[0].regions[pl].upper_coord[0])
-            {
-                if (m_spaces[s].subspaces[0].regions[pl].replicas.empty())
-                {
-                    return virtual_server_id();
-                }
-
-                return m_spaces[s].subspaces[0].regions[pl].replicas[0].vsi;
-            }
-        }
-
-        abort();
-    }
+    return point_leader_in(space_index(sname), key);
+}
 
-    return virtual_server_id();
+virtual_server_id
+configuration :: key_replica(const char* sname, const e::slice& key, uint64_t pick) const
+{
+    return key_replica_in(space_index(sname), key, pick);
 }
 
 virtual_server_id
 configuration :: point_leader(const region_id& rid, const e::slice& key) const
 {
-    for (size_t s = 0; s < m_spaces.size(); ++s)
-    {
-        for (size_t ss = 0; ss < m_spaces[s].subspaces.size(); ++ss)
-        {
-            for (size_t r = 0; r < m_spaces[s].subspaces[ss].regions.size(); ++r)
-            {
-                if (m_spaces[s].subspaces[ss].regions[r].id != rid)
-                {
-                    continue;
-                }
-
-                uint64_t h;
-                hash(m_spaces[s].sc, key, &h);
-
-                for (size_t pl = 0; pl < m_spaces[s].subspaces[0].regions.size(); ++pl)
-                {
-                    if (m_spaces[s].subspaces[0].regions[pl].lower_coord[0] <= h &&
-                        h <= m_spaces[s].subspaces[0].regions[pl].upper_coord[0])
-                    {
-                        if (m_spaces[s].subspaces[0].regions[pl].replicas.empty())
-                        {
-                            return virtual_server_id();
-                        }
-
-                        return m_spaces[s].subspaces[0].regions[pl].replicas[0].vsi;
-                    }
-                }
+    std::vector<pair_uint64_t>::const_iterator it;
+    it = std::lower_bound(m_spaces_by_region.begin(),
+                          m_spaces_by_region.end(),
+                          pair_uint64_t(rid.get(), 0));
 
-                abort();
-            }
-        }
+    if (it != m_spaces_by_region.end() && it->first == rid.get())
+    {
+        return point_leader_in(it->second, key);
     }
 
     return virtual_server_id();
@@ -739,23 +703,16 @@ configuration :: lookup_search(const char* space_name,
                                const std::vector<attribute_check>& chks,
                                std::vector<virtual_server_id>* servers) const
 {
-    const space* s = NULL;
+    size_t space_idx = space_index(space_name);
 
-    for (size_t i = 0; i < m_spaces.size(); ++i)
-    {
-        if (strcmp(space_name, m_spaces[i].name) == 0)
-        {
-            s = &m_spaces[i];
-            break;
-        }
-    }
-
-    if (!s)
+    if (space_idx >= m_spaces.size())
     {
         servers->clear();
         return;
     }
 
+    const space* s = &m_spaces[space_idx];
+
     std::vector<range> ranges;
     range_searches(s->sc, chks, &ranges);
 
@@ -774,10 +731,41 @@ configuration :: lookup_search(const char* space_name,
     for (size_t i = 0; i < s->subspaces.size(); ++i)
     {
         std::vector<virtual_server_id> this_server_set;
+        // regions are sorted by their lower bound on the subspace's first
+        // coordinate, so only a prefix of them can satisfy an upper bound
+        uint64_t upper = UINT64_MAX;
 
-        for (size_t j = 0; j < s->subspaces[i].regions.size(); ++j)
+        for (size_t k = 0; !s->subspaces[i].attrs.empty() && k < ranges.size(); ++k)
         {
-            const region& reg(s->subspaces[i].regions[j]);
+            if (s->subspaces[i].attrs[0] != ranges[k].attr)
+            {
+                continue;
+            }
+
+            if (ranges[k].type == HYPERDATATYPE_STRING &&
+                ranges[k].has_start && ranges[k].has_end &&
+                ranges[k].start == ranges[k].end)
+            {
+                upper = std::min(upper, hash(ranges[k].type, ranges[k].start));
+            }
+
+            if ((ranges[k].type == HYPERDATATYPE_INT64 ||
+                 ranges[k].type == HYPERDATATYPE_FLOAT) &&
+                ranges[k].has_end)
+            {
+                upper = std::min(upper, hash(ranges[k].type, ranges[k].end));
+            }
+        }
+
+        const std::vector<pair_uint64_t>& bounds(m_region_bounds[m_region_bounds_by_space[space_idx] + i]);
+        std::vector<pair_uint64_t>::const_iterator last;
+        last = std::upper_bound(bounds.begin(), bounds.end(),
+                                pair_uint64_t(upper, UINT64_MAX));
+
+        for (std::vector<pair_uint64_t>::const_iterator it = bounds.begin();
+                it != last; ++it)
+        {
+            const region& reg(s->subspaces[i].regions[it->second]);
 
             if (reg.replicas.empty())
             {
@@ -872,17 +860,9 @@ std::string
 configuration :: list_indices(const char* space_name) const
 {
     std::ostringstream out;
-    ssize_t pos = -1;
-
-    for (size_t w = 0; w < m_spaces.size() && pos == -1; ++w)
-    {
-        if(strcmp(m_spaces[w].name, space_name) == 0)
-        {
-            pos = w;
-        }
-    }
+    size_t pos = space_index(space_name);
 
-    if(pos < 0)
+    if (pos >= m_spaces.size())
     {
         return "";
     }
@@ -903,17 +883,9 @@ std::string
 configuration :: list_subspaces(const char* space_name) const
 {
     std::ostringstream out;
-    ssize_t pos = -1;
-
-    for (size_t w = 0; w < m_spaces.size() && pos == -1; ++w)
-    {
-        if(strcmp(m_spaces[w].name, space_name) == 0)
-        {
-            pos = w;
-        }
-    }
+    size_t pos = space_index(space_name);
 
-    if(pos < 0)
+    if (pos >= m_spaces.size())
     {
         return "";
     }
@@ -974,6 +946,20 @@ configuration :: dump() const
             out << "    with authorization\n";
         }
 
+        if (s.sc.durability == schema::DURABILITY_PERIODIC)
+        {
+            out << "    with durability periodic\n";
+        }
+        else if (s.sc.durability == schema::DURABILITY_SYNC)
+        {
+            out << "    with durability sync\n";
+        }
+
+        if (s.sc.consistency == schema::CONSISTENCY_STALE)
+        {
+            out << "    with consistency stale\n";
+        }
+
         for (size_t x = 0; x < s.subspaces.size(); ++x)
         {
             const subspace& ss(s.subspaces[x]);
@@ -1082,6 +1068,78 @@ configuration :: operator = (const configuration& rhs)
     return *this;
 }
 
+size_t
+configuration :: space_index(const char* sname) const
+{
+    uint64_t h = CityHash64(sname, strlen(sname));
+    std::vector<pair_uint64_t>::const_iterator it;
+    it = std::lower_bound(m_spaces_by_name.begin(),
+                          m_spaces_by_name.end(),
+                          pair_uint64_t(h, 0));
+
+    for (; it != m_spaces_by_name.end() && it->first == h; ++it)
+    {
+        if (strcmp(sname, m_spaces[it->second].name) == 0)
+        {
+            return it->second;
+        }
+    }
+
+    return m_spaces.size();
+}
+
+size_t
+configuration :: key_region_index(size_t space_idx, uint64_t h) const
+{
+    const std::vector<pair_uint64_t>& bounds(m_region_bounds[m_region_bounds_by_space[space_idx]]);
+    std::vector<pair_uint64_t>::const_iterator it;
+    it = std::upper_bound(bounds.begin(), bounds.end(),
+                          pair_uint64_t(h, UINT64_MAX));
+
+    if (it == bounds.begin())
+    {
+        return bounds.size();
+    }
+
+    --it;
+    return it->second;
+}
+
+virtual_server_id
+configuration :: point_leader_in(size_t space_idx, const e::slice& key) const
+{
+    return key_replica_in(space_idx, key, 0);
+}
+
+virtual_server_id
+configuration :: key_replica_in(size_t space_idx, const e::slice& key, uint64_t pick) const
+{
+    if (space_idx >= m_spaces.size())
+    {
+        return virtual_server_id();
+    }
+
+    const space& s(m_spaces[space_idx]);
+    uint64_t h;
+    hash(s.sc, key, &h);
+    size_t pl = key_region_index(space_idx, h);
+
+    if (pl >= s.subspaces[0].regions.size() ||
+        s.subspaces[0].regions[pl].upper_coord[0] < h)
+    {
+        abort();
+    }
+
+    const std::vector<replica>& replicas(s.subspaces[0].regions[pl].replicas);
+
+    if (replicas.empty())
+    {
+        return virtual_server_id();
+    }
+
+    return replicas[pick % replicas.size()].vsi;
+}
+
 void
 configuration :: refill_cache()
 {
@@ -1096,14 +1154,23 @@ configuration :: refill_cache()
     m_tails_by_region.clear();
     m_next_by_virtual.clear();
     m_point_leaders_by_virtual.clear();
+    m_spaces_by_name.clear();
+    m_spaces_by_region.clear();
+    m_region_bounds.clear();
+    m_region_bounds_by_space.clear();
 
     for (size_t w = 0; w < m_spaces.size(); ++w)
     {
         space& s(m_spaces[w]);
+        m_spaces_by_name.push_back(std::make_pair(CityHash64(s.name, strlen(s.name)), w));
+        m_region_bounds_by_space.push_back(m_region_bounds.size());
 
         for (size_t x = 0; x < s.subspaces.size(); ++x)
         {
             subspace& ss(s.subspaces[x]);
+            m_region_bounds.push_back(std::vector<pair_uint64_t>());
+            std::vector<pair_uint64_t>& bounds(m_region_bounds.back());
+            bounds.reserve(ss.regions.size());
 
             if (x > 0)
             {
@@ -1123,6 +1190,8 @@ configuration :: refill_cache()
                 m_schemas_by_region.push_back(std::make_pair(r.id.get(), &s.sc));
                 m_subspaces_by_region.push_back(std::make_pair(r.id.get(), &ss));
                 m_subspace_ids_by_region.push_back(std::make_pair(r.id.get(), ss.id.get()));
+                m_spaces_by_region.push_back(std::make_pair(r.id.get(), w));
+                bounds.push_back(std::make_pair(r.lower_coord.empty() ? 0 : r.lower_coord[0], y));
 
                 if (r.replicas.empty())
                 {
@@ -1153,6 +1222,8 @@ configuration :: refill_cache()
                     }
                 }
             }
+
+            std::sort(bounds.begin(), bounds.end());
         }
     }
 
@@ -1175,6 +1246,8 @@ configuration :: refill_cache()
     std::sort(m_tails_by_region.begin(), m_tails_by_region.end());
     std::sort(m_next_by_virtual.begin(), m_next_by_virtual.end());
     std::sort(m_point_leaders_by_virtual.begin(), m_point_leaders_by_virtual.end());
+    std::sort(m_spaces_by_name.begin(), m_spaces_by_name.end());
+    std::sort(m_spaces_by_region.begin(), m_spaces_by_region.end());
 }
 
 e::unpacker
@@ -1198,11 +1271,13 @@ hyperdex :: operator >> (e::unpacker up, configuration& c)
 
     c.m_spaces.clear();
     c.m_spaces.reserve(num_spaces);
+    unsigned format = (c.m_flags & HYPERDEX_CONFIG_SPACES_V1)
+                    ? HYPERSPACE_FORMAT_V1 : HYPERSPACE_FORMAT_V0;
 
     for (size_t i = 0; !up.error() && i < num_spaces; ++i)
     {
         space s;
-        up = up >> s;
+        up = unpack_space(up, s, format);
         c.m_spaces.push_back(s);
     }
 
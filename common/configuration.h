@@ -90,6 +90,9 @@ class configuration
         virtual_server_id point_leader(const char* space, const e::slice& key) const;
         // point leader for this key in the same space as ri
         virtual_server_id point_leader(const region_id& ri, const e::slice& key) const;
+        // replica "pick" (modulo the number of replicas) of the key's region;
+        // pick 0 is the point leader
+        virtual_server_id key_replica(const char* space, const e::slice& key, uint64_t pick) const;
         // lhs and rhs are in adjacent subspaces such that lhs sends CHAIN_PUT
         // to rhs and rhs sends CHAIN_ACK to lhs
         bool subspace_adjacent(const virtual_server_id& lhs, const virtual_server_id& rhs) const;
@@ -142,6 +145,12 @@ class configuration
 
     private:
         void refill_cache();
+        // index into m_spaces of the named space, or m_spaces.size()
+        size_t space_index(const char* space) const;
+        // index into subspace 0's regions of the region containing h
+        size_t key_region_index(size_t space_idx, uint64_t h) const;
+        virtual_server_id point_leader_in(size_t space_idx, const e::slice& key) const;
+        virtual_server_id key_replica_in(size_t space_idx, const e::slice& key, uint64_t pick) const;
         friend size_t pack_size(const configuration&);
         friend e::packer operator << (e::packer, const configuration& s);
         friend e::unpacker operator >> (e::unpacker, configuration& s);
@@ -168,6 +177,15 @@ class configuration
         std::vector<pair_uint64_t> m_tails_by_region;
         std::vector<pair_uint64_t> m_next_by_virtual;
         std::vector<uint64_t> m_point_leaders_by_virtual;
+        // (CityHash64(name), space index)
+        std::vector<pair_uint64_t> m_spaces_by_name;
+        // (region id, space index)
+        std::vector<pair_uint64_t> m_spaces_by_region;
+        // for every subspace of every space (in order), the sorted
+        // (lower_coord[0], region index) pairs of its regions; the subspaces
+        // of space i start at m_region_bounds[m_region_bounds_by_space[i]]
+        std::vector<std::vector<pair_uint64_t> > m_region_bounds;
+        std::vector<size_t> m_region_bounds_by_space;
         std::vector<space> m_spaces;
         std::vector<transfer> m_transfers;
 };
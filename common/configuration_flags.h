@@ -29,5 +29,7 @@
 #define hyperdex_common_configuration_flags_h_
 
 #define HYPERDEX_CONFIG_READ_ONLY 1
+// the spaces are packed in HYPERSPACE_FORMAT_V1 rather than V0
+#define HYPERDEX_CONFIG_SPACES_V1 2
 
 #endif // hyperdex_common_configuration_flags_h_
@@ -82,6 +82,19 @@ space :: ~space() throw ()
 bool
 space :: validate() const
 {
+    if (sc.durability != schema::DURABILITY_NONE &&
+        sc.durability != schema::DURABILITY_PERIODIC &&
+        sc.durability != schema::DURABILITY_SYNC)
+    {
+        return false;
+    }
+
+    if (sc.consistency != schema::CONSISTENCY_STRONG &&
+        sc.consistency != schema::CONSISTENCY_STALE)
+    {
+        return false;
+    }
+
     for (size_t i = 0; i < sc.attrs_sz; ++i)
     {
         for (size_t j = i + 1; j < sc.attrs_sz; ++j)
@@ -219,11 +232,21 @@ hyperdex :: operator << (e::packer pa, const space& s)
         pa = pa << s.indices[i];
     }
 
+    uint8_t options[2];
+    options[0] = static_cast<uint8_t>(s.sc.durability);
+    options[1] = static_cast<uint8_t>(s.sc.consistency);
+    pa = pa << e::slice(options, sizeof(options));
     return pa;
 }
 
 e::unpacker
 hyperdex :: operator >> (e::unpacker up, space& s)
+{
+    return unpack_space(up, s, HYPERSPACE_FORMAT_V1);
+}
+
+e::unpacker
+hyperdex :: unpack_space(e::unpacker up, space& s, unsigned format)
 {
     e::slice name;
     std::vector<std::string> strs;
@@ -269,6 +292,26 @@ hyperdex :: operator >> (e::unpacker up, space& s)
         up = up >> s.indices[i];
     }
 
+    // Unpack options
+    s.sc.durability = schema::DURABILITY_NONE;
+    s.sc.consistency = schema::CONSISTENCY_STRONG;
+
+    if (format >= HYPERSPACE_FORMAT_V1 && !up.error() && up.remain() > 0)
+    {
+        e::slice options;
+        up = up >> options;
+
+        if (options.size() > 0)
+        {
+            s.sc.durability = static_cast<schema::durability_t>(options.data()[0]);
+        }
+
+        if (options.size() > 1)
+        {
+            s.sc.consistency = static_cast<schema::consistency_t>(options.data()[1]);
+        }
+    }
+
     s.reestablish_backing();
     return up;
 }
@@ -281,7 +324,8 @@ hyperdex :: pack_size(const space& s)
               + sizeof(uint64_t) /* fault_tolerance */
               + sizeof(uint16_t) /* sc.attrs_sz */
               + sizeof(uint16_t) /* num subspaces */
-              + sizeof(uint16_t); /* num indices */
+              + sizeof(uint16_t) /* num indices */
+              + sizeof(uint32_t) + 2 * sizeof(uint8_t); /* options */
 
     for (size_t i = 0; i < s.sc.attrs_sz; ++i)
     {
@@ -41,6 +41,15 @@
 #include "common/index.h"
 #include "common/schema.h"
 
+// Spaces are packed in one of two formats.  HYPERSPACE_FORMAT_V0 is the
+// original layout.  HYPERSPACE_FORMAT_V1 follows it with a length-prefixed
+// block of per-space options:  the durability byte, then the consistency
+// byte.  Readers take the options they know and skip the rest, so adding an
+// option does not need another format.  Anything that stores or sends several
+// spaces in a row must record which format it used.
+#define HYPERSPACE_FORMAT_V0 0
+#define HYPERSPACE_FORMAT_V1 1
+
 BEGIN_HYPERDEX_NAMESPACE
 class space;
 class subspace;
@@ -76,6 +85,7 @@ class space
     private:
         friend e::packer operator << (e::packer, const space& s);
         friend e::unpacker operator >> (e::unpacker, space& s);
+        friend e::unpacker unpack_space(e::unpacker, space& s, unsigned format);
         friend size_t pack_size(const space&);
 
     private:
@@ -89,10 +99,15 @@ inline const attribute& space::get_attribute(uint16_t index) const
     return m_attrs[index];
 }
 
+// pack and unpack HYPERSPACE_FORMAT_V1
 e::packer
 operator << (e::packer, const space& s);
 e::unpacker
 operator >> (e::unpacker, space& s);
+// unpack a space packed in "format"; a V1 space at the very end of the buffer
+// may lack its options block, in which case the options keep their defaults
+e::unpacker
+unpack_space(e::unpacker up, space& s, unsigned format);
 size_t
 pack_size(const space& s);
 
@@ -38,6 +38,9 @@ hyperdex :: operator << (std::ostream& lhs, const network_msgtype& rhs)
         STRINGIFY(RESP_GET);
         STRINGIFY(REQ_GET_PARTIAL);
         STRINGIFY(RESP_GET_PARTIAL);
+        STRINGIFY(REQ_GET_MANY);
+        STRINGIFY(RESP_GET_MANY);
+        STRINGIFY(REQ_BATCH);
         STRINGIFY(REQ_ATOMIC);
         STRINGIFY(RESP_ATOMIC);
         STRINGIFY(REQ_SEARCH_START);
@@ -45,23 +48,32 @@ hyperdex :: operator << (std::ostream& lhs, const network_msgtype& rhs)
         STRINGIFY(REQ_SEARCH_STOP);
         STRINGIFY(RESP_SEARCH_ITEM);
         STRINGIFY(RESP_SEARCH_DONE);
+        STRINGIFY(RESP_SEARCH_BATCH);
         STRINGIFY(REQ_SORTED_SEARCH);
         STRINGIFY(RESP_SORTED_SEARCH);
+        STRINGIFY(REQ_SORTED_SEARCH_FETCH);
+        STRINGIFY(RESP_SORTED_SEARCH_KEYS);
         STRINGIFY(REQ_COUNT);
         STRINGIFY(RESP_COUNT);
         STRINGIFY(REQ_SEARCH_DESCRIBE);
         STRINGIFY(RESP_SEARCH_DESCRIBE);
         STRINGIFY(REQ_GROUP_ATOMIC);
         STRINGIFY(RESP_GROUP_ATOMIC);
+        STRINGIFY(REQ_AGGREGATE);
+        STRINGIFY(RESP_AGGREGATE);
         STRINGIFY(CHAIN_OP);
         STRINGIFY(CHAIN_SUBSPACE);
         STRINGIFY(CHAIN_ACK);
+        STRINGIFY(CHAIN_BATCH);
         STRINGIFY(XFER_OP);
         STRINGIFY(XFER_ACK);
         STRINGIFY(XFER_HS);
         STRINGIFY(XFER_HSA);
         STRINGIFY(XFER_HA);
         STRINGIFY(XFER_HW);
+        STRINGIFY(BULK_INGEST);
+        STRINGIFY(BULK_CHAIN);
+        STRINGIFY(BULK_ACK);
         STRINGIFY(BACKUP);
         STRINGIFY(PERF_COUNTERS);
         STRINGIFY(CONFIGMISMATCH);
@@ -36,6 +36,11 @@
 
 BEGIN_HYPERDEX_NAMESPACE
 
+// A REQ_GET_PARTIAL that lists this attribute asks for the object's version,
+// which comes back ahead of the attributes as a pair with this number and an
+// 8-byte big-endian value.  Servers that don't know it ignore it.
+#define HYPERDEX_ATTRIBUTE_VERSION 65535
+
 enum network_msgtype
 {
     REQ_GET         = 8,
@@ -44,6 +49,11 @@ enum network_msgtype
     REQ_GET_PARTIAL = 10,
     RESP_GET_PARTIAL = 11,
 
+    REQ_GET_MANY    = 12,
+    RESP_GET_MANY   = 13,
+
+    REQ_BATCH       = 14,
+
     REQ_ATOMIC      = 16,
     RESP_ATOMIC     = 17,
 
@@ -52,9 +62,12 @@ enum network_msgtype
     REQ_SEARCH_STOP     = 34,
     RESP_SEARCH_ITEM    = 35,
     RESP_SEARCH_DONE    = 36,
+    RESP_SEARCH_BATCH   = 37,
 
     REQ_SORTED_SEARCH   = 40,
     RESP_SORTED_SEARCH  = 41,
+    REQ_SORTED_SEARCH_FETCH = 42,
+    RESP_SORTED_SEARCH_KEYS = 43,
 
     /* 48, 49 retired */
 
@@ -67,10 +80,14 @@ enum network_msgtype
     REQ_GROUP_ATOMIC = 54,
     RESP_GROUP_ATOMIC = 55,
 
+    REQ_AGGREGATE   = 56,
+    RESP_AGGREGATE  = 57,
+
     CHAIN_OP        = 64,
     CHAIN_SUBSPACE  = 65,
     CHAIN_ACK       = 66,
     /* 67 retired */
+    CHAIN_BATCH     = 68,
 
     XFER_OP  = 80,
     XFER_ACK = 81,
@@ -79,6 +96,10 @@ enum network_msgtype
     XFER_HA  = 84, // handshake ack
     XFER_HW  = 85, // wiped
 
+    BULK_INGEST = 96,
+    BULK_CHAIN  = 97,
+    BULK_ACK    = 98,
+
     BACKUP = 126,
     PERF_COUNTERS = 127,
 
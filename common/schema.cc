@@ -37,6 +37,8 @@ schema :: schema()
     : attrs_sz(0)
     , attrs(NULL)
     , authorization(false)
+    , durability(DURABILITY_NONE)
+    , consistency(CONSISTENCY_STRONG)
 {
 }
 
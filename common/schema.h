@@ -39,6 +39,14 @@ BEGIN_HYPERDEX_NAMESPACE
 
 class schema
 {
+    public:
+        // how a write to the space reaches stable storage before it is acked:
+        // never forced, forced at most an interval later, or forced first
+        enum durability_t { DURABILITY_NONE = 0, DURABILITY_PERIODIC = 1, DURABILITY_SYNC = 2 };
+        // which replicas may serve a GET: only the point leader, or any
+        // replica of the key's region at the cost of bounded staleness
+        enum consistency_t { CONSISTENCY_STRONG = 0, CONSISTENCY_STALE = 1 };
+
     public:
         schema();
 
@@ -49,6 +57,8 @@ class schema
         uint16_t attrs_sz;
         const attribute* attrs;
         bool authorization;
+        durability_t durability;
+        consistency_t consistency;
 };
 
 END_HYPERDEX_NAMESPACE
@@ -47,6 +47,10 @@
 
 #define ALARM_INTERVAL 30
 
+// Snapshots begin with this tag and the format of the spaces they hold.
+// Older snapshots begin with the cluster id and hold HYPERSPACE_FORMAT_V0.
+#define SNAPSHOT_MAGIC 0x4879706572446578ULL /* "HyperDex" */
+
 using hyperdex::coordinator;
 using hyperdex::region;
 using hyperdex::region_intent;
@@ -1047,6 +1051,22 @@ coordinator :: recreate(rsm_context* ctx,
     }
 
     e::unpacker up(data, data_sz);
+    e::unpacker tagged(up);
+    uint64_t magic = 0;
+    uint8_t format = HYPERSPACE_FORMAT_V0;
+    tagged = tagged >> magic;
+
+    if (!tagged.error() && magic == SNAPSHOT_MAGIC)
+    {
+        up = tagged >> format;
+
+        if (format > HYPERSPACE_FORMAT_V1)
+        {
+            rsm_log(ctx, "snapshot holds spaces in unknown format %u\n", unsigned(format));
+            return NULL;
+        }
+    }
+
     up = up >> c->m_cluster >> c->m_counter >> c->m_version >> c->m_flags >> c->m_servers
             >> c->m_permutation >> c->m_spares >> c->m_desired_spares >> c->m_intents
             >> c->m_deferred_init >> c->m_offline >> c->m_transfers
@@ -1059,7 +1079,8 @@ coordinator :: recreate(rsm_context* ctx,
     {
         e::slice name;
         space_ptr ptr(new space());
-        up = up >> name >> *ptr;
+        up = up >> name;
+        up = unpack_space(up, *ptr, format);
         c->m_spaces[std::string(reinterpret_cast<const char*>(name.data()), name.size())] = ptr;
     }
 
@@ -1125,7 +1146,8 @@ int
 coordinator :: snapshot(rsm_context* /*ctx*/,
                         char** data, size_t* data_sz)
 {
-    size_t sz = sizeof(m_cluster)
+    size_t sz = sizeof(uint64_t) + sizeof(uint8_t) /* magic, format */
+              + sizeof(m_cluster)
               + sizeof(m_counter)
               + sizeof(m_version)
               + sizeof(m_flags)
@@ -1155,6 +1177,7 @@ coordinator :: snapshot(rsm_context* /*ctx*/,
 
     std::auto_ptr<e::buffer> buf(e::buffer::create(sz));
     e::packer pa = buf->pack_at(0);
+    pa = pa << uint64_t(SNAPSHOT_MAGIC) << uint8_t(HYPERSPACE_FORMAT_V1);
     pa = pa << m_cluster << m_counter << m_version << m_flags << m_servers
             << m_permutation << m_spares << m_desired_spares << m_intents
             << m_deferred_init << m_offline << m_transfers
@@ -1899,7 +1922,8 @@ coordinator :: generate_cached_configuration(rsm_context*)
 
     std::auto_ptr<e::buffer> new_config(e::buffer::create(sz));
     e::packer pa = new_config->pack_at(0);
-    pa = pa << m_cluster << m_version << m_flags
+    pa = pa << m_cluster << m_version
+            << uint64_t(m_flags | HYPERDEX_CONFIG_SPACES_V1)
             << uint64_t(m_servers.size())
             << uint64_t(m_spaces.size())
             << uint64_t(transfers_subset.size());
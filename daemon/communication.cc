@@ -31,6 +31,9 @@
 #include "config.h"
 #endif
 
+// STL
+#include <algorithm>
+
 // Google Log
 #include <glog/logging.h>
 
@@ -41,6 +44,22 @@
 using hyperdex::communication;
 using hyperdex::reconfigure_returncode;
 
+// Upper bound on the payload of a single CHAIN_BATCH
+#define CHAIN_BATCH_MAX_BYTES (1ULL << 20)
+// Chain messages larger than this go alone; copying them into and back out
+// of a CHAIN_BATCH costs more than the send it saves
+#define CHAIN_BATCH_MAX_ITEM_BYTES 4096
+// Upper bound on how many times one thread empties a chain queue before it
+// leaves the rest to whoever enqueues next
+#define CHAIN_FLUSH_MAX_PASSES 4
+
+namespace
+{
+// Non-NULL while this thread is corked; lists the queues it has left entries
+// in so that uncork_chain can flush them.
+__thread std::vector<std::pair<uint64_t, uint64_t> >* t_corked = NULL;
+}
+
 //////////////////////////////// Early Messages ////////////////////////////////
 
 class communication::early_message
@@ -77,6 +96,56 @@ communication :: early_message :: ~early_message() throw ()
 {
 }
 
+///////////////////////////////// Chain Queues /////////////////////////////////
+
+class communication::chain_queue
+{
+    public:
+        chain_queue(const virtual_server_id& from,
+                    const virtual_server_id& to);
+        ~chain_queue() throw ();
+
+    public:
+        const virtual_server_id from;
+        const virtual_server_id to;
+        po6::threads::mutex mtx;
+        bool flushing;
+        std::vector<std::pair<network_msgtype, e::buffer*> > pending;
+
+    private:
+        friend class e::intrusive_ptr<chain_queue>;
+
+    private:
+        void inc() { __sync_add_and_fetch(&m_ref, 1); }
+        void dec() { if (__sync_sub_and_fetch(&m_ref, 1) == 0) delete this; }
+
+    private:
+        size_t m_ref;
+
+    private:
+        chain_queue(const chain_queue&);
+        chain_queue& operator = (const chain_queue&);
+};
+
+communication :: chain_queue :: chain_queue(const virtual_server_id& f,
+                                            const virtual_server_id& t)
+    : from(f)
+    , to(t)
+    , mtx()
+    , flushing(false)
+    , pending()
+    , m_ref(0)
+{
+}
+
+communication :: chain_queue :: ~chain_queue() throw ()
+{
+    for (size_t i = 0; i < pending.size(); ++i)
+    {
+        delete pending[i].second;
+    }
+}
+
 ///////////////////////////////// Public Class /////////////////////////////////
 
 communication :: communication(daemon* d)
@@ -84,6 +153,8 @@ communication :: communication(daemon* d)
     , m_busybee_mapper(&m_daemon->m_config)
     , m_busybee()
     , m_early_messages()
+    , m_chain_mtx()
+    , m_chain_queues()
 {
 }
 
@@ -129,6 +200,13 @@ communication :: reconfigure(const configuration&,
     {
         m_early_messages.push(em);
     }
+
+    // Anything still queued belongs to the old configuration; the
+    // retransmitter will resend it under the new one.  Threads outside the
+    // pause (e.g., the retransmitter) may still hold a queue, so retire the
+    // queues by dropping the map's references; each is freed with its last.
+    po6::threads::mutex::hold hold(&m_chain_mtx);
+    m_chain_queues.clear();
 }
 
 bool
@@ -404,6 +482,78 @@ communication :: send_exact(const virtual_server_id& from,
     return true;
 }
 
+bool
+communication :: send_chain(const virtual_server_id& from,
+                            const virtual_server_id& to,
+                            network_msgtype msg_type,
+                            std::auto_ptr<e::buffer> msg)
+{
+    assert(msg->size() >= HYPERDEX_HEADER_SIZE_VV);
+    assert(msg_type == CHAIN_OP ||
+           msg_type == CHAIN_SUBSPACE ||
+           msg_type == CHAIN_ACK);
+    e::intrusive_ptr<chain_queue> cq = get_chain_queue(from, to);
+
+    {
+        po6::threads::mutex::hold hold(&cq->mtx);
+        cq->pending.push_back(std::make_pair(msg_type, msg.get()));
+        msg.release();
+
+        // Whoever is flushing will pick this up before it stops
+        if (cq->flushing)
+        {
+            return true;
+        }
+
+        if (t_corked)
+        {
+            t_corked->push_back(std::make_pair(from.get(), to.get()));
+            return true;
+        }
+
+        cq->flushing = true;
+    }
+
+    return flush_chain_queue(cq.get());
+}
+
+void
+communication :: cork_chain()
+{
+    assert(!t_corked);
+    t_corked = new std::vector<std::pair<uint64_t, uint64_t> >();
+}
+
+void
+communication :: uncork_chain()
+{
+    assert(t_corked);
+    std::auto_ptr<std::vector<std::pair<uint64_t, uint64_t> > > corked(t_corked);
+    t_corked = NULL;
+    std::sort(corked->begin(), corked->end());
+    corked->erase(std::unique(corked->begin(), corked->end()), corked->end());
+
+    for (size_t i = 0; i < corked->size(); ++i)
+    {
+        e::intrusive_ptr<chain_queue> cq;
+        cq = get_chain_queue(virtual_server_id((*corked)[i].first),
+                             virtual_server_id((*corked)[i].second));
+
+        {
+            po6::threads::mutex::hold hold(&cq->mtx);
+
+            if (cq->flushing || cq->pending.empty())
+            {
+                continue;
+            }
+
+            cq->flushing = true;
+        }
+
+        flush_chain_queue(cq.get());
+    }
+}
+
 bool
 communication :: recv(e::garbage_collector::thread_state* ts,
                       server_id* from,
@@ -512,6 +662,135 @@ communication :: recv(e::garbage_collector::thread_state* ts,
     }
 }
 
+e::intrusive_ptr<communication::chain_queue>
+communication :: get_chain_queue(const virtual_server_id& from,
+                                 const virtual_server_id& to)
+{
+    po6::threads::mutex::hold hold(&m_chain_mtx);
+    chain_queue_key_t key(from.get(), to.get());
+    chain_queue_map_t::iterator it = m_chain_queues.find(key);
+
+    if (it != m_chain_queues.end())
+    {
+        return it->second;
+    }
+
+    e::intrusive_ptr<chain_queue> cq = new chain_queue(from, to);
+    m_chain_queues.insert(std::make_pair(key, cq));
+    return cq;
+}
+
+bool
+communication :: flush_chain_queue(chain_queue* cq)
+{
+    bool ret = true;
+    bool last = false;
+
+    for (unsigned pass = 1; !last; ++pass)
+    {
+        std::vector<std::pair<network_msgtype, e::buffer*> > work;
+
+        {
+            po6::threads::mutex::hold hold(&cq->mtx);
+            assert(cq->flushing);
+
+            if (cq->pending.empty())
+            {
+                cq->flushing = false;
+                return ret;
+            }
+
+            work.swap(cq->pending);
+
+            // Give up the queue on the last pass so that a steady stream of
+            // enqueues cannot keep this thread here forever.  Anything that
+            // arrives from now on finds the queue idle and flushes itself.
+            if (pass >= CHAIN_FLUSH_MAX_PASSES)
+            {
+                cq->flushing = false;
+                last = true;
+            }
+        }
+
+        if (!send_chain_entries(cq, &work))
+        {
+            ret = false;
+        }
+    }
+
+    return ret;
+}
+
+bool
+communication :: send_chain_entries(chain_queue* cq,
+                                    std::vector<std::pair<network_msgtype, e::buffer*> >* work)
+{
+    bool ret = true;
+    size_t idx = 0;
+
+    while (idx < work->size())
+    {
+        size_t end = idx;
+        size_t sz = HYPERDEX_HEADER_SIZE_VV + sizeof(uint32_t);
+
+        // a large message goes alone; small ones are gathered until a large
+        // one ends the run, so order is kept either way
+        if ((*work)[idx].second->size() > CHAIN_BATCH_MAX_ITEM_BYTES)
+        {
+            ++end;
+        }
+        else
+        {
+            while (end < work->size() &&
+                   (*work)[end].second->size() <= CHAIN_BATCH_MAX_ITEM_BYTES &&
+                   sz < CHAIN_BATCH_MAX_BYTES)
+            {
+                sz += sizeof(uint8_t) + sizeof(uint32_t)
+                    + (*work)[end].second->size() - HYPERDEX_HEADER_SIZE_VV;
+                ++end;
+            }
+        }
+
+        std::auto_ptr<e::buffer> msg;
+        network_msgtype msg_type;
+
+        if (end - idx == 1)
+        {
+            msg.reset((*work)[idx].second);
+            msg_type = (*work)[idx].first;
+            (*work)[idx].second = NULL;
+        }
+        else
+        {
+            msg.reset(e::buffer::create(sz));
+            msg_type = CHAIN_BATCH;
+            uint32_t count = end - idx;
+            e::packer pa = msg->pack_at(HYPERDEX_HEADER_SIZE_VV);
+            pa = pa << count;
+
+            for (size_t i = idx; i < end; ++i)
+            {
+                uint8_t mt = static_cast<uint8_t>((*work)[i].first);
+                e::buffer* m = (*work)[i].second;
+                e::slice body(m->data() + HYPERDEX_HEADER_SIZE_VV,
+                              m->size() - HYPERDEX_HEADER_SIZE_VV);
+                pa = pa << mt << body;
+                delete m;
+                (*work)[i].second = NULL;
+            }
+        }
+
+        if (!send_exact(cq->from, cq->to, msg_type, msg))
+        {
+            ret = false;
+        }
+
+        idx = end;
+    }
+
+    return ret;
+}
+
 void
 communication :: handle_disruption(uint64_t id)
 {
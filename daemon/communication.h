@@ -29,7 +29,12 @@
 #define hyperdex_daemon_communication_h_
 
 // STL
+#include <map>
 #include <memory>
+#include <vector>
+
+// po6
+#include <po6/threads/mutex.h>
 
 // BusyBee
 #include <busybee_constants.h>
@@ -37,6 +42,7 @@
 
 // e
 #include <e/buffer.h>
+#include <e/intrusive_ptr.h>
 #include <e/lockfree_fifo.h>
 
 // HyperDex
@@ -106,6 +112,18 @@ class communication
                         const virtual_server_id& to,
                         network_msgtype msg_type,
                         std::auto_ptr<e::buffer> msg);
+        // Send a CHAIN_OP, CHAIN_SUBSPACE, or CHAIN_ACK.  Messages for the
+        // same destination that queue up while an earlier send is in flight
+        // (or while this thread is corked) go out together as a CHAIN_BATCH.
+        // Large messages are never batched.
+        bool send_chain(const virtual_server_id& from,
+                        const virtual_server_id& to,
+                        network_msgtype msg_type,
+                        std::auto_ptr<e::buffer> msg);
+        // Hold this thread's chain messages until uncork_chain so that the
+        // messages generated by one CHAIN_BATCH leave as one CHAIN_BATCH.
+        void cork_chain();
+        void uncork_chain();
         bool recv(e::garbage_collector::thread_state* ts,
                   server_id* from,
                   virtual_server_id* vfrom,
@@ -116,9 +134,19 @@ class communication
 
     private:
         class early_message;
+        class chain_queue;
+        typedef std::pair<uint64_t, uint64_t> chain_queue_key_t;
+        // refcounted, because reconfigure retires queues that other threads
+        // may still be using
+        typedef std::map<chain_queue_key_t, e::intrusive_ptr<chain_queue> > chain_queue_map_t;
 
     private:
         void handle_disruption(uint64_t id);
+        e::intrusive_ptr<chain_queue> get_chain_queue(const virtual_server_id& from,
+                                                      const virtual_server_id& to);
+        bool flush_chain_queue(chain_queue* cq);
+        bool send_chain_entries(chain_queue* cq,
+                                std::vector<std::pair<network_msgtype, e::buffer*> >* work);
 
     private:
         communication(const communication&);
@@ -129,6 +157,8 @@ class communication
         mapper m_busybee_mapper;
         std::auto_ptr<busybee_mta> m_busybee;
         e::lockfree_fifo<early_message> m_early_messages;
+        po6::threads::mutex m_chain_mtx;
+        chain_queue_map_t m_chain_queues;
 };
 
 END_HYPERDEX_NAMESPACE
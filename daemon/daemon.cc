@@ -28,6 +28,9 @@
 #define __STDC_LIMIT_MACROS
 #define _WITH_GETLINE
 
+// C
+#include <string.h>
+
 // POSIX
 #include <dirent.h>
 #include <signal.h>
@@ -52,6 +55,7 @@
 
 // HyperDex
 #include "common/coordinator_returncode.h"
+#include "common/datatype_info.h"
 #include "common/key_change.h"
 #include "common/serialization.h"
 #include "daemon/auth.h"
@@ -111,24 +115,32 @@ daemon :: daemon()
     , m_can_pause(&m_protect_pause)
     , m_paused(false)
     , m_perf_req_get()
+    , m_perf_req_get_many()
     , m_perf_req_get_partial()
     , m_perf_req_atomic()
     , m_perf_req_search_start()
     , m_perf_req_search_next()
     , m_perf_req_search_stop()
     , m_perf_req_sorted_search()
+    , m_perf_req_sorted_search_fetch()
     , m_perf_req_count()
+    , m_perf_req_aggregate()
     , m_perf_req_search_describe()
     , m_perf_req_group_atomic()
+    , m_perf_req_batch()
     , m_perf_chain_op()
     , m_perf_chain_subspace()
     , m_perf_chain_ack()
+    , m_perf_chain_batch()
     , m_perf_xfer_handshake_syn()
     , m_perf_xfer_handshake_synack()
     , m_perf_xfer_handshake_ack()
     , m_perf_xfer_handshake_wiped()
     , m_perf_xfer_op()
     , m_perf_xfer_ack()
+    , m_perf_bulk_ingest()
+    , m_perf_bulk_chain()
+    , m_perf_bulk_ack()
     , m_perf_backup()
     , m_perf_perf_counters()
     , m_block_stat_path()
@@ -183,7 +195,13 @@ daemon :: run(bool daemonize,
               po6::net::location bind_to,
               bool set_coordinator,
               po6::net::hostname coordinator,
-              unsigned threads)
+              unsigned threads,
+              size_t group_commit_batch,
+              uint64_t group_commit_delay,
+              uint64_t sync_interval,
+              uint64_t key_state_cache,
+              size_t value_log_threshold,
+              uint64_t row_cache)
 {
     if (!install_signal_handler(SIGHUP, exit_on_signal) ||
         !install_signal_handler(SIGINT, exit_on_signal) ||
@@ -269,6 +287,11 @@ daemon :: run(bool daemonize,
         return EXIT_FAILURE;
     }
 
+    m_data.set_group_commit(group_commit_batch, group_commit_delay, sync_interval);
+    m_data.set_value_log(value_log_threshold);
+    m_data.set_row_cache(row_cache);
+    m_repl.set_key_state_cache(key_state_cache);
+
     if (po6::path::dirname(data).size())
     {
         if (chdir(po6::path::dirname(data).c_str()) < 0)
@@ -586,6 +609,10 @@ daemon :: loop(size_t thread)
                 process_req_get(from, vfrom, vto, msg, up);
                 m_perf_req_get.tap();
                 break;
+            case REQ_GET_MANY:
+                process_req_get_many(from, vfrom, vto, msg, up);
+                m_perf_req_get_many.tap();
+                break;
             case REQ_GET_PARTIAL:
                 process_req_get_partial(from, vfrom, vto, msg, up);
                 m_perf_req_get_partial.tap();
@@ -610,10 +637,18 @@ daemon :: loop(size_t thread)
                 process_req_sorted_search(from, vfrom, vto, msg, up);
                 m_perf_req_sorted_search.tap();
                 break;
+            case REQ_SORTED_SEARCH_FETCH:
+                process_req_sorted_search_fetch(from, vfrom, vto, msg, up);
+                m_perf_req_sorted_search_fetch.tap();
+                break;
             case REQ_COUNT:
                 process_req_count(from, vfrom, vto, msg, up);
                 m_perf_req_count.tap();
                 break;
+            case REQ_AGGREGATE:
+                process_req_aggregate(from, vfrom, vto, msg, up);
+                m_perf_req_aggregate.tap();
+                break;
             case REQ_SEARCH_DESCRIBE:
                 process_req_search_describe(from, vfrom, vto, msg, up);
                 m_perf_req_search_describe.tap();
@@ -622,6 +657,10 @@ daemon :: loop(size_t thread)
                 process_req_group_atomic(from, vfrom, vto, msg, up);
                 m_perf_req_group_atomic.tap();
                 break;
+            case REQ_BATCH:
+                process_req_batch(from, vfrom, vto, msg, up);
+                m_perf_req_batch.tap();
+                break;
             case CHAIN_OP:
                 process_chain_op(from, vfrom, vto, msg, up);
                 m_perf_chain_op.tap();
@@ -634,6 +673,10 @@ daemon :: loop(size_t thread)
                 process_chain_ack(from, vfrom, vto, msg, up);
                 m_perf_chain_ack.tap();
                 break;
+            case CHAIN_BATCH:
+                process_chain_batch(from, vfrom, vto, msg, up);
+                m_perf_chain_batch.tap();
+                break;
             case XFER_HS:
                 process_xfer_handshake_syn(from, vfrom, vto, msg, up);
                 m_perf_xfer_handshake_syn.tap();
@@ -658,6 +701,18 @@ daemon :: loop(size_t thread)
                 process_xfer_ack(from, vfrom, vto, msg, up);
                 m_perf_xfer_ack.tap();
                 break;
+            case BULK_INGEST:
+                process_bulk_ingest(from, vfrom, vto, msg, up);
+                m_perf_bulk_ingest.tap();
+                break;
+            case BULK_CHAIN:
+                process_bulk_chain(from, vfrom, vto, msg, up);
+                m_perf_bulk_chain.tap();
+                break;
+            case BULK_ACK:
+                process_bulk_ack(from, vfrom, vto, msg, up);
+                m_perf_bulk_ack.tap();
+                break;
             case BACKUP:
                 process_backup(from, vfrom, vto, msg, up);
                 m_perf_backup.tap();
@@ -666,13 +721,17 @@ daemon :: loop(size_t thread)
                 m_perf_perf_counters.tap();
                 break;
             case RESP_GET:
+            case RESP_GET_MANY:
             case RESP_GET_PARTIAL:
             case RESP_ATOMIC:
             case RESP_GROUP_ATOMIC:
             case RESP_SEARCH_ITEM:
             case RESP_SEARCH_DONE:
+            case RESP_SEARCH_BATCH:
             case RESP_SORTED_SEARCH:
+            case RESP_SORTED_SEARCH_KEYS:
             case RESP_COUNT:
+            case RESP_AGGREGATE:
             case RESP_SEARCH_DESCRIBE:
             case CONFIGMISMATCH:
             case PACKET_NOP:
@@ -755,20 +814,118 @@ daemon :: process_req_get(server_id from,
         size_t sz = HYPERDEX_HEADER_SIZE_VC
                   + sizeof(uint64_t)
                   + sizeof(uint16_t)
-                  + pack_size(value);
+                  + pack_size(value)
+                  + sizeof(uint64_t);
         msg.reset(e::buffer::create(sz));
         e::packer pa = msg->pack_at(HYPERDEX_HEADER_SIZE_VC);
         pa = pa << nonce << static_cast<uint16_t>(result);
 
+        // the version lets clients reading from any replica keep their
+        // reads of an object monotonic; it trails the value so that clients
+        // that don't look for it never see it
         if (result == NET_SUCCESS)
         {
-            pa = pa << value;
+            pa = pa << value << version;
         }
     }
 
     m_comm.send_client(vto, from, RESP_GET, msg);
 }
 
+void
+daemon :: process_req_get_many(server_id from,
+                               virtual_server_id,
+                               virtual_server_id vto,
+                               std::auto_ptr<e::buffer> msg,
+                               e::unpacker up)
+{
+    uint64_t nonce;
+    std::vector<e::slice> keys;
+    bool has_auth = false;
+    auth_wallet aw;
+    up = up >> nonce >> keys;
+
+    if (up.remain())
+    {
+        has_auth = true;
+        up = up >> aw;
+    }
+
+    if (up.error())
+    {
+        LOG(WARNING) << "unpack of REQ_GET_MANY failed; here's some hex:  " << msg->hex();
+        return;
+    }
+
+    region_id ri = m_config.get_region_id(vto);
+    const schema* sc = m_config.get_schema(ri);
+    datalayer::snapshot snap = m_data.make_snapshot();
+    std::vector<network_returncode> results(keys.size());
+    std::vector<std::vector<e::slice> > values(keys.size());
+    std::vector<datalayer::reference> refs(keys.size());
+    size_t sz = HYPERDEX_HEADER_SIZE_VC
+              + sizeof(uint64_t)
+              + sizeof(uint32_t);
+
+    // read every key from the same snapshot so the reply is consistent
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        bool has_value = false;
+        uint64_t version;
+
+        switch (m_data.get(ri, snap, keys[i], &values[i], &version, &refs[i]))
+        {
+            case datalayer::SUCCESS:
+                has_value = true;
+                results[i] = NET_SUCCESS;
+                break;
+            case datalayer::NOT_FOUND:
+                results[i] = NET_NOTFOUND;
+                break;
+            case datalayer::BAD_ENCODING:
+            case datalayer::CORRUPTION:
+            case datalayer::IO_ERROR:
+            case datalayer::LEVELDB_ERROR:
+            default:
+                LOG(ERROR) << "GET_MANY returned unacceptable error code.";
+                results[i] = NET_SERVERERROR;
+                break;
+        }
+
+        if (!auth_verify_read(*sc, has_value, &values[i], (has_auth ? &aw : NULL)))
+        {
+            results[i] = NET_UNAUTHORIZED;
+        }
+        else
+        {
+            sanitize_secrets(*sc, &values[i]);
+        }
+
+        sz += sizeof(uint16_t);
+
+        if (results[i] == NET_SUCCESS)
+        {
+            sz += pack_size(values[i]);
+        }
+    }
+
+    msg.reset(e::buffer::create(sz));
+    e::packer pa = msg->pack_at(HYPERDEX_HEADER_SIZE_VC);
+    pa = pa << nonce << static_cast<uint32_t>(keys.size());
+
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        pa = pa << static_cast<uint16_t>(results[i]);
+
+        if (results[i] == NET_SUCCESS)
+        {
+            pa = pa << values[i];
+        }
+    }
+
+    m_comm.send_client(vto, from, RESP_GET_MANY, msg);
+}
+
 void
 daemon :: process_req_get_partial(server_id from,
                                   virtual_server_id,
@@ -835,17 +992,30 @@ daemon :: process_req_get_partial(server_id from,
     else
     {
         sanitize_secrets(*sc, &value);
+        const bool want_version = !attrs.empty() &&
+                                  attrs.back() == HYPERDEX_ATTRIBUTE_VERSION;
         size_t sz = HYPERDEX_HEADER_SIZE_VC
                   + sizeof(uint64_t)
                   + sizeof(uint16_t)
                   + pack_size(value)
-                  + value.size() * sizeof(uint16_t);
+                  + value.size() * sizeof(uint16_t)
+                  + (want_version ? sizeof(uint16_t) + pack_size(e::slice("", sizeof(uint64_t))) : 0);
         msg.reset(e::buffer::create(sz));
         e::packer pa = msg->pack_at(HYPERDEX_HEADER_SIZE_VC);
         pa = pa << nonce << static_cast<uint16_t>(result);
 
         if (result == NET_SUCCESS)
         {
+            // only clients that ask get the version; others would take it
+            // for an attribute
+            if (want_version)
+            {
+                char buf[sizeof(uint64_t)];
+                e::pack64be(version, buf);
+                pa = pa << static_cast<uint16_t>(HYPERDEX_ATTRIBUTE_VERSION)
+                        << e::slice(buf, sizeof(uint64_t));
+            }
+
             for (size_t i = 0; i < value.size(); ++i)
             {
                 uint16_t attr = i + 1;
@@ -893,14 +1063,30 @@ daemon :: process_req_search_start(server_id from,
     uint64_t nonce;
     uint64_t search_id;
     std::vector<attribute_check> checks;
+    uint64_t batch_items = 0;
+    uint64_t batch_bytes = 0;
+    std::vector<uint16_t> projection;
+    up = up >> nonce >> search_id >> checks;
 
-    if ((up >> nonce >> search_id >> checks).error())
+    // older clients omit the batch limits and get one item per message
+    if (up.remain())
+    {
+        up = up >> batch_items >> batch_bytes;
+    }
+
+    // an absent or empty projection returns every attribute
+    if (up.remain())
+    {
+        up = up >> projection;
+    }
+
+    if (up.error())
     {
         LOG(WARNING) << "unpack of REQ_SEARCH_START failed; here's some hex:  " << msg->hex();
         return;
     }
 
-    m_sm.start(from, vto, msg, nonce, search_id, &checks);
+    m_sm.start(from, vto, msg, nonce, search_id, &checks, batch_items, batch_bytes, &projection);
 }
 
 void
@@ -953,14 +1139,48 @@ daemon :: process_req_sorted_search(server_id from,
     uint64_t limit;
     uint16_t sort_by;
     uint8_t flags;
+    std::vector<uint16_t> projection;
+    up = up >> nonce >> checks >> limit >> sort_by >> flags;
+
+    if (up.remain())
+    {
+        up = up >> projection;
+    }
 
-    if ((up >> nonce >> checks >> limit >> sort_by >> flags).error())
+    if (up.error())
     {
         LOG(WARNING) << "unpack of REQ_SORTED_SEARCH failed; here's some hex:  " << msg->hex();
         return;
     }
 
-    m_sm.sorted_search(from, vto, nonce, &checks, limit, sort_by, flags & 0x1);
+    m_sm.sorted_search(from, vto, nonce, &checks, limit, sort_by, flags & 0x1, flags & 0x2, &projection);
+}
+
+void
+daemon :: process_req_sorted_search_fetch(server_id from,
+                                          virtual_server_id,
+                                          virtual_server_id vto,
+                                          std::auto_ptr<e::buffer> msg,
+                                          e::unpacker up)
+{
+    uint64_t nonce;
+    std::vector<attribute_check> checks;
+    std::vector<e::slice> keys;
+    std::vector<uint16_t> projection;
+    up = up >> nonce >> checks >> keys;
+
+    if (up.remain())
+    {
+        up = up >> projection;
+    }
+
+    if (up.error())
+    {
+        LOG(WARNING) << "unpack of REQ_SORTED_SEARCH_FETCH failed; here's some hex:  " << msg->hex();
+        return;
+    }
+
+    m_sm.sorted_search_fetch(from, vto, nonce, &checks, keys, &projection);
 }
 
 void
@@ -982,6 +1202,26 @@ daemon :: process_req_count(server_id from,
     m_sm.count(from, vto, nonce, &checks);
 }
 
+void
+daemon :: process_req_aggregate(server_id from,
+                                virtual_server_id,
+                                virtual_server_id vto,
+                                std::auto_ptr<e::buffer> msg,
+                                e::unpacker up)
+{
+    uint64_t nonce;
+    std::vector<attribute_check> checks;
+    std::vector<aggregate> aggs;
+
+    if ((up >> nonce >> checks >> aggs).error())
+    {
+        LOG(WARNING) << "unpack of REQ_AGGREGATE failed; here's some hex:  " << msg->hex();
+        return;
+    }
+
+    m_sm.aggregate(from, vto, nonce, &checks, &aggs);
+}
+
 void
 daemon :: process_req_search_describe(server_id from,
                                       virtual_server_id,
@@ -1023,6 +1263,106 @@ daemon :: process_req_group_atomic(server_id from,
     m_sm.group_keyop(from, vto, nonce, &checks, REQ_ATOMIC, sl, RESP_GROUP_ATOMIC);
 }
 
+void
+daemon :: process_req_batch(server_id from,
+                            virtual_server_id vfrom,
+                            virtual_server_id,
+                            std::auto_ptr<e::buffer> msg,
+                            e::unpacker up)
+{
+    uint64_t nonce;
+    uint32_t count;
+    up = up >> nonce >> count;
+
+    if (up.error())
+    {
+        LOG(WARNING) << "unpack of REQ_BATCH failed; here's some hex:  " << msg->hex();
+        return;
+    }
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        e::slice body;
+        up = up >> body;
+
+        if (up.error())
+        {
+            LOG(WARNING) << "unpack of REQ_BATCH failed; here's some hex:  " << msg->hex();
+            break;
+        }
+
+        // Each request keeps slices into its own message, so give it one
+        size_t sz = BUSYBEE_HEADER_SIZE + body.size();
+        std::auto_ptr<e::buffer> m(e::buffer::create(sz));
+        memmove(m->data() + BUSYBEE_HEADER_SIZE, body.data(), body.size());
+        m->resize(sz);
+        uint8_t mt;
+        uint8_t flags;
+        uint64_t version;
+        virtual_server_id vto;
+        uint64_t req_nonce;
+        e::unpacker mup = m->unpack_from(BUSYBEE_HEADER_SIZE);
+        mup = mup >> mt >> flags >> version >> vto;
+        // the handlers unpack the nonce themselves, so read it from a copy
+        e::unpacker nup = mup;
+        nup = nup >> req_nonce;
+
+        if (mup.error() || nup.error())
+        {
+            LOG(WARNING) << "unpack of REQ_BATCH failed; here's some hex:  " << msg->hex();
+            break;
+        }
+
+        // communication::recv checked only the batch's header; check each
+        // request's the same way
+        if ((flags & 0x1))
+        {
+            LOG(WARNING) << "REQ_BATCH carries a message between virtual servers;"
+                         << " here's some hex:  " << msg->hex();
+            continue;
+        }
+
+        if ((flags & 0x2) && version < m_config.version())
+        {
+            continue;
+        }
+
+        // The batch went to this server as a whole; each request must still
+        // be for one of our virtual servers, or the client has to retry it.
+        // A request made under a configuration we haven't seen can't be held
+        // back apart from its batch, so it is retried too.
+        if (version > m_config.version() ||
+            m_config.get_server_id(vto) != m_us)
+        {
+            sz = HYPERDEX_HEADER_SIZE_VC + sizeof(uint64_t);
+            std::auto_ptr<e::buffer> bounce(e::buffer::create(sz));
+            bounce->pack_at(HYPERDEX_HEADER_SIZE_VC) << req_nonce;
+            m_comm.send_client(virtual_server_id(UINT64_MAX), from, CONFIGMISMATCH, bounce);
+            continue;
+        }
+
+        switch (static_cast<network_msgtype>(mt))
+        {
+            case REQ_GET:
+                process_req_get(from, vfrom, vto, m, mup);
+                m_perf_req_get.tap();
+                break;
+            case REQ_GET_PARTIAL:
+                process_req_get_partial(from, vfrom, vto, m, mup);
+                m_perf_req_get_partial.tap();
+                break;
+            case REQ_ATOMIC:
+                process_req_atomic(from, vfrom, vto, m, mup);
+                m_perf_req_atomic.tap();
+                break;
+            default:
+                LOG(WARNING) << "REQ_BATCH carries " << static_cast<network_msgtype>(mt)
+                             << " message; here's some hex:  " << msg->hex();
+                break;
+        }
+    }
+}
+
 void
 daemon :: process_chain_op(server_id,
                            virtual_server_id vfrom,
@@ -1093,6 +1433,67 @@ daemon :: process_chain_ack(server_id,
     m_repl.chain_ack(vfrom, vto, version, key);
 }
 
+void
+daemon :: process_chain_batch(server_id from,
+                              virtual_server_id vfrom,
+                              virtual_server_id vto,
+                              std::auto_ptr<e::buffer> msg,
+                              e::unpacker up)
+{
+    uint32_t count;
+
+    if ((up >> count).error())
+    {
+        LOG(WARNING) << "unpack of CHAIN_BATCH failed; here's some hex:  " << msg->hex();
+        return;
+    }
+
+    // Hold what we send on so the batch travels down the chain intact
+    m_comm.cork_chain();
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        uint8_t mt;
+        e::slice body;
+
+        if ((up >> mt >> body).error())
+        {
+            LOG(WARNING) << "unpack of CHAIN_BATCH failed; here's some hex:  " << msg->hex();
+            break;
+        }
+
+        // Each op keeps slices into its own message, so give it one; only
+        // small messages are batched, so the copy is cheap
+        size_t sz = HYPERDEX_HEADER_SIZE_VV + body.size();
+        std::auto_ptr<e::buffer> m(e::buffer::create(sz));
+        memmove(m->data() + HYPERDEX_HEADER_SIZE_VV, body.data(), body.size());
+        m->resize(sz);
+        e::unpacker mup = m->unpack_from(HYPERDEX_HEADER_SIZE_VV);
+
+        switch (static_cast<network_msgtype>(mt))
+        {
+            case CHAIN_OP:
+                process_chain_op(from, vfrom, vto, m, mup);
+                m_perf_chain_op.tap();
+                break;
+            case CHAIN_SUBSPACE:
+                process_chain_subspace(from, vfrom, vto, m, mup);
+                m_perf_chain_subspace.tap();
+                break;
+            case CHAIN_ACK:
+                process_chain_ack(from, vfrom, vto, m, mup);
+                m_perf_chain_ack.tap();
+                break;
+            default:
+                LOG(WARNING) << "CHAIN_BATCH carries " << static_cast<network_msgtype>(mt)
+                             << " message; here's some hex:  " << msg->hex();
+                break;
+        }
+    }
+
+    m_comm.uncork_chain();
+}
+
 void
 daemon :: process_xfer_handshake_syn(server_id,
                                      virtual_server_id vfrom,
@@ -1212,6 +1613,143 @@ daemon :: process_xfer_ack(server_id from,
     m_stm.xfer_ack(from, vto, transfer_id(xid), seq_no);
 }
 
+void
+daemon :: process_bulk_ingest(server_id from,
+                              virtual_server_id,
+                              virtual_server_id vto,
+                              std::auto_ptr<e::buffer> msg,
+                              e::unpacker up)
+{
+    uint64_t nonce;
+    uint64_t batch;
+    uint32_t count;
+
+    if ((up >> nonce >> batch >> count).error())
+    {
+        LOG(WARNING) << "unpack of BULK_INGEST failed; here's some hex:  " << msg->hex();
+        return;
+    }
+
+    std::vector<e::slice> keys;
+    std::vector<std::vector<e::slice> > values;
+    keys.reserve(count);
+    values.reserve(count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        keys.push_back(e::slice());
+        values.push_back(std::vector<e::slice>());
+
+        if ((up >> keys.back() >> values.back()).error())
+        {
+            LOG(WARNING) << "unpack of BULK_INGEST failed; here's some hex:  " << msg->hex();
+            return;
+        }
+    }
+
+    network_returncode result = NET_SUCCESS;
+    const region_id ri(m_config.get_region_id(vto));
+    const schema* sc = m_config.get_schema(ri);
+
+    if (!sc)
+    {
+        result = NET_NOTUS;
+    }
+
+    for (size_t i = 0; result == NET_SUCCESS && i < keys.size(); ++i)
+    {
+        if (values[i].size() + 1 != sc->attrs_sz ||
+            !datatype_info::lookup(sc->attrs[0].type)->validate(keys[i]))
+        {
+            result = NET_BADDIMSPEC;
+        }
+
+        for (size_t j = 0; result == NET_SUCCESS && j < values[i].size(); ++j)
+        {
+            if (!datatype_info::lookup(sc->attrs[j + 1].type)->validate(values[i][j]))
+            {
+                result = NET_BADDIMSPEC;
+            }
+        }
+    }
+
+    // a batch the replication manager takes is answered once the whole
+    // chain has it
+    if (result == NET_SUCCESS && !keys.empty())
+    {
+        result = m_repl.bulk_ingest(vto, from, nonce, batch, keys, values);
+
+        if (result == NET_SUCCESS)
+        {
+            return;
+        }
+    }
+
+    // batch is opaque to us; it tells the admin which of its batches this is
+    size_t sz = HYPERDEX_HEADER_SIZE_VC
+              + sizeof(uint64_t)
+              + sizeof(uint16_t)
+              + sizeof(uint64_t);
+    msg.reset(e::buffer::create(sz));
+    uint16_t rc = static_cast<uint16_t>(result);
+    msg->pack_at(HYPERDEX_HEADER_SIZE_VC) << nonce << rc << batch;
+    m_comm.send_client(vto, from, BULK_INGEST, msg);
+}
+
+void
+daemon :: process_bulk_chain(server_id,
+                             virtual_server_id vfrom,
+                             virtual_server_id vto,
+                             std::auto_ptr<e::buffer> msg,
+                             e::unpacker up)
+{
+    uint64_t first_version;
+    uint32_t count;
+
+    if ((up >> first_version >> count).error())
+    {
+        LOG(WARNING) << "unpack of BULK_CHAIN failed; here's some hex:  " << msg->hex();
+        return;
+    }
+
+    std::vector<e::slice> keys;
+    std::vector<std::vector<e::slice> > values;
+    keys.reserve(count);
+    values.reserve(count);
+
+    for (uint32_t i = 0; i < count; ++i)
+    {
+        keys.push_back(e::slice());
+        values.push_back(std::vector<e::slice>());
+
+        if ((up >> keys.back() >> values.back()).error())
+        {
+            LOG(WARNING) << "unpack of BULK_CHAIN failed; here's some hex:  " << msg->hex();
+            return;
+        }
+    }
+
+    m_repl.bulk_chain(vfrom, vto, first_version, keys, values, msg);
+}
+
+void
+daemon :: process_bulk_ack(server_id,
+                           virtual_server_id vfrom,
+                           virtual_server_id vto,
+                           std::auto_ptr<e::buffer> msg,
+                           e::unpacker up)
+{
+    uint64_t first_version;
+
+    if ((up >> first_version).error())
+    {
+        LOG(WARNING) << "unpack of BULK_ACK failed; here's some hex:  " << msg->hex();
+        return;
+    }
+
+    m_repl.bulk_ack(vfrom, vto, first_version);
+}
+
 void
 daemon :: process_backup(server_id from,
                          virtual_server_id,
@@ -1368,20 +1906,28 @@ void
 daemon :: collect_stats_msgs(std::ostringstream* ret)
 {
     *ret << " msgs.req_get=" << m_perf_req_get.read();
+    *ret << " msgs.req_get_many=" << m_perf_req_get_many.read();
     *ret << " msgs.req_get_partial=" << m_perf_req_get_partial.read();
     *ret << " msgs.req_atomic=" << m_perf_req_atomic.read();
     *ret << " msgs.req_search_start=" << m_perf_req_search_start.read();
     *ret << " msgs.req_search_next=" << m_perf_req_search_next.read();
     *ret << " msgs.req_search_stop=" << m_perf_req_search_stop.read();
     *ret << " msgs.req_sorted_search=" << m_perf_req_sorted_search.read();
+    *ret << " msgs.req_sorted_search_fetch=" << m_perf_req_sorted_search_fetch.read();
     *ret << " msgs.req_count=" << m_perf_req_count.read();
+    *ret << " msgs.req_aggregate=" << m_perf_req_aggregate.read();
     *ret << " msgs.req_search_describe=" << m_perf_req_search_describe.read();
     *ret << " msgs.req_group_atomic=" << m_perf_req_group_atomic.read();
+    *ret << " msgs.req_batch=" << m_perf_req_batch.read();
     *ret << " msgs.chain_op=" << m_perf_chain_op.read();
     *ret << " msgs.chain_subspace=" << m_perf_chain_subspace.read();
     *ret << " msgs.chain_ack=" << m_perf_chain_ack.read();
+    *ret << " msgs.chain_batch=" << m_perf_chain_batch.read();
     *ret << " msgs.xfer_op=" << m_perf_xfer_op.read();
     *ret << " msgs.xfer_ack=" << m_perf_xfer_ack.read();
+    *ret << " msgs.bulk_ingest=" << m_perf_bulk_ingest.read();
+    *ret << " msgs.bulk_chain=" << m_perf_bulk_chain.read();
+    *ret << " msgs.bulk_ack=" << m_perf_bulk_ack.read();
     *ret << " msgs.perf_counters=" << m_perf_perf_counters.read();
 }
 
@@ -1448,6 +1994,56 @@ daemon :: collect_stats_leveldb(std::ostringstream* ret)
             *ret << " leveldb.write" << i << "=" << stats[i].write;
         }
     }
+
+    if (m_data.get_property(e::slice("hyperdex.group_commit"), &tmp))
+    {
+        std::istringstream lines(tmp);
+        std::string line;
+
+        while (std::getline(lines, line))
+        {
+            *ret << " datalayer.group_commit" << line;
+        }
+    }
+
+    if (m_data.get_property(e::slice("hyperdex.group_commit_syncs"), &tmp))
+    {
+        *ret << " datalayer.group_commit_syncs=" << tmp;
+    }
+
+    if (m_data.get_property(e::slice("hyperdex.value_log"), &tmp))
+    {
+        std::istringstream pairs(tmp);
+        std::string pair;
+
+        while (pairs >> pair)
+        {
+            *ret << " datalayer.value_log_" << pair;
+        }
+    }
+
+    if (m_data.get_property(e::slice("hyperdex.row_cache"), &tmp))
+    {
+        std::istringstream pairs(tmp);
+        std::string pair;
+
+        while (pairs >> pair)
+        {
+            *ret << " datalayer.row_cache_" << pair;
+        }
+    }
+
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    m_repl.key_state_cache_stats(&hits, &misses);
+    *ret << " datalayer.key_state_cache_hits=" << hits;
+    *ret << " datalayer.key_state_cache_misses=" << misses;
+
+    uint64_t passes = 0;
+    uint64_t last_pass = 0;
+    m_repl.retransmit_stats(&passes, &last_pass);
+    *ret << " replication.retransmit_passes=" << passes;
+    *ret << " replication.retransmit_last_pass_ns=" << last_pass;
 }
 
 namespace
@@ -63,9 +63,12 @@
 #include "daemon/datalayer.h"
 #include "daemon/datalayer_checkpointer_thread.h"
 #include "daemon/datalayer_encodings.h"
+#include "daemon/datalayer_group_commit.h"
 #include "daemon/datalayer_index_state.h"
 #include "daemon/datalayer_indexer_thread.h"
 #include "daemon/datalayer_iterator.h"
+#include "daemon/datalayer_row_cache.h"
+#include "daemon/datalayer_value_log.h"
 #include "daemon/datalayer_wiper_thread.h"
 
 #define STRLENOF(x)	(sizeof(x)-1)
@@ -87,6 +90,11 @@ datalayer :: datalayer(daemon* d)
     , m_mediator(new wiper_indexer_mediator())
     , m_indexer(new indexer_thread(d, m_mediator.get()))
     , m_wiper(new wiper_thread(d, m_mediator.get()))
+    , m_group_commit(new group_commit())
+    , m_value_log(new value_log())
+    , m_row_cache(new row_cache())
+    , m_syncer(make_thread_wrapper(&datalayer::sync_periodic, this))
+    , m_syncer_started(false)
 {
 }
 
@@ -95,6 +103,7 @@ datalayer :: ~datalayer() throw ()
     m_checkpointer->shutdown();
     m_indexer->shutdown();
     m_wiper->shutdown();
+    stop_syncer();
 }
 
 #define FORMAT_1_6 "v1.6.0 format"
@@ -209,9 +218,16 @@ datalayer :: initialize(const std::string& path,
         return false;
     }
 
+    if (!m_value_log->open(path))
+    {
+        return false;
+    }
+
     m_checkpointer->start();
     m_indexer->start();
     m_wiper->start();
+    m_syncer.start();
+    m_syncer_started = true;
     *saved = !first_time;
     return true;
 }
@@ -222,6 +238,7 @@ datalayer :: teardown()
     m_checkpointer->shutdown();
     m_indexer->shutdown();
     m_wiper->shutdown();
+    stop_syncer();
 }
 
 bool
@@ -395,10 +412,82 @@ bool
 datalayer :: get_property(const e::slice& property,
                           std::string* value)
 {
+    if (property == e::slice("hyperdex.group_commit"))
+    {
+        *value = m_group_commit->histogram();
+        return true;
+    }
+
+    if (property == e::slice("hyperdex.group_commit_syncs"))
+    {
+        std::ostringstream ostr;
+        ostr << m_group_commit->syncs();
+        *value = ostr.str();
+        return true;
+    }
+
+    if (property == e::slice("hyperdex.value_log"))
+    {
+        *value = m_value_log->stats();
+        return true;
+    }
+
+    if (property == e::slice("hyperdex.row_cache"))
+    {
+        *value = m_row_cache->stats();
+        return true;
+    }
+
     leveldb::Slice prop(reinterpret_cast<const char*>(property.data()), property.size());
     return m_db->GetProperty(prop, value);
 }
 
+void
+datalayer :: set_group_commit(size_t max_batch, uint64_t max_delay,
+                              uint64_t sync_interval)
+{
+    m_group_commit->configure(max_batch, max_delay);
+    m_group_commit->configure_sync(sync_interval);
+}
+
+void
+datalayer :: sync_periodic()
+{
+    while (m_group_commit->wait_for_sync_due())
+    {
+        leveldb::Status st = m_group_commit->sync_if_due(m_db.get());
+
+        if (!st.ok())
+        {
+            handle_error(st);
+        }
+    }
+}
+
+void
+datalayer :: stop_syncer()
+{
+    m_group_commit->stop_syncing();
+
+    if (m_syncer_started)
+    {
+        m_syncer.join();
+        m_syncer_started = false;
+    }
+}
+
+void
+datalayer :: set_value_log(size_t threshold)
+{
+    m_value_log->set_threshold(threshold);
+}
+
+void
+datalayer :: set_row_cache(uint64_t bytes)
+{
+    m_row_cache->set_budget(bytes);
+}
+
 std::string
 datalayer :: get_timestamp()
 {
@@ -424,6 +513,28 @@ datalayer :: get(const region_id& ri,
                  std::vector<e::slice>* value,
                  uint64_t* version,
                  reference* ref)
+{
+    return get(ri, NULL, key, value, version, ref);
+}
+
+datalayer::returncode
+datalayer :: get(const region_id& ri,
+                 snapshot snap,
+                 const e::slice& key,
+                 std::vector<e::slice>* value,
+                 uint64_t* version,
+                 reference* ref)
+{
+    return get(ri, snap.get(), key, value, version, ref);
+}
+
+datalayer::returncode
+datalayer :: get(const region_id& ri,
+                 const leveldb::Snapshot* snap,
+                 const e::slice& key,
+                 std::vector<e::slice>* value,
+                 uint64_t* version,
+                 reference* ref)
 {
     const schema& sc(*m_daemon->m_config.get_schema(ri));
     std::vector<char> scratch;
@@ -432,16 +543,34 @@ datalayer :: get(const region_id& ri,
     leveldb::Slice lkey;
     encode_key(ri, sc.attrs[0].type, key, &scratch, &lkey);
 
+    // the cache holds only the latest value, which a snapshot may not see
+    const bool cached = !snap && m_row_cache->enabled();
+    // keep every segment a pointer read below could name
+    value_log::pin pin(m_value_log.get());
+    uint64_t generation = 0;
+
+    if (cached && m_row_cache->get(lkey, &ref->m_backing, &generation))
+    {
+        e::slice v(ref->m_backing.data(), ref->m_backing.size());
+        return decode_object(v, value, version, ref);
+    }
+
     // perform the read
     leveldb::ReadOptions opts;
     opts.fill_cache = true;
     opts.verify_checksums = true;
+    opts.snapshot = snap;
     leveldb::Status st = m_db->Get(opts, lkey, &ref->m_backing);
 
     if (st.ok())
     {
+        if (cached)
+        {
+            m_row_cache->fill(lkey, ref->m_backing, generation);
+        }
+
         e::slice v(ref->m_backing.data(), ref->m_backing.size());
-        return decode_value(v, value, version);
+        return decode_object(v, value, version, ref);
     }
     else if (st.IsNotFound())
     {
@@ -466,6 +595,16 @@ datalayer :: del(const region_id& ri,
     leveldb::Slice lkey;
     encode_key(ri, sc.attrs[0].type, key, &scratch, &lkey);
 
+    // release whatever the object kept in the value log
+    value_log::key_guard kg(m_value_log.get(), key);
+    returncode rc = encode_object(ri, sc, lkey, key, &old_value, NULL,
+                                  0, NULL, NULL);
+
+    if (rc != SUCCESS)
+    {
+        return rc;
+    }
+
     // delete the actual object
     updates.Delete(lkey);
 
@@ -475,9 +614,8 @@ datalayer :: del(const region_id& ri,
     create_index_changes(sc, ri, indices, key, &old_value, NULL, &updates);
 
     // Perform the write
-    leveldb::WriteOptions opts;
-    opts.sync = false;
-    leveldb::Status st = m_db->Write(opts, &updates);
+    leveldb::Status st = m_group_commit->write(m_db.get(), &updates, sc.durability);
+    m_row_cache->forget(lkey);
 
     if (st.ok())
     {
@@ -509,8 +647,15 @@ datalayer :: put(const region_id& ri,
     encode_key(ri, sc.attrs[0].type, key, &scratch1, &lkey);
 
     // create the encoded value
+    value_log::key_guard kg(m_value_log.get(), key);
     leveldb::Slice lval;
-    encode_value(new_value, version, &scratch2, &lval);
+    returncode rc = encode_object(ri, sc, lkey, key, NULL, &new_value,
+                                  version, &scratch2, &lval);
+
+    if (rc != SUCCESS)
+    {
+        return rc;
+    }
 
     // put the actual object
     updates.Put(lkey, lval);
@@ -524,17 +669,17 @@ datalayer :: put(const region_id& ri,
     write_version(ri, version, &updates);
 
     // Perform the write
-    leveldb::WriteOptions opts;
-    opts.sync = false;
-    leveldb::Status st = m_db->Write(opts, &updates);
+    leveldb::Status st = m_group_commit->write(m_db.get(), &updates, sc.durability);
 
     if (st.ok())
     {
+        m_row_cache->put(lkey, lval);
         update_memory_version(ri, version);
         return SUCCESS;
     }
     else
     {
+        m_row_cache->forget(lkey);
         return handle_error(st);
     }
 }
@@ -556,8 +701,15 @@ datalayer :: overput(const region_id& ri,
     encode_key(ri, sc.attrs[0].type, key, &scratch1, &lkey);
 
     // create the encoded value
+    value_log::key_guard kg(m_value_log.get(), key);
     leveldb::Slice lval;
-    encode_value(new_value, version, &scratch2, &lval);
+    returncode rc = encode_object(ri, sc, lkey, key, &old_value, &new_value,
+                                  version, &scratch2, &lval);
+
+    if (rc != SUCCESS)
+    {
+        return rc;
+    }
 
     // put the actual object
     updates.Put(lkey, lval);
@@ -571,17 +723,17 @@ datalayer :: overput(const region_id& ri,
     write_version(ri, version, &updates);
 
     // Perform the write
-    leveldb::WriteOptions opts;
-    opts.sync = false;
-    leveldb::Status st = m_db->Write(opts, &updates);
+    leveldb::Status st = m_group_commit->write(m_db.get(), &updates, sc.durability);
 
     if (st.ok())
     {
+        m_row_cache->put(lkey, lval);
         update_memory_version(ri, version);
         return SUCCESS;
     }
     else
     {
+        m_row_cache->forget(lkey);
         return handle_error(st);
     }
 }
@@ -598,18 +750,18 @@ datalayer :: uncertain_del(const region_id& ri,
     encode_key(ri, sc.attrs[0].type, key, &scratch, &lkey);
 
     // perform the read
-    std::string ref;
+    reference ref;
     leveldb::ReadOptions opts;
     opts.fill_cache = true;
     opts.verify_checksums = true;
-    leveldb::Status st = m_db->Get(opts, lkey, &ref);
+    leveldb::Status st = m_db->Get(opts, lkey, &ref.m_backing);
 
     if (st.ok())
     {
         std::vector<e::slice> old_value;
         uint64_t old_version;
-        returncode rc = decode_value(e::slice(ref.data(), ref.size()),
-                                     &old_value, &old_version);
+        returncode rc = decode_object(e::slice(ref.m_backing.data(), ref.m_backing.size()),
+                                      &old_value, &old_version, &ref);
 
         if (rc != SUCCESS)
         {
@@ -647,18 +799,18 @@ datalayer :: uncertain_put(const region_id& ri,
     encode_key(ri, sc.attrs[0].type, key, &scratch, &lkey);
 
     // perform the read
-    std::string ref;
+    reference ref;
     leveldb::ReadOptions opts;
     opts.fill_cache = true;
     opts.verify_checksums = true;
-    leveldb::Status st = m_db->Get(opts, lkey, &ref);
+    leveldb::Status st = m_db->Get(opts, lkey, &ref.m_backing);
 
     if (st.ok())
     {
         std::vector<e::slice> old_value;
         uint64_t old_version;
-        returncode rc = decode_value(e::slice(ref.data(), ref.size()),
-                                     &old_value, &old_version);
+        returncode rc = decode_object(e::slice(ref.m_backing.data(), ref.m_backing.size()),
+                                      &old_value, &old_version, &ref);
 
         if (rc != SUCCESS)
         {
@@ -682,19 +834,172 @@ datalayer :: uncertain_put(const region_id& ri,
     }
 }
 
+datalayer::returncode
+datalayer :: bulk_put(const region_id& ri,
+                      const std::vector<e::slice>& keys,
+                      const std::vector<std::vector<e::slice> >& values,
+                      uint64_t first_version)
+{
+    assert(keys.size() == values.size());
+
+    if (keys.empty())
+    {
+        return SUCCESS;
+    }
+
+    leveldb::WriteBatch updates;
+    const schema& sc(*m_daemon->m_config.get_schema(ri));
+    std::vector<const index*> indices;
+    find_indices(ri, &indices);
+    value_log::key_guard kg(m_value_log.get(), keys);
+    const bool read_old = !indices.empty() || m_value_log->active();
+    std::vector<char> scratch1;
+    std::vector<char> scratch2;
+    leveldb::ReadOptions opts;
+    opts.fill_cache = false;
+    opts.verify_checksums = true;
+
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        // create the encoded key
+        leveldb::Slice lkey;
+        encode_key(ri, sc.attrs[0].type, keys[i], &scratch1, &lkey);
+
+        // without indices or the value log there is nothing the old value
+        // could change
+        reference ref;
+        std::vector<e::slice> old_value;
+        bool has_old = false;
+
+        if (read_old)
+        {
+            leveldb::Status st = m_db->Get(opts, lkey, &ref.m_backing);
+
+            if (st.ok())
+            {
+                uint64_t old_version;
+                returncode rc = decode_object(e::slice(ref.m_backing.data(), ref.m_backing.size()),
+                                              &old_value, &old_version, &ref);
+
+                if (rc != SUCCESS)
+                {
+                    return rc;
+                }
+
+                if (old_value.size() + 1 != sc.attrs_sz)
+                {
+                    return BAD_ENCODING;
+                }
+
+                has_old = true;
+            }
+            else if (!st.IsNotFound())
+            {
+                return handle_error(st);
+            }
+        }
+
+        // create the encoded value and put the actual object
+        leveldb::Slice lval;
+        returncode rc = encode_object(ri, sc, lkey, keys[i],
+                                      has_old ? &old_value : NULL,
+                                      &values[i], first_version + i,
+                                      &scratch2, &lval);
+
+        if (rc != SUCCESS)
+        {
+            return rc;
+        }
+
+        updates.Put(lkey, lval);
+
+        // put the index entries
+        create_index_changes(sc, ri, indices, keys[i],
+                             has_old ? &old_value : NULL,
+                             &values[i], &updates);
+    }
+
+    // ensure we've recorded a version at least as high as every key
+    const uint64_t last_version = first_version + keys.size() - 1;
+    write_version(ri, last_version, &updates);
+
+    // Perform the write
+    leveldb::Status st = m_group_commit->write(m_db.get(), &updates, sc.durability);
+
+    // whatever the outcome, the cache cannot vouch for these keys any more
+    if (m_row_cache->enabled())
+    {
+        for (size_t i = 0; i < keys.size(); ++i)
+        {
+            leveldb::Slice lkey;
+            encode_key(ri, sc.attrs[0].type, keys[i], &scratch1, &lkey);
+            m_row_cache->forget(lkey);
+        }
+    }
+
+    if (st.ok())
+    {
+        update_memory_version(ri, last_version);
+        return SUCCESS;
+    }
+    else
+    {
+        return handle_error(st);
+    }
+}
+
 datalayer::snapshot
 datalayer :: make_snapshot()
 {
-    return leveldb_snapshot_ptr(m_db, m_db->GetSnapshot());
+    // pin first so nothing the snapshot can see is retired out from under it
+    e::compat::shared_ptr<value_log::pin> p(new value_log::pin(m_value_log.get()));
+    leveldb_snapshot_ptr snap(m_db, m_db->GetSnapshot());
+    snap.keep(p);
+    return snap;
+}
+
+datalayer::iterator*
+datalayer :: make_search_iterator(snapshot snap,
+                                  const region_id& ri,
+                                  const std::vector<attribute_check>& checks,
+                                  std::ostringstream* ostr)
+{
+    bool ordered = false;
+    return make_search_iterator(snap, ri, checks, UINT16_MAX, false, &ordered, ostr);
+}
+
+// Reading an object through an index is a random read, while a full scan
+// reads the region sequentially; charge each object an index selects this many
+// times the sequential cost of reading it.
+#define PLANNER_RANDOM_READ_PENALTY 3
+
+namespace
+{
+
+struct plan_step
+{
+    plan_step(e::intrusive_ptr<datalayer::index_iterator> i, uint64_t c, double s)
+        : iter(i), cost(c), selectivity(s) {}
+    bool operator < (const plan_step& rhs) const { return cost < rhs.cost; }
+
+    e::intrusive_ptr<datalayer::index_iterator> iter;
+    uint64_t cost;
+    double selectivity;
+};
+
 }
 
 datalayer::iterator*
 datalayer :: make_search_iterator(snapshot snap,
                                   const region_id& ri,
                                   const std::vector<attribute_check>& checks,
+                                  uint16_t sort_by,
+                                  bool maximize,
+                                  bool* ordered,
                                   std::ostringstream* ostr)
 {
     const schema& sc(*m_daemon->m_config.get_schema(ri));
+    *ordered = false;
     std::vector<e::intrusive_ptr<index_iterator> > iterators;
 
     // pull a set of range queries from checks
@@ -770,57 +1075,293 @@ datalayer :: make_search_iterator(snapshot snap,
     // figure out the cost of accessing all objects
     e::intrusive_ptr<index_iterator> full_scan;
     full_scan = key_ii->iterator_for_keys(snap, ri);
-    if (ostr) *ostr << " accessing all objects has cost " << full_scan->cost(m_db.get()) << "\n";
+    const uint64_t full_cost = full_scan->cost(m_db.get());
+    if (ostr) *ostr << " plan full_scan cost=" << full_cost << "\n";
 
     // figure out the cost of each iterator
     // we do this here and not below so that iterators can cache the size and we
-    // don't ping-pong between HyperDex and LevelDB.
+    // don't ping-pong between HyperDex and LevelDB.  An iterator's selectivity
+    // is the fraction of the region's bytes that its range covers.
+    std::vector<plan_step> sorted;
+    std::vector<plan_step> unsorted;
+
     for (size_t i = 0; i < iterators.size(); ++i)
     {
-        uint64_t iterator_cost = iterators[i]->cost(m_db.get());
-        if (ostr) *ostr << " iterator " << *iterators[i] << " has cost " << iterator_cost << "\n";
+        uint64_t c = iterators[i]->cost(m_db.get());
+        double sel = full_cost > 0 ? std::min(1.0, double(c) / full_cost) : 0.0;
+        bool is_sorted = iterators[i]->sorted();
+        if (ostr) *ostr << " plan index " << *iterators[i] << " cost=" << c
+                        << " selectivity=" << sel
+                        << (is_sorted ? " sorted" : " unsorted") << "\n";
+        (is_sorted ? sorted : unsorted).push_back(plan_step(iterators[i], c, sel));
     }
 
-    std::vector<e::intrusive_ptr<index_iterator> > sorted;
-    std::vector<e::intrusive_ptr<index_iterator> > unsorted;
+    std::sort(sorted.begin(), sorted.end());
+    std::sort(unsorted.begin(), unsorted.end());
+    e::intrusive_ptr<index_iterator> best = full_scan;
+    double best_cost = full_cost;
 
-    for (size_t i = 0; i < iterators.size(); ++i)
+    // Without a size for the region (e.g., it is all still in the memtable)
+    // there are no selectivities to plan with.  Plan the way HyperDex always
+    // has:  intersect every sorted index, and abandon an index that claims
+    // to cost more than a quarter of a region that claims to cost nothing.
+    if (full_cost == 0)
+    {
+        if (sorted.size() == 1)
+        {
+            best = sorted[0].iter;
+        }
+        else if (!sorted.empty())
+        {
+            std::vector<e::intrusive_ptr<index_iterator> > chosen;
+
+            for (size_t i = 0; i < sorted.size(); ++i)
+            {
+                chosen.push_back(sorted[i].iter);
+            }
+
+            best = new intersect_iterator(snap, chosen);
+        }
+        else if (!unsorted.empty())
+        {
+            best = unsorted[0].iter;
+        }
+
+        uint64_t cost = best->cost(m_db.get());
+
+        if (cost > 0 && cost * 4 > full_cost)
+        {
+            best = full_scan;
+        }
+    }
+
+    // Sorted iterators can be intersected.  Take them most selective first,
+    // and add each one only while seeking into it costs less than the object
+    // reads it saves.
+    if (full_cost > 0 && !sorted.empty())
     {
-        if (iterators[i]->sorted())
+        std::vector<e::intrusive_ptr<index_iterator> > chosen;
+        chosen.push_back(sorted[0].iter);
+        double index_cost = sorted[0].cost;
+        double sel = sorted[0].selectivity;
+
+        for (size_t i = 1; i < sorted.size(); ++i)
         {
-            sorted.push_back(iterators[i]);
+            // one seek per surviving candidate, but never more than reading
+            // the iterator's whole range
+            double probe = std::min(double(sorted[i].cost), sel * full_cost);
+            double saved = PLANNER_RANDOM_READ_PENALTY * sel * full_cost
+                         * (1.0 - sorted[i].selectivity);
+
+            if (probe < saved)
+            {
+                chosen.push_back(sorted[i].iter);
+                index_cost += probe;
+                sel *= sorted[i].selectivity;
+                if (ostr) *ostr << " plan intersect " << *sorted[i].iter << " probe=" << probe << " saves=" << saved << "\n";
+            }
+            else
+            {
+                if (ostr) *ostr << " plan skip " << *sorted[i].iter << " probe=" << probe << " saves=" << saved << "\n";
+            }
+        }
+
+        double c = index_cost + PLANNER_RANDOM_READ_PENALTY * sel * full_cost;
+        if (ostr) *ostr << " plan intersection of " << chosen.size() << " indices cost=" << c
+                        << " selectivity=" << sel << "\n";
+
+        if (c <= best_cost && chosen.size() == 1)
+        {
+            best = chosen[0];
+            best_cost = c;
+        }
+        else if (c <= best_cost)
+        {
+            best = new intersect_iterator(snap, chosen);
+            best_cost = c;
+        }
+    }
+
+    // An unsorted iterator cannot be intersected and must be used alone
+    if (full_cost > 0 && !unsorted.empty())
+    {
+        double c = unsorted[0].cost
+                 + PLANNER_RANDOM_READ_PENALTY * unsorted[0].selectivity * full_cost;
+        if (ostr) *ostr << " plan single " << *unsorted[0].iter << " cost=" << c << "\n";
+
+        if (c < best_cost || (c <= best_cost && best.get() == full_scan.get()))
+        {
+            best = unsorted[0].iter;
+            best_cost = c;
+        }
+    }
+
+    assert(best);
+
+    // If the caller wants objects ordered by sort_by and an index can walk
+    // them in that order, prefer it unless another index is far more
+    // selective.  The caller can then stop after the first few matches.
+    e::intrusive_ptr<index_iterator> in_order;
+
+    if (sort_by == 0)
+    {
+        in_order = key_ii->iterator_for_sort(snap, ri, index_id(), 0, maximize, key_ie);
+    }
+    else if (sort_by < sc.attrs_sz)
+    {
+        std::vector<const index*> indices;
+        find_indices(ri, sort_by, &indices);
+        const index_info* ii = index_info::lookup(sc.attrs[sort_by].type);
+
+        for (size_t i = 0; ii && !in_order && i < indices.size(); ++i)
+        {
+            if (indices[i]->type != index::NORMAL)
+            {
+                continue;
+            }
+
+            in_order = ii->iterator_for_sort(snap, ri, indices[i]->id, sort_by, maximize, key_ie);
+        }
+    }
+
+    if (in_order)
+    {
+        uint64_t in_order_cost = in_order->cost(m_db.get());
+        if (ostr) *ostr << " iterating in order of attr " << sort_by << " has cost " << in_order_cost << "\n";
+
+        if (best.get() == full_scan.get() || best->cost(m_db.get()) * 4 > in_order_cost)
+        {
+            best = in_order;
+            *ordered = true;
+        }
+    }
+
+    if (ostr) *ostr << " choosing to use " << *best << "\n";
+    return new search_iterator(this, ri, best, ostr, &checks);
+}
+
+bool
+datalayer :: count_from_indices(snapshot snap,
+                                const region_id& ri,
+                                const std::vector<attribute_check>& checks,
+                                uint64_t* count)
+{
+    const schema& sc(*m_daemon->m_config.get_schema(ri));
+    const index_encoding* key_ie = index_encoding::lookup(sc.attrs[0].type);
+    const index_info* key_ii = index_info::lookup(sc.attrs[0].type);
+
+    // Ranges are inclusive, so only these predicates are answered exactly by
+    // walking a range; anything else must be checked against the object.
+    for (size_t i = 0; i < checks.size(); ++i)
+    {
+        if (checks[i].attr >= sc.attrs_sz ||
+            checks[i].datatype != sc.attrs[checks[i].attr].type)
+        {
+            return false;
+        }
+
+        switch (checks[i].predicate)
+        {
+            case HYPERPREDICATE_EQUALS:
+            case HYPERPREDICATE_LESS_EQUAL:
+            case HYPERPREDICATE_GREATER_EQUAL:
+                break;
+            default:
+                return false;
+        }
+    }
+
+    std::vector<range> ranges;
+    range_searches(sc, checks, &ranges);
+    std::vector<e::intrusive_ptr<index_iterator> > iterators;
+
+    for (size_t i = 0; i < ranges.size(); ++i)
+    {
+        if (ranges[i].invalid)
+        {
+            *count = 0;
+            return true;
+        }
+
+        e::intrusive_ptr<index_iterator> it;
+
+        if (ranges[i].attr == 0)
+        {
+            it = key_ii->iterator_from_range(snap, ri, index_id(), ranges[i], key_ie);
         }
         else
         {
-            unsorted.push_back(iterators[i]);
+            std::vector<const index*> indices;
+            find_indices(ri, ranges[i].attr, &indices);
+            const index_info* ii = index_info::lookup(ranges[i].type);
+
+            for (size_t j = 0; ii && !it && j < indices.size(); ++j)
+            {
+                if (indices[j]->type == index::NORMAL)
+                {
+                    it = ii->iterator_from_range(snap, ri, indices[j]->id, ranges[i], key_ie);
+                }
+            }
         }
+
+        if (!it)
+        {
+            return false;
+        }
+
+        iterators.push_back(it);
     }
 
-    e::intrusive_ptr<index_iterator> best;
+    // every check must have been folded into one of the ranges
+    for (size_t i = 0; i < checks.size(); ++i)
+    {
+        bool covered = false;
+
+        for (size_t j = 0; !covered && j < ranges.size(); ++j)
+        {
+            covered = ranges[j].attr == checks[i].attr;
+        }
 
-    if (!best && !sorted.empty())
+        if (!covered)
+        {
+            return false;
+        }
+    }
+
+    e::intrusive_ptr<index_iterator> iter;
+
+    if (iterators.empty())
     {
-        best = new intersect_iterator(snap, sorted);
+        iter = key_ii->iterator_for_keys(snap, ri);
     }
-    else if (!best && !unsorted.empty())
+    else if (iterators.size() == 1)
     {
-        best = unsorted[0];
+        iter = iterators[0];
     }
     else
     {
-        best = full_scan;
+        // only equality ranges walk keys in order and can be intersected
+        for (size_t i = 0; i < iterators.size(); ++i)
+        {
+            if (!iterators[i]->sorted())
+            {
+                return false;
+            }
+        }
+
+        iter = new intersect_iterator(snap, iterators);
     }
 
-    assert(best);
-    uint64_t cost = best->cost(m_db.get());
+    uint64_t result = 0;
 
-    if (cost > 0 && cost * 4 > full_scan->cost(m_db.get()))
+    while (iter->valid())
     {
-        best = full_scan;
+        ++result;
+        iter->next();
     }
 
-    if (ostr) *ostr << " choosing to use " << *best << "\n";
-    return new search_iterator(this, ri, best, ostr, &checks);
+    *count = result;
+    return true;
 }
 
 bool
@@ -831,7 +1372,7 @@ datalayer :: backup(const e::slice& _name)
 
     if (st.ok())
     {
-        return true;
+        return m_value_log->backup(name.ToString());
     }
     else if (st.IsCorruption())
     {
@@ -859,6 +1400,18 @@ datalayer :: get_from_iterator(const region_id& ri,
                                uint64_t* version,
                                reference* ref)
 {
+    // the iterator already read the object; copy it rather than read it again
+    if (iter->has_value())
+    {
+        e::slice k = iter->key();
+        e::slice v = iter->value();
+        ref->m_backing.assign(reinterpret_cast<const char*>(v.data()), v.size());
+        ref->m_backing.append(reinterpret_cast<const char*>(k.data()), k.size());
+        *key = e::slice(ref->m_backing.data() + v.size(), k.size());
+        v = e::slice(ref->m_backing.data(), v.size());
+        return decode_object(v, value, version, ref);
+    }
+
     std::vector<char> scratch;
 
     // create the encoded key
@@ -880,7 +1433,7 @@ datalayer :: get_from_iterator(const region_id& ri,
                         - iter->key().size(),
                         iter->key().size());
         e::slice v(ref->m_backing.data(), ref->m_backing.size() - iter->key().size());
-        return decode_value(v, value, version);
+        return decode_object(v, value, version, ref);
     }
     else if (st.IsNotFound())
     {
@@ -906,6 +1459,373 @@ roundup_version(uint64_t v)
 
 }
 
+datalayer::returncode
+datalayer :: decode_object(const e::slice& in,
+                           std::vector<e::slice>* value,
+                           uint64_t* version,
+                           reference* ref)
+{
+    std::vector<bool> indirect;
+    returncode rc = decode_value(in, value, &indirect, version);
+
+    if (rc != SUCCESS)
+    {
+        return rc;
+    }
+
+    size_t sz = 0;
+    bool any = false;
+
+    for (size_t i = 0; i < indirect.size(); ++i)
+    {
+        if (!indirect[i])
+        {
+            continue;
+        }
+
+        if ((*value)[i].size() != VALUE_POINTER_SIZE)
+        {
+            return BAD_ENCODING;
+        }
+
+        sz += value_log::value_size((*value)[i]);
+        any = true;
+    }
+
+    if (!any)
+    {
+        return SUCCESS;
+    }
+
+    ref->m_indirect.resize(sz);
+    char* ptr = sz > 0 ? &ref->m_indirect[0] : NULL;
+
+    for (size_t i = 0; i < indirect.size(); ++i)
+    {
+        if (!indirect[i])
+        {
+            continue;
+        }
+
+        const uint32_t attr_sz = value_log::value_size((*value)[i]);
+
+        if (attr_sz > 0 && !m_value_log->read((*value)[i], ptr))
+        {
+            return IO_ERROR;
+        }
+
+        (*value)[i] = e::slice(ptr, attr_sz);
+        ptr += attr_sz;
+    }
+
+    return SUCCESS;
+}
+
+namespace
+{
+
+// every attribute in the value log is at least this large
+bool
+may_have_indirect(const std::vector<e::slice>& value)
+{
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        if (value[i].size() >= VALUE_LOG_MIN_THRESHOLD)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+} // namespace
+
+datalayer::returncode
+datalayer :: encode_object(const region_id& ri,
+                           const schema& sc,
+                           const leveldb::Slice& lkey,
+                           const e::slice& key,
+                           const std::vector<e::slice>* old_value,
+                           const std::vector<e::slice>* new_value,
+                           uint64_t version,
+                           std::vector<char>* backing,
+                           leveldb::Slice* out)
+{
+    if (!m_value_log->active())
+    {
+        if (new_value)
+        {
+            encode_value(*new_value, version, backing, out);
+        }
+
+        return SUCCESS;
+    }
+
+    // the object as stored, so we know which attributes it keeps in the log
+    std::string old_backing;
+    std::vector<e::slice> old_stored;
+    std::vector<bool> old_indirect;
+
+    if (old_value && may_have_indirect(*old_value))
+    {
+        leveldb::ReadOptions opts;
+        opts.fill_cache = true;
+        opts.verify_checksums = true;
+        leveldb::Status st = m_db->Get(opts, lkey, &old_backing);
+
+        if (st.ok())
+        {
+            uint64_t old_version;
+            returncode rc = decode_value(e::slice(old_backing.data(), old_backing.size()),
+                                         &old_stored, &old_indirect, &old_version);
+
+            if (rc != SUCCESS)
+            {
+                return rc;
+            }
+
+            if (old_stored.size() + 1 != sc.attrs_sz ||
+                old_value->size() != old_stored.size())
+            {
+                return BAD_ENCODING;
+            }
+        }
+        else if (!st.IsNotFound())
+        {
+            return handle_error(st);
+        }
+    }
+
+    const size_t threshold = m_value_log->threshold();
+    std::vector<e::slice> stored;
+    std::vector<bool> indirect;
+    std::vector<char> pointers;
+    bool appended = false;
+
+    if (new_value)
+    {
+        stored = *new_value;
+        indirect.resize(stored.size(), false);
+        pointers.resize(stored.size() * VALUE_POINTER_SIZE);
+    }
+
+    for (size_t i = 0; threshold > 0 && i < stored.size(); ++i)
+    {
+        if (stored[i].size() < threshold)
+        {
+            continue;
+        }
+
+        char* ptr = &pointers[i * VALUE_POINTER_SIZE];
+
+        // an unchanged attribute keeps the record it already has
+        if (i < old_indirect.size() && old_indirect[i] &&
+            old_stored[i].size() == VALUE_POINTER_SIZE &&
+            (*old_value)[i] == (*new_value)[i])
+        {
+            memmove(ptr, old_stored[i].data(), VALUE_POINTER_SIZE);
+            old_indirect[i] = false;
+        }
+        else if (m_value_log->append(ri, i + 1, key, (*new_value)[i], ptr))
+        {
+            appended = true;
+        }
+        else
+        {
+            return IO_ERROR;
+        }
+
+        stored[i] = e::slice(ptr, VALUE_POINTER_SIZE);
+        indirect[i] = true;
+    }
+
+    // the LevelDB write must not reach the disk ahead of what it points to;
+    // even an unsynced write may be made durable by a later synced write or
+    // a memtable flush, so sync no matter the durability
+    if (appended && !m_value_log->sync())
+    {
+        return IO_ERROR;
+    }
+
+    for (size_t i = 0; i < old_indirect.size(); ++i)
+    {
+        if (old_indirect[i] && old_stored[i].size() == VALUE_POINTER_SIZE)
+        {
+            m_value_log->release(old_stored[i]);
+        }
+    }
+
+    if (new_value)
+    {
+        encode_value(stored, indirect, version, backing, out);
+    }
+
+    return SUCCESS;
+}
+
+void
+datalayer :: collect_value_log(const std::string& lower_bound)
+{
+    m_value_log->release_retired(m_db.get(), lower_bound);
+    uint64_t number;
+
+    if (!m_value_log->pick(&number))
+    {
+        return;
+    }
+
+    std::vector<value_log::entry> entries;
+    uint64_t size = 0;
+
+    if (!m_value_log->scan(number, &entries, &size))
+    {
+        return;
+    }
+
+    // a wipe that starts after we check a region could miss an object we
+    // repoint, bringing it back; hold wipes off until we are done
+    m_wiper->inhibit_wiping();
+    e::guard g = e::makeobjguard(*m_wiper, &wiper_thread::permit_wiping);
+    g.use_variable();
+    std::vector<bool> live(entries.size(), false);
+    uint64_t live_bytes = 0;
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        const value_log::entry& ent(entries[i]);
+        e::slice key(ent.key.data(), ent.key.size());
+        e::slice ptr(ent.ptr, VALUE_POINTER_SIZE);
+        std::string backing;
+        std::vector<e::slice> stored;
+        std::vector<bool> indirect;
+        uint64_t version;
+        live[i] = value_log_live(ent.ri, ent.attr, key, ptr,
+                                 &backing, &stored, &indirect, &version);
+        live_bytes += live[i] ? value_log::value_size(ptr) : 0;
+    }
+
+    // not yet worth rewriting; wait for more of it to become garbage
+    if (live_bytes * 2 > size)
+    {
+        m_value_log->scanned(number, live_bytes);
+        return;
+    }
+
+    for (size_t i = 0; i < entries.size(); ++i)
+    {
+        if (!live[i])
+        {
+            continue;
+        }
+
+        const value_log::entry& ent(entries[i]);
+        e::slice key(ent.key.data(), ent.key.size());
+        e::slice ptr(ent.ptr, VALUE_POINTER_SIZE);
+        value_log::key_guard kg(m_value_log.get(), key);
+        std::string backing;
+        std::vector<e::slice> stored;
+        std::vector<bool> indirect;
+        uint64_t version;
+
+        // a write may have replaced it since we looked
+        if (!value_log_live(ent.ri, ent.attr, key, ptr,
+                            &backing, &stored, &indirect, &version))
+        {
+            continue;
+        }
+
+        const schema& sc(*m_daemon->m_config.get_schema(ent.ri));
+        const uint32_t value_sz = value_log::value_size(ptr);
+        std::vector<char> value(std::max(value_sz, 1U));
+        char moved[VALUE_POINTER_SIZE];
+
+        if (!m_value_log->read(ptr, &value[0]) ||
+            !m_value_log->append(ent.ri, ent.attr, key,
+                                 e::slice(&value[0], value_sz), moved))
+        {
+            m_value_log->scanned(number, live_bytes);
+            return;
+        }
+
+        stored[ent.attr - 1] = e::slice(moved, VALUE_POINTER_SIZE);
+        std::vector<char> scratch1;
+        std::vector<char> scratch2;
+        leveldb::Slice lkey;
+        leveldb::Slice lval;
+        encode_key(ent.ri, sc.attrs[0].type, key, &scratch1, &lkey);
+        encode_value(stored, indirect, version, &scratch2, &lval);
+        leveldb::WriteBatch updates;
+        updates.Put(lkey, lval);
+        leveldb::Status st = m_group_commit->write(m_db.get(), &updates, schema::DURABILITY_NONE);
+        m_row_cache->forget(lkey);
+
+        if (!st.ok())
+        {
+            handle_error(st);
+            m_value_log->scanned(number, live_bytes);
+            return;
+        }
+    }
+
+    // the new records and the repointed objects must both be on disk before
+    // the segment can go
+    leveldb::WriteBatch empty;
+
+    if (!m_value_log->sync() ||
+        !m_group_commit->write(m_db.get(), &empty, schema::DURABILITY_SYNC).ok())
+    {
+        m_value_log->scanned(number, live_bytes);
+        return;
+    }
+
+    m_value_log->retire(number, get_timestamp());
+}
+
+bool
+datalayer :: value_log_live(const region_id& ri, uint16_t attr,
+                            const e::slice& key, const e::slice& ptr,
+                            std::string* backing,
+                            std::vector<e::slice>* stored,
+                            std::vector<bool>* indirect,
+                            uint64_t* version)
+{
+    const schema* sc = m_daemon->m_config.get_schema(ri);
+
+    if (!sc || attr == 0 || attr >= sc->attrs_sz ||
+        m_wiper->region_will_be_wiped(ri))
+    {
+        return false;
+    }
+
+    std::vector<char> scratch;
+    leveldb::Slice lkey;
+    encode_key(ri, sc->attrs[0].type, key, &scratch, &lkey);
+    leveldb::ReadOptions opts;
+    opts.fill_cache = false;
+    opts.verify_checksums = true;
+    leveldb::Status st = m_db->Get(opts, lkey, backing);
+
+    if (!st.ok())
+    {
+        if (!st.IsNotFound())
+        {
+            handle_error(st);
+        }
+
+        return false;
+    }
+
+    if (decode_value(e::slice(backing->data(), backing->size()),
+                     stored, indirect, version) != SUCCESS ||
+        stored->size() + 1 != sc->attrs_sz)
+    {
+        return false;
+    }
+
+    return (*indirect)[attr - 1] && (*stored)[attr - 1] == ptr;
+}
+
 bool
 datalayer :: write_version(const region_id& ri,
                            uint64_t version,
@@ -958,9 +1878,7 @@ datalayer :: bump_version(const region_id& ri, uint64_t version)
     }
 
     // Perform the write
-    leveldb::WriteOptions opts;
-    opts.sync = false;
-    leveldb::Status st = m_db->Write(opts, &updates);
+    leveldb::Status st = m_group_commit->write(m_db.get(), &updates, schema::DURABILITY_NONE);
 
     if (!st.ok())
     {
@@ -1110,6 +2028,7 @@ datalayer :: request_wipe(const transfer_id& xid,
                           const region_id& ri)
 {
     m_wiper->request_wipe(xid, ri);
+    m_value_log->forget_estimates();
 }
 
 void
@@ -1178,7 +2097,7 @@ datalayer :: replay_region_from_checkpoint(const region_id& ri,
 
     leveldb_replay_iterator_ptr ptr(m_db, iter);
     const schema& sc(*m_daemon->m_config.get_schema(ri));
-    return new replay_iterator(ri, ptr, index_encoding::lookup(sc.attrs[0].type));
+    return new replay_iterator(this, ri, ptr, index_encoding::lookup(sc.attrs[0].type));
 }
 
 void
@@ -1416,6 +2335,7 @@ datalayer :: handle_error(leveldb::Status st)
 
 datalayer :: reference :: reference()
     : m_backing()
+    , m_indirect()
 {
 }
 
@@ -1427,6 +2347,7 @@ void
 datalayer :: reference :: swap(reference* ref)
 {
     m_backing.swap(ref->m_backing);
+    m_indirect.swap(ref->m_indirect);
 }
 
 std::ostream&
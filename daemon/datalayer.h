@@ -84,6 +84,9 @@ class datalayer
         class index_iterator;
         class range_index_iterator;
         class intersect_iterator;
+        class group_commit;
+        class value_log;
+        class row_cache;
         typedef leveldb_snapshot_ptr snapshot;
         // must be pow2
         const static uint64_t REGION_PERIODIC = 65536;
@@ -109,6 +112,17 @@ class datalayer
                          const configuration& new_config,
                          const server_id& us);
         void debug_dump();
+        // merge up to max_batch concurrent writes into one LevelDB write,
+        // waiting up to max_delay nanoseconds for a group to fill; writes to
+        // spaces with periodic durability are synced every sync_interval
+        void set_group_commit(size_t max_batch, uint64_t max_delay,
+                              uint64_t sync_interval);
+        // keep attributes of at least threshold bytes in the value log
+        // rather than in their objects; zero keeps them all inline
+        void set_value_log(size_t threshold);
+        // keep the stored form of recently used objects in up to bytes of
+        // memory; zero reads every object from LevelDB
+        void set_row_cache(uint64_t bytes);
         // stats
         bool get_property(const e::slice& property,
                           std::string* value);
@@ -122,6 +136,13 @@ class datalayer
                        std::vector<e::slice>* value,
                        uint64_t* version,
                        reference* ref);
+        // retrieve the value of a key as of snap
+        returncode get(const region_id& ri,
+                       snapshot snap,
+                       const e::slice& key,
+                       std::vector<e::slice>* value,
+                       uint64_t* version,
+                       reference* ref);
         // put, overput, or delete a key where the existing value is known
         returncode del(const region_id& ri,
                        const e::slice& key,
@@ -142,6 +163,12 @@ class datalayer
                                  const e::slice& key,
                                  const std::vector<e::slice>& new_value,
                                  uint64_t version);
+        // put keys[i] with values[i] at version first_version + i, all in one
+        // write; the previous values are read only if the region has indices
+        returncode bulk_put(const region_id& ri,
+                            const std::vector<e::slice>& keys,
+                            const std::vector<std::vector<e::slice> >& values,
+                            uint64_t first_version);
         // leveldb provides no failure mechanism for this, neither do we
         snapshot make_snapshot();
         // create iterators from snapshots
@@ -149,6 +176,23 @@ class datalayer
                                        const region_id& ri,
                                        const std::vector<attribute_check>& checks,
                                        std::ostringstream* ostr);
+        // same as above, but if an index can return the matching objects in
+        // order of attribute sort_by (descending if maximize), use it when
+        // it is not much more costly than the alternatives and set *ordered
+        iterator* make_search_iterator(snapshot snap,
+                                       const region_id& ri,
+                                       const std::vector<attribute_check>& checks,
+                                       uint16_t sort_by,
+                                       bool maximize,
+                                       bool* ordered,
+                                       std::ostringstream* ostr);
+        // count the objects that match checks from index entries alone;
+        // returns false (and leaves *count alone) if some check cannot be
+        // answered exactly by an index, so the objects must be read
+        bool count_from_indices(snapshot snap,
+                                const region_id& ri,
+                                const std::vector<attribute_check>& checks,
+                                uint64_t* count);
         // backups
         bool backup(const e::slice& name);
         // get the object pointed to by the iterator
@@ -190,6 +234,41 @@ class datalayer
         datalayer& operator = (const datalayer&);
 
     private:
+        returncode get(const region_id& ri,
+                       const leveldb::Snapshot* snap,
+                       const e::slice& key,
+                       std::vector<e::slice>* value,
+                       uint64_t* version,
+                       reference* ref);
+        // decode an object read from LevelDB, reading the attributes kept
+        // in the value log into ref
+        returncode decode_object(const e::slice& in,
+                                 std::vector<e::slice>* value,
+                                 uint64_t* version,
+                                 reference* ref);
+        // encode new_value (if any) for storage under lkey, moving large
+        // attributes to the value log; old_value is the object it replaces
+        // (if any).  Call with the key's value_log::key_guard held.
+        returncode encode_object(const region_id& ri,
+                                 const schema& sc,
+                                 const leveldb::Slice& lkey,
+                                 const e::slice& key,
+                                 const std::vector<e::slice>* old_value,
+                                 const std::vector<e::slice>* new_value,
+                                 uint64_t version,
+                                 std::vector<char>* backing,
+                                 leveldb::Slice* out);
+        // run from the checkpointer thread; lower_bound is the oldest
+        // timestamp a retained checkpoint may replay from
+        void collect_value_log(const std::string& lower_bound);
+        // true if the object under key still points at ptr for attr, in
+        // which case its stored form is left in backing/stored/indirect
+        bool value_log_live(const region_id& ri, uint16_t attr,
+                            const e::slice& key, const e::slice& ptr,
+                            std::string* backing,
+                            std::vector<e::slice>* stored,
+                            std::vector<bool>* indirect,
+                            uint64_t* version);
         bool write_version(const region_id& ri,
                            uint64_t version,
                            leveldb::WriteBatch* updates);
@@ -202,6 +281,10 @@ class datalayer
 
         returncode handle_error(leveldb::Status st);
         void collect_lower_checkpoints(uint64_t checkpoint_gc);
+        // body of m_syncer:  syncs periodic writes that no later write
+        // carried a sync for
+        void sync_periodic();
+        void stop_syncer();
 
         const static region_id defaultri;
         static uint64_t id(region_id ri) { return ri.get(); }
@@ -215,6 +298,11 @@ class datalayer
         const std::auto_ptr<wiper_indexer_mediator> m_mediator;
         const std::auto_ptr<indexer_thread> m_indexer;
         const std::auto_ptr<wiper_thread> m_wiper;
+        const std::auto_ptr<group_commit> m_group_commit;
+        const std::auto_ptr<value_log> m_value_log;
+        const std::auto_ptr<row_cache> m_row_cache;
+        po6::threads::thread m_syncer;
+        bool m_syncer_started;
 };
 
 class datalayer::reference
@@ -231,6 +319,7 @@ class datalayer::reference
 
     private:
         std::string m_backing;
+        std::string m_indirect;
 };
 
 std::ostream&
@@ -169,12 +169,19 @@ datalayer :: checkpointer_thread :: collect_lower_checkpoints(uint64_t checkpoin
     }
 
     this->lock();
+    bool collect = m_gc_inhibit_permit_diff == 0;
 
-    if (m_gc_inhibit_permit_diff == 0)
+    if (collect)
     {
         m_daemon->m_data.m_db->AllowGarbageCollectBeforeTimestamp(lower_bound_timestamp);
         m_checkpoint_gced = m_checkpoint_target;
     }
 
     this->unlock();
+
+    // the value log may drop only what no retained checkpoint can replay
+    if (collect)
+    {
+        m_daemon->m_data.collect_value_log(lower_bound_timestamp);
+    }
 }
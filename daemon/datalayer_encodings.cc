@@ -141,12 +141,25 @@ hyperdex :: encode_value(const std::vector<e::slice>& attrs,
                          uint64_t version,
                          std::vector<char>* backing,
                          leveldb::Slice* out)
+{
+    std::vector<bool> indirect(attrs.size(), false);
+    encode_value(attrs, indirect, version, backing, out);
+}
+
+void
+hyperdex :: encode_value(const std::vector<e::slice>& attrs,
+                         const std::vector<bool>& indirect,
+                         uint64_t version,
+                         std::vector<char>* backing,
+                         leveldb::Slice* out)
 {
     assert(attrs.size() < 65536);
+    assert(attrs.size() == indirect.size());
     size_t sz = sizeof(uint64_t) + sizeof(uint16_t);
 
     for (size_t i = 0; i < attrs.size(); ++i)
     {
+        assert(attrs[i].size() < VALUE_INDIRECT_BIT);
         sz += sizeof(uint32_t) + attrs[i].size();
     }
 
@@ -157,7 +170,9 @@ hyperdex :: encode_value(const std::vector<e::slice>& attrs,
 
     for (size_t i = 0; i < attrs.size(); ++i)
     {
-        ptr = e::pack32be(attrs[i].size(), ptr);
+        uint32_t len = attrs[i].size();
+        len |= indirect[i] ? VALUE_INDIRECT_BIT : 0;
+        ptr = e::pack32be(len, ptr);
         memmove(ptr, attrs[i].data(), attrs[i].size());
         ptr += attrs[i].size();
     }
@@ -168,6 +183,7 @@ hyperdex :: encode_value(const std::vector<e::slice>& attrs,
 datalayer::returncode
 hyperdex :: decode_value(const e::slice& in,
                          std::vector<e::slice>* attrs,
+                         std::vector<bool>* indirect,
                          uint64_t* version)
 {
     const uint8_t* ptr = in.data();
@@ -194,6 +210,7 @@ hyperdex :: decode_value(const e::slice& in,
     }
 
     attrs->clear();
+    indirect->clear();
 
     for (size_t i = 0; i < num_attrs; ++i)
     {
@@ -208,6 +225,14 @@ hyperdex :: decode_value(const e::slice& in,
             return datalayer::BAD_ENCODING;
         }
 
+        indirect->push_back((sz & VALUE_INDIRECT_BIT) != 0);
+        sz &= ~VALUE_INDIRECT_BIT;
+
+        if (ptr + sz > end)
+        {
+            return datalayer::BAD_ENCODING;
+        }
+
         e::slice s(reinterpret_cast<const uint8_t*>(ptr), sz);
         ptr += sz;
         attrs->push_back(s);
@@ -300,9 +325,6 @@ hyperdex :: create_index_changes(const schema& sc,
         assert(idx->attr > 0);
         assert(idx->attr < sc.attrs_sz);
 
-        const index_info* ai = index_info::lookup(sc.attrs[idx->attr].type);
-        assert(ai);
-
         const e::slice* old_attr = NULL;
         const e::slice* new_attr = NULL;
         old_attr = old_value ? &(*old_value)[idx->attr - 1] : NULL;
@@ -313,6 +335,16 @@ hyperdex :: create_index_changes(const schema& sc,
             continue;
         }
 
+        // Most writes touch a few attributes and carry the rest over
+        // byte-for-byte.  An attribute that did not change cannot change
+        // its index entries, so don't make the index diff it.
+        if (old_attr && new_attr && *old_attr == *new_attr)
+        {
+            continue;
+        }
+
+        const index_info* ai = index_info::lookup(sc.attrs[idx->attr].type);
+        assert(ai);
         ai->index_changes(idx, ri, key_ie, key, old_attr, new_attr, updates);
     }
 }
@@ -72,9 +72,22 @@ encode_value(const std::vector<e::slice>& attrs,
              uint64_t version,
              std::vector<char>* backing,
              leveldb::Slice* out);
+
+// Attributes kept in the value log are stored as a VALUE_POINTER_SIZE pointer
+// whose length word has VALUE_INDIRECT_BIT set.  encode_value stores attrs[i]
+// that way when indirect[i] is set; decode_value yields the pointer itself
+// and sets indirect[i].
+#define VALUE_INDIRECT_BIT 0x80000000U
+void
+encode_value(const std::vector<e::slice>& attrs,
+             const std::vector<bool>& indirect,
+             uint64_t version,
+             std::vector<char>* backing,
+             leveldb::Slice* out);
 datalayer::returncode
 decode_value(const e::slice& in,
              std::vector<e::slice>* attrs,
+             std::vector<bool>* indirect,
              uint64_t* version);
 
 // Encode the record of an operation for which we have sent an ACK
@@ -0,0 +1,351 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+// STL
+#include <algorithm>
+#include <sstream>
+
+// po6
+#include <po6/time.h>
+
+// HyperDex
+#include "daemon/datalayer_group_commit.h"
+
+using hyperdex::datalayer;
+
+class datalayer::group_commit::writer
+{
+    public:
+        writer(leveldb::WriteBatch* u, hyperdex::schema::durability_t d)
+            : updates(u), durability(d), status(), done(false) {}
+        ~writer() throw () {}
+
+    public:
+        leveldb::WriteBatch* updates;
+        hyperdex::schema::durability_t durability;
+        leveldb::Status status;
+        bool done;
+
+    private:
+        writer(const writer&);
+        writer& operator = (const writer&);
+};
+
+namespace
+{
+
+class append_handler : public leveldb::WriteBatch::Handler
+{
+    public:
+        append_handler(leveldb::WriteBatch* out) : m_out(out) {}
+        virtual ~append_handler() {}
+
+    public:
+        virtual void Put(const leveldb::Slice& key, const leveldb::Slice& value)
+        { m_out->Put(key, value); }
+        virtual void Delete(const leveldb::Slice& key)
+        { m_out->Delete(key); }
+
+    private:
+        leveldb::WriteBatch* m_out;
+
+    private:
+        append_handler(const append_handler&);
+        append_handler& operator = (const append_handler&);
+};
+
+}
+
+datalayer :: group_commit :: group_commit()
+    : m_mtx()
+    , m_cond(&m_mtx)
+    , m_full(&m_mtx)
+    , m_sync_due(&m_mtx)
+    , m_queue()
+    , m_max_batch(1)
+    , m_max_delay(0)
+    , m_sync_interval(1000000000ULL)
+    , m_last_sync(po6::monotonic_time())
+    , m_last_sync_attempt(0)
+    , m_unsynced(false)
+    , m_stop_syncing(false)
+    , m_syncs(0)
+{
+    for (size_t i = 0; i < GROUP_COMMIT_HISTOGRAM_BUCKETS; ++i)
+    {
+        m_histogram[i] = 0;
+    }
+}
+
+datalayer :: group_commit :: ~group_commit() throw ()
+{
+}
+
+void
+datalayer :: group_commit :: configure(size_t max_batch, uint64_t max_delay)
+{
+    po6::threads::mutex::hold hold(&m_mtx);
+    m_max_batch = max_batch > 0 ? max_batch : 1;
+    m_max_delay = max_delay;
+}
+
+void
+datalayer :: group_commit :: configure_sync(uint64_t sync_interval)
+{
+    po6::threads::mutex::hold hold(&m_mtx);
+    m_sync_interval = sync_interval;
+    m_sync_due.broadcast();
+}
+
+leveldb::Status
+datalayer :: group_commit :: write(leveldb::DB* db, leveldb::WriteBatch* updates,
+                                   schema::durability_t durability)
+{
+    // Synced writes queue even with grouping off, so that those arriving
+    // while an fsync is in flight share the next one.
+    const bool grouping = m_max_batch > 1;
+
+    if (!grouping && durability != schema::DURABILITY_SYNC)
+    {
+        return write_alone(db, updates, durability);
+    }
+
+    const size_t max_group = grouping ? m_max_batch : GROUP_COMMIT_MAX_SYNC_GROUP;
+    writer w(updates, durability);
+    po6::threads::mutex::hold hold(&m_mtx);
+    m_queue.push_back(&w);
+
+    if (m_queue.size() >= max_group)
+    {
+        m_full.signal();
+    }
+
+    while (!w.done && m_queue.front() != &w)
+    {
+        m_cond.wait();
+    }
+
+    if (w.done)
+    {
+        return w.status;
+    }
+
+    // we lead the next group; give others until max_delay to join it, but
+    // go as soon as it fills
+    if (grouping && m_max_delay > 0 && m_queue.size() < max_group)
+    {
+        const uint64_t deadline = po6::monotonic_time() + m_max_delay;
+        uint64_t now = po6::monotonic_time();
+
+        while (m_queue.size() < max_group && now < deadline)
+        {
+            m_full.wait(deadline - now);
+            now = po6::monotonic_time();
+        }
+    }
+
+    const size_t group = std::min(m_queue.size(), max_group);
+    leveldb::WriteBatch merged;
+    leveldb::WriteBatch* batch = w.updates;
+    leveldb::Status st;
+    bool periodic = false;
+    bool sync = false;
+
+    for (size_t i = 0; i < group; ++i)
+    {
+        periodic = periodic || m_queue[i]->durability == schema::DURABILITY_PERIODIC;
+        sync = sync || m_queue[i]->durability == schema::DURABILITY_SYNC;
+    }
+
+    const uint64_t now = po6::monotonic_time();
+    sync = sync || ((periodic || m_unsynced) &&
+                    now - m_last_sync >= m_sync_interval);
+
+    // The writers in the group are blocked until we mark them done, so
+    // their batches are safe to read without the lock.
+    if (group > 1)
+    {
+        append_handler ah(&merged);
+
+        for (size_t i = 0; st.ok() && i < group; ++i)
+        {
+            st = m_queue[i]->updates->Iterate(&ah);
+        }
+
+        batch = &merged;
+    }
+
+    m_mtx.unlock();
+
+    if (st.ok())
+    {
+        leveldb::WriteOptions opts;
+        opts.sync = sync;
+        st = db->Write(opts, batch);
+    }
+
+    m_mtx.lock();
+    wrote(st, group, sync, periodic, now);
+
+    for (size_t i = 0; i < group; ++i)
+    {
+        m_queue.front()->status = st;
+        m_queue.front()->done = true;
+        m_queue.pop_front();
+    }
+
+    m_cond.broadcast();
+    return st;
+}
+
+leveldb::Status
+datalayer :: group_commit :: write_alone(leveldb::DB* db, leveldb::WriteBatch* updates,
+                                         schema::durability_t durability)
+{
+    // Grouping is off, so let HyperLevelDB's concurrent writers do their
+    // job; the lock only covers the bookkeeping on either side of the write.
+    const bool periodic = durability == schema::DURABILITY_PERIODIC;
+    bool sync = durability == schema::DURABILITY_SYNC;
+    uint64_t now;
+
+    {
+        po6::threads::mutex::hold hold(&m_mtx);
+        now = po6::monotonic_time();
+        sync = sync || ((periodic || m_unsynced) &&
+                        now - m_last_sync >= m_sync_interval);
+    }
+
+    leveldb::WriteOptions opts;
+    opts.sync = sync;
+    leveldb::Status st = db->Write(opts, updates);
+    po6::threads::mutex::hold hold(&m_mtx);
+    wrote(st, 1, sync, periodic, now);
+    return st;
+}
+
+void
+datalayer :: group_commit :: wrote(const leveldb::Status& st, size_t group,
+                                   bool sync, bool periodic, uint64_t when)
+{
+    if (st.ok() && sync)
+    {
+        m_last_sync = std::max(m_last_sync, when);
+        m_unsynced = false;
+        ++m_syncs;
+    }
+    else if (st.ok() && periodic && !m_unsynced)
+    {
+        m_unsynced = true;
+        m_sync_due.signal();
+    }
+
+    size_t bucket = 0;
+
+    while (bucket + 1 < GROUP_COMMIT_HISTOGRAM_BUCKETS && (2ULL << bucket) <= group)
+    {
+        ++bucket;
+    }
+
+    ++m_histogram[bucket];
+}
+
+leveldb::Status
+datalayer :: group_commit :: sync_if_due(leveldb::DB* db)
+{
+    {
+        po6::threads::mutex::hold hold(&m_mtx);
+        const uint64_t now = po6::monotonic_time();
+
+        if (!m_unsynced || now - m_last_sync < m_sync_interval)
+        {
+            return leveldb::Status::OK();
+        }
+
+        m_last_sync_attempt = now;
+    }
+
+    // an empty synced write flushes the log up to everything before it
+    leveldb::WriteBatch empty;
+    return write(db, &empty, schema::DURABILITY_SYNC);
+}
+
+bool
+datalayer :: group_commit :: wait_for_sync_due()
+{
+    po6::threads::mutex::hold hold(&m_mtx);
+
+    while (!m_stop_syncing)
+    {
+        const uint64_t now = po6::monotonic_time();
+        const uint64_t since = std::max(m_last_sync, m_last_sync_attempt);
+
+        if (!m_unsynced)
+        {
+            m_sync_due.wait();
+        }
+        else if (now - since < m_sync_interval)
+        {
+            m_sync_due.wait(since + m_sync_interval - now);
+        }
+        else
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+datalayer :: group_commit :: stop_syncing()
+{
+    po6::threads::mutex::hold hold(&m_mtx);
+    m_stop_syncing = true;
+    m_sync_due.broadcast();
+}
+
+std::string
+datalayer :: group_commit :: histogram()
+{
+    po6::threads::mutex::hold hold(&m_mtx);
+    std::ostringstream ostr;
+
+    for (size_t i = 0; i < GROUP_COMMIT_HISTOGRAM_BUCKETS; ++i)
+    {
+        ostr << (1ULL << i) << "=" << m_histogram[i] << "\n";
+    }
+
+    return ostr.str();
+}
+
+uint64_t
+datalayer :: group_commit :: syncs()
+{
+    po6::threads::mutex::hold hold(&m_mtx);
+    return m_syncs;
+}
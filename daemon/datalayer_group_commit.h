@@ -0,0 +1,126 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef hyperdex_daemon_datalayer_group_commit_h_
+#define hyperdex_daemon_datalayer_group_commit_h_
+
+// STL
+#include <deque>
+#include <string>
+
+// po6
+#include <po6/threads/cond.h>
+#include <po6/threads/mutex.h>
+
+// LevelDB
+#include <hyperleveldb/db.h>
+#include <hyperleveldb/write_batch.h>
+
+// HyperDex
+#include "common/schema.h"
+#include "daemon/datalayer.h"
+
+// Bucket i counts groups of [2^i, 2^(i+1)) writers; the last takes the rest
+#define GROUP_COMMIT_HISTOGRAM_BUCKETS 8
+// With grouping off, the most synced writes that share one fsync
+#define GROUP_COMMIT_MAX_SYNC_GROUP 128
+
+// Merges the batches of concurrent writers into one LevelDB write.  The first
+// writer in the queue leads:  it takes everyone queued behind it (up to
+// max_batch), writes them together, and hands their status back.  Writers
+// that arrive while a group is in flight form the next group.  With a
+// max_batch of one (the default) only DURABILITY_SYNC writers queue, so that
+// those waiting on an fsync share the next; the rest go straight to
+// HyperLevelDB, which handles concurrent writers itself.
+//
+// Durability rides on the same group:  the merged write is synced if any
+// member asked for DURABILITY_SYNC, or if a DURABILITY_PERIODIC write has
+// gone unsynced for sync_interval.  One fsync thus covers every writer in the
+// group, whatever it asked for.  When writes go quiet, the datalayer's syncer
+// thread waits in wait_for_sync_due and issues the sync no write carried.
+class hyperdex::datalayer::group_commit
+{
+    public:
+        group_commit();
+        ~group_commit() throw ();
+
+    public:
+        // max_delay (in nanoseconds) is how long a leader waits for others
+        // to join a group that is not yet full; zero never waits.  Call
+        // before the first write.
+        void configure(size_t max_batch, uint64_t max_delay);
+        // sync_interval (in nanoseconds) bounds how long a periodic write
+        // stays unsynced
+        void configure_sync(uint64_t sync_interval);
+        leveldb::Status write(leveldb::DB* db, leveldb::WriteBatch* updates,
+                              schema::durability_t durability);
+        // sync periodic writes whose interval has lapsed with no write
+        // to carry the sync
+        leveldb::Status sync_if_due(leveldb::DB* db);
+        // block until a periodic write has gone unsynced for sync_interval
+        // and return true; return false once stop_syncing is called
+        bool wait_for_sync_due();
+        void stop_syncing();
+        // group sizes so far, one "bucket=count" pair per line
+        std::string histogram();
+        uint64_t syncs();
+
+    private:
+        class writer;
+        leveldb::Status write_alone(leveldb::DB* db, leveldb::WriteBatch* updates,
+                                    schema::durability_t durability);
+        // account for a write of group batches; call with m_mtx held
+        void wrote(const leveldb::Status& st, size_t group,
+                   bool sync, bool periodic, uint64_t when);
+
+    private:
+        po6::threads::mutex m_mtx;
+        po6::threads::cond m_cond;
+        // signalled when the queue fills while its leader waits
+        po6::threads::cond m_full;
+        // signalled when a periodic write leaves the log unsynced
+        po6::threads::cond m_sync_due;
+        std::deque<writer*> m_queue;
+        size_t m_max_batch;
+        uint64_t m_max_delay;
+        uint64_t m_sync_interval;
+        uint64_t m_last_sync;
+        // when sync_if_due last tried, so a failing sync is retried once an
+        // interval rather than in a tight loop
+        uint64_t m_last_sync_attempt;
+        bool m_unsynced;
+        bool m_stop_syncing;
+        uint64_t m_syncs;
+        uint64_t m_histogram[GROUP_COMMIT_HISTOGRAM_BUCKETS];
+
+    private:
+        group_commit(const group_commit&);
+        group_commit& operator = (const group_commit&);
+};
+
+#endif // hyperdex_daemon_datalayer_group_commit_h_
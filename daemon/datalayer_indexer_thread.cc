@@ -40,6 +40,7 @@
 #include "daemon/datalayer_encodings.h"
 #include "daemon/datalayer_index_state.h"
 #include "daemon/datalayer_indexer_thread.h"
+#include "daemon/datalayer_value_log.h"
 #include "daemon/datalayer_wiper_thread.h"
 
 using hyperdex::datalayer;
@@ -302,7 +303,9 @@ datalayer :: indexer_thread :: play(const region_id& ri, const schema* sc)
     leveldb_iterator_ptr iip;
     leveldb::ReadOptions ro;
     ro.fill_cache = false;
-    iip.reset(leveldb_snapshot_ptr(db, NULL), db->NewIterator(ro));
+    leveldb_snapshot_ptr snap(db, NULL);
+    snap.keep(e::compat::shared_ptr<value_log::pin>(new value_log::pin(m_daemon->m_data.m_value_log.get())));
+    iip.reset(snap, db->NewIterator(ro));
     const index_encoding* ie = index_encoding::lookup(sc->attrs[0].type);
     return new region_iterator(iip, ri, ie);
 }
@@ -321,7 +324,7 @@ datalayer :: indexer_thread :: replay(const region_id& ri, const std::string& ti
 
     leveldb_replay_iterator_ptr ptr(m_daemon->m_data.m_db, riip);
     const schema& sc(*m_daemon->m_config.get_schema(ri));
-    return new replay_iterator(ri, ptr, index_encoding::lookup(sc.attrs[0].type));
+    return new replay_iterator(&m_daemon->m_data, ri, ptr, index_encoding::lookup(sc.attrs[0].type));
 }
 
 bool
@@ -439,17 +442,18 @@ datalayer :: indexer_thread :: index_from_replay_iterator(replay_iterator* rit,
     std::vector<char> scratch;
     leveldb::Slice lkey;
     encode_key(ri, sc->attrs[0].type, key, &scratch, &lkey);
-    std::string ref2;
+    datalayer::reference ref2;
+    value_log::pin pin(m_daemon->m_data.m_value_log.get());
     leveldb::ReadOptions opts;
     opts.verify_checksums = true;
-    leveldb::Status st = m_daemon->m_data.m_db->Get(opts, lkey, &ref2);
+    leveldb::Status st = m_daemon->m_data.m_db->Get(opts, lkey, &ref2.m_backing);
     std::vector<e::slice> _old_value;
 
     if (st.ok())
     {
         uint64_t old_version;
-        rc = decode_value(e::slice(ref2.data(), ref2.size()),
-                          &_old_value, &old_version);
+        rc = m_daemon->m_data.decode_object(e::slice(ref2.m_backing.data(), ref2.m_backing.size()),
+                                            &_old_value, &old_version, &ref2);
 
         if (rc != SUCCESS)
         {
@@ -78,6 +78,18 @@ datalayer :: iterator :: iterator(leveldb_snapshot_ptr s)
 {
 }
 
+bool
+datalayer :: iterator :: has_value()
+{
+    return false;
+}
+
+e::slice
+datalayer :: iterator :: value()
+{
+    return e::slice();
+}
+
 leveldb_snapshot_ptr
 datalayer :: iterator :: snap()
 {
@@ -90,10 +102,12 @@ datalayer :: iterator :: ~iterator() throw ()
 
 ///////////////////////////// class replay_iterator ////////////////////////////
 
-datalayer :: replay_iterator :: replay_iterator(const region_id& ri,
+datalayer :: replay_iterator :: replay_iterator(datalayer* dl,
+                                                const region_id& ri,
                                                 leveldb_replay_iterator_ptr ptr,
                                                 const index_encoding* ie)
-    : m_ri(ri)
+    : m_dl(dl)
+    , m_ri(ri)
     , m_iter(ptr.get())
     , m_ptr(ptr)
     , m_decoded()
@@ -165,7 +179,7 @@ datalayer :: replay_iterator :: unpack_value(std::vector<e::slice>* value,
 {
     ref->m_backing.assign(m_iter->value().data(), m_iter->value().size());
     e::slice v(ref->m_backing.data(), ref->m_backing.size());
-    return decode_value(v, value, version);
+    return m_dl->decode_object(v, value, version, ref);
 }
 
 leveldb::Status
@@ -338,7 +352,8 @@ datalayer :: range_index_iterator :: range_index_iterator(leveldb_snapshot_ptr s
                                                           bool has_lower,
                                                           bool has_upper,
                                                           const index_encoding* val_ie,
-                                                          const index_encoding* key_ie)
+                                                          const index_encoding* key_ie,
+                                                          bool reverse)
     : index_iterator(s)
     , m_iter()
     , m_val_ie(val_ie)
@@ -352,6 +367,7 @@ datalayer :: range_index_iterator :: range_index_iterator(leveldb_snapshot_ptr s
     , m_scratch()
     , m_has_lower(has_lower)
     , m_has_upper(has_upper)
+    , m_reverse(reverse)
     , m_invalid(false)
 {
     // setup the iterator
@@ -383,7 +399,26 @@ datalayer :: range_index_iterator :: range_index_iterator(leveldb_snapshot_ptr s
         m_invalid = !decode_entry_keyless(m_range_upper, &m_value_upper) || m_invalid;
     }
 
-    m_iter->Seek(e2level(m_range_lower));
+    if (!m_reverse)
+    {
+        m_iter->Seek(e2level(m_range_lower));
+        return;
+    }
+
+    // position on the last entry that sorts at or before the upper bound
+    m_scratch.resize(m_range_upper.size());
+    memmove(&m_scratch[0], m_range_upper.data(), m_range_upper.size());
+    hyperdex::encode_bump(&m_scratch[0], &m_scratch[0] + m_scratch.size());
+    m_iter->Seek(leveldb::Slice(&m_scratch[0], m_scratch.size()));
+
+    if (m_iter->Valid())
+    {
+        m_iter->Prev();
+    }
+    else
+    {
+        m_iter->SeekToLast();
+    }
 }
 
 datalayer :: range_index_iterator :: ~range_index_iterator() throw ()
@@ -411,23 +446,36 @@ datalayer :: range_index_iterator :: valid()
             return false;
         }
 
-        size_t sz = std::min(m_range_upper.size(), current.size());
+        if (!m_reverse)
+        {
+            size_t sz = std::min(m_range_upper.size(), current.size());
 
-        if (m_has_upper && memcmp(m_range_upper.data(), current.data(), sz) < 0)
+            if (m_has_upper && memcmp(m_range_upper.data(), current.data(), sz) < 0)
+            {
+                m_invalid = true;
+                return false;
+            }
+        }
+        else
         {
-            m_invalid = true;
-            return false;
+            size_t sz = std::min(m_range_lower.size(), current.size());
+
+            if (m_has_lower && memcmp(m_range_lower.data(), current.data(), sz) > 0)
+            {
+                m_invalid = true;
+                return false;
+            }
         }
 
         if (m_has_lower && internal_key_compare(m_value_lower, iv) > 0)
         {
-            m_iter->Next();
+            this->next();
             continue;
         }
 
         if (m_has_upper && internal_key_compare(m_value_upper, iv) < 0)
         {
-            m_iter->Next();
+            this->next();
             continue;
         }
 
@@ -440,7 +488,14 @@ datalayer :: range_index_iterator :: valid()
 void
 datalayer :: range_index_iterator :: next()
 {
-    m_iter->Next();
+    if (m_reverse)
+    {
+        m_iter->Prev();
+    }
+    else
+    {
+        m_iter->Next();
+    }
 }
 
 uint64_t
@@ -455,7 +510,7 @@ datalayer :: range_index_iterator :: cost(leveldb::DB* db)
     hyperdex::encode_bump(&m_scratch[0], &m_scratch[0] + m_range_upper.size());
     // create the range
     leveldb::Range r;
-    r.start = m_iter->key();
+    r.start = m_reverse || !m_iter->Valid() ? e2level(m_range_lower) : m_iter->key();
     r.limit = leveldb::Slice(&m_scratch[0], m_range_upper.size());
     // ask leveldb for the size of the range
     uint64_t ret;
@@ -484,6 +539,20 @@ datalayer :: range_index_iterator :: describe(std::ostream& out) const
     return out << "range_iterator()";
 }
 
+bool
+datalayer :: range_index_iterator :: has_value()
+{
+    // without a value encoding, this iterates the objects themselves
+    return !m_val_ie;
+}
+
+e::slice
+datalayer :: range_index_iterator :: value()
+{
+    assert(!m_val_ie);
+    return level2e(m_iter->value());
+}
+
 e::slice
 datalayer :: range_index_iterator :: internal_key()
 {
@@ -497,7 +566,7 @@ datalayer :: range_index_iterator :: internal_key()
 bool
 datalayer :: range_index_iterator :: sorted()
 {
-    return m_has_lower && m_has_upper && m_value_lower == m_value_upper;
+    return !m_reverse && m_has_lower && m_has_upper && m_value_lower == m_value_upper;
 }
 
 void
@@ -743,6 +812,18 @@ datalayer :: intersect_iterator :: describe(std::ostream& out) const
     return out << ")";
 }
 
+bool
+datalayer :: intersect_iterator :: has_value()
+{
+    return m_iters[0]->has_value();
+}
+
+e::slice
+datalayer :: intersect_iterator :: value()
+{
+    return m_iters[0]->value();
+}
+
 e::slice
 datalayer :: intersect_iterator :: internal_key()
 {
@@ -776,6 +857,9 @@ datalayer :: search_iterator :: search_iterator(datalayer* dl,
     , m_ostr(ostr)
     , m_num_gets(0)
     , m_checks(checks)
+    , m_checked(false)
+    , m_value()
+    , m_ref()
 {
 }
 
@@ -797,46 +881,58 @@ datalayer :: search_iterator :: valid()
         return false;
     }
 
+    if (m_checked)
+    {
+        return true;
+    }
+
     // Don't try to optimize by replacing m_ri with a const schema* because it
     // won't persist across reconfigurations
     const schema& sc(*m_dl->m_daemon->m_config.get_schema(m_ri));
 
     uint64_t version;
     std::vector<e::slice> value;
-    reference ref;
 
     // while the most selective iterator is valid and not past the end
     while (m_iter->valid())
     {
-        leveldb::ReadOptions opts;
-        opts.fill_cache = true;
-        opts.verify_checksums = true;
-        std::vector<char> kbacking;
-        leveldb::Slice lkey;
-        encode_key(m_ri, sc.attrs[0].type, m_iter->key(), &kbacking, &lkey);
-        leveldb::Status st = m_dl->m_db->Get(opts, lkey, &ref.m_backing);
-
-        if (st.ok())
+        if (m_iter->has_value())
         {
-            e::slice v(ref.m_backing.data(), ref.m_backing.size());
-            datalayer::returncode rc = decode_value(v, &value, &version);
-
-            if (rc != SUCCESS)
+            // scanning the objects directly; the value is right there
+            m_value = m_iter->value();
+        }
+        else
+        {
+            leveldb::ReadOptions opts;
+            opts.fill_cache = true;
+            opts.verify_checksums = true;
+            opts.snapshot = snap().get();
+            std::vector<char> kbacking;
+            leveldb::Slice lkey;
+            encode_key(m_ri, sc.attrs[0].type, m_iter->key(), &kbacking, &lkey);
+            leveldb::Status st = m_dl->m_db->Get(opts, lkey, &m_ref.m_backing);
+
+            if (!st.ok())
             {
-                m_error = rc;
+                m_error = m_dl->handle_error(st);
                 return false;
             }
 
+            m_value = e::slice(m_ref.m_backing.data(), m_ref.m_backing.size());
             ++m_num_gets;
         }
-        else
+
+        datalayer::returncode rc = m_dl->decode_object(m_value, &value, &version, &m_ref);
+
+        if (rc != SUCCESS)
         {
-            m_error = m_dl->handle_error(st);
+            m_error = rc;
             return false;
         }
 
         if (passes_attribute_checks(sc, *m_checks, m_iter->key(), value) == m_checks->size())
         {
+            m_checked = true;
             return true;
         }
         else
@@ -852,6 +948,8 @@ datalayer :: search_iterator :: valid()
 void
 datalayer :: search_iterator :: next()
 {
+    m_checked = false;
+    m_value = e::slice();
     m_iter->next();
 }
 
@@ -866,3 +964,16 @@ datalayer :: search_iterator :: key()
 {
     return m_iter->key();
 }
+
+bool
+datalayer :: search_iterator :: has_value()
+{
+    return m_checked;
+}
+
+e::slice
+datalayer :: search_iterator :: value()
+{
+    assert(m_checked);
+    return m_value;
+}
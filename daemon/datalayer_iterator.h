@@ -51,6 +51,12 @@ class datalayer::iterator
         // REQUIRES: valid
         virtual e::slice key() = 0;
         virtual std::ostream& describe(std::ostream&) const = 0;
+        // REQUIRES: valid
+        // true if value() can return the encoded object without another read
+        virtual bool has_value();
+        // REQUIRES: has_value
+        // the slice is only good until the next call to next()
+        virtual e::slice value();
 
     public:
         leveldb_snapshot_ptr snap();
@@ -69,7 +75,7 @@ class datalayer::iterator
 class datalayer::replay_iterator
 {
     public:
-        replay_iterator(const region_id& ri, leveldb_replay_iterator_ptr ptr, const index_encoding* ie);
+        replay_iterator(datalayer* dl, const region_id& ri, leveldb_replay_iterator_ptr ptr, const index_encoding* ie);
 
     public:
         bool valid();
@@ -82,6 +88,7 @@ class datalayer::replay_iterator
         leveldb::Status status();
 
     private:
+        datalayer* m_dl;
         region_id m_ri;
         leveldb::ReplayIterator* m_iter;
         leveldb_replay_iterator_ptr m_ptr;
@@ -160,7 +167,8 @@ class datalayer::range_index_iterator : public index_iterator
                              bool has_value_lower,
                              bool has_value_upper,
                              const index_encoding* val_ie,
-                             const index_encoding* key_ie);
+                             const index_encoding* key_ie,
+                             bool reverse);
         virtual ~range_index_iterator() throw ();
 
     public:
@@ -169,6 +177,8 @@ class datalayer::range_index_iterator : public index_iterator
         virtual uint64_t cost(leveldb::DB*);
         virtual e::slice key();
         virtual std::ostream& describe(std::ostream&) const;
+        virtual bool has_value();
+        virtual e::slice value();
         virtual e::slice internal_key();
         virtual bool sorted();
         virtual void seek(const e::slice& internal_key);
@@ -198,6 +208,8 @@ class datalayer::range_index_iterator : public index_iterator
         std::vector<char> m_scratch;
         bool m_has_lower;
         bool m_has_upper;
+        // walk from the upper end of the range down to the lower end
+        bool m_reverse;
         bool m_invalid;
 };
 
@@ -214,6 +226,8 @@ class datalayer::intersect_iterator : public index_iterator
         virtual uint64_t cost(leveldb::DB*);
         virtual e::slice key();
         virtual std::ostream& describe(std::ostream&) const;
+        virtual bool has_value();
+        virtual e::slice value();
         virtual e::slice internal_key();
         virtual bool sorted();
         virtual void seek(const e::slice& internal_key);
@@ -240,6 +254,8 @@ class datalayer::search_iterator : public iterator
         virtual uint64_t cost(leveldb::DB*);
         virtual e::slice key();
         virtual std::ostream& describe(std::ostream&) const;
+        virtual bool has_value();
+        virtual e::slice value();
 
     private:
         search_iterator(const search_iterator&);
@@ -253,6 +269,10 @@ class datalayer::search_iterator : public iterator
         std::ostringstream* m_ostr;
         uint64_t m_num_gets;
         const std::vector<attribute_check>* m_checks;
+        // the object that passed the checks; held until the next call to next()
+        bool m_checked;
+        e::slice m_value;
+        reference m_ref;
 };
 
 inline std::ostream&
@@ -0,0 +1,286 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <assert.h>
+
+// STL
+#include <sstream>
+
+// HyperDex
+#include "cityhash/city.h"
+#include "daemon/datalayer_row_cache.h"
+
+using hyperdex::datalayer;
+
+class datalayer::row_cache::shard
+{
+    public:
+        shard();
+        ~shard() throw ();
+
+    public:
+        void put(const std::string& key, const char* value, size_t value_sz);
+        void forget(const std::string& key);
+
+    public:
+        typedef std::list<std::string> lru_t;
+        struct entry
+        {
+            entry() : backing(), lru() {}
+            std::string backing;
+            lru_t::iterator lru;
+        };
+        typedef std::map<std::string, entry> entry_map_t;
+
+    public:
+        void erase(entry_map_t::iterator it);
+
+    public:
+        po6::threads::mutex mtx;
+        uint64_t budget;
+        uint64_t bytes;
+        uint64_t generation;
+        uint64_t hits;
+        uint64_t misses;
+        lru_t lru;
+        entry_map_t entries;
+
+    private:
+        shard(const shard&);
+        shard& operator = (const shard&);
+};
+
+datalayer :: row_cache :: shard :: shard()
+    : mtx()
+    , budget(0)
+    , bytes(0)
+    , generation(0)
+    , hits(0)
+    , misses(0)
+    , lru()
+    , entries()
+{
+}
+
+datalayer :: row_cache :: shard :: ~shard() throw ()
+{
+}
+
+void
+datalayer :: row_cache :: shard :: put(const std::string& key,
+                                       const char* value, size_t value_sz)
+{
+    entry_map_t::iterator it = entries.find(key);
+
+    if (it != entries.end())
+    {
+        erase(it);
+    }
+
+    uint64_t cost = key.size() + value_sz + ROW_CACHE_OVERHEAD;
+
+    if (cost > budget)
+    {
+        return;
+    }
+
+    while (bytes + cost > budget)
+    {
+        assert(!lru.empty());
+        erase(entries.find(lru.back()));
+    }
+
+    entry& ent(entries[key]);
+    ent.backing.assign(value, value_sz);
+    lru.push_front(key);
+    ent.lru = lru.begin();
+    bytes += cost;
+}
+
+void
+datalayer :: row_cache :: shard :: forget(const std::string& key)
+{
+    entry_map_t::iterator it = entries.find(key);
+
+    if (it != entries.end())
+    {
+        erase(it);
+    }
+}
+
+void
+datalayer :: row_cache :: shard :: erase(entry_map_t::iterator it)
+{
+    assert(it != entries.end());
+    uint64_t cost = it->first.size()
+                  + it->second.backing.size()
+                  + ROW_CACHE_OVERHEAD;
+    assert(cost <= bytes);
+    bytes -= cost;
+    lru.erase(it->second.lru);
+    entries.erase(it);
+}
+
+datalayer :: row_cache :: row_cache()
+    : m_budget(0)
+    , m_shards(new shard[ROW_CACHE_SHARDS])
+{
+}
+
+datalayer :: row_cache :: ~row_cache() throw ()
+{
+    delete[] m_shards;
+}
+
+void
+datalayer :: row_cache :: set_budget(uint64_t bytes)
+{
+    m_budget = bytes;
+
+    for (size_t i = 0; i < ROW_CACHE_SHARDS; ++i)
+    {
+        po6::threads::mutex::hold hold(&m_shards[i].mtx);
+        m_shards[i].budget = bytes / ROW_CACHE_SHARDS;
+
+        while (m_shards[i].bytes > m_shards[i].budget)
+        {
+            assert(!m_shards[i].lru.empty());
+            m_shards[i].erase(m_shards[i].entries.find(m_shards[i].lru.back()));
+        }
+    }
+}
+
+bool
+datalayer :: row_cache :: get(const leveldb::Slice& lkey,
+                              std::string* backing,
+                              uint64_t* generation)
+{
+    shard* s = get_shard(lkey);
+    po6::threads::mutex::hold hold(&s->mtx);
+    shard::entry_map_t::iterator it = s->entries.find(lkey.ToString());
+
+    if (it == s->entries.end())
+    {
+        ++s->misses;
+        *generation = s->generation;
+        return false;
+    }
+
+    ++s->hits;
+    s->lru.splice(s->lru.begin(), s->lru, it->second.lru);
+    *backing = it->second.backing;
+    return true;
+}
+
+void
+datalayer :: row_cache :: fill(const leveldb::Slice& lkey,
+                               const std::string& backing,
+                               uint64_t generation)
+{
+    shard* s = get_shard(lkey);
+    po6::threads::mutex::hold hold(&s->mtx);
+
+    if (s->generation == generation)
+    {
+        s->put(lkey.ToString(), backing.data(), backing.size());
+    }
+}
+
+void
+datalayer :: row_cache :: put(const leveldb::Slice& lkey,
+                              const leveldb::Slice& lval)
+{
+    if (!enabled())
+    {
+        return;
+    }
+
+    shard* s = get_shard(lkey);
+    po6::threads::mutex::hold hold(&s->mtx);
+    ++s->generation;
+    s->put(lkey.ToString(), lval.data(), lval.size());
+}
+
+void
+datalayer :: row_cache :: forget(const leveldb::Slice& lkey)
+{
+    if (!enabled())
+    {
+        return;
+    }
+
+    shard* s = get_shard(lkey);
+    po6::threads::mutex::hold hold(&s->mtx);
+    ++s->generation;
+    s->forget(lkey.ToString());
+}
+
+void
+datalayer :: row_cache :: reset()
+{
+    for (size_t i = 0; i < ROW_CACHE_SHARDS; ++i)
+    {
+        po6::threads::mutex::hold hold(&m_shards[i].mtx);
+        ++m_shards[i].generation;
+        m_shards[i].lru.clear();
+        m_shards[i].entries.clear();
+        m_shards[i].bytes = 0;
+    }
+}
+
+std::string
+datalayer :: row_cache :: stats()
+{
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t entries = 0;
+    uint64_t bytes = 0;
+
+    for (size_t i = 0; i < ROW_CACHE_SHARDS; ++i)
+    {
+        po6::threads::mutex::hold hold(&m_shards[i].mtx);
+        hits += m_shards[i].hits;
+        misses += m_shards[i].misses;
+        entries += m_shards[i].entries.size();
+        bytes += m_shards[i].bytes;
+    }
+
+    std::ostringstream ostr;
+    ostr << "hits=" << hits
+         << " misses=" << misses
+         << " entries=" << entries
+         << " bytes=" << bytes;
+    return ostr.str();
+}
+
+datalayer::row_cache::shard*
+datalayer :: row_cache :: get_shard(const leveldb::Slice& lkey)
+{
+    uint64_t h = CityHash64(lkey.data(), lkey.size());
+    return &m_shards[h & (ROW_CACHE_SHARDS - 1)];
+}
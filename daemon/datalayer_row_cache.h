@@ -0,0 +1,106 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef hyperdex_daemon_datalayer_row_cache_h_
+#define hyperdex_daemon_datalayer_row_cache_h_
+
+// STL
+#include <list>
+#include <map>
+#include <string>
+
+// po6
+#include <po6/threads/mutex.h>
+
+// LevelDB
+#include <hyperleveldb/db.h>
+
+// HyperDex
+#include "daemon/datalayer.h"
+
+// must be pow2
+#define ROW_CACHE_SHARDS 16
+// Rough cost of the bookkeeping for one entry
+#define ROW_CACHE_OVERHEAD 128
+
+// Keeps the stored form of recently read or written objects, keyed by their
+// encoded LevelDB key (which names the region), so that reading a hot object
+// skips the LevelDB probe.  Each shard evicts least-recently-used first once
+// it holds more than its share of the budget.
+//
+// Writers update or invalidate the entry after their write reaches LevelDB.
+// A reader that misses may fill the entry from what it read, but only if no
+// writer touched the shard in between; each shard counts its writes so a
+// reader cannot put back a value a concurrent write replaced.
+//
+// This cache serves reads:  it is consulted by datalayer::get for reads that
+// are not pinned to a snapshot, and it is kept current by every write that
+// reaches LevelDB through the datalayer, whether it came from a key state,
+// state transfer or bulk ingest, so reconfiguration leaves it alone.  Writes
+// go through the key_state_cache first, which remembers the values of
+// finished key states; a key state that misses there reads through the
+// datalayer, and so through this cache.  Wiping a region drops everything.
+class hyperdex::datalayer::row_cache
+{
+    public:
+        row_cache();
+        ~row_cache() throw ();
+
+    public:
+        // a budget of zero disables the cache; call before the first read
+        void set_budget(uint64_t bytes);
+        bool enabled() const { return m_budget > 0; }
+        // on a miss, *generation is what fill must be given
+        bool get(const leveldb::Slice& lkey,
+                 std::string* backing,
+                 uint64_t* generation);
+        // remember what a missed get read from LevelDB
+        void fill(const leveldb::Slice& lkey,
+                  const std::string& backing,
+                  uint64_t generation);
+        // lkey now holds lval
+        void put(const leveldb::Slice& lkey, const leveldb::Slice& lval);
+        // lkey may have changed in a way not worth tracking
+        void forget(const leveldb::Slice& lkey);
+        // drop everything (e.g. after a wipe)
+        void reset();
+        std::string stats();
+
+    private:
+        class shard;
+        shard* get_shard(const leveldb::Slice& lkey);
+
+    private:
+        uint64_t m_budget;
+        shard* m_shards;
+
+    private:
+        row_cache(const row_cache&);
+        row_cache& operator = (const row_cache&);
+};
+
+#endif // hyperdex_daemon_datalayer_row_cache_h_
@@ -0,0 +1,799 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#define __STDC_LIMIT_MACROS
+#define __STDC_FORMAT_MACROS
+
+// C
+#include <assert.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+// POSIX
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+// STL
+#include <algorithm>
+#include <sstream>
+
+// Google Log
+#include <glog/logging.h>
+
+// po6
+#include <po6/path.h>
+
+// e
+#include <e/atomic.h>
+#include <e/endian.h>
+
+// HyperDex
+#include "cityhash/city.h"
+#include "daemon/datalayer_value_log.h"
+
+using hyperdex::datalayer;
+
+class datalayer::value_log::segment
+{
+    public:
+        segment(uint64_t n, int f, uint64_t sz)
+            : number(n), fd(f), size(sz), garbage(0), scanned(false) {}
+        ~segment() throw () {}
+
+    public:
+        const uint64_t number;
+        po6::io::fd fd;
+        uint64_t size;
+        uint64_t garbage;
+        bool scanned;
+
+    private:
+        segment(const segment&);
+        segment& operator = (const segment&);
+};
+
+namespace
+{
+
+bool
+pwrite_fully(int fd, const char* data, size_t sz, uint64_t offset)
+{
+    while (sz > 0)
+    {
+        ssize_t amt = pwrite(fd, data, sz, offset);
+
+        if (amt < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (amt <= 0)
+        {
+            return false;
+        }
+
+        data += amt;
+        sz -= amt;
+        offset += amt;
+    }
+
+    return true;
+}
+
+bool
+pread_fully(int fd, char* data, size_t sz, uint64_t offset)
+{
+    while (sz > 0)
+    {
+        ssize_t amt = pread(fd, data, sz, offset);
+
+        if (amt < 0 && errno == EINTR)
+        {
+            continue;
+        }
+
+        if (amt <= 0)
+        {
+            return false;
+        }
+
+        data += amt;
+        sz -= amt;
+        offset += amt;
+    }
+
+    return true;
+}
+
+void
+unpack_pointer(const e::slice& ptr, uint64_t* number, uint64_t* offset, uint32_t* size)
+{
+    assert(ptr.size() == VALUE_POINTER_SIZE);
+    const uint8_t* p = ptr.data();
+    p = e::unpack64be(p, number);
+    p = e::unpack64be(p, offset);
+    p = e::unpack32be(p, size);
+}
+
+} // namespace
+
+datalayer :: value_log :: entry :: entry()
+    : ri()
+    , attr()
+    , key()
+{
+    memset(ptr, 0, sizeof(ptr));
+}
+
+datalayer :: value_log :: entry :: ~entry() throw ()
+{
+}
+
+datalayer :: value_log :: value_log()
+    : m_base()
+    , m_path()
+    , m_threshold(0)
+    , m_mtx()
+    , m_segments()
+    , m_segments_sz(0)
+    , m_head()
+    , m_retired()
+    , m_next_number(1)
+    , m_relocated(0)
+    , m_freed(0)
+    , m_appended(0)
+    , m_synced(0)
+    , m_sync_mtx()
+    , m_pin_mtx()
+    , m_generation(0)
+    , m_pins()
+{
+}
+
+datalayer :: value_log :: ~value_log() throw ()
+{
+}
+
+bool
+datalayer :: value_log :: open(const std::string& path)
+{
+    m_base = path;
+    m_path = po6::path::join(path, "vlog");
+
+    if (mkdir(m_path.c_str(), S_IRWXU) < 0 && errno != EEXIST)
+    {
+        PLOG(ERROR) << "could not create value log directory " << m_path;
+        return false;
+    }
+
+    DIR* dir = opendir(m_path.c_str());
+    struct dirent* ent = NULL;
+
+    if (dir == NULL)
+    {
+        PLOG(ERROR) << "could not list value log directory " << m_path;
+        return false;
+    }
+
+    std::vector<uint64_t> numbers;
+    errno = 0;
+
+    while ((ent = readdir(dir)) != NULL)
+    {
+        uint64_t number = 0;
+        char tail = '\0';
+
+        if (sscanf(ent->d_name, "%" SCNx64 ".vlo%c", &number, &tail) == 2 && tail == 'g')
+        {
+            numbers.push_back(number);
+        }
+    }
+
+    closedir(dir);
+
+    if (errno != 0)
+    {
+        PLOG(ERROR) << "could not list value log directory " << m_path;
+        return false;
+    }
+
+    std::sort(numbers.begin(), numbers.end());
+    po6::threads::mutex::hold hold(&m_mtx);
+
+    for (size_t i = 0; i < numbers.size(); ++i)
+    {
+        std::string p(segment_path(numbers[i]));
+        int fd = ::open(p.c_str(), O_RDWR);
+        struct stat st;
+
+        if (fd < 0 || fstat(fd, &st) < 0)
+        {
+            PLOG(ERROR) << "could not open value log segment " << p;
+
+            if (fd >= 0)
+            {
+                close(fd);
+            }
+
+            return false;
+        }
+
+        // segments from an earlier run are sealed and their garbage unknown
+        m_segments[numbers[i]].reset(new segment(numbers[i], fd, st.st_size));
+        m_next_number = numbers[i] + 1;
+    }
+
+    e::atomic::store_64_release(&m_segments_sz, m_segments.size());
+    return true;
+}
+
+void
+datalayer :: value_log :: set_threshold(size_t threshold)
+{
+    m_threshold = threshold;
+}
+
+bool
+datalayer :: value_log :: active()
+{
+    return m_threshold > 0 || e::atomic::load_64_acquire(&m_segments_sz) > 0;
+}
+
+bool
+datalayer :: value_log :: append(const region_id& ri, uint16_t attr,
+                                 const e::slice& key, const e::slice& value,
+                                 char* ptr)
+{
+    std::vector<char> header(VALUE_RECORD_HEADER_SIZE + key.size());
+    char* h = &header[0];
+    h = e::pack64be(ri.get(), h);
+    h = e::pack16be(attr, h);
+    h = e::pack32be(key.size(), h);
+    h = e::pack32be(value.size(), h);
+    memmove(h, key.data(), key.size());
+
+    po6::threads::mutex::hold hold(&m_mtx);
+
+    if ((!m_head || m_head->size >= VALUE_LOG_SEGMENT_SIZE) && !roll())
+    {
+        return false;
+    }
+
+    const uint64_t offset = m_head->size;
+    const uint64_t value_offset = offset + header.size();
+
+    if (!pwrite_fully(m_head->fd.get(), &header[0], header.size(), offset) ||
+        !pwrite_fully(m_head->fd.get(), reinterpret_cast<const char*>(value.data()),
+                      value.size(), value_offset))
+    {
+        PLOG(ERROR) << "could not append to value log segment "
+                    << segment_path(m_head->number);
+        // leave the torn record behind; scans stop at it
+        m_head->size += header.size() + value.size();
+        m_head.reset();
+        return false;
+    }
+
+    m_head->size += header.size() + value.size();
+    m_appended += header.size() + value.size();
+    ptr = e::pack64be(m_head->number, ptr);
+    ptr = e::pack64be(value_offset, ptr);
+    ptr = e::pack32be(value.size(), ptr);
+    return true;
+}
+
+bool
+datalayer :: value_log :: sync()
+{
+    uint64_t target;
+
+    {
+        po6::threads::mutex::hold hold(&m_mtx);
+        target = m_appended;
+    }
+
+    po6::threads::mutex::hold hold_sync(&m_sync_mtx);
+
+    if (m_synced >= target)
+    {
+        return true;
+    }
+
+    e::compat::shared_ptr<segment> head;
+    uint64_t through;
+
+    {
+        po6::threads::mutex::hold hold(&m_mtx);
+        head = m_head;
+        through = m_appended;
+    }
+
+    // roll() synced every segment before the head
+    if (head && fdatasync(head->fd.get()) < 0)
+    {
+        PLOG(ERROR) << "could not sync value log segment " << segment_path(head->number);
+        return false;
+    }
+
+    m_synced = through;
+    return true;
+}
+
+uint32_t
+datalayer :: value_log :: value_size(const e::slice& ptr)
+{
+    uint64_t number;
+    uint64_t offset;
+    uint32_t size;
+    unpack_pointer(ptr, &number, &offset, &size);
+    return size;
+}
+
+bool
+datalayer :: value_log :: read(const e::slice& ptr, char* out)
+{
+    uint64_t number;
+    uint64_t offset;
+    uint32_t size;
+    unpack_pointer(ptr, &number, &offset, &size);
+    e::compat::shared_ptr<segment> seg = get_segment(number);
+
+    if (!seg)
+    {
+        LOG(ERROR) << "value log segment " << number << " is missing";
+        return false;
+    }
+
+    if (!pread_fully(seg->fd.get(), out, size, offset))
+    {
+        PLOG(ERROR) << "could not read value log segment " << segment_path(number);
+        return false;
+    }
+
+    return true;
+}
+
+void
+datalayer :: value_log :: release(const e::slice& ptr)
+{
+    uint64_t number;
+    uint64_t offset;
+    uint32_t size;
+    unpack_pointer(ptr, &number, &offset, &size);
+    po6::threads::mutex::hold hold(&m_mtx);
+    segment_map_t::iterator it = m_segments.find(number);
+
+    if (it != m_segments.end())
+    {
+        it->second->garbage += size;
+    }
+}
+
+void
+datalayer :: value_log :: forget_estimates()
+{
+    po6::threads::mutex::hold hold(&m_mtx);
+
+    for (segment_map_t::iterator it = m_segments.begin();
+            it != m_segments.end(); ++it)
+    {
+        it->second->scanned = false;
+    }
+}
+
+bool
+datalayer :: value_log :: backup(const std::string& name)
+{
+    std::string dir(po6::path::join(m_base, "backup-" + name));
+    std::string dst(po6::path::join(dir, "vlog"));
+
+    if (mkdir(dst.c_str(), S_IRWXU) < 0 && errno != EEXIST)
+    {
+        PLOG(ERROR) << "could not create value log backup directory " << dst;
+        return false;
+    }
+
+    po6::threads::mutex::hold hold(&m_mtx);
+    std::vector<uint64_t> numbers;
+
+    for (segment_map_t::iterator it = m_segments.begin();
+            it != m_segments.end(); ++it)
+    {
+        numbers.push_back(it->first);
+    }
+
+    // checkpoints in the backup may still reach retired segments
+    for (std::list<retired>::iterator it = m_retired.begin();
+            it != m_retired.end(); ++it)
+    {
+        numbers.push_back(it->seg->number);
+    }
+
+    for (size_t i = 0; i < numbers.size(); ++i)
+    {
+        std::string src(segment_path(numbers[i]));
+        std::string name(src.substr(m_path.size() + 1));
+        std::string tgt(po6::path::join(dst, name));
+
+        if (link(src.c_str(), tgt.c_str()) < 0 && errno != EEXIST)
+        {
+            PLOG(ERROR) << "could not link " << src << " into the backup";
+            return false;
+        }
+    }
+
+    return true;
+}
+
+std::string
+datalayer :: value_log :: stats()
+{
+    po6::threads::mutex::hold hold(&m_mtx);
+    uint64_t bytes = 0;
+    uint64_t garbage = 0;
+
+    for (segment_map_t::iterator it = m_segments.begin();
+            it != m_segments.end(); ++it)
+    {
+        bytes += it->second->size;
+        garbage += std::min(it->second->garbage, it->second->size);
+    }
+
+    std::ostringstream ostr;
+    ostr << "segments=" << m_segments.size()
+         << " bytes=" << bytes
+         << " garbage=" << garbage
+         << " retired=" << m_retired.size()
+         << " relocated=" << m_relocated
+         << " freed=" << m_freed;
+    return ostr.str();
+}
+
+void
+datalayer :: value_log :: release_retired(leveldb::DB* db, const std::string& lower_bound)
+{
+    po6::threads::mutex::hold hold(&m_mtx);
+    uint64_t oldest_pin;
+
+    {
+        po6::threads::mutex::hold hold_pins(&m_pin_mtx);
+        oldest_pin = m_pins.empty() ? UINT64_MAX : m_pins.begin()->first;
+    }
+
+    std::list<retired>::iterator it = m_retired.begin();
+
+    while (it != m_retired.end())
+    {
+        if (db->CompareTimestamps(it->timestamp, lower_bound) > 0 ||
+            oldest_pin < it->generation)
+        {
+            ++it;
+            continue;
+        }
+
+        std::string p(segment_path(it->seg->number));
+
+        if (unlink(p.c_str()) < 0 && errno != ENOENT)
+        {
+            PLOG(ERROR) << "could not remove value log segment " << p;
+            ++it;
+            continue;
+        }
+
+        ++m_freed;
+        it = m_retired.erase(it);
+    }
+}
+
+bool
+datalayer :: value_log :: pick(uint64_t* number)
+{
+    po6::threads::mutex::hold hold(&m_mtx);
+
+    for (segment_map_t::iterator it = m_segments.begin();
+            it != m_segments.end(); ++it)
+    {
+        const segment* seg = it->second.get();
+
+        if (seg == m_head.get())
+        {
+            continue;
+        }
+
+        if (!seg->scanned || seg->garbage * 2 >= seg->size)
+        {
+            *number = seg->number;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool
+datalayer :: value_log :: scan(uint64_t number,
+                               std::vector<entry>* entries,
+                               uint64_t* size)
+{
+    e::compat::shared_ptr<segment> seg;
+
+    {
+        po6::threads::mutex::hold hold(&m_mtx);
+        segment_map_t::iterator it = m_segments.find(number);
+
+        if (it == m_segments.end() || it->second == m_head)
+        {
+            return false;
+        }
+
+        seg = it->second;
+        // whatever happens, don't pick it again until it gathers garbage
+        seg->scanned = true;
+        seg->garbage = 0;
+        *size = seg->size;
+    }
+
+    uint64_t offset = 0;
+    char header[VALUE_RECORD_HEADER_SIZE];
+
+    while (offset + VALUE_RECORD_HEADER_SIZE <= *size)
+    {
+        if (!pread_fully(seg->fd.get(), header, VALUE_RECORD_HEADER_SIZE, offset))
+        {
+            PLOG(ERROR) << "could not read value log segment " << segment_path(number);
+            return false;
+        }
+
+        uint64_t ri;
+        uint16_t attr;
+        uint32_t key_sz;
+        uint32_t value_sz;
+        const uint8_t* h = reinterpret_cast<const uint8_t*>(header);
+        h = e::unpack64be(h, &ri);
+        h = e::unpack16be(h, &attr);
+        h = e::unpack32be(h, &key_sz);
+        h = e::unpack32be(h, &value_sz);
+        const uint64_t value_offset = offset + VALUE_RECORD_HEADER_SIZE + key_sz;
+
+        // a torn append; nothing after it was ever referenced
+        if (value_offset + value_sz > *size)
+        {
+            break;
+        }
+
+        entries->push_back(entry());
+        entry& ent(entries->back());
+        ent.ri = region_id(ri);
+        ent.attr = attr;
+        ent.key.resize(key_sz);
+
+        if (key_sz > 0 &&
+            !pread_fully(seg->fd.get(), &ent.key[0], key_sz, offset + VALUE_RECORD_HEADER_SIZE))
+        {
+            PLOG(ERROR) << "could not read value log segment " << segment_path(number);
+            return false;
+        }
+
+        char* p = ent.ptr;
+        p = e::pack64be(number, p);
+        p = e::pack64be(value_offset, p);
+        p = e::pack32be(value_sz, p);
+        offset = value_offset + value_sz;
+    }
+
+    return true;
+}
+
+void
+datalayer :: value_log :: scanned(uint64_t number, uint64_t live)
+{
+    po6::threads::mutex::hold hold(&m_mtx);
+    segment_map_t::iterator it = m_segments.find(number);
+
+    if (it != m_segments.end())
+    {
+        it->second->garbage += it->second->size - std::min(live, it->second->size);
+    }
+}
+
+void
+datalayer :: value_log :: retire(uint64_t number, const std::string& timestamp)
+{
+    po6::threads::mutex::hold hold(&m_mtx);
+    segment_map_t::iterator it = m_segments.find(number);
+
+    if (it == m_segments.end() || it->second == m_head)
+    {
+        return;
+    }
+
+    uint64_t generation;
+
+    {
+        po6::threads::mutex::hold hold_pins(&m_pin_mtx);
+        generation = ++m_generation;
+    }
+
+    m_retired.push_back(retired(it->second, timestamp, generation));
+    m_segments.erase(it);
+    ++m_relocated;
+    e::atomic::store_64_release(&m_segments_sz, m_segments.size());
+}
+
+std::string
+datalayer :: value_log :: segment_path(uint64_t number)
+{
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%016" PRIx64 ".vlog", number);
+    return po6::path::join(m_path, buf);
+}
+
+bool
+datalayer :: value_log :: roll()
+{
+    // the sealed head was only synced as far as its writers asked; seal it
+    // for good so that sync() need only ever look at the head
+    if (m_head && fdatasync(m_head->fd.get()) < 0)
+    {
+        PLOG(ERROR) << "could not sync value log segment " << segment_path(m_head->number);
+        return false;
+    }
+
+    const uint64_t number = m_next_number;
+    std::string p(segment_path(number));
+    int fd = ::open(p.c_str(), O_RDWR|O_CREAT|O_EXCL, S_IRUSR|S_IWUSR);
+
+    if (fd < 0)
+    {
+        PLOG(ERROR) << "could not create value log segment " << p;
+        return false;
+    }
+
+    // make the new name durable so pointers into the segment never dangle
+    po6::io::fd dir(::open(m_path.c_str(), O_RDONLY));
+
+    if (dir.get() < 0 || fsync(dir.get()) < 0)
+    {
+        PLOG(ERROR) << "could not sync value log directory " << m_path;
+        close(fd);
+        unlink(p.c_str());
+        return false;
+    }
+
+    ++m_next_number;
+    m_head.reset(new segment(number, fd, 0));
+    m_segments[number] = m_head;
+    e::atomic::store_64_release(&m_segments_sz, m_segments.size());
+    return true;
+}
+
+e::compat::shared_ptr<datalayer::value_log::segment>
+datalayer :: value_log :: get_segment(uint64_t number)
+{
+    po6::threads::mutex::hold hold(&m_mtx);
+    segment_map_t::iterator it = m_segments.find(number);
+
+    if (it != m_segments.end())
+    {
+        return it->second;
+    }
+
+    for (std::list<retired>::iterator r = m_retired.begin();
+            r != m_retired.end(); ++r)
+    {
+        if (r->seg->number == number)
+        {
+            return r->seg;
+        }
+    }
+
+    return e::compat::shared_ptr<segment>();
+}
+
+po6::threads::mutex*
+datalayer :: value_log :: key_lock(const e::slice& key)
+{
+    uint64_t h = CityHash64(reinterpret_cast<const char*>(key.data()), key.size());
+    return &m_key_locks[h % VALUE_LOG_KEY_LOCKS];
+}
+
+datalayer :: value_log :: key_guard :: key_guard(value_log* vl, const e::slice& key)
+    : m_held()
+{
+    if (vl->active())
+    {
+        m_held.push_back(vl->key_lock(key));
+        m_held.back()->lock();
+    }
+}
+
+datalayer :: value_log :: key_guard :: key_guard(value_log* vl, const std::vector<e::slice>& keys)
+    : m_held()
+{
+    if (!vl->active())
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        m_held.push_back(vl->key_lock(keys[i]));
+    }
+
+    // lock in address order so that two guards never deadlock
+    std::sort(m_held.begin(), m_held.end());
+    m_held.erase(std::unique(m_held.begin(), m_held.end()), m_held.end());
+
+    for (size_t i = 0; i < m_held.size(); ++i)
+    {
+        m_held[i]->lock();
+    }
+}
+
+datalayer :: value_log :: key_guard :: ~key_guard() throw ()
+{
+    for (size_t i = m_held.size(); i > 0; --i)
+    {
+        m_held[i - 1]->unlock();
+    }
+}
+
+datalayer :: value_log :: pin :: pin(value_log* vl)
+    : m_vl(NULL)
+    , m_generation(0)
+{
+    if (vl->active())
+    {
+        m_vl = vl;
+        po6::threads::mutex::hold hold(&m_vl->m_pin_mtx);
+        m_generation = m_vl->m_generation;
+        ++m_vl->m_pins[m_generation];
+    }
+}
+
+datalayer :: value_log :: pin :: ~pin() throw ()
+{
+    if (!m_vl)
+    {
+        return;
+    }
+
+    po6::threads::mutex::hold hold(&m_vl->m_pin_mtx);
+    pin_map_t::iterator it = m_vl->m_pins.find(m_generation);
+    assert(it != m_vl->m_pins.end());
+
+    if (--it->second == 0)
+    {
+        m_vl->m_pins.erase(it);
+    }
+}
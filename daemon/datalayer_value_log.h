@@ -0,0 +1,232 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef hyperdex_daemon_datalayer_value_log_h_
+#define hyperdex_daemon_datalayer_value_log_h_
+
+// STL
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+// po6
+#include <po6/io/fd.h>
+#include <po6/threads/mutex.h>
+
+// e
+#include <e/compat.h>
+#include <e/slice.h>
+
+// LevelDB
+#include <hyperleveldb/db.h>
+
+// HyperDex
+#include "common/ids.h"
+#include "daemon/datalayer.h"
+
+// segment (8) + offset (8) + size (4)
+#define VALUE_POINTER_SIZE (2 * sizeof(uint64_t) + sizeof(uint32_t))
+// region (8) + attr (2) + key size (4) + value size (4)
+#define VALUE_RECORD_HEADER_SIZE (sizeof(uint64_t) + sizeof(uint16_t) + 2 * sizeof(uint32_t))
+// the smallest threshold accepted; smaller values gain nothing over the pointer
+#define VALUE_LOG_MIN_THRESHOLD 1024
+#define VALUE_LOG_SEGMENT_SIZE (64ULL * 1024ULL * 1024ULL)
+#define VALUE_LOG_KEY_LOCKS 64
+
+// An append-only log, kept in segment files under <data>/vlog, for attributes
+// of at least threshold bytes.  The object stored in LevelDB carries a
+// VALUE_POINTER_SIZE pointer in place of each such attribute, so rewriting an
+// object rewrites only the large attributes that changed.
+//
+// Each record names the region, attribute and key that wrote it, so the
+// collector can tell a live record (the object still points at it) from
+// garbage.  Sealed segments with enough estimated garbage are scanned from
+// the checkpointer thread; live records are appended anew and the objects
+// repointed, after which the segment is retired.  A retired segment is not
+// unlinked until every retained checkpoint postdates its retirement and no
+// pin taken before its retirement remains.
+//
+// Appends are synced before the pointers to them are written, whatever the
+// durability of the write, because LevelDB may make a pointer durable (a
+// later synced write, a memtable flush) long after the write that made it.
+//
+// The collector repoints objects behind the back of the key's writers, so
+// every write to an object takes that object's key_guard while the log is
+// active.  Readers that hold no key_guard take a pin instead.
+class hyperdex::datalayer::value_log
+{
+    public:
+        class key_guard;
+        class pin;
+        struct entry
+        {
+            entry();
+            ~entry() throw ();
+
+            region_id ri;
+            uint16_t attr;
+            std::string key;
+            char ptr[VALUE_POINTER_SIZE];
+        };
+
+    public:
+        value_log();
+        ~value_log() throw ();
+
+    public:
+        bool open(const std::string& path);
+        // attributes of at least threshold bytes go to the log; zero keeps
+        // every attribute inline
+        void set_threshold(size_t threshold);
+        size_t threshold() const { return m_threshold; }
+        // true when the log is configured or still holds segments
+        bool active();
+        // append value and fill ptr with the VALUE_POINTER_SIZE bytes that
+        // refer to it
+        bool append(const region_id& ri, uint16_t attr,
+                    const e::slice& key, const e::slice& value,
+                    char* ptr);
+        // make every append so far durable; concurrent callers share one
+        // fdatasync where they can
+        bool sync();
+        static uint32_t value_size(const e::slice& ptr);
+        // REQUIRES: out has room for value_size(ptr) bytes
+        bool read(const e::slice& ptr, char* out);
+        // the record behind ptr is no longer referenced
+        void release(const e::slice& ptr);
+        // something (e.g. a wipe) dropped references without saying which;
+        // rescan every segment
+        void forget_estimates();
+        // hard link every segment into the vlog directory of the backup
+        // LevelDB made in <data>/backup-<name>
+        bool backup(const std::string& name);
+        std::string stats();
+
+    // used by the collector
+    public:
+        // unlink retired segments that nothing can reach any more
+        void release_retired(leveldb::DB* db, const std::string& lower_bound);
+        // a sealed segment worth scanning
+        bool pick(uint64_t* number);
+        bool scan(uint64_t number, std::vector<entry>* entries, uint64_t* size);
+        // the scan found live bytes that were worth keeping
+        void scanned(uint64_t number, uint64_t live);
+        // every live record in the segment has been rewritten elsewhere
+        void retire(uint64_t number, const std::string& timestamp);
+
+    private:
+        class segment;
+        struct retired
+        {
+            retired(e::compat::shared_ptr<segment> s,
+                    const std::string& t, uint64_t g)
+                : seg(s), timestamp(t), generation(g) {}
+            ~retired() throw () {}
+
+            e::compat::shared_ptr<segment> seg;
+            std::string timestamp;
+            // pins older than this may still reach it
+            uint64_t generation;
+        };
+        typedef std::map<uint64_t, e::compat::shared_ptr<segment> > segment_map_t;
+        // generation -> live pins
+        typedef std::map<uint64_t, uint64_t> pin_map_t;
+
+    private:
+        std::string segment_path(uint64_t number);
+        // call with m_mtx held
+        bool roll();
+        e::compat::shared_ptr<segment> get_segment(uint64_t number);
+        po6::threads::mutex* key_lock(const e::slice& key);
+
+    private:
+        std::string m_base;
+        std::string m_path;
+        size_t m_threshold;
+        po6::threads::mutex m_mtx;
+        segment_map_t m_segments;
+        uint64_t m_segments_sz; // m_segments.size(), readable without m_mtx
+        e::compat::shared_ptr<segment> m_head;
+        std::list<retired> m_retired;
+        uint64_t m_next_number;
+        uint64_t m_relocated;
+        uint64_t m_freed;
+        // bytes appended so far, and how many of them are known durable
+        uint64_t m_appended;
+        uint64_t m_synced;
+        // one fdatasync at a time; those waiting usually find their appends
+        // covered when their turn comes
+        po6::threads::mutex m_sync_mtx;
+        // kept apart from m_mtx so readers don't contend with appends; take
+        // it after m_mtx when holding both
+        po6::threads::mutex m_pin_mtx;
+        uint64_t m_generation;
+        pin_map_t m_pins;
+        po6::threads::mutex m_key_locks[VALUE_LOG_KEY_LOCKS];
+
+    private:
+        value_log(const value_log&);
+        value_log& operator = (const value_log&);
+};
+
+// Serializes a write to one or more objects with the collector.  Does nothing
+// while the log is inactive.
+class hyperdex::datalayer::value_log::key_guard
+{
+    public:
+        key_guard(value_log* vl, const e::slice& key);
+        key_guard(value_log* vl, const std::vector<e::slice>& keys);
+        ~key_guard() throw ();
+
+    private:
+        std::vector<po6::threads::mutex*> m_held;
+
+    private:
+        key_guard(const key_guard&);
+        key_guard& operator = (const key_guard&);
+};
+
+// Keeps every segment that a pointer read after the pin was taken could
+// reach, until the pin goes away.  Does nothing while the log is inactive.
+class hyperdex::datalayer::value_log::pin
+{
+    public:
+        pin(value_log* vl);
+        ~pin() throw ();
+
+    private:
+        value_log* m_vl;
+        uint64_t m_generation;
+
+    private:
+        pin(const pin&);
+        pin& operator = (const pin&);
+};
+
+#endif // hyperdex_daemon_datalayer_value_log_h_
@@ -38,6 +38,7 @@
 #include "daemon/daemon.h"
 #include "daemon/datalayer_index_state.h"
 #include "daemon/datalayer_indexer_thread.h"
+#include "daemon/datalayer_row_cache.h"
 #include "daemon/datalayer_wiper_thread.h"
 
 using hyperdex::datalayer;
@@ -198,6 +199,8 @@ datalayer :: wiper_thread :: wipe(transfer_id xid, region_id rid)
     wipe_checkpoints(rid);
     wipe_indices(rid);
     wipe_objects(rid);
+    // the cache has no cheap way to find the region's objects
+    m_daemon->m_data.m_row_cache->reset();
     this->online();
 
     if (interrupted())
@@ -75,6 +75,39 @@ identifier_collector :: collect(const region_id& ri, uint64_t seqno)
     sc->collect(seqno);
 }
 
+void
+identifier_collector :: collect_all_but(const region_id& ri,
+                                        const uint64_t* outstanding,
+                                        size_t outstanding_sz,
+                                        uint64_t limit)
+{
+    e::compat::shared_ptr<e::seqno_collector> sc;
+
+    if (!m_collectors.get(ri, &sc))
+    {
+        abort();
+    }
+
+    // everything below the oldest outstanding identifier goes in one step
+    uint64_t oldest = outstanding_sz > 0 ? outstanding[0] : limit;
+    sc->collect_up_to(std::min(oldest, limit));
+    uint64_t lb;
+    sc->lower_bound(&lb);
+
+    // then the gaps between consecutive outstanding identifiers
+    for (size_t i = 0; i < outstanding_sz && outstanding[i] < limit; ++i)
+    {
+        uint64_t gap_start = std::max(outstanding[i] + 1, lb);
+        uint64_t gap_limit = i + 1 < outstanding_sz ? outstanding[i + 1] : limit;
+        gap_limit = std::min(gap_limit, limit);
+
+        for (uint64_t id = gap_start; id < gap_limit; ++id)
+        {
+            sc->collect(id);
+        }
+    }
+}
+
 uint64_t
 identifier_collector :: lower_bound(const region_id& ri)
 {
@@ -53,6 +53,11 @@ class identifier_collector
         void bump(const region_id& ri, uint64_t lb);
         // mark the identifier as collected
         void collect(const region_id& ri, uint64_t id);
+        // collect every identifier below "limit" except those in the sorted
+        // array "outstanding"
+        void collect_all_but(const region_id& ri,
+                             const uint64_t* outstanding, size_t outstanding_sz,
+                             uint64_t limit);
         // store a value in "*lb" such that ids "< *lb" have been collected
         uint64_t lower_bound(const region_id& ri);
 
@@ -96,6 +96,19 @@ identifier_generator :: generate_id(const region_id& ri)
     return e::atomic::increment_64_nobarrier(val, 1) - 1;
 }
 
+uint64_t
+identifier_generator :: generate_ids(const region_id& ri, uint64_t n)
+{
+    uint64_t* val = NULL;
+
+    if (!m_generators.mod(ri, &val))
+    {
+        abort();
+    }
+
+    return e::atomic::increment_64_nobarrier(val, n) - n;
+}
+
 void
 identifier_generator :: adopt(region_id* ris, size_t ris_sz)
 {
@@ -52,6 +52,8 @@ class identifier_generator
         uint64_t peek(const region_id& ri) const;
         // generate one unique identifier, and store it in "id"
         uint64_t generate_id(const region_id& ri);
+        // generate n consecutive identifiers and return the first
+        uint64_t generate_ids(const region_id& ri, uint64_t n);
 
     // external synchronization required; nothing can call other methods during
     // adopt; copy_from must be mutually exclusive with adopt on either
@@ -197,7 +197,7 @@ index_document :: iterator_from_check(leveldb_snapshot_ptr snap,
     return new datalayer::range_index_iterator(snap, range_prefix_sz,
                                                start, limit,
                                                has_start, has_limit,
-                                               ie, key_ie);
+                                               ie, key_ie, false);
 }
 
 const hyperdex::index_encoding*
@@ -400,7 +400,7 @@ index_document :: iterator_key(leveldb_snapshot_ptr snap,
     return new hyperdex::datalayer::range_index_iterator(snap, range_prefix_sz,
                                                start, limit,
                                                r.has_start, r.has_end,
-                                               NULL, key_ie);
+                                               NULL, key_ie, false);
 }
 
 void
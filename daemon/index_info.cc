@@ -235,3 +235,14 @@ index_info :: iterator_from_check(leveldb_snapshot_ptr,
 {
     return NULL;
 }
+
+datalayer::index_iterator*
+index_info :: iterator_for_sort(leveldb_snapshot_ptr,
+                                const region_id&,
+                                const index_id&,
+                                uint16_t,
+                                bool,
+                                const index_encoding*) const
+{
+    return NULL;
+}
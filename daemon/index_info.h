@@ -110,6 +110,15 @@ class index_info
                                                                const index_id& ii,
                                                                const attribute_check& c,
                                                                const index_encoding* key_ie) const;
+        // return an iterator across all keys in ascending order of attribute
+        // attr (descending if reverse)
+        // if the index cannot produce values in order, return NULL
+        virtual datalayer::index_iterator* iterator_for_sort(leveldb_snapshot_ptr snap,
+                                                             const region_id& ri,
+                                                             const index_id& ii,
+                                                             uint16_t attr,
+                                                             bool reverse,
+                                                             const index_encoding* key_ie) const;
 };
 
 END_HYPERDEX_NAMESPACE
@@ -90,7 +90,7 @@ index_primitive :: iterator_for_keys(leveldb_snapshot_ptr snap,
     scan.has_end = false;
     scan.invalid = false;
     const index_encoding* ie = index_encoding::lookup(scan.type);
-    return iterator_key(snap, ri, scan, ie);
+    return iterator_key(snap, ri, scan, ie, false);
 }
 
 datalayer::index_iterator*
@@ -107,19 +107,51 @@ index_primitive :: iterator_from_range(leveldb_snapshot_ptr snap,
 
     if (r.attr != 0)
     {
-        return iterator_attr(snap, ri, ii, r, key_ie);
+        return iterator_attr(snap, ri, ii, r, key_ie, false);
     }
     else
     {
-        return iterator_key(snap, ri, r, key_ie);
+        return iterator_key(snap, ri, r, key_ie, false);
     }
 }
 
+datalayer::index_iterator*
+index_primitive :: iterator_for_sort(leveldb_snapshot_ptr snap,
+                                     const region_id& ri,
+                                     const index_id& ii,
+                                     uint16_t attr,
+                                     bool reverse,
+                                     const index_encoding* key_ie) const
+{
+    range scan;
+    scan.attr = attr;
+    scan.type = this->datatype();
+    scan.has_start = false;
+    scan.has_end = false;
+    scan.invalid = false;
+
+    if (attr == 0)
+    {
+        return iterator_key(snap, ri, scan, key_ie, reverse);
+    }
+
+    // Variable-length values are stored immediately before the key, so a
+    // value that is a prefix of another does not sort before it.  Only
+    // fixed-size encodings keep index entries in value order.
+    if (!m_ie->encoding_fixed())
+    {
+        return NULL;
+    }
+
+    return iterator_attr(snap, ri, ii, scan, key_ie, reverse);
+}
+
 datalayer::index_iterator*
 index_primitive :: iterator_key(leveldb_snapshot_ptr snap,
                                 const region_id& ri,
                                 const range& r,
-                                const index_encoding* key_ie) const
+                                const index_encoding* key_ie,
+                                bool reverse) const
 {
     std::vector<char> scratch_start;
     std::vector<char> scratch_limit;
@@ -157,7 +189,7 @@ index_primitive :: iterator_key(leveldb_snapshot_ptr snap,
     return new datalayer::range_index_iterator(snap, range_prefix_sz,
                                                start, limit,
                                                r.has_start, r.has_end,
-                                               NULL, key_ie);
+                                               NULL, key_ie, reverse);
 }
 
 datalayer::index_iterator*
@@ -165,7 +197,8 @@ index_primitive :: iterator_attr(leveldb_snapshot_ptr snap,
                                  const region_id& ri,
                                  const index_id& ii,
                                  const range& r,
-                                 const index_encoding* key_ie) const
+                                 const index_encoding* key_ie,
+                                 bool reverse) const
 {
     std::vector<char> scratch_start;
     std::vector<char> scratch_limit;
@@ -195,7 +228,7 @@ index_primitive :: iterator_attr(leveldb_snapshot_ptr snap,
     return new datalayer::range_index_iterator(snap, range_prefix_sz,
                                                start, limit,
                                                r.has_start, r.has_end,
-                                               m_ie, key_ie);
+                                               m_ie, key_ie, reverse);
 }
 
 size_t
@@ -55,6 +55,12 @@ class index_primitive : public index_info
                                                                const index_id& ii,
                                                                const range& r,
                                                                const index_encoding* key_ie) const;
+        virtual datalayer::index_iterator* iterator_for_sort(leveldb_snapshot_ptr snap,
+                                                             const region_id& ri,
+                                                             const index_id& ii,
+                                                             uint16_t attr,
+                                                             bool reverse,
+                                                             const index_encoding* key_ie) const;
 
     private:
         class range_iterator;
@@ -64,12 +70,14 @@ class index_primitive : public index_info
         datalayer::index_iterator* iterator_key(leveldb_snapshot_ptr snap,
                                                 const region_id& ri,
                                                 const range& r,
-                                                const index_encoding* key_ie) const;
+                                                const index_encoding* key_ie,
+                                                bool reverse) const;
         datalayer::index_iterator* iterator_attr(leveldb_snapshot_ptr snap,
                                                  const region_id& ri,
                                                  const index_id& ii,
                                                  const range& r,
-                                                 const index_encoding* key_ie) const;
+                                                 const index_encoding* key_ie,
+                                                 bool reverse) const;
         size_t index_entry_prefix_size(const region_id& ri, const index_id& ii) const;
         void index_entry(const region_id& ri,
                          const index_id& ii,
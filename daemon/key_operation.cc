@@ -53,6 +53,8 @@ key_operation :: key_operation(uint64_t old_version,
     , m_sent()
     , m_value(_value)
     , m_memory(memory)
+    , m_received_type(PACKET_NOP)
+    , m_received_msg(NULL)
     , m_type(UNKNOWN)
     , m_this_old_region()
     , m_this_new_region()
@@ -33,15 +33,18 @@
 
 // e
 #include <e/arena.h>
+#include <e/buffer.h>
 #include <e/intrusive_ptr.h>
 
 // HyperDex
 #include "namespace.h"
 #include "common/ids.h"
+#include "common/network_msgtype.h"
+#include "daemon/object_pool.h"
 
 BEGIN_HYPERDEX_NAMESPACE
 
-class key_operation
+class key_operation : public pooled<key_operation>
 {
     public:
         key_operation(uint64_t old_version,
@@ -97,6 +100,13 @@ class key_operation
         bool has_value() { return m_has_value; }
         const std::vector<e::slice>& value() { return m_value; }
 
+        // the message this op arrived in, which must live in its arena;
+        // forwarding it again in the same form needs only a new header
+        void set_received_as(network_msgtype type, const e::buffer* msg)
+        { m_received_type = type; m_received_msg = msg; }
+        const e::buffer* received_as(network_msgtype type) const
+        { return m_received_type == type ? m_received_msg : NULL; }
+
         void debug_dump();
 
     private:
@@ -119,6 +129,8 @@ class key_operation
 
         const std::vector<e::slice> m_value;
         const std::auto_ptr<e::arena> m_memory;
+        network_msgtype m_received_type;
+        const e::buffer* m_received_msg;
 
         enum { UNKNOWN, CONTINUOUS, DISCONTINUOUS } m_type;
         region_id m_this_old_region;
@@ -49,7 +49,7 @@ using hyperdex::key_operation;
 using hyperdex::key_region;
 using hyperdex::key_state;
 
-struct key_state::deferred_key_change
+struct key_state::deferred_key_change : public pooled<deferred_key_change>
 {
     deferred_key_change(const server_id& _from,
                         uint64_t _nonce, uint64_t _version,
@@ -125,6 +125,7 @@ key_state :: key_state(const key_region& kr)
     , m_old_version(0)
     , m_old_value()
     , m_old_disk_ref()
+    , m_old_cache_backing()
     , m_old_op()
     , m_client_responses_heap()
     , m_committable()
@@ -135,6 +136,7 @@ key_state :: key_state(const key_region& kr)
     , m_deferred_empty(true)
     , m_changes()
     , m_changes_empty(true)
+    , m_unacked()
 {
 }
 
@@ -171,6 +173,7 @@ key_state :: initialized()
 
 hyperdex::datalayer::returncode
 key_state :: initialize(datalayer* data,
+                        key_state_cache* cache,
                         const schema&,
                         const region_id& ri)
 {
@@ -193,6 +196,14 @@ key_state :: initialize(datalayer* data,
         return datalayer::SUCCESS;
     }
 
+    if (cache->get(state_key(), &m_old_version, &m_old_value, &m_old_cache_backing))
+    {
+        m_has_old_value = true;
+        m_initialized = true;
+        CHECK_INVARIANTS();
+        return datalayer::SUCCESS;
+    }
+
     datalayer::returncode rc = data->get(ri, m_key, &m_old_value, &m_old_version, &m_old_disk_ref);
 
     switch (rc)
@@ -216,7 +227,7 @@ key_state :: initialize(datalayer* data,
     return rc;
 }
 
-struct key_state::stub_client_atomic
+struct key_state::stub_client_atomic : public pooled<stub_client_atomic>
 {
     stub_client_atomic(const server_id& f,
                        uint64_t n,
@@ -255,7 +266,7 @@ key_state :: enqueue_client_atomic(replication_manager* rm,
     }
 }
 
-struct key_state::stub_chain_op
+struct key_state::stub_chain_op : public pooled<stub_chain_op>
 {
     stub_chain_op(const virtual_server_id& _from,
                   uint64_t _old_version,
@@ -311,7 +322,7 @@ key_state :: enqueue_chain_op(replication_manager* rm,
     }
 }
 
-struct key_state::stub_chain_subspace
+struct key_state::stub_chain_subspace : public pooled<stub_chain_subspace>
 {
     stub_chain_subspace(const virtual_server_id& _from,
                         uint64_t _old_version,
@@ -375,7 +386,7 @@ key_state :: enqueue_chain_subspace(replication_manager* rm,
     }
 }
 
-struct key_state::stub_chain_ack
+struct key_state::stub_chain_ack : public pooled<stub_chain_ack>
 {
     stub_chain_ack(const virtual_server_id& _from,
                    uint64_t _version)
@@ -459,8 +470,9 @@ key_state :: max_version()
 }
 
 void
-key_state :: reconfigure(e::garbage_collector* gc)
+key_state :: reconfigure(replication_manager* rm)
 {
+    e::garbage_collector* gc = &rm->m_daemon->m_gc;
     po6::threads::mutex::hold hold(&m_lock);
 
     while (m_someone_is_working_the_state_machine)
@@ -494,12 +506,14 @@ key_state :: reconfigure(e::garbage_collector* gc)
     }
 
     m_deferred.clear();
+    update_unacked(rm);
     CHECK_INVARIANTS();
 }
 
 void
-key_state :: reset(e::garbage_collector* gc)
+key_state :: reset(replication_manager* rm)
 {
+    e::garbage_collector* gc = &rm->m_daemon->m_gc;
     po6::threads::mutex::hold hold(&m_lock);
 
     while (m_someone_is_working_the_state_machine)
@@ -540,6 +554,7 @@ key_state :: reset(e::garbage_collector* gc)
     m_blocked.clear();
     m_deferred.clear();
     m_changes.clear();
+    update_unacked(rm);
     CHECK_INVARIANTS();
 }
 
@@ -843,6 +858,7 @@ key_state :: work_state_machine_with_work_bit(replication_manager* rm,
 
         if (done)
         {
+            update_unacked(rm);
             m_committable_empty = m_committable.empty();
             m_blocked_empty = m_blocked.empty();
             m_deferred_empty = m_deferred.empty();
@@ -862,7 +878,8 @@ key_state :: do_client_atomic(replication_manager* rm,
                               std::auto_ptr<key_change> kc,
                               std::auto_ptr<e::buffer> backing)
 {
-    uint64_t version = rm->m_idgen.generate_id(m_ri);
+    uint64_t version = rm->m_unacked.generate(m_ri, m_key, &rm->m_idgen);
+    m_unacked.push_back(version);
 
     if (version % datalayer::REGION_PERIODIC == 0)
     {
@@ -887,6 +904,7 @@ key_state :: do_chain_op(replication_manager* rm,
                          std::auto_ptr<e::buffer> backing)
 {
     e::intrusive_ptr<key_operation> op = get(new_version);
+    const e::buffer* msg = backing.get();
     std::auto_ptr<e::arena> memory(new e::arena());
     memory->takeover(backing.release());
 
@@ -894,6 +912,7 @@ key_state :: do_chain_op(replication_manager* rm,
     {
         op = enqueue_continuous_key_op(old_version, new_version, fresh,
                                        has_value, value, memory);
+        op->set_received_as(CHAIN_OP, msg);
     }
 
     assert(op);
@@ -920,6 +939,7 @@ key_state :: do_chain_subspace(replication_manager* rm,
                                const region_id& next_region)
 {
     e::intrusive_ptr<key_operation> op = get(new_version);
+    const e::buffer* msg = backing.get();
     std::auto_ptr<e::arena> memory(new e::arena());
     memory->takeover(backing.release());
 
@@ -929,6 +949,7 @@ key_state :: do_chain_subspace(replication_manager* rm,
                                           value, memory,
                                           prev_region, this_old_region,
                                           this_new_region, next_region);
+        op->set_received_as(CHAIN_SUBSPACE, msg);
     }
 
     assert(op);
@@ -991,11 +1012,78 @@ key_state :: send_responses(replication_manager* rm,
     }
 }
 
+void
+key_state :: update_unacked(replication_manager* rm)
+{
+    if (m_unacked.empty() && m_committable.empty() && m_blocked.empty() &&
+        m_deferred.empty() && m_changes.empty())
+    {
+        return;
+    }
+
+    std::vector<uint64_t> current;
+    current.reserve(m_committable.size() + m_blocked.size() +
+                    m_deferred.size() + m_changes.size());
+
+    for (key_operation_list_t::iterator it = m_committable.begin();
+            it != m_committable.end(); ++it)
+    {
+        current.push_back((*it)->this_version());
+    }
+
+    for (key_operation_list_t::iterator it = m_blocked.begin();
+            it != m_blocked.end(); ++it)
+    {
+        current.push_back((*it)->this_version());
+    }
+
+    for (key_operation_list_t::iterator it = m_deferred.begin();
+            it != m_deferred.end(); ++it)
+    {
+        current.push_back((*it)->this_version());
+    }
+
+    for (key_change_list_t::iterator it = m_changes.begin();
+            it != m_changes.end(); ++it)
+    {
+        current.push_back((*it)->version);
+    }
+
+    std::sort(current.begin(), current.end());
+    current.erase(std::unique(current.begin(), current.end()), current.end());
+    std::sort(m_unacked.begin(), m_unacked.end());
+    size_t i = 0;
+    size_t j = 0;
+
+    while (i < m_unacked.size() || j < current.size())
+    {
+        if (j == current.size() ||
+            (i < m_unacked.size() && m_unacked[i] < current[j]))
+        {
+            rm->m_unacked.remove(m_ri, m_unacked[i]);
+            ++i;
+        }
+        else if (i == m_unacked.size() || current[j] < m_unacked[i])
+        {
+            rm->m_unacked.add(m_ri, current[j], m_key);
+            ++j;
+        }
+        else
+        {
+            ++i;
+            ++j;
+        }
+    }
+
+    m_unacked.swap(current);
+}
+
 namespace
 {
 
+template <typename L>
 bool
-get_by_version(const std::list<e::intrusive_ptr<key_operation> >& list,
+get_by_version(const L& list,
                uint64_t version, e::intrusive_ptr<key_operation>* op)
 {
     if (list.empty() || list.back()->this_version() < version)
@@ -1003,7 +1091,7 @@ get_by_version(const std::list<e::intrusive_ptr<key_operation> >& list,
         return false;
     }
 
-    for (std::list<e::intrusive_ptr<key_operation> >::const_iterator it = list.begin();
+    for (typename L::const_iterator it = list.begin();
             it != list.end(); ++it)
     {
         uint64_t v = (*it)->this_version();
@@ -1402,8 +1490,11 @@ key_state :: drain_committable(replication_manager* rm,
 
         // if this is a case where we are to remove the object from disk
         // because of a delete or the first half of a subspace transfer
-        if (!op->has_value() ||
-            (op->this_old_region() != op->this_new_region() && m_ri == op->this_old_region()))
+        bool removed = !op->has_value() ||
+                       (op->this_old_region() != op->this_new_region() &&
+                        m_ri == op->this_old_region());
+
+        if (removed)
         {
             if (m_has_old_value)
             {
@@ -1437,6 +1528,16 @@ key_state :: drain_committable(replication_manager* rm,
                 return; // XXX
         }
 
+        // Keep the cache in step with what is now on disk
+        if (removed)
+        {
+            rm->m_key_state_cache.forget(state_key());
+        }
+        else
+        {
+            rm->m_key_state_cache.put(state_key(), version, op->value());
+        }
+
         m_has_old_value = op->has_value();
         m_old_version = version;
         m_old_value = op->value();
@@ -35,6 +35,8 @@
 #include "namespace.h"
 #include "daemon/datalayer.h"
 #include "daemon/key_operation.h"
+#include "daemon/key_state_cache.h"
+#include "daemon/object_pool.h"
 
 BEGIN_HYPERDEX_NAMESPACE
 class replication_manager;
@@ -55,6 +57,7 @@ class key_state
     public:
         bool initialized();
         datalayer::returncode initialize(datalayer* data,
+                                         key_state_cache* cache,
                                          const schema& sc,
                                          const region_id& ri);
 
@@ -97,8 +100,8 @@ class key_state
                                 const schema& sc);
 
         uint64_t max_version();
-        void reconfigure(e::garbage_collector* gc);
-        void reset(e::garbage_collector* gc);
+        void reconfigure(replication_manager* rm);
+        void reset(replication_manager* rm);
 
         void resend_committable(replication_manager* rm,
                                 const virtual_server_id& us);
@@ -114,8 +117,10 @@ class key_state
         struct stub_chain_subspace;
         struct stub_chain_ack;
         struct client_response;
-        typedef std::list<e::intrusive_ptr<key_operation> > key_operation_list_t;
-        typedef std::list<e::intrusive_ptr<deferred_key_change> > key_change_list_t;
+        typedef std::list<e::intrusive_ptr<key_operation>,
+                          pool_allocator<e::intrusive_ptr<key_operation> > > key_operation_list_t;
+        typedef std::list<e::intrusive_ptr<deferred_key_change>,
+                          pool_allocator<e::intrusive_ptr<deferred_key_change> > > key_change_list_t;
 
     private:
         void check_invariants() const;
@@ -169,6 +174,9 @@ class key_state
         void add_response(const client_response& cr);
         void send_responses(replication_manager* rm,
                             const virtual_server_id& us);
+        // call holding m_lock with the state machine idle; makes the
+        // versions recorded in rm's unacked_index match those held here
+        void update_unacked(replication_manager* rm);
         e::intrusive_ptr<key_operation> get(uint64_t new_version);
         e::intrusive_ptr<key_operation>
             enqueue_continuous_key_op(uint64_t old_version,
@@ -253,6 +261,7 @@ class key_state
 
         std::vector<e::slice> m_old_value;
         datalayer::reference m_old_disk_ref;
+        std::string m_old_cache_backing;
         e::intrusive_ptr<key_operation> m_old_op;
 
         std::vector<client_response> m_client_responses_heap;
@@ -279,6 +288,10 @@ class key_state
         // blocked/committable immediate.
         key_change_list_t m_changes;
         bool m_changes_empty;
+
+        // The versions this key last recorded in the replication manager's
+        // unacked_index, in ascending order once update_unacked has run.
+        std::vector<uint64_t> m_unacked;
 };
 
 END_HYPERDEX_NAMESPACE
@@ -0,0 +1,287 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+// C
+#include <assert.h>
+
+// STL
+#include <algorithm>
+#include <list>
+#include <map>
+
+// po6
+#include <po6/threads/mutex.h>
+
+// HyperDex
+#include "daemon/key_state_cache.h"
+
+using hyperdex::key_region;
+using hyperdex::key_state_cache;
+
+// Rough cost of the bookkeeping for one entry
+#define KEY_STATE_CACHE_OVERHEAD 128
+
+class key_state_cache::shard
+{
+    public:
+        shard();
+        ~shard() throw ();
+
+    public:
+        typedef std::list<key_region> lru_t;
+        struct entry
+        {
+            entry() : version(), sizes(), backing(), lru() {}
+            uint64_t version;
+            std::vector<size_t> sizes;
+            std::string backing;
+            lru_t::iterator lru;
+        };
+        typedef std::map<key_region, entry> entry_map_t;
+
+    public:
+        bool excluded(const region_id& ri);
+        void erase(entry_map_t::iterator it);
+
+    public:
+        po6::threads::mutex mtx;
+        uint64_t budget;
+        uint64_t bytes;
+        uint64_t hits;
+        uint64_t misses;
+        lru_t lru;
+        entry_map_t entries;
+        // each shard keeps its own copy so that put takes one lock
+        std::vector<region_id> excluded_regions;
+
+    private:
+        shard(const shard&);
+        shard& operator = (const shard&);
+};
+
+key_state_cache :: shard :: shard()
+    : mtx()
+    , budget(0)
+    , bytes(0)
+    , hits(0)
+    , misses(0)
+    , lru()
+    , entries()
+    , excluded_regions()
+{
+}
+
+key_state_cache :: shard :: ~shard() throw ()
+{
+}
+
+bool
+key_state_cache :: shard :: excluded(const region_id& ri)
+{
+    return std::binary_search(excluded_regions.begin(), excluded_regions.end(), ri);
+}
+
+void
+key_state_cache :: shard :: erase(entry_map_t::iterator it)
+{
+    assert(it != entries.end());
+    uint64_t cost = it->first.key.size()
+                  + it->second.backing.size()
+                  + KEY_STATE_CACHE_OVERHEAD;
+    assert(cost <= bytes);
+    bytes -= cost;
+    lru.erase(it->second.lru);
+    entries.erase(it);
+}
+
+key_state_cache :: key_state_cache()
+    : m_shards(new shard[KEY_STATE_CACHE_SHARDS])
+{
+}
+
+key_state_cache :: ~key_state_cache() throw ()
+{
+    delete[] m_shards;
+}
+
+void
+key_state_cache :: set_budget(uint64_t bytes)
+{
+    for (size_t i = 0; i < KEY_STATE_CACHE_SHARDS; ++i)
+    {
+        po6::threads::mutex::hold hold(&m_shards[i].mtx);
+        m_shards[i].budget = bytes / KEY_STATE_CACHE_SHARDS;
+
+        while (m_shards[i].bytes > m_shards[i].budget)
+        {
+            assert(!m_shards[i].lru.empty());
+            m_shards[i].erase(m_shards[i].entries.find(m_shards[i].lru.back()));
+        }
+    }
+}
+
+bool
+key_state_cache :: get(const key_region& kr,
+                       uint64_t* version,
+                       std::vector<e::slice>* value,
+                       std::string* backing)
+{
+    shard* s = get_shard(kr);
+    po6::threads::mutex::hold hold(&s->mtx);
+    shard::entry_map_t::iterator it = s->entries.find(kr);
+
+    if (it == s->entries.end())
+    {
+        ++s->misses;
+        return false;
+    }
+
+    ++s->hits;
+    s->lru.splice(s->lru.begin(), s->lru, it->second.lru);
+    *version = it->second.version;
+    *backing = it->second.backing;
+    value->clear();
+    const char* ptr = backing->data();
+
+    for (size_t i = 0; i < it->second.sizes.size(); ++i)
+    {
+        value->push_back(e::slice(ptr, it->second.sizes[i]));
+        ptr += it->second.sizes[i];
+    }
+
+    return true;
+}
+
+void
+key_state_cache :: put(const key_region& kr,
+                       uint64_t version,
+                       const std::vector<e::slice>& value)
+{
+    size_t sz = 0;
+
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        sz += value[i].size();
+    }
+
+    shard* s = get_shard(kr);
+    po6::threads::mutex::hold hold(&s->mtx);
+    shard::entry_map_t::iterator it = s->entries.find(kr);
+
+    if (it != s->entries.end())
+    {
+        s->erase(it);
+    }
+
+    uint64_t cost = kr.key.size() + sz + KEY_STATE_CACHE_OVERHEAD;
+
+    if (cost > s->budget || s->excluded(kr.region))
+    {
+        return;
+    }
+
+    while (s->bytes + cost > s->budget)
+    {
+        assert(!s->lru.empty());
+        s->erase(s->entries.find(s->lru.back()));
+    }
+
+    shard::entry& ent(s->entries[kr]);
+    ent.version = version;
+    ent.sizes.resize(value.size());
+    ent.backing.reserve(sz);
+
+    for (size_t i = 0; i < value.size(); ++i)
+    {
+        ent.sizes[i] = value[i].size();
+        ent.backing.append(reinterpret_cast<const char*>(value[i].data()), value[i].size());
+    }
+
+    s->lru.push_front(kr);
+    ent.lru = s->lru.begin();
+    s->bytes += cost;
+}
+
+void
+key_state_cache :: forget(const key_region& kr)
+{
+    shard* s = get_shard(kr);
+    po6::threads::mutex::hold hold(&s->mtx);
+    shard::entry_map_t::iterator it = s->entries.find(kr);
+
+    if (it != s->entries.end())
+    {
+        s->erase(it);
+    }
+}
+
+void
+key_state_cache :: reset(const std::vector<region_id>& excluded)
+{
+    for (size_t i = 0; i < KEY_STATE_CACHE_SHARDS; ++i)
+    {
+        po6::threads::mutex::hold hold(&m_shards[i].mtx);
+        m_shards[i].lru.clear();
+        m_shards[i].entries.clear();
+        m_shards[i].bytes = 0;
+        m_shards[i].excluded_regions = excluded;
+    }
+}
+
+uint64_t
+key_state_cache :: hits()
+{
+    uint64_t hits = 0;
+
+    for (size_t i = 0; i < KEY_STATE_CACHE_SHARDS; ++i)
+    {
+        po6::threads::mutex::hold hold(&m_shards[i].mtx);
+        hits += m_shards[i].hits;
+    }
+
+    return hits;
+}
+
+uint64_t
+key_state_cache :: misses()
+{
+    uint64_t misses = 0;
+
+    for (size_t i = 0; i < KEY_STATE_CACHE_SHARDS; ++i)
+    {
+        po6::threads::mutex::hold hold(&m_shards[i].mtx);
+        misses += m_shards[i].misses;
+    }
+
+    return misses;
+}
+
+key_state_cache::shard*
+key_state_cache :: get_shard(const key_region& kr)
+{
+    size_t h = e::compat::hash<key_region>()(kr);
+    return &m_shards[h & (KEY_STATE_CACHE_SHARDS - 1)];
+}
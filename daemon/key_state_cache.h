@@ -0,0 +1,102 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef hyperdex_daemon_key_state_cache_h_
+#define hyperdex_daemon_key_state_cache_h_
+
+// STL
+#include <string>
+#include <vector>
+
+// e
+#include <e/slice.h>
+
+// HyperDex
+#include "namespace.h"
+#include "common/ids.h"
+#include "daemon/key_region.h"
+
+// must be pow2
+#define KEY_STATE_CACHE_SHARDS 16
+
+BEGIN_HYPERDEX_NAMESPACE
+
+// Remembers the last value written by key states that have since finished, so
+// that the next write to a hot key can start without reading it from disk.
+// Entries are spread over shards by key, each with its own lock, so that
+// writers to different keys do not contend; each shard evicts
+// least-recently-used first once it holds more than its share of the budget.
+// Only keys whose latest write stored a value are kept; a delete forgets the
+// key.
+//
+// This cache serves writes only:  it is consulted when a key state is
+// created, and it is kept current by the key states themselves.  Reads go
+// through the datalayer and its row_cache, which is kept current by every
+// write that reaches LevelDB.  A key state that misses here reads through
+// the datalayer, so it still benefits from the row cache.  Writes that
+// bypass key states (state transfer, bulk ingest) must reset or forget
+// entries here; reconfiguration resets the cache for that reason.
+class key_state_cache
+{
+    public:
+        key_state_cache();
+        ~key_state_cache() throw ();
+
+    public:
+        // a budget of zero disables the cache
+        void set_budget(uint64_t bytes);
+        // on a hit, value points into backing
+        bool get(const key_region& kr,
+                 uint64_t* version,
+                 std::vector<e::slice>* value,
+                 std::string* backing);
+        void put(const key_region& kr,
+                 uint64_t version,
+                 const std::vector<e::slice>& value);
+        void forget(const key_region& kr);
+        // drop everything, and refuse to cache keys in the given regions
+        // (which must be sorted) until the next reset
+        void reset(const std::vector<region_id>& excluded);
+        uint64_t hits();
+        uint64_t misses();
+
+    private:
+        class shard;
+        shard* get_shard(const key_region& kr);
+
+    private:
+        shard* m_shards;
+
+    private:
+        key_state_cache(const key_state_cache&);
+        key_state_cache& operator = (const key_state_cache&);
+};
+
+END_HYPERDEX_NAMESPACE
+
+#endif // hyperdex_daemon_key_state_cache_h_
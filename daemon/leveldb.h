@@ -77,18 +77,20 @@ class leveldb_release_ptr
 {
     public:
         leveldb_release_ptr()
-            : m_db(), m_resource() {}
+            : m_db(), m_resource(), m_keep() {}
         leveldb_release_ptr(leveldb_db_ptr d, T* t)
-            : m_db(), m_resource() { reset(d, t); }
+            : m_db(), m_resource(), m_keep() { reset(d, t); }
         leveldb_release_ptr(const leveldb_release_ptr& other)
-            : m_db(other.m_db), m_resource(other.m_resource) {}
+            : m_db(other.m_db), m_resource(other.m_resource), m_keep(other.m_keep) {}
         ~leveldb_release_ptr() throw () {}
 
     public:
         T* get() const { return m_resource->ptr; }
         leveldb::DB* db() const { return m_db.get(); }
         void reset(leveldb_db_ptr d, T* t)
-        { m_db = d; m_resource.reset(new wrapper(d, t)); }
+        { m_db = d; m_resource.reset(new wrapper(d, t)); m_keep.reset(); }
+        // keep k alive for as long as any copy of this pointer
+        void keep(e::compat::shared_ptr<void> k) { m_keep = k; }
 
     public:
         T* operator * () const throw () { return get(); }
@@ -99,6 +101,7 @@ class leveldb_release_ptr
             {
                 m_resource = rhs.m_resource;
                 m_db = rhs.m_db;
+                m_keep = rhs.m_keep;
             }
 
             return *this;
@@ -127,6 +130,7 @@ class leveldb_release_ptr
     private:
         leveldb_db_ptr m_db;
         e::compat::shared_ptr<wrapper> m_resource;
+        e::compat::shared_ptr<void> m_keep;
 };
 
 typedef leveldb_release_ptr<const leveldb::Snapshot> leveldb_snapshot_ptr;
@@ -45,6 +45,7 @@
 
 // HyperDex
 #include "daemon/daemon.h"
+#include "daemon/datalayer_value_log.h"
 
 int
 main(int argc, const char* argv[])
@@ -61,6 +62,12 @@ main(int argc, const char* argv[])
     const char* coordinator_host = "127.0.0.1";
     long coordinator_port = 1982;
     long threads = 0;
+    long group_commit_batch = 1;
+    long group_commit_delay = 0;
+    long sync_interval = 1000;
+    long key_state_cache = 64;
+    long value_log_threshold = 0;
+    long row_cache = 0;
     bool log_immediate = false;
 
     e::argparser ap;
@@ -95,6 +102,24 @@ main(int argc, const char* argv[])
     ap.arg().name('t', "threads")
             .description("the number of threads which will handle network traffic")
             .metavar("N").as_long(&threads);
+    ap.arg().long_name("group-commit-batch")
+            .description("merge up to N concurrent writes into one disk write (default: 1, off)")
+            .metavar("N").as_long(&group_commit_batch);
+    ap.arg().long_name("group-commit-delay")
+            .description("wait up to N microseconds for concurrent writes to merge (default: 0)")
+            .metavar("N").as_long(&group_commit_delay);
+    ap.arg().long_name("sync-interval")
+            .description("sync writes to spaces with periodic durability every N milliseconds (default: 1000)")
+            .metavar("N").as_long(&sync_interval);
+    ap.arg().long_name("key-state-cache")
+            .description("remember recently written values in up to N megabytes (default: 64)")
+            .metavar("N").as_long(&key_state_cache);
+    ap.arg().long_name("value-log-threshold")
+            .description("store attributes of N bytes or more apart from their objects (default: 0, never)")
+            .metavar("N").as_long(&value_log_threshold);
+    ap.arg().long_name("row-cache")
+            .description("keep recently used objects in up to N megabytes (default: 0, off)")
+            .metavar("N").as_long(&row_cache);
     ap.arg().long_name("log-immediate")
             .description("immediately flush all log output")
             .set_true(&log_immediate).hidden();
@@ -123,6 +148,39 @@ main(int argc, const char* argv[])
         return EXIT_FAILURE;
     }
 
+    if (group_commit_batch <= 0 || group_commit_delay < 0)
+    {
+        std::cerr << "group-commit-batch must be positive and group-commit-delay non-negative" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (sync_interval <= 0)
+    {
+        std::cerr << "sync-interval must be positive" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (key_state_cache < 0)
+    {
+        std::cerr << "key-state-cache must be non-negative" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (value_log_threshold != 0 &&
+        (value_log_threshold < VALUE_LOG_MIN_THRESHOLD ||
+         value_log_threshold >= (1LL << 31)))
+    {
+        std::cerr << "value-log-threshold must be 0 or between "
+                  << VALUE_LOG_MIN_THRESHOLD << " and 2^31 bytes" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    if (row_cache < 0)
+    {
+        std::cerr << "row-cache must be non-negative" << std::endl;
+        return EXIT_FAILURE;
+    }
+
     po6::net::ipaddr listen_ip;
     po6::net::location bind_to;
 
@@ -201,7 +259,13 @@ main(int argc, const char* argv[])
                      std::string(pidfile), has_pidfile,
                      listen, bind_to,
                      coordinator, po6::net::hostname(coordinator_host, coordinator_port),
-                     threads);
+                     threads,
+                     group_commit_batch,
+                     group_commit_delay * 1000ULL,
+                     sync_interval * 1000000ULL,
+                     key_state_cache * 1024ULL * 1024ULL,
+                     value_log_threshold,
+                     row_cache * 1024ULL * 1024ULL);
     }
     catch (std::exception& e)
     {
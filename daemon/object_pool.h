@@ -0,0 +1,351 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef hyperdex_daemon_object_pool_h_
+#define hyperdex_daemon_object_pool_h_
+
+// C
+#include <pthread.h>
+#include <stddef.h>
+
+// STL
+#include <limits>
+#include <new>
+
+// HyperDex
+#include "namespace.h"
+
+// Blocks each thread keeps on hand per size class before handing them back to
+// the general-purpose heap
+#define OBJECT_POOL_MAX_CACHED 4096
+
+BEGIN_HYPERDEX_NAMESPACE
+
+// Per-thread free lists of SZ-byte blocks.  Every block carries a pointer to
+// the list of the thread that took it from the heap, and always goes back to
+// that list:  the owner pushes onto its private list without synchronization,
+// while any other thread pushes onto the owner's remote list with a CAS.  The
+// owner drains its remote list when the private list runs dry, so objects
+// created by the network threads and destroyed by the replication thread
+// recycle on the network threads rather than piling up on the replication
+// thread.  Neither list holds more than OBJECT_POOL_MAX_CACHED blocks for
+// long; the excess goes back to the heap.
+//
+// A thread's lists are released by a pthread key destructor when it exits.
+// Blocks still in use at that point are freed straight to the heap when they
+// are released, and the list header itself lives until the last of them is
+// gone.
+template <size_t SZ>
+class object_pool_blocks
+{
+    public:
+        static void* allocate()
+        {
+            cache* c = local();
+
+            if (!c->head)
+            {
+                c->drain();
+            }
+
+            if (c->head)
+            {
+                block* b = c->head;
+                c->head = b->next;
+                --c->cached;
+                b->owner = c;
+                return b + 1;
+            }
+
+            return c->create() + 1;
+        }
+        static void release(void* p)
+        {
+            block* b = static_cast<block*>(p) - 1;
+            cache* c = b->owner;
+
+            if (c == t_cache)
+            {
+                c->push(b);
+            }
+            else
+            {
+                c->push_remote(b);
+            }
+        }
+        // Blocks taken from the heap and not yet handed back, whether in use
+        // or sitting on a free list
+        static size_t allocated() { return s_allocated; }
+
+    private:
+        struct cache;
+        // 16 bytes wide so the payload keeps the heap's alignment
+        union block
+        {
+            cache* owner;
+            block* next;
+            char pad[16];
+        };
+        struct cache
+        {
+            cache() : head(NULL), cached(0), remote(NULL), refs(1) {}
+            block* create()
+            {
+                __sync_add_and_fetch(&refs, 1);
+                __sync_add_and_fetch(&s_allocated, 1);
+                block* b = static_cast<block*>(::operator new(sizeof(block) + SZ));
+                b->owner = this;
+                return b;
+            }
+            void destroy(block* b)
+            {
+                ::operator delete(b);
+                __sync_sub_and_fetch(&s_allocated, 1);
+                dec();
+            }
+            void push(block* b)
+            {
+                if (cached >= OBJECT_POOL_MAX_CACHED)
+                {
+                    destroy(b);
+                    return;
+                }
+
+                b->next = head;
+                head = b;
+                ++cached;
+            }
+            void push_remote(block* b)
+            {
+                while (true)
+                {
+                    block* r = remote;
+
+                    if (r == closed())
+                    {
+                        destroy(b);
+                        return;
+                    }
+
+                    b->next = r;
+
+                    if (__sync_bool_compare_and_swap(&remote, r, b))
+                    {
+                        return;
+                    }
+                }
+            }
+            void drain()
+            {
+                block* r = __sync_lock_test_and_set(&remote, static_cast<block*>(NULL));
+
+                while (r)
+                {
+                    block* n = r->next;
+                    push(r);
+                    r = n;
+                }
+            }
+            void close()
+            {
+                block* r = __sync_lock_test_and_set(&remote, closed());
+
+                while (r)
+                {
+                    block* n = r->next;
+                    destroy(r);
+                    r = n;
+                }
+
+                while (head)
+                {
+                    block* n = head->next;
+                    destroy(head);
+                    head = n;
+                }
+
+                cached = 0;
+                dec();
+            }
+            void dec()
+            {
+                if (__sync_sub_and_fetch(&refs, 1) == 0)
+                {
+                    delete this;
+                }
+            }
+            static block* closed() { return reinterpret_cast<block*>(1); }
+
+            block* head;
+            size_t cached;
+            block* volatile remote;
+            // one for the owning thread, plus one per block in existence
+            size_t refs;
+
+            private:
+                cache(const cache&);
+                cache& operator = (const cache&);
+        };
+
+    private:
+        static cache* local()
+        {
+            if (!t_cache)
+            {
+                pthread_once(&s_once, create_key);
+                t_cache = new cache();
+                pthread_setspecific(s_key, t_cache);
+            }
+
+            return t_cache;
+        }
+        static void create_key() { pthread_key_create(&s_key, thread_exit); }
+        static void thread_exit(void* p)
+        {
+            cache* c = static_cast<cache*>(p);
+
+            if (t_cache == c)
+            {
+                t_cache = NULL;
+            }
+
+            c->close();
+        }
+
+    private:
+        static __thread cache* t_cache;
+        static pthread_once_t s_once;
+        static pthread_key_t s_key;
+        static size_t s_allocated;
+};
+
+template <size_t SZ>
+__thread typename object_pool_blocks<SZ>::cache* object_pool_blocks<SZ>::t_cache = NULL;
+template <size_t SZ>
+pthread_once_t object_pool_blocks<SZ>::s_once = PTHREAD_ONCE_INIT;
+template <size_t SZ>
+pthread_key_t object_pool_blocks<SZ>::s_key;
+template <size_t SZ>
+size_t object_pool_blocks<SZ>::s_allocated = 0;
+
+// Round up to a multiple of 16 so that types of similar size share a list
+#define OBJECT_POOL_SIZE_CLASS(X) ((((X) < sizeof(void*) ? sizeof(void*) : (X)) + 15) & ~static_cast<size_t>(15))
+
+// Derive T from pooled<T> to allocate every T from the pool.  Anything
+// derived from T with a different size goes to the heap as usual.
+template <typename T>
+class pooled
+{
+    public:
+        static void* operator new(size_t sz)
+        {
+            if (sz != sizeof(T))
+            {
+                return ::operator new(sz);
+            }
+
+            return object_pool_blocks<OBJECT_POOL_SIZE_CLASS(sizeof(T))>::allocate();
+        }
+        static void operator delete(void* p, size_t sz)
+        {
+            if (!p)
+            {
+                return;
+            }
+
+            if (sz != sizeof(T))
+            {
+                ::operator delete(p);
+                return;
+            }
+
+            object_pool_blocks<OBJECT_POOL_SIZE_CLASS(sizeof(T))>::release(p);
+        }
+};
+
+// An STL allocator whose single-object allocations (e.g., std::list nodes)
+// come from the pool
+template <typename T>
+class pool_allocator
+{
+    public:
+        typedef size_t size_type;
+        typedef ptrdiff_t difference_type;
+        typedef T* pointer;
+        typedef const T* const_pointer;
+        typedef T& reference;
+        typedef const T& const_reference;
+        typedef T value_type;
+        template <typename U> struct rebind { typedef pool_allocator<U> other; };
+
+    public:
+        pool_allocator() throw () {}
+        pool_allocator(const pool_allocator&) throw () {}
+        template <typename U> pool_allocator(const pool_allocator<U>&) throw () {}
+        ~pool_allocator() throw () {}
+
+    public:
+        pointer address(reference x) const { return &x; }
+        const_pointer address(const_reference x) const { return &x; }
+        pointer allocate(size_type n, const void* = 0)
+        {
+            if (n == 1)
+            {
+                return static_cast<pointer>(object_pool_blocks<OBJECT_POOL_SIZE_CLASS(sizeof(T))>::allocate());
+            }
+
+            return static_cast<pointer>(::operator new(n * sizeof(T)));
+        }
+        void deallocate(pointer p, size_type n)
+        {
+            if (n == 1)
+            {
+                object_pool_blocks<OBJECT_POOL_SIZE_CLASS(sizeof(T))>::release(p);
+            }
+            else
+            {
+                ::operator delete(p);
+            }
+        }
+        size_type max_size() const throw ()
+        { return std::numeric_limits<size_type>::max() / sizeof(T); }
+        void construct(pointer p, const T& val) { new (static_cast<void*>(p)) T(val); }
+        void destroy(pointer p) { p->~T(); }
+};
+
+template <typename T, typename U>
+inline bool
+operator == (const pool_allocator<T>&, const pool_allocator<U>&) { return true; }
+
+template <typename T, typename U>
+inline bool
+operator != (const pool_allocator<T>&, const pool_allocator<U>&) { return false; }
+
+END_HYPERDEX_NAMESPACE
+
+#endif // hyperdex_daemon_object_pool_h_
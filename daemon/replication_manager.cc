@@ -27,6 +27,9 @@
 
 #define __STDC_LIMIT_MACROS
 
+// C
+#include <string.h>
+
 // POSIX
 #include <signal.h>
 
@@ -36,6 +39,13 @@
 // Google Log
 #include <glog/logging.h>
 
+// po6
+#include <po6/time.h>
+
+// e
+#include <e/array_ptr.h>
+#include <e/atomic.h>
+
 // HyperDex
 #include "common/datatype_info.h"
 #include "common/hash.h"
@@ -50,6 +60,11 @@ using hyperdex::key_state;
 using hyperdex::reconfigure_returncode;
 using hyperdex::replication_manager;
 
+// Retransmission passes that take longer than this (in nanoseconds) get logged
+#define RETRANSMIT_SLOW_PASS 1000000000ULL
+// Bulk ingest holds at most this many key states at once
+#define BULK_INGEST_LOCKED_KEYS 256
+
 class replication_manager::retransmitter_thread : public hyperdex::background_thread
 {
     public:
@@ -68,6 +83,9 @@ class replication_manager::retransmitter_thread : public hyperdex::background_th
     public:
         replication_manager* m_rm;
         uint64_t m_trigger;
+        // written by the thread, read by anyone
+        uint64_t m_passes;
+        uint64_t m_last_pass;
 
     private:
         retransmitter_thread(const retransmitter_thread&);
@@ -77,8 +95,12 @@ class replication_manager::retransmitter_thread : public hyperdex::background_th
 replication_manager :: replication_manager(daemon* d)
     : m_daemon(d)
     , m_key_states(&d->m_gc)
+    , m_key_state_cache()
     , m_idgen()
     , m_idcol(&d->m_gc)
+    , m_unacked()
+    , m_bulk_mtx()
+    , m_bulk()
     , m_stable()
     , m_retransmitter(new retransmitter_thread(d))
     , m_protect_stable_stuff()
@@ -137,18 +159,21 @@ replication_manager :: reconfigure(const configuration&,
 
     std::vector<region_id> transfers_in_regions;
     new_config.transfers_in_regions(m_daemon->m_us, &transfers_in_regions);
+    // State transfer writes to disk behind the key states' backs, so nothing
+    // cached may outlive the configuration it was cached under
+    m_key_state_cache.reset(transfers_in_regions);
 
     // iterate over all key states; cleanup dead ones, and bump idgen
     for (key_map_t::iterator it(&m_key_states); it.valid(); ++it)
     {
         key_state* ks = *it;
-        ks->reconfigure(&m_daemon->m_gc);
+        ks->reconfigure(this);
         region_id ri = ks->state_key().region;
 
         if (std::binary_search(transfers_in_regions.begin(),
                                transfers_in_regions.end(), ri))
         {
-            ks->reset(&m_daemon->m_gc);
+            ks->reset(this);
         }
 
         if (std::binary_search(key_regions.begin(),
@@ -196,6 +221,26 @@ replication_manager :: reconfigure(const configuration&,
     }
 }
 
+void
+replication_manager :: set_key_state_cache(uint64_t budget)
+{
+    m_key_state_cache.set_budget(budget);
+}
+
+void
+replication_manager :: key_state_cache_stats(uint64_t* hits, uint64_t* misses)
+{
+    *hits = m_key_state_cache.hits();
+    *misses = m_key_state_cache.misses();
+}
+
+void
+replication_manager :: retransmit_stats(uint64_t* passes, uint64_t* last_pass)
+{
+    *passes = e::atomic::load_64_nobarrier(&m_retransmitter->m_passes);
+    *last_pass = e::atomic::load_64_nobarrier(&m_retransmitter->m_last_pass);
+}
+
 void
 replication_manager :: debug_dump()
 {
@@ -360,6 +405,264 @@ replication_manager :: chain_ack(const virtual_server_id& from,
     ks->enqueue_chain_ack(this, to, sc, from, version);
 }
 
+namespace
+{
+
+class key_order
+{
+    public:
+        key_order(const std::vector<e::slice>& keys) : m_keys(keys) {}
+        bool operator () (size_t lhs, size_t rhs) const
+        {
+            const e::slice& l(m_keys[lhs]);
+            const e::slice& r(m_keys[rhs]);
+            int cmp = memcmp(l.data(), r.data(), std::min(l.size(), r.size()));
+            return cmp < 0 || (cmp == 0 && l.size() < r.size());
+        }
+
+    private:
+        const std::vector<e::slice>& m_keys;
+};
+
+} // namespace
+
+// A bulk ingest batch this replica has written but has not yet seen acked by
+// the tail.  The point leader also remembers whom to answer.
+struct replication_manager::bulk_batch
+{
+    bulk_batch(const virtual_server_id& u, uint64_t c, std::auto_ptr<e::buffer> m)
+        : us(u), recv_from(), client(), nonce(0), batch(0), count(c), msg(m) {}
+    virtual_server_id us;
+    // unset on the point leader
+    virtual_server_id recv_from;
+    server_id client;
+    uint64_t nonce;
+    uint64_t batch;
+    uint64_t count;
+    // the BULK_CHAIN we pass on, kept to retransmit it
+    std::auto_ptr<e::buffer> msg;
+
+    private:
+        bulk_batch(const bulk_batch&);
+        bulk_batch& operator = (const bulk_batch&);
+};
+
+hyperdex::network_returncode
+replication_manager :: bulk_ingest(const virtual_server_id& us,
+                                   const server_id& client,
+                                   uint64_t nonce,
+                                   uint64_t batch,
+                                   const std::vector<e::slice>& keys,
+                                   const std::vector<std::vector<e::slice> >& values)
+{
+    assert(keys.size() == values.size());
+    assert(!keys.empty());
+    const region_id ri(m_daemon->m_config.get_region_id(us));
+
+    if (ri == region_id() || !m_daemon->m_config.is_point_leader(us))
+    {
+        return NET_NOTUS;
+    }
+
+    if (m_daemon->m_config.is_server_involved_in_transfer(m_daemon->m_us, ri))
+    {
+        LOG(INFO) << "refusing bulk ingest into " << ri << " while it is being transferred";
+        return NET_SERVERERROR;
+    }
+
+    // Sort the keys so that batches lock key states in the same order and
+    // cannot deadlock, and keep only the last copy of a key so we never lock
+    // it twice.  Replicas take the batch in this order, so the versions
+    // follow it too.
+    std::vector<size_t> order(keys.size());
+
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        order[i] = i;
+    }
+
+    key_order cmp(keys);
+    std::stable_sort(order.begin(), order.end(), cmp);
+    std::vector<e::slice> sorted_keys;
+    std::vector<std::vector<e::slice> > sorted_values;
+    sorted_keys.reserve(order.size());
+    sorted_values.reserve(order.size());
+    size_t sz = HYPERDEX_HEADER_SIZE_VV
+              + sizeof(uint64_t)
+              + sizeof(uint32_t);
+
+    for (size_t i = 0; i < order.size(); ++i)
+    {
+        if (i + 1 < order.size() && !cmp(order[i], order[i + 1]))
+        {
+            continue;
+        }
+
+        sorted_keys.push_back(keys[order[i]]);
+        sorted_values.push_back(values[order[i]]);
+        sz += pack_size(sorted_keys.back()) + pack_size(sorted_values.back());
+    }
+
+    // A key with client operations in flight cannot be written behind their
+    // backs, so the whole batch is refused instead.  Each key state is held
+    // only long enough to look at it.
+    for (size_t i = 0; i < sorted_keys.size(); ++i)
+    {
+        key_map_t::state_reference ksr;
+        key_state* ks = m_key_states.get_state(key_region(ri, sorted_keys[i]), &ksr);
+
+        if (ks && ks->initialized() && !ks->finished())
+        {
+            LOG(INFO) << "refusing bulk ingest into " << ri << " because clients are writing some of its keys";
+            return NET_SERVERERROR;
+        }
+    }
+
+    // The versions stay outstanding, and so keep the region from reporting a
+    // stable checkpoint, until the tail acks the batch.
+    const uint64_t n = sorted_keys.size();
+    const uint64_t first_version = m_unacked.generate_range(ri, n, &m_idgen);
+    datalayer::returncode rc = bulk_write(ri, first_version, sorted_keys, sorted_values);
+
+    if (rc != datalayer::SUCCESS)
+    {
+        LOG(ERROR) << "bulk ingest into " << ri << " failed: " << rc;
+        m_unacked.remove_range(ri, first_version);
+
+        for (uint64_t v = 0; v < n; ++v)
+        {
+            m_idcol.collect(ri, first_version + v);
+        }
+
+        check_stable(ri);
+        return NET_SERVERERROR;
+    }
+
+    std::auto_ptr<e::buffer> msg(e::buffer::create(sz));
+    e::packer pa = msg->pack_at(HYPERDEX_HEADER_SIZE_VV);
+    pa = pa << first_version << uint32_t(n);
+
+    for (size_t i = 0; i < sorted_keys.size(); ++i)
+    {
+        pa = pa << sorted_keys[i] << sorted_values[i];
+    }
+
+    e::compat::shared_ptr<bulk_batch> b(new bulk_batch(us, n, msg));
+    b->client = client;
+    b->nonce = nonce;
+    b->batch = batch;
+
+    {
+        po6::threads::mutex::hold hold(&m_bulk_mtx);
+        m_bulk[std::make_pair(ri, first_version)] = b;
+    }
+
+    bulk_send(ri, first_version);
+    return NET_SUCCESS;
+}
+
+void
+replication_manager :: bulk_chain(const virtual_server_id& from,
+                                  const virtual_server_id& to,
+                                  uint64_t first_version,
+                                  const std::vector<e::slice>& keys,
+                                  const std::vector<std::vector<e::slice> >& values,
+                                  std::auto_ptr<e::buffer> backing)
+{
+    assert(keys.size() == values.size());
+    const region_id ri(m_daemon->m_config.get_region_id(to));
+
+    if (ri == region_id() || keys.empty() ||
+        m_daemon->m_config.next_in_region(from) != to)
+    {
+        LOG(ERROR) << "dropping BULK_CHAIN from " << from << " to " << to
+                   << " that does not follow the chain";
+        return;
+    }
+
+    const std::pair<region_id, uint64_t> id(ri, first_version);
+    bool seen = false;
+
+    {
+        po6::threads::mutex::hold hold(&m_bulk_mtx);
+        bulk_map_t::iterator it = m_bulk.find(id);
+
+        if (it != m_bulk.end())
+        {
+            it->second->recv_from = from;
+            seen = true;
+        }
+    }
+
+    // A batch retransmitted after we acked it is written again; it carries
+    // the same versions, so the result is the same.
+    if (!seen)
+    {
+        m_idgen.bump(ri, first_version + keys.size() - 1);
+        datalayer::returncode rc = bulk_write(ri, first_version, keys, values);
+
+        if (rc != datalayer::SUCCESS)
+        {
+            // the point leader sends it again on the next reconfiguration
+            LOG(ERROR) << "bulk ingest into " << ri << " failed: " << rc;
+            return;
+        }
+
+        e::compat::shared_ptr<bulk_batch> b(new bulk_batch(to, keys.size(), backing));
+        b->recv_from = from;
+        po6::threads::mutex::hold hold(&m_bulk_mtx);
+        m_bulk[id] = b;
+    }
+
+    bulk_send(ri, first_version);
+}
+
+void
+replication_manager :: bulk_ack(const virtual_server_id& from,
+                                const virtual_server_id& to,
+                                uint64_t first_version)
+{
+    const region_id ri(m_daemon->m_config.get_region_id(to));
+
+    if (ri == region_id() || m_daemon->m_config.next_in_region(to) != from)
+    {
+        LOG(ERROR) << "dropping BULK_ACK from " << from << " to " << to
+                   << " that does not follow the chain";
+        return;
+    }
+
+    virtual_server_id recv_from;
+
+    {
+        po6::threads::mutex::hold hold(&m_bulk_mtx);
+        bulk_map_t::iterator it = m_bulk.find(std::make_pair(ri, first_version));
+
+        if (it == m_bulk.end() || it->second->us != to)
+        {
+            return;
+        }
+
+        recv_from = it->second->recv_from;
+
+        if (recv_from != virtual_server_id())
+        {
+            m_bulk.erase(it);
+        }
+    }
+
+    if (recv_from == virtual_server_id())
+    {
+        bulk_acked(ri, first_version);
+    }
+    else
+    {
+        size_t sz = HYPERDEX_HEADER_SIZE_VV + sizeof(uint64_t);
+        std::auto_ptr<e::buffer> msg(e::buffer::create(sz));
+        msg->pack_at(HYPERDEX_HEADER_SIZE_VV) << first_version;
+        m_daemon->m_comm.send_exact(to, recv_from, BULK_ACK, msg);
+    }
+}
+
 void
 replication_manager :: begin_checkpoint(uint64_t checkpoint_num)
 {
@@ -456,7 +759,7 @@ replication_manager :: post_get_key_state_init(region_id ri, key_state* ks)
 
     const schema& sc(*m_daemon->m_config.get_schema(ri));
 
-    switch (ks->initialize(&m_daemon->m_data, sc, ri))
+    switch (ks->initialize(&m_daemon->m_data, &m_key_state_cache, sc, ri))
     {
         case datalayer::SUCCESS:
         case datalayer::NOT_FOUND:
@@ -584,8 +887,14 @@ replication_manager :: send_message(const virtual_server_id& us,
     }
 
     std::auto_ptr<e::buffer> msg;
+    const e::buffer* received = op->received_as(type);
 
-    if (type == CHAIN_OP)
+    if (received)
+    {
+        // The body is exactly what we received; send_chain rewrites the header
+        msg.reset(received->copy());
+    }
+    else if (type == CHAIN_OP)
     {
         uint8_t flags = (op->is_fresh() ? 1 : 0)
                       | (op->has_value() ? 2 : 0);
@@ -626,7 +935,7 @@ replication_manager :: send_message(const virtual_server_id& us,
     }
 
     op->set_sent(m_daemon->m_config.version(), dest);
-    return m_daemon->m_comm.send_exact(us, dest, type, msg);
+    return m_daemon->m_comm.send_chain(us, dest, type, msg);
 }
 
 bool
@@ -642,43 +951,100 @@ replication_manager :: send_ack(const virtual_server_id& us,
     size_t sz = HYPERDEX_HEADER_SIZE_VV + sizeof(uint64_t) + pack_size(key);
     std::auto_ptr<e::buffer> msg(e::buffer::create(sz));
     msg->pack_at(HYPERDEX_HEADER_SIZE_VV) << op->this_version() << key;
-    return m_daemon->m_comm.send_exact(us, op->recv_from(), CHAIN_ACK, msg);
+    return m_daemon->m_comm.send_chain(us, op->recv_from(), CHAIN_ACK, msg);
 }
 
-void
-replication_manager :: retransmit(const std::vector<region_id>& point_leaders,
-                                  std::vector<std::pair<region_id, uint64_t> >* versions)
+size_t
+replication_manager :: retransmit()
 {
-    for (key_map_t::iterator it(&m_key_states); it.valid(); ++it)
+    std::vector<region_id> regions;
+    m_unacked.regions(&regions);
+    std::vector<std::string> keys;
+    size_t visited = 0;
+
+    for (size_t i = 0; i < regions.size(); ++i)
     {
-        key_state* ks = *it;
-        region_id ri = ks->state_key().region;
+        const region_id& ri(regions[i]);
+        m_unacked.keys(ri, &keys);
+        bool blocked = m_daemon->m_config.is_server_blocked_by_live_transfer(m_daemon->m_us, ri);
+        virtual_server_id us = m_daemon->m_config.get_virtual(ri, m_daemon->m_us);
 
-        if (std::binary_search(point_leaders.begin(),
-                               point_leaders.end(), ri))
+        for (size_t j = 0; j < keys.size(); ++j)
         {
-            ks->append_all_versions(versions);
-        }
+            e::slice key(keys[j].data(), keys[j].size());
+            key_map_t::state_reference ksr;
+            key_state* ks = get_key_state(ri, key, &ksr);
+            ++visited;
 
-        if (m_daemon->m_config.is_server_blocked_by_live_transfer(m_daemon->m_us, ri))
-        {
-            continue;
+            if (!ks)
+            {
+                m_unacked.forget(ri, key);
+                continue;
+            }
+
+            if (blocked)
+            {
+                continue;
+            }
+
+            if (us == virtual_server_id() || ks->finished())
+            {
+                ks->reset(this);
+                continue;
+            }
+
+            const schema& sc(*m_daemon->m_config.get_schema(ri));
+            ks->resend_committable(this, us);
+            ks->work_state_machine(this, us, sc);
         }
+    }
 
-        virtual_server_id us = m_daemon->m_config.get_virtual(ri, m_daemon->m_us);
+    m_daemon->m_comm.wake_one();
+    return visited;
+}
 
-        if (us == virtual_server_id() || ks->finished())
+void
+replication_manager :: retransmit_bulk()
+{
+    std::vector<std::pair<region_id, uint64_t> > ids;
+    std::vector<e::compat::shared_ptr<bulk_batch> > dropped;
+
+    {
+        po6::threads::mutex::hold hold(&m_bulk_mtx);
+
+        for (bulk_map_t::iterator it = m_bulk.begin(); it != m_bulk.end(); )
         {
-            ks->reset(&m_daemon->m_gc);
-            continue;
+            const region_id& ri(it->first.first);
+
+            // a batch whose replica left the chain is no longer ours to pass on
+            if (m_daemon->m_config.get_virtual(ri, m_daemon->m_us) != it->second->us)
+            {
+                if (it->second->recv_from == virtual_server_id())
+                {
+                    m_unacked.remove_range(ri, it->first.second);
+                    dropped.push_back(it->second);
+                }
+
+                m_bulk.erase(it++);
+            }
+            else
+            {
+                ids.push_back(it->first);
+                ++it;
+            }
         }
+    }
 
-        const schema& sc(*m_daemon->m_config.get_schema(ri));
-        ks->resend_committable(this, us);
-        ks->work_state_machine(this, us, sc);
+    // the point leader changed under these batches; the client must try again
+    for (size_t i = 0; i < dropped.size(); ++i)
+    {
+        respond_to_bulk(*dropped[i], NET_SERVERERROR);
     }
 
-    m_daemon->m_comm.wake_one();
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        bulk_send(ids[i].first, ids[i].second);
+    }
 }
 
 void
@@ -699,63 +1065,151 @@ replication_manager :: collect(const region_id& ri, uint64_t version)
     check_stable(ri);
 }
 
-void
-replication_manager :: close_gaps(const std::vector<region_id>& point_leaders,
-                                  const identifier_generator& peek_ids,
-                                  std::vector<std::pair<region_id, uint64_t> >* versions)
+size_t
+replication_manager :: close_gaps(const std::vector<region_id>& point_leaders)
 {
-    std::sort(versions->begin(), versions->end());
+    std::vector<uint64_t> versions;
+    size_t outstanding = 0;
 
     for (size_t i = 0; i < point_leaders.size(); ++i)
     {
-        // figure out the start and end ptrs within versions
-        // s.t. [start, limit) contains all point_leaders[i]
-        std::pair<region_id, uint64_t>* start = &(*versions)[0];
-        std::pair<region_id, uint64_t>* const end = start + versions->size();
+        const region_id& ri(point_leaders[i]);
+        // every ID below cant_touch_this not still in the index is done
+        uint64_t cant_touch_this = m_unacked.versions(ri, m_idgen, &versions);
+        m_idcol.collect_all_but(ri, versions.empty() ? NULL : &versions[0],
+                                versions.size(), cant_touch_this);
+        outstanding += versions.size();
+    }
 
-        while (start < end && start->first == point_leaders[i])
+    return outstanding;
+}
+
+hyperdex::datalayer::returncode
+replication_manager :: bulk_write(const region_id& ri,
+                                  uint64_t first_version,
+                                  const std::vector<e::slice>& keys,
+                                  const std::vector<std::vector<e::slice> >& values)
+{
+    // Holding each key's state keeps client operations on these keys out
+    // until their part of the batch is on disk; those that follow read the
+    // new value from disk.  The keys are sorted, so locking them a slice at a
+    // time still locks them in order.
+    for (size_t start = 0; start < keys.size(); start += BULK_INGEST_LOCKED_KEYS)
+    {
+        const size_t limit = std::min(keys.size(), start + BULK_INGEST_LOCKED_KEYS);
+        e::array_ptr<key_map_t::state_reference> ksrs(new key_map_t::state_reference[limit - start]);
+
+        for (size_t i = start; i < limit; ++i)
         {
-            ++start;
+            key_region kr(ri, keys[i]);
+            m_key_states.get_or_create_state(kr, &ksrs[i - start]);
+            m_key_state_cache.forget(kr);
         }
 
-        std::pair<region_id, uint64_t>* limit = start;
+        std::vector<e::slice> slice_keys(keys.begin() + start, keys.begin() + limit);
+        std::vector<std::vector<e::slice> > slice_values(values.begin() + start, values.begin() + limit);
+        datalayer::returncode rc = m_daemon->m_data.bulk_put(ri, slice_keys, slice_values,
+                                                             first_version + start);
 
-        while (limit < end && limit->first == start->first)
+        if (rc != datalayer::SUCCESS)
         {
-            ++limit;
+            return rc;
         }
+    }
+
+    return datalayer::SUCCESS;
+}
 
-        // find the next ID to generate for point_leaders[i] (cant_touch_this)
-        uint64_t cant_touch_this = peek_ids.peek(point_leaders[i]);
+void
+replication_manager :: bulk_send(const region_id& ri, uint64_t first_version)
+{
+    virtual_server_id us;
+    virtual_server_id recv_from;
+    std::auto_ptr<e::buffer> msg;
+    bool tail = false;
 
-        // if start == limit, then there are no versions and everything less than
-        // cant_touch_this is collectable and we can short-circuit the
-        // complexity below
-        if (start == limit)
+    {
+        po6::threads::mutex::hold hold(&m_bulk_mtx);
+        bulk_map_t::iterator it = m_bulk.find(std::make_pair(ri, first_version));
+
+        if (it == m_bulk.end())
         {
-            m_idcol.bump(point_leaders[i], cant_touch_this);
-            continue;
+            return;
         }
 
-        // find the lower bound for point_leaders[i] (lb)
-        uint64_t lb = m_idcol.lower_bound(point_leaders[i]);
+        us = it->second->us;
+        recv_from = it->second->recv_from;
+        tail = m_daemon->m_config.tail_of_region(ri) == us;
 
-        // for every value [lb, cant_touch_this), call collect if not found in
-        // versions [start, limit)
-        for (uint64_t maybe_next_to_collect = lb;
-                maybe_next_to_collect < cant_touch_this; ++maybe_next_to_collect)
+        if (!tail)
         {
-            if (!std::binary_search(start, limit,
-                        std::make_pair(point_leaders[i], maybe_next_to_collect)))
-            {
-                m_idcol.collect(point_leaders[i], maybe_next_to_collect);
-            }
+            msg.reset(it->second->msg->copy());
+        }
+        else if (recv_from != virtual_server_id())
+        {
+            m_bulk.erase(it);
+        }
+    }
+
+    if (tail && recv_from == virtual_server_id())
+    {
+        bulk_acked(ri, first_version);
+    }
+    else if (tail)
+    {
+        size_t sz = HYPERDEX_HEADER_SIZE_VV + sizeof(uint64_t);
+        msg.reset(e::buffer::create(sz));
+        msg->pack_at(HYPERDEX_HEADER_SIZE_VV) << first_version;
+        m_daemon->m_comm.send_exact(us, recv_from, BULK_ACK, msg);
+    }
+    // like chain ops, hold the batch back while a transfer is in progress;
+    // the retransmitter sends it once the transfer completes
+    else if (!m_daemon->m_config.is_server_blocked_by_live_transfer(m_daemon->m_us, ri))
+    {
+        m_daemon->m_comm.send_exact(us, m_daemon->m_config.next_in_region(us), BULK_CHAIN, msg);
+    }
+}
+
+void
+replication_manager :: bulk_acked(const region_id& ri, uint64_t first_version)
+{
+    e::compat::shared_ptr<bulk_batch> b;
+
+    {
+        po6::threads::mutex::hold hold(&m_bulk_mtx);
+        bulk_map_t::iterator it = m_bulk.find(std::make_pair(ri, first_version));
+
+        if (it == m_bulk.end())
+        {
+            return;
         }
 
-        // compute the lower bound on point_leaders[i] to squash gaps
-        uint64_t tmp = m_idcol.lower_bound(point_leaders[i]);
-        (void) tmp;
+        b = it->second;
+        m_bulk.erase(it);
+    }
+
+    m_unacked.remove_range(ri, first_version);
+
+    for (uint64_t v = 0; v < b->count; ++v)
+    {
+        m_idcol.collect(ri, first_version + v);
     }
+
+    check_stable(ri);
+    respond_to_bulk(*b, NET_SUCCESS);
+}
+
+void
+replication_manager :: respond_to_bulk(const bulk_batch& b, network_returncode ret)
+{
+    size_t sz = HYPERDEX_HEADER_SIZE_VC
+              + sizeof(uint64_t)
+              + sizeof(uint16_t)
+              + sizeof(uint64_t);
+    std::auto_ptr<e::buffer> msg(e::buffer::create(sz));
+    uint16_t rc = static_cast<uint16_t>(ret);
+    msg->pack_at(HYPERDEX_HEADER_SIZE_VC) << b.nonce << rc << b.batch;
+    m_daemon->m_comm.send_client(b.us, b.client, BULK_INGEST, msg);
 }
 
 void
@@ -844,6 +1298,8 @@ replication_manager :: retransmitter_thread :: retransmitter_thread(daemon* d)
     : background_thread(d)
     , m_rm(&d->m_repl)
     , m_trigger(0)
+    , m_passes(0)
+    , m_last_pass(0)
 {
 }
 
@@ -867,21 +1323,29 @@ replication_manager :: retransmitter_thread :: copy_work()
 void
 replication_manager :: retransmitter_thread :: do_work()
 {
+    uint64_t start = po6::monotonic_time();
+
     // get the list of point leaders
     std::vector<region_id> point_leaders;
     m_rm->m_daemon->m_config.point_leaders(m_rm->m_daemon->m_us, &point_leaders);
     std::sort(point_leaders.begin(), point_leaders.end());
 
-    // peek at the next-to-generate values of m_idgen
-    identifier_generator peeked_values;
-    peeked_values.copy_from(m_rm->m_idgen);
-    std::vector<std::pair<region_id, uint64_t> > versions;
-
-    // retransmit everything
-    m_rm->retransmit(point_leaders, &versions);
+    // retransmit every key with operations in flight
+    size_t visited = m_rm->retransmit();
+    m_rm->retransmit_bulk();
 
     // now close all gaps
-    m_rm->close_gaps(point_leaders, peeked_values, &versions);
+    size_t outstanding = m_rm->close_gaps(point_leaders);
+    uint64_t elapsed = po6::monotonic_time() - start;
+    e::atomic::store_64_nobarrier(&m_last_pass, elapsed);
+    e::atomic::increment_64_nobarrier(&m_passes, 1);
+
+    if (elapsed >= RETRANSMIT_SLOW_PASS)
+    {
+        LOG(INFO) << "retransmission pass over " << visited << " key states and "
+                  << outstanding << " outstanding versions took "
+                  << elapsed / 1000000ULL << "ms";
+    }
 
     for (size_t i = 0; i < point_leaders.size(); ++i)
     {
@@ -30,6 +30,7 @@
 
 // STL
 #include <list>
+#include <map>
 
 // po6
 #include <po6/threads/cond.h>
@@ -50,14 +51,17 @@
 #include "common/ids.h"
 #include "common/key_change.h"
 #include "common/network_returncode.h"
+#include "daemon/datalayer.h"
 #include "daemon/identifier_collector.h"
 #include "daemon/identifier_generator.h"
 #include "daemon/key_operation.h"
 #include "daemon/key_region.h"
 #include "daemon/key_state.h"
+#include "daemon/key_state_cache.h"
 #include "daemon/reconfigure_returncode.h"
 #include "daemon/region_timestamp.h"
 #include "daemon/state_hash_table.h"
+#include "daemon/unacked_index.h"
 
 BEGIN_HYPERDEX_NAMESPACE
 class daemon;
@@ -79,6 +83,11 @@ class replication_manager
                          const configuration& new_config,
                          const server_id& us);
         void debug_dump();
+        // Bound the memory that remembers values of recently written keys
+        void set_key_state_cache(uint64_t budget);
+        void key_state_cache_stats(uint64_t* hits, uint64_t* misses);
+        // passes of the retransmitter so far, and the duration (ns) of the last
+        void retransmit_stats(uint64_t* passes, uint64_t* last_pass);
 
     // Network workers call these methods.
     public:
@@ -114,12 +123,34 @@ class replication_manager
                        const virtual_server_id& to,
                        uint64_t version,
                        const e::slice& key);
+        // Bulk ingest.  The point leader picks consecutive versions for a
+        // batch, writes it, and passes it down the chain in a BULK_CHAIN;
+        // every replica writes it and passes it on, and the tail acks back up
+        // the chain with a BULK_ACK.  The client hears back once the point
+        // leader sees that ack.  Returns NET_SUCCESS if the batch was taken.
+        network_returncode bulk_ingest(const virtual_server_id& us,
+                                       const server_id& client,
+                                       uint64_t nonce,
+                                       uint64_t batch,
+                                       const std::vector<e::slice>& keys,
+                                       const std::vector<std::vector<e::slice> >& values);
+        void bulk_chain(const virtual_server_id& from,
+                        const virtual_server_id& to,
+                        uint64_t first_version,
+                        const std::vector<e::slice>& keys,
+                        const std::vector<std::vector<e::slice> >& values,
+                        std::auto_ptr<e::buffer> backing);
+        void bulk_ack(const virtual_server_id& from,
+                      const virtual_server_id& to,
+                      uint64_t first_version);
         void begin_checkpoint(uint64_t seq);
         void end_checkpoint(uint64_t seq);
 
     private:
         class retransmitter_thread;
+        struct bulk_batch;
         typedef state_hash_table<key_region, key_state> key_map_t;
+        typedef std::map<std::pair<region_id, uint64_t>, e::compat::shared_ptr<bulk_batch> > bulk_map_t;
         friend class key_state;
 
     private:
@@ -145,13 +176,24 @@ class replication_manager
         bool send_ack(const virtual_server_id& us,
                       const e::slice& key,
                       e::intrusive_ptr<key_operation> op);
-        void retransmit(const std::vector<region_id>& point_leaders,
-                        std::vector<std::pair<region_id, uint64_t> >* versions);
+        // write a batch holding at most BULK_INGEST_LOCKED_KEYS key states
+        // at a time
+        datalayer::returncode bulk_write(const region_id& ri,
+                                         uint64_t first_version,
+                                         const std::vector<e::slice>& keys,
+                                         const std::vector<std::vector<e::slice> >& values);
+        // pass the batch down the chain, or ack it if we are the tail
+        void bulk_send(const region_id& ri, uint64_t first_version);
+        // the batch reached the tail; call without holding m_bulk_mtx
+        void bulk_acked(const region_id& ri, uint64_t first_version);
+        void respond_to_bulk(const bulk_batch& b, network_returncode ret);
+        // returns the number of key states visited
+        size_t retransmit();
+        void retransmit_bulk();
         void collect(const region_id& ri, e::intrusive_ptr<key_operation> op);
         void collect(const region_id& ri, uint64_t version);
-        void close_gaps(const std::vector<region_id>& point_leaders,
-                        const identifier_generator& peek_ids,
-                        std::vector<std::pair<region_id, uint64_t> >* versions);
+        // returns the number of outstanding versions seen
+        size_t close_gaps(const std::vector<region_id>& point_leaders);
         // call reset_to_unstable holding m_protect_stable_stuff
         void reset_to_unstable();
         bool is_check_needed() { return e::atomic::compare_and_swap_32_nobarrier(&m_need_check, 0, 0) == 1; }
@@ -163,8 +205,12 @@ class replication_manager
     private:
         daemon* m_daemon;
         key_map_t m_key_states;
+        key_state_cache m_key_state_cache;
         identifier_generator m_idgen;
         identifier_collector m_idcol;
+        unacked_index m_unacked;
+        po6::threads::mutex m_bulk_mtx;
+        bulk_map_t m_bulk;
         identifier_generator m_stable;
         const std::auto_ptr<retransmitter_thread> m_retransmitter;
         po6::threads::mutex m_protect_stable_stuff;
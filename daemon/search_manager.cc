@@ -29,6 +29,7 @@
 
 // STL
 #include <algorithm>
+#include <list>
 #include <sstream>
 
 // Google Log
@@ -52,6 +53,46 @@ using hyperdex::datatype_info;
 using hyperdex::search_manager;
 using hyperdex::reconfigure_returncode;
 
+// Upper bounds on what a client may ask for in a single RESP_SEARCH_BATCH
+#define SEARCH_BATCH_MAX_ITEMS 4096
+#define SEARCH_BATCH_MAX_BYTES (4ULL * 1024ULL * 1024ULL)
+
+// A projection lists the (non-key) attributes a client wants back.  Sort it,
+// drop duplicates, and fall back to the whole object if it names anything
+// outside the schema.
+static void
+normalize_projection(const hyperdex::schema& sc, std::vector<uint16_t>* projection)
+{
+    std::sort(projection->begin(), projection->end());
+    projection->erase(std::unique(projection->begin(), projection->end()), projection->end());
+
+    if (!projection->empty() &&
+        (projection->front() == 0 || projection->back() >= sc.attrs_sz))
+    {
+        LOG(WARNING) << "ignoring projection naming attributes outside the schema";
+        projection->clear();
+    }
+}
+
+// Reduce value to the projected attributes; an empty projection keeps all
+static void
+project_value(const std::vector<uint16_t>& projection, std::vector<e::slice>* value)
+{
+    if (projection.empty())
+    {
+        return;
+    }
+
+    std::vector<e::slice> projected(projection.size());
+
+    for (size_t i = 0; i < projection.size(); ++i)
+    {
+        projected[i] = (*value)[projection[i] - 1];
+    }
+
+    value->swap(projected);
+}
+
 /////////////////////////////// Search Manager ID //////////////////////////////
 
 class search_manager::id
@@ -114,7 +155,10 @@ class search_manager::state
     public:
         state(const region_id& region,
               std::auto_ptr<e::buffer> msg,
-              std::vector<attribute_check>* checks);
+              std::vector<attribute_check>* checks,
+              uint64_t batch_items,
+              uint64_t batch_bytes,
+              std::vector<uint16_t>* projection);
         ~state() throw ();
 
     public:
@@ -123,6 +167,10 @@ class search_manager::state
         const std::auto_ptr<e::buffer> backing;
         std::vector<attribute_check> checks;
         e::intrusive_ptr<datalayer::iterator> iter;
+        // zero items means the client wants one RESP_SEARCH_ITEM per request
+        const uint64_t batch_items;
+        const uint64_t batch_bytes;
+        std::vector<uint16_t> projection;
 
     private:
         friend class e::intrusive_ptr<state>;
@@ -137,15 +185,22 @@ class search_manager::state
 
 search_manager :: state :: state(const region_id& r,
                                  std::auto_ptr<e::buffer> msg,
-                                 std::vector<attribute_check>* c)
+                                 std::vector<attribute_check>* c,
+                                 uint64_t bi,
+                                 uint64_t bb,
+                                 std::vector<uint16_t>* p)
     : lock()
     , region(r)
     , backing(msg)
     , checks()
     , iter()
+    , batch_items(std::min(bi, uint64_t(SEARCH_BATCH_MAX_ITEMS)))
+    , batch_bytes(std::max(std::min(bb, uint64_t(SEARCH_BATCH_MAX_BYTES)), uint64_t(1)))
+    , projection()
     , m_ref(0)
 {
     checks.swap(*c);
+    projection.swap(*p);
 }
 
 search_manager :: state :: ~state() throw ()
@@ -199,7 +254,10 @@ search_manager :: start(const server_id& from,
                         std::auto_ptr<e::buffer> msg,
                         uint64_t nonce,
                         uint64_t search_id,
-                        std::vector<attribute_check>* checks)
+                        std::vector<attribute_check>* checks,
+                        uint64_t batch_items,
+                        uint64_t batch_bytes,
+                        std::vector<uint16_t>* projection)
 {
     region_id ri(m_daemon->m_config.get_region_id(to));
     const schema* sc = m_daemon->m_config.get_schema(ri);
@@ -218,7 +276,8 @@ search_manager :: start(const server_id& from,
         return;
     }
 
-    e::intrusive_ptr<state> st = new state(ri, msg, checks);
+    normalize_projection(*sc, projection);
+    e::intrusive_ptr<state> st = new state(ri, msg, checks, batch_items, batch_bytes, projection);
     std::stable_sort(st->checks.begin(), st->checks.end());
     datalayer::returncode rc = datalayer::SUCCESS;
     datalayer::snapshot snap = m_daemon->m_data.make_snapshot();
@@ -264,6 +323,12 @@ search_manager :: next(const server_id& from,
 
     po6::threads::mutex::hold hold(&st->lock);
 
+    if (st->batch_items > 0)
+    {
+        next_batch(from, to, nonce, search_id, sc, st.get());
+        return;
+    }
+
     if (st->iter->valid())
     {
         e::slice key;
@@ -271,6 +336,7 @@ search_manager :: next(const server_id& from,
         uint64_t ver;
         datalayer::reference tmp;
         m_daemon->m_data.get_from_iterator(ri, sc, st->iter.get(), &key, &val, &ver, &tmp);
+        project_value(st->projection, &val);
         size_t sz = HYPERDEX_HEADER_SIZE_VC
                   + sizeof(uint64_t)
                   + pack_size(key)
@@ -289,6 +355,80 @@ search_manager :: next(const server_id& from,
     }
 }
 
+namespace hyperdex
+{
+
+struct _search_batch_item
+{
+    _search_batch_item() : key(), value(), version(), ref() {}
+    ~_search_batch_item() throw () {}
+    e::slice key;
+    std::vector<e::slice> value;
+    uint64_t version;
+    datalayer::reference ref;
+};
+
+} // namespace hyperdex
+
+void
+search_manager :: next_batch(const server_id& from,
+                             const virtual_server_id& to,
+                             uint64_t nonce,
+                             uint64_t search_id,
+                             const schema& sc,
+                             state* st)
+{
+    // a std::list so the references backing each item never move
+    std::list<_search_batch_item> items;
+    uint64_t num_items = 0;
+    size_t sz = HYPERDEX_HEADER_SIZE_VC
+              + sizeof(uint64_t)
+              + sizeof(uint8_t)
+              + sizeof(uint64_t);
+    size_t payload = 0;
+
+    // every batch carries at least one item, or a client asking for a batch
+    // of nothing would keep the search going forever
+    while ((num_items == 0 ||
+            (num_items < st->batch_items && payload < st->batch_bytes)) &&
+           st->iter->valid())
+    {
+        items.push_back(_search_batch_item());
+        _search_batch_item& item(items.back());
+        m_daemon->m_data.get_from_iterator(st->region, sc, st->iter.get(),
+                                           &item.key, &item.value,
+                                           &item.version, &item.ref);
+        project_value(st->projection, &item.value);
+        size_t item_sz = pack_size(item.key) + pack_size(item.value);
+        sz += item_sz;
+        payload += item_sz;
+        ++num_items;
+        st->iter->next();
+    }
+
+    // valid() positions the iterator on the next match, so we know now
+    // whether this batch is the last one and can spare the client a round
+    // trip just to learn that the search is done
+    const bool done = !st->iter->valid();
+    const uint8_t flags = done ? 1 : 0;
+    std::auto_ptr<e::buffer> msg(e::buffer::create(sz));
+    e::packer pa = msg->pack_at(HYPERDEX_HEADER_SIZE_VC);
+    pa = pa << nonce << flags << num_items;
+
+    for (std::list<_search_batch_item>::iterator it = items.begin();
+            it != items.end(); ++it)
+    {
+        pa = pa << it->key << it->value;
+    }
+
+    m_daemon->m_comm.send_client(to, from, RESP_SEARCH_BATCH, msg);
+
+    if (done)
+    {
+        stop(from, to, search_id);
+    }
+}
+
 void
 search_manager :: stop(const server_id& from,
                        const virtual_server_id& to,
@@ -431,7 +571,9 @@ search_manager :: sorted_search(const server_id& from,
                                 std::vector<attribute_check>* checks,
                                 uint64_t limit,
                                 uint16_t sort_by,
-                                bool maximize)
+                                bool maximize,
+                                bool keys_only,
+                                std::vector<uint16_t>* projection)
 {
     region_id ri(m_daemon->m_config.get_region_id(to));
     const schema* sc = m_daemon->m_config.get_schema(ri);
@@ -442,10 +584,12 @@ search_manager :: sorted_search(const server_id& from,
     }
 
     std::stable_sort(checks->begin(), checks->end());
+    normalize_projection(*sc, projection);
     datalayer::returncode rc = datalayer::SUCCESS;
     datalayer::snapshot snap = m_daemon->m_data.make_snapshot();
     e::intrusive_ptr<datalayer::iterator> iter;
-    iter = m_daemon->m_data.make_search_iterator(snap, ri, *checks, NULL);
+    bool ordered = false;
+    iter = m_daemon->m_data.make_search_iterator(snap, ri, *checks, sort_by, maximize, &ordered, NULL);
 
     switch (rc)
     {
@@ -466,26 +610,65 @@ search_manager :: sorted_search(const server_id& from,
     std::vector<_sorted_search_item> top_n;
     top_n.reserve(limit);
 
-    while (iter->valid())
+    // When the iterator walks an index in sort order, the first limit
+    // matches are the answer and there is no need to look at the rest.
+    while (iter->valid() && (!ordered || top_n.size() < limit))
     {
         top_n.push_back(_sorted_search_item(&params));
         m_daemon->m_data.get_from_iterator(ri, *sc, iter.get(), &top_n.back().key, &top_n.back().value, &top_n.back().version, &top_n.back().ref);
-        std::push_heap(top_n.begin(), top_n.end());
 
-        if (top_n.size() > limit)
+        if (!ordered)
         {
-            std::pop_heap(top_n.begin(), top_n.end());
-            top_n.pop_back();
+            std::push_heap(top_n.begin(), top_n.end());
+
+            if (top_n.size() > limit)
+            {
+                std::pop_heap(top_n.begin(), top_n.end());
+                top_n.pop_back();
+            }
         }
 
         iter->next();
     }
 
-    std::sort(top_n.begin(), top_n.end(), std::greater<_sorted_search_item>());
+    if (!ordered)
+    {
+        std::sort(top_n.begin(), top_n.end(), std::greater<_sorted_search_item>());
+    }
+
+    // In the first phase of a two-phase sorted search, send only the key
+    // and the sort attribute of each candidate.  The client picks the
+    // global winners and fetches just those with REQ_SORTED_SEARCH_FETCH.
+    if (keys_only && sort_by < sc->attrs_sz)
+    {
+        size_t sz = HYPERDEX_HEADER_SIZE_VC + sizeof(uint64_t) + sizeof(uint64_t);
+
+        for (size_t i = 0; i < top_n.size(); ++i)
+        {
+            const e::slice& attr(sort_by == 0 ? top_n[i].key : top_n[i].value[sort_by - 1]);
+            sz += pack_size(top_n[i].key) + pack_size(attr);
+        }
+
+        std::auto_ptr<e::buffer> msg(e::buffer::create(sz));
+        e::packer pa = msg->pack_at(HYPERDEX_HEADER_SIZE_VC);
+        pa = pa << nonce << static_cast<uint64_t>(top_n.size());
+
+        for (size_t i = 0; i < top_n.size(); ++i)
+        {
+            const e::slice& attr(sort_by == 0 ? top_n[i].key : top_n[i].value[sort_by - 1]);
+            pa = pa << top_n[i].key << attr;
+        }
+
+        m_daemon->m_comm.send_client(to, from, RESP_SORTED_SEARCH_KEYS, msg);
+        return;
+    }
+
+    // projecting happens last because sorting needs the whole object
     size_t sz = HYPERDEX_HEADER_SIZE_VC + sizeof(uint64_t) + sizeof(uint64_t);
 
     for (size_t i = 0; i < top_n.size(); ++i)
     {
+        project_value(*projection, &top_n[i].value);
         sz += pack_size(top_n[i].key) + pack_size(top_n[i].value);
     }
 
@@ -501,6 +684,71 @@ search_manager :: sorted_search(const server_id& from,
     m_daemon->m_comm.send_client(to, from, RESP_SORTED_SEARCH, msg);
 }
 
+void
+search_manager :: sorted_search_fetch(const server_id& from,
+                                      const virtual_server_id& to,
+                                      uint64_t nonce,
+                                      std::vector<attribute_check>* checks,
+                                      const std::vector<e::slice>& keys,
+                                      std::vector<uint16_t>* projection)
+{
+    region_id ri(m_daemon->m_config.get_region_id(to));
+    const schema* sc = m_daemon->m_config.get_schema(ri);
+
+    if (sc->authorization)
+    {
+        return;
+    }
+
+    std::stable_sort(checks->begin(), checks->end());
+    normalize_projection(*sc, projection);
+    _sorted_search_params params(sc, 0, false);
+    std::vector<_sorted_search_item> found;
+    found.reserve(keys.size());
+
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        found.push_back(_sorted_search_item(&params));
+        _sorted_search_item& item(found.back());
+        datalayer::returncode rc = m_daemon->m_data.get(ri, keys[i], &item.value, &item.version, &item.ref);
+
+        // the object may have been deleted or changed to no longer match
+        // since the first phase; the client merges whatever comes back
+        if (rc != datalayer::SUCCESS ||
+            passes_attribute_checks(*sc, *checks, keys[i], item.value) != checks->size())
+        {
+            if (rc != datalayer::SUCCESS && rc != datalayer::NOT_FOUND)
+            {
+                LOG(ERROR) << "could not fetch object for sorted search:  " << rc;
+            }
+
+            found.pop_back();
+            continue;
+        }
+
+        item.key = keys[i];
+        project_value(*projection, &item.value);
+    }
+
+    size_t sz = HYPERDEX_HEADER_SIZE_VC + sizeof(uint64_t) + sizeof(uint64_t);
+
+    for (size_t i = 0; i < found.size(); ++i)
+    {
+        sz += pack_size(found[i].key) + pack_size(found[i].value);
+    }
+
+    std::auto_ptr<e::buffer> msg(e::buffer::create(sz));
+    e::packer pa = msg->pack_at(HYPERDEX_HEADER_SIZE_VC);
+    pa = pa << nonce << static_cast<uint64_t>(found.size());
+
+    for (size_t i = 0; i < found.size(); ++i)
+    {
+        pa = pa << found[i].key << found[i].value;
+    }
+
+    m_daemon->m_comm.send_client(to, from, RESP_SORTED_SEARCH, msg);
+}
+
 void
 search_manager :: group_keyop(const server_id& from,
                               const virtual_server_id& to,
@@ -543,11 +791,8 @@ search_manager :: group_keyop(const server_id& from,
 
     while (iter->valid() && result < UINT64_MAX)
     {
-        e::slice key;
-        std::vector<e::slice> val;
-        uint64_t ver;
-        datalayer::reference tmp;
-        m_daemon->m_data.get_from_iterator(ri, *sc, iter.get(), &key, &val, &ver, &tmp);
+        // only the key is forwarded, so there's no need to copy the object
+        e::slice key = iter->key();
         size_t sz = HYPERDEX_HEADER_SIZE_SV // SV because we imitate a client
                   + sizeof(uint64_t)
                   + pack_size(key)
@@ -591,30 +836,36 @@ search_manager :: count(const server_id& from,
     std::stable_sort(checks->begin(), checks->end());
     datalayer::returncode rc = datalayer::SUCCESS;
     datalayer::snapshot snap = m_daemon->m_data.make_snapshot();
-    e::intrusive_ptr<datalayer::iterator> iter;
-    iter = m_daemon->m_data.make_search_iterator(snap, ri, *checks, NULL);
     uint64_t result = 0;
 
-    switch (rc)
+    // when the indices answer every check, count their entries and never
+    // read the objects
+    if (!m_daemon->m_data.count_from_indices(snap, ri, *checks, &result))
     {
-        case datalayer::SUCCESS:
-            break;
-        case datalayer::NOT_FOUND:
-        case datalayer::BAD_ENCODING:
-        case datalayer::CORRUPTION:
-        case datalayer::IO_ERROR:
-        case datalayer::LEVELDB_ERROR:
-            LOG(ERROR) << "could not make snapshot for search:  " << rc;
-            result = UINT64_MAX;
-            break;
-        default:
-            abort();
-    }
+        e::intrusive_ptr<datalayer::iterator> iter;
+        iter = m_daemon->m_data.make_search_iterator(snap, ri, *checks, NULL);
 
-    while (iter->valid() && result < UINT64_MAX)
-    {
-        ++result;
-        iter->next();
+        switch (rc)
+        {
+            case datalayer::SUCCESS:
+                break;
+            case datalayer::NOT_FOUND:
+            case datalayer::BAD_ENCODING:
+            case datalayer::CORRUPTION:
+            case datalayer::IO_ERROR:
+            case datalayer::LEVELDB_ERROR:
+                LOG(ERROR) << "could not make snapshot for search:  " << rc;
+                result = UINT64_MAX;
+                break;
+            default:
+                abort();
+        }
+
+        while (iter->valid() && result < UINT64_MAX)
+        {
+            ++result;
+            iter->next();
+        }
     }
 
     size_t sz = HYPERDEX_HEADER_SIZE_VC
@@ -625,6 +876,83 @@ search_manager :: count(const server_id& from,
     m_daemon->m_comm.send_client(to, from, RESP_COUNT, msg);
 }
 
+void
+search_manager :: aggregate(const server_id& from,
+                            const virtual_server_id& to,
+                            uint64_t nonce,
+                            std::vector<attribute_check>* checks,
+                            std::vector<hyperdex::aggregate>* aggs)
+{
+    region_id ri(m_daemon->m_config.get_region_id(to));
+    const schema* sc = m_daemon->m_config.get_schema(ri);
+
+    if (sc->authorization)
+    {
+        return;
+    }
+
+    // an empty reply tells the client the request could not be served
+    std::vector<aggregate_state> states;
+    bool valid = true;
+
+    for (size_t i = 0; i < aggs->size(); ++i)
+    {
+        valid = valid && validate_aggregate(*sc, (*aggs)[i]);
+    }
+
+    std::stable_sort(checks->begin(), checks->end());
+    datalayer::snapshot snap = m_daemon->m_data.make_snapshot();
+    e::intrusive_ptr<datalayer::iterator> iter;
+
+    if (valid)
+    {
+        for (size_t i = 0; i < aggs->size(); ++i)
+        {
+            states.push_back(aggregate_state((*aggs)[i]));
+        }
+
+        iter = m_daemon->m_data.make_search_iterator(snap, ri, *checks, NULL);
+    }
+
+    while (iter.get() && iter->valid())
+    {
+        e::slice key;
+        std::vector<e::slice> value;
+        uint64_t version;
+        datalayer::reference ref;
+        datalayer::returncode rc;
+        rc = m_daemon->m_data.get_from_iterator(ri, *sc, iter.get(), &key, &value, &version, &ref);
+
+        if (rc != datalayer::SUCCESS)
+        {
+            LOG(ERROR) << "could not read object for aggregate:  " << rc;
+            states.clear();
+            break;
+        }
+
+        for (size_t i = 0; i < aggs->size(); ++i)
+        {
+            const hyperdex::aggregate& agg((*aggs)[i]);
+            states[i].add(agg, sc->attrs[agg.attr].type, value[agg.attr - 1]);
+        }
+
+        iter->next();
+    }
+
+    size_t sz = HYPERDEX_HEADER_SIZE_VC
+              + sizeof(uint64_t)
+              + sizeof(uint32_t);
+
+    for (size_t i = 0; i < states.size(); ++i)
+    {
+        sz += pack_size(states[i]);
+    }
+
+    std::auto_ptr<e::buffer> msg(e::buffer::create(sz));
+    msg->pack_at(HYPERDEX_HEADER_SIZE_VC) << nonce << states;
+    m_daemon->m_comm.send_client(to, from, RESP_AGGREGATE, msg);
+}
+
 void
 search_manager :: search_describe(const server_id& from,
                                   const virtual_server_id& to,
@@ -34,6 +34,7 @@
 
 // HyperDex
 #include "namespace.h"
+#include "common/aggregate.h"
 #include "common/ids.h"
 #include "common/network_msgtype.h"
 #include "daemon/datalayer.h"
@@ -63,7 +64,10 @@ class search_manager
                    std::auto_ptr<e::buffer> msg,
                    uint64_t nonce,
                    uint64_t search_id,
-                   std::vector<attribute_check>* checks);
+                   std::vector<attribute_check>* checks,
+                   uint64_t batch_items,
+                   uint64_t batch_bytes,
+                   std::vector<uint16_t>* projection);
         void next(const server_id& from,
                   const virtual_server_id& to,
                   uint64_t nonce,
@@ -77,7 +81,17 @@ class search_manager
                            std::vector<attribute_check>* checks,
                            uint64_t limit,
                            uint16_t sort_by,
-                           bool maximize);
+                           bool maximize,
+                           bool keys_only,
+                           std::vector<uint16_t>* projection);
+        // Second phase of a keys_only sorted search:  return the objects
+        // for the keys that made the client's global cut
+        void sorted_search_fetch(const server_id& from,
+                                 const virtual_server_id& to,
+                                 uint64_t nonce,
+                                 std::vector<attribute_check>* checks,
+                                 const std::vector<e::slice>& keys,
+                                 std::vector<uint16_t>* projection);
 
         // Find keys that match the check and forward ops to the corresponding servers
         // Essentially this splits out the group operation in several seperate operations
@@ -96,6 +110,14 @@ class search_manager
                    uint64_t nonce,
                    std::vector<attribute_check>* checks);
 
+        // Fold every entry that matches the checks into one partial result
+        // per aggregate
+        void aggregate(const server_id& from,
+                       const virtual_server_id& to,
+                       uint64_t nonce,
+                       std::vector<attribute_check>* checks,
+                       std::vector<hyperdex::aggregate>* aggs);
+
         void search_describe(const server_id& from,
                              const virtual_server_id& to,
                              uint64_t nonce,
@@ -111,6 +133,12 @@ class search_manager
 
     private:
         static uint64_t hash(const id&);
+        void next_batch(const server_id& from,
+                        const virtual_server_id& to,
+                        uint64_t nonce,
+                        uint64_t search_id,
+                        const schema& sc,
+                        state* st);
 
     private:
         daemon* m_daemon;
@@ -36,6 +36,7 @@
 
 // HyperDex
 #include "namespace.h"
+#include "daemon/object_pool.h"
 
 // This provides a hash table to map from a key to a piece of state.  It
 // differs from an ordinary hash table in that the piece of state is assumed to
@@ -135,7 +136,7 @@ class state_hash_table<K, T, H>::iterator
 };
 
 template <typename K, typename T, uint64_t (*H)(const K& k)>
-class state_hash_table<K, T, H>::state
+class state_hash_table<K, T, H>::state : public pooled<state>
 {
     public:
         state(const K& k);
@@ -0,0 +1,316 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+// STL
+#include <sstream>
+#include <string>
+#include <vector>
+
+// po6
+#include <po6/threads/thread.h>
+#include <po6/time.h>
+
+// LevelDB
+#include <hyperleveldb/db.h>
+#include <hyperleveldb/write_batch.h>
+
+// e
+#include <e/compat.h>
+
+// HyperDex
+#include "test/th.h"
+#include "daemon/datalayer_group_commit.h"
+
+using po6::threads::make_thread_wrapper;
+using hyperdex::datalayer;
+using hyperdex::schema;
+
+namespace
+{
+
+class scratch_db
+{
+    public:
+        scratch_db()
+            : db(NULL)
+        {
+            char dir[] = "/tmp/hyperdex-group-commit-XXXXXX";
+
+            if (!mkdtemp(dir))
+            {
+                abort();
+            }
+
+            path = dir;
+            leveldb::Options opts;
+            opts.create_if_missing = true;
+
+            if (!leveldb::DB::Open(opts, path, &db).ok())
+            {
+                abort();
+            }
+        }
+        ~scratch_db() throw ()
+        {
+            delete db;
+            leveldb::DestroyDB(path, leveldb::Options());
+        }
+
+    public:
+        std::string path;
+        leveldb::DB* db;
+
+    private:
+        scratch_db(const scratch_db&);
+        scratch_db& operator = (const scratch_db&);
+};
+
+class writer
+{
+    public:
+        writer(datalayer::group_commit* gc, leveldb::DB* db,
+               unsigned id, unsigned writes, schema::durability_t durability)
+            : m_gc(gc), m_db(db), m_id(id), m_writes(writes)
+            , m_durability(durability), failures(0) {}
+
+    public:
+        void run()
+        {
+            for (unsigned i = 0; i < m_writes; ++i)
+            {
+                std::ostringstream key;
+                key << m_id << ":" << i;
+                leveldb::WriteBatch updates;
+                updates.Put(key.str(), "value");
+
+                if (!m_gc->write(m_db, &updates, m_durability).ok())
+                {
+                    ++failures;
+                }
+            }
+        }
+
+    private:
+        datalayer::group_commit* m_gc;
+        leveldb::DB* m_db;
+        unsigned m_id;
+        unsigned m_writes;
+        schema::durability_t m_durability;
+
+    public:
+        unsigned failures;
+};
+
+// run writers writers concurrently, each making writes writes
+void
+run_writers(datalayer::group_commit* gc, leveldb::DB* db,
+            unsigned writers, unsigned writes,
+            schema::durability_t durability = schema::DURABILITY_NONE)
+{
+    std::vector<e::compat::shared_ptr<writer> > ws;
+    std::vector<e::compat::shared_ptr<po6::threads::thread> > ts;
+
+    for (unsigned i = 0; i < writers; ++i)
+    {
+        e::compat::shared_ptr<writer> w(new writer(gc, db, i, writes, durability));
+        e::compat::shared_ptr<po6::threads::thread> t(new po6::threads::thread(make_thread_wrapper(&writer::run, w.get())));
+        ws.push_back(w);
+        ts.push_back(t);
+    }
+
+    for (unsigned i = 0; i < writers; ++i)
+    {
+        ts[i]->start();
+    }
+
+    for (unsigned i = 0; i < writers; ++i)
+    {
+        ts[i]->join();
+        ASSERT_EQ(ws[i]->failures, 0U);
+    }
+
+    for (unsigned i = 0; i < writers; ++i)
+    {
+        for (unsigned j = 0; j < writes; ++j)
+        {
+            std::ostringstream key;
+            key << i << ":" << j;
+            std::string value;
+            ASSERT_TRUE(db->Get(leveldb::ReadOptions(), key.str(), &value).ok());
+            ASSERT_EQ(value, "value");
+        }
+    }
+}
+
+void
+sleep_ns(uint64_t ns)
+{
+    struct timespec ts;
+    ts.tv_sec = ns / 1000000000ULL;
+    ts.tv_nsec = ns % 1000000000ULL;
+    nanosleep(&ts, NULL);
+}
+
+class syncer
+{
+    public:
+        syncer(datalayer::group_commit* gc, leveldb::DB* db)
+            : m_gc(gc), m_db(db), passes(0) {}
+
+    public:
+        void run()
+        {
+            while (m_gc->wait_for_sync_due())
+            {
+                ASSERT_TRUE(m_gc->sync_if_due(m_db).ok());
+                ++passes;
+            }
+        }
+
+    private:
+        datalayer::group_commit* m_gc;
+        leveldb::DB* m_db;
+
+    public:
+        unsigned passes;
+};
+
+} // namespace
+
+TEST(GroupCommit, OffByDefault)
+{
+    scratch_db sdb;
+    datalayer::group_commit gc;
+    run_writers(&gc, sdb.db, 8, 100);
+    // every write went alone
+    std::string h = gc.histogram();
+    ASSERT_EQ(h.substr(0, h.find('\n')), "1=800");
+}
+
+TEST(GroupCommit, LeaderWaitsForFullGroup)
+{
+    scratch_db sdb;
+    datalayer::group_commit gc;
+    // the leader would wait a minute for followers, but must go as soon as
+    // the group fills
+    gc.configure(4, 60ULL * 1000000000ULL);
+    const uint64_t start = po6::monotonic_time();
+    run_writers(&gc, sdb.db, 4, 1);
+    const uint64_t elapsed = po6::monotonic_time() - start;
+    ASSERT_LT(elapsed, 30ULL * 1000000000ULL);
+    ASSERT_EQ(gc.histogram(), "1=0\n2=0\n4=1\n8=0\n16=0\n32=0\n64=0\n128=0\n");
+}
+
+TEST(GroupCommit, LeaderDelayIsBounded)
+{
+    scratch_db sdb;
+    datalayer::group_commit gc;
+    gc.configure(4, 10ULL * 1000000ULL);
+    // a lone writer leads a group nobody joins, and goes after the delay
+    const uint64_t start = po6::monotonic_time();
+    run_writers(&gc, sdb.db, 1, 3);
+    const uint64_t elapsed = po6::monotonic_time() - start;
+    ASSERT_GE(elapsed, 30ULL * 1000000ULL);
+    std::string h = gc.histogram();
+    ASSERT_EQ(h.substr(0, h.find('\n')), "1=3");
+}
+
+TEST(GroupCommit, FollowersGetLeadersStatus)
+{
+    scratch_db sdb;
+    datalayer::group_commit gc;
+    gc.configure(8, 1000000ULL);
+    run_writers(&gc, sdb.db, 16, 50);
+}
+
+TEST(GroupCommit, SyncCounts)
+{
+    scratch_db sdb;
+    datalayer::group_commit gc;
+    leveldb::WriteBatch updates;
+    updates.Put("k", "v");
+    ASSERT_TRUE(gc.write(sdb.db, &updates, schema::DURABILITY_NONE).ok());
+    ASSERT_EQ(gc.syncs(), 0U);
+    ASSERT_TRUE(gc.write(sdb.db, &updates, schema::DURABILITY_SYNC).ok());
+    ASSERT_EQ(gc.syncs(), 1U);
+    // a periodic write rides along unsynced until the interval lapses
+    gc.configure_sync(60ULL * 1000000000ULL);
+    ASSERT_TRUE(gc.write(sdb.db, &updates, schema::DURABILITY_PERIODIC).ok());
+    ASSERT_EQ(gc.syncs(), 1U);
+    gc.configure_sync(0);
+    ASSERT_TRUE(gc.write(sdb.db, &updates, schema::DURABILITY_PERIODIC).ok());
+    ASSERT_EQ(gc.syncs(), 2U);
+}
+
+TEST(GroupCommit, SyncWritersShareSyncsByDefault)
+{
+    scratch_db sdb;
+    datalayer::group_commit gc;
+    // grouping is off, but synced writers that queue behind an fsync still
+    // share the next one
+    run_writers(&gc, sdb.db, 16, 50, schema::DURABILITY_SYNC);
+    ASSERT_LT(gc.syncs(), 800U);
+    ASSERT_GE(gc.syncs(), 1U);
+}
+
+TEST(GroupCommit, SyncerCatchesQuietPeriodicWrites)
+{
+    scratch_db sdb;
+    datalayer::group_commit gc;
+    gc.configure_sync(200ULL * 1000000ULL);
+    syncer sy(&gc, sdb.db);
+    po6::threads::thread t(make_thread_wrapper(&syncer::run, &sy));
+    t.start();
+    // nothing is unsynced, so the syncer sleeps
+    sleep_ns(250ULL * 1000000ULL);
+    ASSERT_EQ(gc.syncs(), 0U);
+    // restart the interval so the periodic write below rides along unsynced
+    leveldb::WriteBatch updates;
+    updates.Put("k", "v");
+    ASSERT_TRUE(gc.write(sdb.db, &updates, schema::DURABILITY_SYNC).ok());
+    ASSERT_EQ(gc.syncs(), 1U);
+    // a periodic write with nothing after it gets synced within an interval
+    ASSERT_TRUE(gc.write(sdb.db, &updates, schema::DURABILITY_PERIODIC).ok());
+    ASSERT_EQ(gc.syncs(), 1U);
+    const uint64_t start = po6::monotonic_time();
+
+    while (gc.syncs() == 1 &&
+           po6::monotonic_time() - start < 10ULL * 1000000000ULL)
+    {
+        sleep_ns(1000000ULL);
+    }
+
+    ASSERT_EQ(gc.syncs(), 2U);
+    gc.stop_syncing();
+    t.join();
+    ASSERT_EQ(sy.passes, 1U);
+}
@@ -87,3 +87,94 @@ TEST(IdentifierCollector, Test)
         ASSERT_EQ(id, i + 1);
     }
 }
+
+TEST(IdentifierCollector, BumpAtCollectedEdges)
+{
+    e::garbage_collector gc;
+    identifier_collector ic(&gc);
+    region_id ri(1);
+    ic.adopt(&ri, 1);
+    // collect a run that starts right at the lower bound's gap
+    ic.collect(ri, 5);
+    ic.collect(ri, 6);
+    ic.collect(ri, 7);
+    ASSERT_EQ(ic.lower_bound(ri), 1U);
+    // bumping to the start of the run joins it
+    ic.bump(ri, 5);
+    ASSERT_EQ(ic.lower_bound(ri), 8U);
+    // bumping to or below the lower bound changes nothing
+    ic.bump(ri, 8);
+    ASSERT_EQ(ic.lower_bound(ri), 8U);
+    ic.bump(ri, 3);
+    ASSERT_EQ(ic.lower_bound(ri), 8U);
+    // bumping one short of a collected id stops at the gap
+    ic.collect(ri, 10);
+    ic.bump(ri, 9);
+    ASSERT_EQ(ic.lower_bound(ri), 9U);
+    ic.collect(ri, 9);
+    ASSERT_EQ(ic.lower_bound(ri), 11U);
+}
+
+TEST(IdentifierCollector, CollectAllButNothingOutstanding)
+{
+    e::garbage_collector gc;
+    identifier_collector ic(&gc);
+    region_id ri(1);
+    ic.adopt(&ri, 1);
+    ic.collect_all_but(ri, NULL, 0, 20);
+    ASSERT_EQ(ic.lower_bound(ri), 20U);
+    // the limit itself is never collected
+    ic.collect_all_but(ri, NULL, 0, 20);
+    ASSERT_EQ(ic.lower_bound(ri), 20U);
+}
+
+TEST(IdentifierCollector, CollectAllButStopsAtOutstanding)
+{
+    e::garbage_collector gc;
+    identifier_collector ic(&gc);
+    region_id ri(1);
+    ic.adopt(&ri, 1);
+    uint64_t outstanding[] = {10, 11, 15};
+    ic.collect_all_but(ri, outstanding, 3, 20);
+    // everything below the oldest outstanding id is gone
+    ASSERT_EQ(ic.lower_bound(ri), 10U);
+    // the gap between 11 and 15 and the tail up to 20 are collected, so
+    // finishing the outstanding ids in any order moves the bound past them
+    ic.collect(ri, 15);
+    ASSERT_EQ(ic.lower_bound(ri), 10U);
+    ic.collect(ri, 11);
+    ASSERT_EQ(ic.lower_bound(ri), 10U);
+    ic.collect(ri, 10);
+    ASSERT_EQ(ic.lower_bound(ri), 20U);
+}
+
+TEST(IdentifierCollector, CollectAllButAboveLimit)
+{
+    e::garbage_collector gc;
+    identifier_collector ic(&gc);
+    region_id ri(1);
+    ic.adopt(&ri, 1);
+    // outstanding ids at or past the limit leave everything below it
+    // collectable, and nothing at or past the limit is touched
+    uint64_t outstanding[] = {20, 25};
+    ic.collect_all_but(ri, outstanding, 2, 20);
+    ASSERT_EQ(ic.lower_bound(ri), 20U);
+    ic.collect(ri, 20);
+    ASSERT_EQ(ic.lower_bound(ri), 21U);
+}
+
+TEST(IdentifierCollector, CollectAllButBelowLowerBound)
+{
+    e::garbage_collector gc;
+    identifier_collector ic(&gc);
+    region_id ri(1);
+    ic.adopt(&ri, 1);
+    ic.bump(ri, 30);
+    // a stale outstanding id below the lower bound cannot move it back, and
+    // the gaps above the bound are still collected
+    uint64_t outstanding[] = {5, 32};
+    ic.collect_all_but(ri, outstanding, 2, 40);
+    ASSERT_EQ(ic.lower_bound(ri), 32U);
+    ic.collect(ri, 32);
+    ASSERT_EQ(ic.lower_bound(ri), 40U);
+}
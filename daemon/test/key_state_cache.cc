@@ -0,0 +1,191 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <stdint.h>
+#include <stdio.h>
+
+// STL
+#include <string>
+#include <vector>
+
+// HyperDex
+#include "test/th.h"
+#include "daemon/key_state_cache.h"
+
+using hyperdex::key_region;
+using hyperdex::key_state_cache;
+using hyperdex::region_id;
+
+namespace
+{
+
+key_region
+kr(uint64_t region, const char* key)
+{
+    return key_region(region_id(region), e::slice(key));
+}
+
+std::vector<e::slice>
+value(const char* a, const char* b)
+{
+    std::vector<e::slice> v;
+    v.push_back(e::slice(a));
+    v.push_back(e::slice(b));
+    return v;
+}
+
+// n keys in region 1 that all land in the same shard
+std::vector<std::string>
+same_shard(size_t n)
+{
+    std::vector<std::string> keys;
+    size_t shard = 0;
+
+    for (uint64_t i = 0; keys.size() < n; ++i)
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(i));
+        std::string key(buf);
+        const size_t s = e::compat::hash<key_region>()(kr(1, key.c_str()))
+                       & (KEY_STATE_CACHE_SHARDS - 1);
+
+        if (keys.empty())
+        {
+            shard = s;
+        }
+
+        if (s == shard)
+        {
+            keys.push_back(key);
+        }
+    }
+
+    return keys;
+}
+
+bool
+has(key_state_cache* ksc, const key_region& k)
+{
+    uint64_t version;
+    std::vector<e::slice> v;
+    std::string backing;
+    return ksc->get(k, &version, &v, &backing);
+}
+
+} // namespace
+
+TEST(KeyStateCache, Disabled)
+{
+    key_state_cache ksc;
+    ksc.put(kr(1, "k"), 1, value("a", "b"));
+    ASSERT_FALSE(has(&ksc, kr(1, "k")));
+    ASSERT_EQ(ksc.hits(), 0U);
+    ASSERT_EQ(ksc.misses(), 1U);
+}
+
+TEST(KeyStateCache, PutGetForget)
+{
+    key_state_cache ksc;
+    ksc.set_budget(1 << 20);
+    ksc.put(kr(1, "k"), 5, value("hello", "world"));
+    uint64_t version = 0;
+    std::vector<e::slice> v;
+    std::string backing;
+    ASSERT_TRUE(ksc.get(kr(1, "k"), &version, &v, &backing));
+    ASSERT_EQ(version, 5U);
+    ASSERT_EQ(v.size(), 2U);
+    ASSERT_TRUE(v[0] == e::slice("hello"));
+    ASSERT_TRUE(v[1] == e::slice("world"));
+    // the same key in another region is another key
+    ASSERT_FALSE(has(&ksc, kr(2, "k")));
+    // a newer write replaces the entry
+    ksc.put(kr(1, "k"), 6, value("", "x"));
+    ASSERT_TRUE(ksc.get(kr(1, "k"), &version, &v, &backing));
+    ASSERT_EQ(version, 6U);
+    ASSERT_EQ(v[0].size(), 0U);
+    ASSERT_TRUE(v[1] == e::slice("x"));
+    // a delete forgets it
+    ksc.forget(kr(1, "k"));
+    ASSERT_FALSE(has(&ksc, kr(1, "k")));
+    ASSERT_EQ(ksc.hits(), 2U);
+    ASSERT_EQ(ksc.misses(), 2U);
+}
+
+TEST(KeyStateCache, EvictsLeastRecentlyUsed)
+{
+    std::vector<std::string> keys = same_shard(4);
+    const char* a = keys[0].c_str();
+    const char* b = keys[1].c_str();
+    const char* c = keys[2].c_str();
+    const char* d = keys[3].c_str();
+    key_state_cache ksc;
+    std::string big(1000, 'x');
+    // each shard has room for two entries, but not three
+    ksc.set_budget((2 * (keys[2].size() + big.size() + 128) + 64) * KEY_STATE_CACHE_SHARDS);
+    ksc.put(kr(1, a), 1, value(big.c_str(), ""));
+    ksc.put(kr(1, b), 1, value(big.c_str(), ""));
+    // touch a so that b is the least recently used
+    ASSERT_TRUE(has(&ksc, kr(1, a)));
+    ksc.put(kr(1, c), 1, value(big.c_str(), ""));
+    ASSERT_TRUE(has(&ksc, kr(1, a)));
+    ASSERT_FALSE(has(&ksc, kr(1, b)));
+    ASSERT_TRUE(has(&ksc, kr(1, c)));
+    // shrinking the budget evicts down to it
+    ksc.set_budget((keys[2].size() + big.size() + 128) * KEY_STATE_CACHE_SHARDS);
+    ASSERT_FALSE(has(&ksc, kr(1, a)));
+    ASSERT_TRUE(has(&ksc, kr(1, c)));
+    // an entry larger than the shard's budget is never kept
+    std::string huge(4096, 'y');
+    ksc.put(kr(1, d), 1, value(huge.c_str(), ""));
+    ASSERT_FALSE(has(&ksc, kr(1, d)));
+}
+
+TEST(KeyStateCache, ResetExcludesRegions)
+{
+    key_state_cache ksc;
+    ksc.set_budget(1 << 20);
+    ksc.put(kr(1, "k"), 1, value("a", "b"));
+    ksc.put(kr(3, "k"), 1, value("a", "b"));
+    std::vector<region_id> excluded;
+    excluded.push_back(region_id(2));
+    excluded.push_back(region_id(3));
+    ksc.reset(excluded);
+    // reset drops everything
+    ASSERT_FALSE(has(&ksc, kr(1, "k")));
+    ASSERT_FALSE(has(&ksc, kr(3, "k")));
+    // regions being transferred in are not cached until the next reset
+    ksc.put(kr(1, "k"), 1, value("a", "b"));
+    ksc.put(kr(2, "k"), 1, value("a", "b"));
+    ksc.put(kr(3, "k"), 1, value("a", "b"));
+    ASSERT_TRUE(has(&ksc, kr(1, "k")));
+    ASSERT_FALSE(has(&ksc, kr(2, "k")));
+    ASSERT_FALSE(has(&ksc, kr(3, "k")));
+    ksc.reset(std::vector<region_id>());
+    ksc.put(kr(2, "k"), 1, value("a", "b"));
+    ASSERT_TRUE(has(&ksc, kr(2, "k")));
+}
@@ -0,0 +1,192 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <stdint.h>
+
+// STL
+#include <vector>
+
+// po6
+#include <po6/threads/thread.h>
+
+// HyperDex
+#include "test/th.h"
+#include "daemon/object_pool.h"
+
+using po6::threads::make_thread_wrapper;
+using hyperdex::object_pool_blocks;
+using hyperdex::pooled;
+
+// Every test uses its own size class so the counts don't interfere
+
+namespace
+{
+
+template <size_t S>
+struct sized_churn
+{
+    sized_churn(size_t n) : count(n), blocks() {}
+    void allocate()
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            blocks.push_back(object_pool_blocks<S>::allocate());
+        }
+    }
+    void release()
+    {
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            object_pool_blocks<S>::release(blocks[i]);
+        }
+
+        blocks.clear();
+    }
+    void allocate_and_release()
+    {
+        allocate();
+        release();
+    }
+    size_t count;
+    std::vector<void*> blocks;
+};
+
+struct widget : public pooled<widget>
+{
+    widget() : x(0), y(0) {}
+    uint64_t x;
+    uint64_t y;
+};
+
+} // namespace
+
+TEST(ObjectPool, ReusesFreedBlocks)
+{
+    void* a = object_pool_blocks<32>::allocate();
+    size_t before = object_pool_blocks<32>::allocated();
+    object_pool_blocks<32>::release(a);
+    void* b = object_pool_blocks<32>::allocate();
+    ASSERT_EQ(a, b);
+    ASSERT_EQ(before, object_pool_blocks<32>::allocated());
+    object_pool_blocks<32>::release(b);
+}
+
+TEST(ObjectPool, CapsEachList)
+{
+    size_t before = object_pool_blocks<48>::allocated();
+    sized_churn<48> c(OBJECT_POOL_MAX_CACHED + 100);
+    c.allocate();
+    ASSERT_EQ(before + OBJECT_POOL_MAX_CACHED + 100, object_pool_blocks<48>::allocated());
+    c.release();
+    ASSERT_EQ(before + OBJECT_POOL_MAX_CACHED, object_pool_blocks<48>::allocated());
+}
+
+TEST(ObjectPool, RemoteFreeReturnsToOwner)
+{
+    // allocate here, free on another thread, and the blocks come back here
+    // rather than being stranded on the other thread's list
+    sized_churn<64> c(100);
+    c.allocate();
+    std::vector<void*> first(c.blocks);
+    size_t before = object_pool_blocks<64>::allocated();
+    po6::threads::thread t(make_thread_wrapper(&sized_churn<64>::release, &c));
+    t.start();
+    t.join();
+    ASSERT_EQ(before, object_pool_blocks<64>::allocated());
+    c.allocate();
+    ASSERT_EQ(before, object_pool_blocks<64>::allocated());
+
+    for (size_t i = 0; i < first.size(); ++i)
+    {
+        bool found = false;
+
+        for (size_t j = 0; j < c.blocks.size(); ++j)
+        {
+            found = found || first[i] == c.blocks[j];
+        }
+
+        ASSERT_TRUE(found);
+    }
+
+    c.release();
+}
+
+TEST(ObjectPool, RepeatedRemoteFreesDoNotAccumulate)
+{
+    // a producer/consumer pair:  this thread allocates, another frees; the
+    // footprint stays at one batch however many rounds run
+    sized_churn<80> c(1000);
+    size_t before = object_pool_blocks<80>::allocated();
+
+    for (size_t round = 0; round < 20; ++round)
+    {
+        c.allocate();
+        po6::threads::thread t(make_thread_wrapper(&sized_churn<80>::release, &c));
+        t.start();
+        t.join();
+        ASSERT_GE(before + 1000, object_pool_blocks<80>::allocated());
+    }
+}
+
+TEST(ObjectPool, ThreadExitReleasesLists)
+{
+    size_t before = object_pool_blocks<96>::allocated();
+    sized_churn<96> c(500);
+    po6::threads::thread t(make_thread_wrapper(&sized_churn<96>::allocate_and_release, &c));
+    t.start();
+    t.join();
+    ASSERT_EQ(before, object_pool_blocks<96>::allocated());
+}
+
+TEST(ObjectPool, OutlivesOwningThread)
+{
+    // blocks allocated on a thread that has since exited go back to the heap
+    size_t before = object_pool_blocks<112>::allocated();
+    sized_churn<112> c(500);
+    po6::threads::thread t(make_thread_wrapper(&sized_churn<112>::allocate, &c));
+    t.start();
+    t.join();
+    ASSERT_EQ(before + 500, object_pool_blocks<112>::allocated());
+    c.release();
+    ASSERT_EQ(before, object_pool_blocks<112>::allocated());
+}
+
+TEST(ObjectPool, PooledOperatorNew)
+{
+    const size_t SZ = OBJECT_POOL_SIZE_CLASS(sizeof(widget));
+    widget* w = new widget();
+    size_t before = object_pool_blocks<SZ>::allocated();
+    w->x = 1;
+    w->y = 2;
+    delete w;
+    widget* v = new widget();
+    ASSERT_EQ(w, v);
+    ASSERT_EQ(0U, v->x);
+    ASSERT_EQ(before, object_pool_blocks<SZ>::allocated());
+    delete v;
+}
@@ -0,0 +1,192 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <stdint.h>
+#include <stdio.h>
+
+// STL
+#include <string>
+#include <vector>
+
+// HyperDex
+#include "test/th.h"
+#include "cityhash/city.h"
+#include "daemon/datalayer_row_cache.h"
+
+using hyperdex::datalayer;
+
+namespace
+{
+
+std::string
+lookup(datalayer::row_cache* rc, const char* key)
+{
+    std::string backing;
+    uint64_t generation;
+
+    if (!rc->get(key, &backing, &generation))
+    {
+        return "<miss>";
+    }
+
+    return backing;
+}
+
+// n keys of length sz that all land in the same shard
+std::vector<std::string>
+same_shard(size_t n, size_t sz)
+{
+    std::vector<std::string> keys;
+    uint64_t shard = 0;
+
+    for (uint64_t i = 0; keys.size() < n; ++i)
+    {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%0*llu", static_cast<int>(sz),
+                 static_cast<unsigned long long>(i));
+        std::string key(buf);
+        const uint64_t s = CityHash64(key.data(), key.size()) & (ROW_CACHE_SHARDS - 1);
+
+        if (keys.empty())
+        {
+            shard = s;
+        }
+
+        if (s == shard)
+        {
+            keys.push_back(key);
+        }
+    }
+
+    return keys;
+}
+
+} // namespace
+
+TEST(RowCache, DisabledByDefault)
+{
+    datalayer::row_cache rc;
+    ASSERT_TRUE(!rc.enabled());
+    rc.put("k", "v");
+    ASSERT_EQ(lookup(&rc, "k"), "<miss>");
+}
+
+TEST(RowCache, PutThenGet)
+{
+    datalayer::row_cache rc;
+    rc.set_budget(1ULL << 20);
+    ASSERT_TRUE(rc.enabled());
+    ASSERT_EQ(lookup(&rc, "k"), "<miss>");
+    rc.put("k", "v1");
+    ASSERT_EQ(lookup(&rc, "k"), "v1");
+    rc.put("k", "v2");
+    ASSERT_EQ(lookup(&rc, "k"), "v2");
+    ASSERT_EQ(lookup(&rc, "other"), "<miss>");
+}
+
+TEST(RowCache, Forget)
+{
+    datalayer::row_cache rc;
+    rc.set_budget(1ULL << 20);
+    rc.put("k", "v");
+    rc.put("j", "w");
+    rc.forget("k");
+    ASSERT_EQ(lookup(&rc, "k"), "<miss>");
+    ASSERT_EQ(lookup(&rc, "j"), "w");
+    rc.reset();
+    ASSERT_EQ(lookup(&rc, "j"), "<miss>");
+}
+
+TEST(RowCache, FillAfterMiss)
+{
+    datalayer::row_cache rc;
+    rc.set_budget(1ULL << 20);
+    std::string backing;
+    uint64_t generation;
+    ASSERT_TRUE(!rc.get("k", &backing, &generation));
+    rc.fill("k", "from-disk", generation);
+    ASSERT_EQ(lookup(&rc, "k"), "from-disk");
+}
+
+TEST(RowCache, FillAfterInvalidateIsDropped)
+{
+    datalayer::row_cache rc;
+    rc.set_budget(1ULL << 20);
+    std::string backing;
+    uint64_t generation;
+
+    // a reader misses and reads the old value while a writer replaces it
+    ASSERT_TRUE(!rc.get("k", &backing, &generation));
+    rc.put("k", "new");
+    rc.fill("k", "old", generation);
+    ASSERT_EQ(lookup(&rc, "k"), "new");
+
+    // likewise when the writer only invalidates
+    ASSERT_TRUE(!rc.get("j", &backing, &generation));
+    rc.forget("j");
+    rc.fill("j", "old", generation);
+    ASSERT_EQ(lookup(&rc, "j"), "<miss>");
+
+    // and when the whole cache is dropped
+    ASSERT_TRUE(!rc.get("i", &backing, &generation));
+    rc.reset();
+    rc.fill("i", "old", generation);
+    ASSERT_EQ(lookup(&rc, "i"), "<miss>");
+}
+
+TEST(RowCache, BudgetEvictsLeastRecentlyUsed)
+{
+    std::vector<std::string> keys = same_shard(3, 8);
+    const std::string value(64, 'v');
+    const uint64_t cost = keys[0].size() + value.size() + ROW_CACHE_OVERHEAD;
+    datalayer::row_cache rc;
+    // each shard holds two entries
+    rc.set_budget(2 * cost * ROW_CACHE_SHARDS);
+    rc.put(keys[0], value);
+    rc.put(keys[1], value);
+    // touch the first so that the second is the least recently used
+    ASSERT_EQ(lookup(&rc, keys[0].c_str()), value);
+    rc.put(keys[2], value);
+    ASSERT_EQ(lookup(&rc, keys[0].c_str()), value);
+    ASSERT_EQ(lookup(&rc, keys[1].c_str()), "<miss>");
+    ASSERT_EQ(lookup(&rc, keys[2].c_str()), value);
+    // shrinking the budget evicts down to it
+    rc.set_budget(cost * ROW_CACHE_SHARDS);
+    ASSERT_EQ(lookup(&rc, keys[0].c_str()), "<miss>");
+    ASSERT_EQ(lookup(&rc, keys[2].c_str()), value);
+}
+
+TEST(RowCache, OversizedEntriesAreNotKept)
+{
+    datalayer::row_cache rc;
+    rc.set_budget(ROW_CACHE_SHARDS * 1024);
+    rc.put("k", "small");
+    rc.put("k", std::string(2048, 'x'));
+    // the stale small value must not survive either
+    ASSERT_EQ(lookup(&rc, "k"), "<miss>");
+}
@@ -0,0 +1,157 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <stdint.h>
+
+// STL
+#include <string>
+#include <vector>
+
+// HyperDex
+#include "test/th.h"
+#include "daemon/identifier_generator.h"
+#include "daemon/unacked_index.h"
+
+using hyperdex::identifier_generator;
+using hyperdex::region_id;
+using hyperdex::unacked_index;
+
+TEST(UnackedIndex, VersionsInOrder)
+{
+    identifier_generator ids;
+    region_id ri(1);
+    ids.adopt(&ri, 1);
+    ids.bump(ri, 99);
+    unacked_index ui;
+    ui.add(ri, 7, e::slice("b"));
+    ui.add(ri, 3, e::slice("a"));
+    ui.add(ri, 5, e::slice("a"));
+    std::vector<uint64_t> versions;
+    ASSERT_EQ(ui.versions(ri, ids, &versions), 100U);
+    ASSERT_EQ(versions.size(), 3U);
+    ASSERT_EQ(versions[0], 3U);
+    ASSERT_EQ(versions[1], 5U);
+    ASSERT_EQ(versions[2], 7U);
+    ui.remove(ri, 5);
+    ui.versions(ri, ids, &versions);
+    ASSERT_EQ(versions.size(), 2U);
+    ASSERT_EQ(versions[0], 3U);
+    ASSERT_EQ(versions[1], 7U);
+}
+
+TEST(UnackedIndex, GenerateRecords)
+{
+    identifier_generator ids;
+    region_id ri(1);
+    ids.adopt(&ri, 1);
+    unacked_index ui;
+    uint64_t v1 = ui.generate(ri, e::slice("k"), &ids);
+    uint64_t v2 = ui.generate(ri, e::slice("k"), &ids);
+    ASSERT_LT(v1, v2);
+    std::vector<uint64_t> versions;
+    ASSERT_EQ(ui.versions(ri, ids, &versions), v2 + 1);
+    ASSERT_EQ(versions.size(), 2U);
+    ASSERT_EQ(versions[0], v1);
+    ASSERT_EQ(versions[1], v2);
+}
+
+TEST(UnackedIndex, KeysAndRegions)
+{
+    unacked_index ui;
+    // regions 1 and 65 share a stripe; neither may see the other's entries
+    region_id r1(1);
+    region_id r2(1 + UNACKED_INDEX_STRIPES);
+    region_id r3(2);
+    ui.add(r1, 1, e::slice("x"));
+    ui.add(r1, 2, e::slice("y"));
+    ui.add(r1, 3, e::slice("x"));
+    ui.add(r2, 1, e::slice("z"));
+    ui.add(r3, 4, e::slice("w"));
+    ASSERT_EQ(ui.size(), 5U);
+
+    std::vector<region_id> regions;
+    ui.regions(&regions);
+    ASSERT_EQ(regions.size(), 3U);
+    ASSERT_EQ(regions[0], r1);
+    ASSERT_EQ(regions[1], r3);
+    ASSERT_EQ(regions[2], r2);
+
+    std::vector<std::string> keys;
+    ui.keys(r1, &keys);
+    ASSERT_EQ(keys.size(), 2U);
+    ASSERT_EQ(keys[0], "x");
+    ASSERT_EQ(keys[1], "y");
+    ui.keys(r2, &keys);
+    ASSERT_EQ(keys.size(), 1U);
+    ASSERT_EQ(keys[0], "z");
+
+    // forgetting a key drops all of its versions and nothing else
+    ui.forget(r1, e::slice("x"));
+    ui.keys(r1, &keys);
+    ASSERT_EQ(keys.size(), 1U);
+    ASSERT_EQ(keys[0], "y");
+    ASSERT_EQ(ui.size(), 3U);
+
+    ui.remove(r1, 2);
+    ui.remove(r2, 1);
+    ui.remove(r3, 4);
+    ASSERT_EQ(ui.size(), 0U);
+    ui.regions(&regions);
+    ASSERT_TRUE(regions.empty());
+}
+
+TEST(UnackedIndex, RangesHoldVersionsWithoutKeys)
+{
+    identifier_generator ids;
+    region_id ri(1);
+    ids.adopt(&ri, 1);
+    ids.bump(ri, 9);
+    unacked_index ui;
+    ui.add(ri, 4, e::slice("k"));
+    uint64_t first = ui.generate_range(ri, 3, &ids);
+    ASSERT_EQ(first, 10U);
+    ui.add(ri, 13, e::slice("k"));
+    std::vector<uint64_t> versions;
+    ASSERT_EQ(ui.versions(ri, ids, &versions), 13U);
+    ASSERT_EQ(versions.size(), 5U);
+    ASSERT_EQ(versions[0], 4U);
+    ASSERT_EQ(versions[1], 10U);
+    ASSERT_EQ(versions[2], 11U);
+    ASSERT_EQ(versions[3], 12U);
+    ASSERT_EQ(versions[4], 13U);
+    ASSERT_EQ(ui.size(), 5U);
+    // a range has no key for the retransmitter to visit
+    std::vector<std::string> keys;
+    ui.keys(ri, &keys);
+    ASSERT_EQ(keys.size(), 1U);
+    ui.remove_range(ri, first);
+    ui.versions(ri, ids, &versions);
+    ASSERT_EQ(versions.size(), 2U);
+    ASSERT_EQ(versions[0], 4U);
+    ASSERT_EQ(versions[1], 13U);
+}
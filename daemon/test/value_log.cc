@@ -0,0 +1,301 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+// C
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// POSIX
+#include <dirent.h>
+#include <unistd.h>
+
+// STL
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+// po6
+#include <po6/path.h>
+
+// LevelDB
+#include <hyperleveldb/db.h>
+#include <hyperleveldb/write_batch.h>
+
+// HyperDex
+#include "test/th.h"
+#include "daemon/datalayer_value_log.h"
+
+using hyperdex::datalayer;
+using hyperdex::region_id;
+
+namespace
+{
+
+void
+remove_tree(const std::string& path)
+{
+    DIR* dir = opendir(path.c_str());
+
+    if (dir)
+    {
+        struct dirent* ent = NULL;
+
+        while ((ent = readdir(dir)) != NULL)
+        {
+            if (strcmp(ent->d_name, ".") != 0 && strcmp(ent->d_name, "..") != 0)
+            {
+                unlink(po6::path::join(path, ent->d_name).c_str());
+            }
+        }
+
+        closedir(dir);
+    }
+
+    rmdir(path.c_str());
+}
+
+// a data directory holding a LevelDB (for its timestamps) and a value log
+class scratch_dir
+{
+    public:
+        scratch_dir()
+            : path()
+            , db(NULL)
+        {
+            char dir[] = "/tmp/hyperdex-value-log-XXXXXX";
+
+            if (!mkdtemp(dir))
+            {
+                abort();
+            }
+
+            path = dir;
+            leveldb::Options opts;
+            opts.create_if_missing = true;
+
+            if (!leveldb::DB::Open(opts, po6::path::join(path, "db"), &db).ok())
+            {
+                abort();
+            }
+        }
+        ~scratch_dir() throw ()
+        {
+            delete db;
+            leveldb::DestroyDB(po6::path::join(path, "db"), leveldb::Options());
+            remove_tree(po6::path::join(path, "vlog"));
+            rmdir(path.c_str());
+        }
+
+    public:
+        // a timestamp later than every one taken before
+        std::string timestamp()
+        {
+            leveldb::WriteBatch updates;
+            updates.Put("tick", "tock");
+            leveldb::WriteOptions opts;
+            opts.sync = false;
+
+            if (!db->Write(opts, &updates).ok())
+            {
+                abort();
+            }
+
+            std::string ts;
+            db->GetReplayTimestamp(&ts);
+            return ts;
+        }
+        bool exists(uint64_t number)
+        {
+            char buf[32];
+            snprintf(buf, sizeof(buf), "%016llx.vlog", static_cast<unsigned long long>(number));
+            return access(po6::path::join(po6::path::join(path, "vlog"), buf).c_str(), F_OK) == 0;
+        }
+
+    public:
+        std::string path;
+        leveldb::DB* db;
+
+    private:
+        scratch_dir(const scratch_dir&);
+        scratch_dir& operator = (const scratch_dir&);
+};
+
+std::string
+read_value(datalayer::value_log* vl, const char* ptr)
+{
+    e::slice p(ptr, VALUE_POINTER_SIZE);
+    std::vector<char> out(std::max(datalayer::value_log::value_size(p), 1U));
+
+    if (!vl->read(p, &out[0]))
+    {
+        return "<unreadable>";
+    }
+
+    return std::string(&out[0], datalayer::value_log::value_size(p));
+}
+
+// values large enough that releasing them makes their segment worth
+// collecting
+const std::string value1(1024, '1');
+const std::string value2(1024, '2');
+
+// fill the log in dir with one sealed segment holding value1 and value2,
+// and return pointers to them; a reopened log treats every segment it finds
+// as sealed
+void
+make_sealed_segment(scratch_dir* sd, char* ptr1, char* ptr2)
+{
+    datalayer::value_log vl;
+    ASSERT_TRUE(vl.open(sd->path));
+    vl.set_threshold(VALUE_LOG_MIN_THRESHOLD);
+    ASSERT_TRUE(vl.append(region_id(5), 1, "key1", e::slice(value1.data(), value1.size()), ptr1));
+    ASSERT_TRUE(vl.append(region_id(5), 2, "key2", e::slice(value2.data(), value2.size()), ptr2));
+    ASSERT_TRUE(vl.sync());
+}
+
+} // namespace
+
+TEST(ValueLog, InactiveUntilConfigured)
+{
+    scratch_dir sd;
+    datalayer::value_log vl;
+    ASSERT_TRUE(vl.open(sd.path));
+    ASSERT_TRUE(!vl.active());
+    vl.set_threshold(VALUE_LOG_MIN_THRESHOLD);
+    ASSERT_TRUE(vl.active());
+}
+
+TEST(ValueLog, AppendThenRead)
+{
+    scratch_dir sd;
+    datalayer::value_log vl;
+    ASSERT_TRUE(vl.open(sd.path));
+    vl.set_threshold(VALUE_LOG_MIN_THRESHOLD);
+    char ptr1[VALUE_POINTER_SIZE];
+    char ptr2[VALUE_POINTER_SIZE];
+    char ptr3[VALUE_POINTER_SIZE];
+    std::string big(3 * VALUE_LOG_MIN_THRESHOLD, 'x');
+    ASSERT_TRUE(vl.append(region_id(1), 1, "a", "first", ptr1));
+    ASSERT_TRUE(vl.append(region_id(1), 1, "b", "", ptr2));
+    ASSERT_TRUE(vl.append(region_id(1), 2, "a", e::slice(big.data(), big.size()), ptr3));
+    ASSERT_EQ(datalayer::value_log::value_size(e::slice(ptr1, VALUE_POINTER_SIZE)), 5U);
+    ASSERT_EQ(read_value(&vl, ptr1), "first");
+    ASSERT_EQ(read_value(&vl, ptr2), "");
+    ASSERT_EQ(read_value(&vl, ptr3), big);
+    // repeated syncs with nothing new appended are free, and still succeed
+    ASSERT_TRUE(vl.sync());
+    ASSERT_TRUE(vl.sync());
+}
+
+TEST(ValueLog, ReopenKeepsRecords)
+{
+    scratch_dir sd;
+    char ptr1[VALUE_POINTER_SIZE];
+    char ptr2[VALUE_POINTER_SIZE];
+    make_sealed_segment(&sd, ptr1, ptr2);
+    datalayer::value_log vl;
+    ASSERT_TRUE(vl.open(sd.path));
+    // segments remain even though no threshold is set
+    ASSERT_TRUE(vl.active());
+    ASSERT_EQ(read_value(&vl, ptr1), value1);
+    ASSERT_EQ(read_value(&vl, ptr2), value2);
+}
+
+TEST(ValueLog, ScanFindsEveryRecord)
+{
+    scratch_dir sd;
+    char ptr1[VALUE_POINTER_SIZE];
+    char ptr2[VALUE_POINTER_SIZE];
+    make_sealed_segment(&sd, ptr1, ptr2);
+    datalayer::value_log vl;
+    ASSERT_TRUE(vl.open(sd.path));
+    uint64_t number = 0;
+    ASSERT_TRUE(vl.pick(&number));
+    std::vector<datalayer::value_log::entry> entries;
+    uint64_t size = 0;
+    ASSERT_TRUE(vl.scan(number, &entries, &size));
+    ASSERT_EQ(entries.size(), 2U);
+    ASSERT_EQ(entries[0].ri, region_id(5));
+    ASSERT_EQ(entries[0].attr, 1U);
+    ASSERT_EQ(entries[0].key, "key1");
+    ASSERT_EQ(memcmp(entries[0].ptr, ptr1, VALUE_POINTER_SIZE), 0);
+    ASSERT_EQ(entries[1].key, "key2");
+    ASSERT_EQ(memcmp(entries[1].ptr, ptr2, VALUE_POINTER_SIZE), 0);
+    // all of it is live, so it is not picked again until it gathers garbage
+    vl.scanned(number, size);
+    ASSERT_TRUE(!vl.pick(&number));
+    vl.release(e::slice(ptr1, VALUE_POINTER_SIZE));
+    vl.release(e::slice(ptr2, VALUE_POINTER_SIZE));
+    ASSERT_TRUE(vl.pick(&number));
+}
+
+TEST(ValueLog, RetiredSegmentWaitsForCheckpoints)
+{
+    scratch_dir sd;
+    char ptr1[VALUE_POINTER_SIZE];
+    char ptr2[VALUE_POINTER_SIZE];
+    make_sealed_segment(&sd, ptr1, ptr2);
+    datalayer::value_log vl;
+    ASSERT_TRUE(vl.open(sd.path));
+    uint64_t number = 0;
+    ASSERT_TRUE(vl.pick(&number));
+    const std::string before = sd.timestamp();
+    vl.retire(number, sd.timestamp());
+    // retired segments stay readable
+    ASSERT_EQ(read_value(&vl, ptr1), value1);
+    ASSERT_TRUE(!vl.pick(&number));
+    // a checkpoint older than the retirement may still point into it
+    vl.release_retired(sd.db, before);
+    ASSERT_TRUE(sd.exists(number));
+    vl.release_retired(sd.db, sd.timestamp());
+    ASSERT_TRUE(!sd.exists(number));
+}
+
+TEST(ValueLog, RetiredSegmentWaitsForPins)
+{
+    scratch_dir sd;
+    char ptr1[VALUE_POINTER_SIZE];
+    char ptr2[VALUE_POINTER_SIZE];
+    make_sealed_segment(&sd, ptr1, ptr2);
+    datalayer::value_log vl;
+    ASSERT_TRUE(vl.open(sd.path));
+    uint64_t number = 0;
+    ASSERT_TRUE(vl.pick(&number));
+    std::auto_ptr<datalayer::value_log::pin> before(new datalayer::value_log::pin(&vl));
+    vl.retire(number, sd.timestamp());
+    // a pin taken after the retirement can't reach the segment, so it
+    // doesn't hold it
+    datalayer::value_log::pin after(&vl);
+    vl.release_retired(sd.db, sd.timestamp());
+    ASSERT_TRUE(sd.exists(number));
+    ASSERT_EQ(read_value(&vl, ptr2), value2);
+    before.reset();
+    vl.release_retired(sd.db, sd.timestamp());
+    ASSERT_TRUE(!sd.exists(number));
+}
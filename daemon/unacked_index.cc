@@ -0,0 +1,219 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#define __STDC_LIMIT_MACROS
+
+// C
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+
+// STL
+#include <algorithm>
+
+// HyperDex
+#include "daemon/unacked_index.h"
+
+using hyperdex::region_id;
+using hyperdex::unacked_index;
+
+unacked_index :: unacked_index()
+    : m_stripes()
+{
+}
+
+unacked_index :: ~unacked_index() throw ()
+{
+}
+
+uint64_t
+unacked_index :: generate(const region_id& ri, const e::slice& key,
+                          identifier_generator* ids)
+{
+    stripe* s = get_stripe(ri);
+    po6::threads::mutex::hold hold(&s->mtx);
+    uint64_t version = ids->generate_id(ri);
+    s->entries[std::make_pair(ri, version)].assign(key.cdata(), key.size());
+    return version;
+}
+
+void
+unacked_index :: add(const region_id& ri, uint64_t version, const e::slice& key)
+{
+    stripe* s = get_stripe(ri);
+    po6::threads::mutex::hold hold(&s->mtx);
+    s->entries[std::make_pair(ri, version)].assign(key.cdata(), key.size());
+}
+
+void
+unacked_index :: remove(const region_id& ri, uint64_t version)
+{
+    stripe* s = get_stripe(ri);
+    po6::threads::mutex::hold hold(&s->mtx);
+    s->entries.erase(std::make_pair(ri, version));
+}
+
+void
+unacked_index :: forget(const region_id& ri, const e::slice& key)
+{
+    stripe* s = get_stripe(ri);
+    po6::threads::mutex::hold hold(&s->mtx);
+    entry_map_t::iterator it = s->entries.lower_bound(std::make_pair(ri, uint64_t(0)));
+
+    while (it != s->entries.end() && it->first.first == ri)
+    {
+        if (it->second.size() == key.size() &&
+            memcmp(it->second.data(), key.data(), key.size()) == 0)
+        {
+            s->entries.erase(it++);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void
+unacked_index :: regions(std::vector<region_id>* ris)
+{
+    ris->clear();
+
+    for (size_t i = 0; i < UNACKED_INDEX_STRIPES; ++i)
+    {
+        stripe* s = &m_stripes[i];
+        po6::threads::mutex::hold hold(&s->mtx);
+        entry_map_t::iterator it = s->entries.begin();
+
+        while (it != s->entries.end())
+        {
+            region_id ri = it->first.first;
+            ris->push_back(ri);
+            it = s->entries.upper_bound(std::make_pair(ri, UINT64_MAX));
+        }
+    }
+
+    std::sort(ris->begin(), ris->end());
+}
+
+void
+unacked_index :: keys(const region_id& ri, std::vector<std::string>* keys)
+{
+    keys->clear();
+
+    {
+        stripe* s = get_stripe(ri);
+        po6::threads::mutex::hold hold(&s->mtx);
+
+        for (entry_map_t::iterator it = s->entries.lower_bound(std::make_pair(ri, uint64_t(0)));
+                it != s->entries.end() && it->first.first == ri; ++it)
+        {
+            keys->push_back(it->second);
+        }
+    }
+
+    std::sort(keys->begin(), keys->end());
+    keys->erase(std::unique(keys->begin(), keys->end()), keys->end());
+}
+
+uint64_t
+unacked_index :: versions(const region_id& ri,
+                          const identifier_generator& ids,
+                          std::vector<uint64_t>* versions)
+{
+    versions->clear();
+    stripe* s = get_stripe(ri);
+    po6::threads::mutex::hold hold(&s->mtx);
+
+    for (entry_map_t::iterator it = s->entries.lower_bound(std::make_pair(ri, uint64_t(0)));
+            it != s->entries.end() && it->first.first == ri; ++it)
+    {
+        versions->push_back(it->first.second);
+    }
+
+    bool ranged = false;
+
+    for (range_map_t::iterator it = s->ranges.lower_bound(std::make_pair(ri, uint64_t(0)));
+            it != s->ranges.end() && it->first.first == ri; ++it)
+    {
+        for (uint64_t i = 0; i < it->second; ++i)
+        {
+            versions->push_back(it->first.second + i);
+        }
+
+        ranged = true;
+    }
+
+    if (ranged)
+    {
+        std::sort(versions->begin(), versions->end());
+    }
+
+    return ids.peek(ri);
+}
+
+uint64_t
+unacked_index :: generate_range(const region_id& ri, uint64_t n,
+                                identifier_generator* ids)
+{
+    assert(n > 0);
+    stripe* s = get_stripe(ri);
+    po6::threads::mutex::hold hold(&s->mtx);
+    uint64_t first = ids->generate_ids(ri, n);
+    s->ranges[std::make_pair(ri, first)] = n;
+    return first;
+}
+
+void
+unacked_index :: remove_range(const region_id& ri, uint64_t first)
+{
+    stripe* s = get_stripe(ri);
+    po6::threads::mutex::hold hold(&s->mtx);
+    s->ranges.erase(std::make_pair(ri, first));
+}
+
+size_t
+unacked_index :: size()
+{
+    size_t sz = 0;
+
+    for (size_t i = 0; i < UNACKED_INDEX_STRIPES; ++i)
+    {
+        stripe* s = &m_stripes[i];
+        po6::threads::mutex::hold hold(&s->mtx);
+        sz += s->entries.size();
+
+        for (range_map_t::iterator it = s->ranges.begin();
+                it != s->ranges.end(); ++it)
+        {
+            sz += it->second;
+        }
+    }
+
+    return sz;
+}
@@ -0,0 +1,121 @@
+// Copyright (c) 2014, Cornell University
+// All rights reserved.
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+//     * Redistributions of source code must retain the above copyright notice,
+//       this list of conditions and the following disclaimer.
+//     * Redistributions in binary form must reproduce the above copyright
+//       notice, this list of conditions and the following disclaimer in the
+//       documentation and/or other materials provided with the distribution.
+//     * Neither the name of HyperDex nor the names of its contributors may be
+//       used to endorse or promote products derived from this software without
+//       specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+
+
+#ifndef hyperdex_daemon_unacked_index_h_
+#define hyperdex_daemon_unacked_index_h_
+
+// STL
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// po6
+#include <po6/threads/mutex.h>
+
+// e
+#include <e/slice.h>
+
+// HyperDex
+#include "namespace.h"
+#include "common/ids.h"
+#include "daemon/identifier_generator.h"
+
+// Regions are spread over this many independently locked stripes
+#define UNACKED_INDEX_STRIPES 64
+
+BEGIN_HYPERDEX_NAMESPACE
+
+// The versions of every operation this server holds in a key state but has
+// not seen through to the end of its chain, ordered by version within each
+// region.  Key states keep it current at the end of each pass of their state
+// machine, so the retransmitter can visit just the keys with work in flight,
+// and gap closing can read a region's outstanding versions without touching
+// any key state.  Bulk ingest batches hold runs of versions with no key state
+// behind them; those are kept as ranges that only "versions" reports.
+class unacked_index
+{
+    public:
+        unacked_index();
+        ~unacked_index() throw ();
+
+    public:
+        // take the next version for "ri" from "ids" and record it for "key"
+        // in one step, so that no caller of "versions" sees the version
+        // generated but not yet recorded
+        uint64_t generate(const region_id& ri, const e::slice& key,
+                          identifier_generator* ids);
+        void add(const region_id& ri, uint64_t version, const e::slice& key);
+        void remove(const region_id& ri, uint64_t version);
+        // remove every version recorded for "key" in "ri"
+        void forget(const region_id& ri, const e::slice& key);
+        // every region with at least one version recorded
+        void regions(std::vector<region_id>* ris);
+        // the distinct keys with versions recorded in "ri"
+        void keys(const region_id& ri, std::vector<std::string>* keys);
+        // the versions recorded in "ri" in ascending order; returns
+        // ids.peek(ri) as of the same instant
+        uint64_t versions(const region_id& ri,
+                          const identifier_generator& ids,
+                          std::vector<uint64_t>* versions);
+        // take "n" consecutive versions for "ri" from "ids" and record them
+        // as one range; returns the first
+        uint64_t generate_range(const region_id& ri, uint64_t n,
+                                identifier_generator* ids);
+        // remove the range starting at "first"
+        void remove_range(const region_id& ri, uint64_t first);
+        size_t size();
+
+    private:
+        typedef std::map<std::pair<region_id, uint64_t>, std::string> entry_map_t;
+        typedef std::map<std::pair<region_id, uint64_t>, uint64_t> range_map_t;
+        struct stripe
+        {
+            stripe() : mtx(), entries(), ranges() {}
+            po6::threads::mutex mtx;
+            entry_map_t entries;
+            range_map_t ranges;
+
+            private:
+                stripe(const stripe&);
+                stripe& operator = (const stripe&);
+        };
+        stripe* get_stripe(const region_id& ri)
+        { return &m_stripes[ri.get() % UNACKED_INDEX_STRIPES]; }
+
+    private:
+        stripe m_stripes[UNACKED_INDEX_STRIPES];
+
+    private:
+        unacked_index(const unacked_index&);
+        unacked_index& operator = (const unacked_index&);
+};
+
+END_HYPERDEX_NAMESPACE
+
+#endif // hyperdex_daemon_unacked_index_h_
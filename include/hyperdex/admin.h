@@ -51,6 +51,23 @@ struct hyperdex_admin_perf_counter
     uint64_t measurement;
 };
 
+/* laid out like struct hyperdex_client_attribute */
+struct hyperdex_admin_ingest_attribute
+{
+    const char* attr; /* NULL-terminated */
+    const char* value;
+    size_t value_sz;
+    enum hyperdatatype datatype;
+};
+
+struct hyperdex_admin_ingest_object
+{
+    const char* key;
+    size_t key_sz;
+    const struct hyperdex_admin_ingest_attribute* attrs;
+    size_t attrs_sz;
+};
+
 /* hyperdex_admin_returncode occupies [8704, 8832) */
 enum hyperdex_admin_returncode
 {
@@ -198,6 +215,18 @@ hyperdex_admin_raw_backup(const char* host, uint16_t port,
                           const char* name,
                           enum hyperdex_admin_returncode* status);
 
+/* Write objects into every replica of their regions in large batches that
+ * travel down each region's chain, bypassing the per-key operations.  Meant
+ * for initial loads:  objects must not be written by clients while they are
+ * being ingested, and the space must have no secondary subspaces.  A key given
+ * more than once keeps its last value. */
+int64_t
+hyperdex_admin_bulk_ingest(struct hyperdex_admin* admin,
+                           const char* space,
+                           const struct hyperdex_admin_ingest_object* objects,
+                           size_t objects_sz,
+                           enum hyperdex_admin_returncode* status);
+
 const char*
 hyperdex_admin_error_message(struct hyperdex_admin* admin);
 const char*
@@ -71,6 +71,35 @@ struct hyperdex_client_attribute_check
     enum hyperpredicate predicate;
 };
 
+enum hyperdex_client_aggregate_function
+{
+    HYPERDEX_CLIENT_AGGREGATE_SUM       = 1,
+    HYPERDEX_CLIENT_AGGREGATE_MIN       = 2,
+    HYPERDEX_CLIENT_AGGREGATE_MAX       = 3,
+    HYPERDEX_CLIENT_AGGREGATE_AVG       = 4,
+    HYPERDEX_CLIENT_AGGREGATE_HISTOGRAM = 5
+};
+
+/* An aggregate over an int64, float, or timestamp attribute.  The caller
+ * fills in the inputs; the outputs are valid once the operation completes.
+ * int64 and timestamp attributes report through int_value, float attributes
+ * (and every AVG) through float_value.  A HISTOGRAM counts values into
+ * buckets_sz buckets of bucket_width, starting at bucket_start. */
+struct hyperdex_client_aggregate_spec
+{
+    /* inputs */
+    const char* attr; /* NULL-terminated */
+    enum hyperdex_client_aggregate_function function;
+    double bucket_start;
+    double bucket_width;
+    size_t buckets_sz;
+    uint64_t* buckets;
+    /* outputs */
+    uint64_t count;
+    int64_t int_value;
+    double float_value;
+};
+
 /* hyperdex_client_returncode occupies [8448, 8576) */
 enum hyperdex_client_returncode
 {
@@ -144,6 +173,24 @@ hyperdex_client_uxact_cond_commit(struct hyperdex_client* _cl,
                                 const char* key, size_t key_sz,
                                 const struct hyperdex_client_attribute_check *chks, size_t chks_sz);
 
+int64_t
+hyperdex_client_aggregate(struct hyperdex_client* client,
+                          const char* space,
+                          const struct hyperdex_client_attribute_check* checks, size_t checks_sz,
+                          struct hyperdex_client_aggregate_spec* aggs, size_t aggs_sz,
+                          enum hyperdex_client_returncode* status);
+
+/* Retrieve num_keys objects with one request per server.  statuses, attrs,
+ * and attrs_sz hold one entry per key; status reports the operation as a
+ * whole. */
+int64_t
+hyperdex_client_get_many(struct hyperdex_client* client,
+                         const char* space,
+                         const char** keys, const size_t* keys_sz, size_t num_keys,
+                         enum hyperdex_client_returncode* status,
+                         enum hyperdex_client_returncode* statuses,
+                         const struct hyperdex_client_attribute** attrs, size_t* attrs_sz);
+
 int64_t
 hyperdex_client_get(struct hyperdex_client* client,
                     const char* space,
@@ -1137,6 +1184,14 @@ hyperdex_client_search(struct hyperdex_client* client,
                        enum hyperdex_client_returncode* status,
                        const struct hyperdex_client_attribute** attrs, size_t* attrs_sz);
 
+int64_t
+hyperdex_client_search_partial(struct hyperdex_client* client,
+                               const char* space,
+                               const struct hyperdex_client_attribute_check* checks, size_t checks_sz,
+                               const char** attrnames, size_t attrnames_sz,
+                               enum hyperdex_client_returncode* status,
+                               const struct hyperdex_client_attribute** attrs, size_t* attrs_sz);
+
 int64_t
 hyperdex_client_search_describe(struct hyperdex_client* client,
                                 const char* space,
@@ -1154,6 +1209,17 @@ hyperdex_client_sorted_search(struct hyperdex_client* client,
                               enum hyperdex_client_returncode* status,
                               const struct hyperdex_client_attribute** attrs, size_t* attrs_sz);
 
+int64_t
+hyperdex_client_sorted_search_partial(struct hyperdex_client* client,
+                                      const char* space,
+                                      const struct hyperdex_client_attribute_check* checks, size_t checks_sz,
+                                      const char** attrnames, size_t attrnames_sz,
+                                      const char* sort_by,
+                                      uint64_t limit,
+                                      int maxmin,
+                                      enum hyperdex_client_returncode* status,
+                                      const struct hyperdex_client_attribute** attrs, size_t* attrs_sz);
+
 int64_t
 hyperdex_client_count(struct hyperdex_client* client,
                       const char* space,
@@ -1165,12 +1231,39 @@ int64_t
 hyperdex_client_loop(struct hyperdex_client* client, int timeout,
                      enum hyperdex_client_returncode* status);
 
+/* Reap up to n finished operations in one call.  Waits up to timeout for the
+ * first, then takes only those whose responses have already arrived.  ids[i]
+ * and statuses[i] are what the i-th call to hyperdex_client_loop would have
+ * returned.  Returns the number reaped, or -1 if none could be, with the
+ * reason in statuses[0].  An error met after some operations were reaped is
+ * returned by the next call. */
+int64_t
+hyperdex_client_loop_many(struct hyperdex_client* client, int timeout,
+                          int64_t* ids, enum hyperdex_client_returncode* statuses,
+                          size_t n);
+
 int
 hyperdex_client_poll_fd(struct hyperdex_client* client);
 
 int
 hyperdex_client_block(struct hyperdex_client* client, int timeout);
 
+/* Let many threads share the client.  Each thread's hyperdex_client_loop
+ * returns only the operations that thread issued.  Call before sharing.
+ * Returns -1 if the client cannot track its threads. */
+int
+hyperdex_client_set_thread_safe(struct hyperdex_client* client, int enabled);
+
+/* Hold small requests (get, get_partial, and atomic operations) and send each
+ * server's as one message.  Held requests go out on hyperdex_client_flush, on
+ * the next hyperdex_client_loop, or once enough accumulate.  Disabling
+ * corking flushes. */
+int
+hyperdex_client_set_corking(struct hyperdex_client* client, int enabled);
+
+int
+hyperdex_client_flush(struct hyperdex_client* client);
+
 enum hyperdatatype
 hyperdex_client_attribute_type(struct hyperdex_client* client,
                                const char* space, const char* name,
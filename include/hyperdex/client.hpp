@@ -731,6 +731,12 @@ class Client
                        hyperdex_client_returncode* status,
                        const hyperdex_client_attribute** attrs, size_t* attrs_sz)
             { return hyperdex_client_search(m_cl, space, checks, checks_sz, status, attrs, attrs_sz); }
+        int64_t search_partial(const char* space,
+                               const hyperdex_client_attribute_check* checks, size_t checks_sz,
+                               const char** attrnames, size_t attrnames_sz,
+                               hyperdex_client_returncode* status,
+                               const hyperdex_client_attribute** attrs, size_t* attrs_sz)
+            { return hyperdex_client_search_partial(m_cl, space, checks, checks_sz, attrnames, attrnames_sz, status, attrs, attrs_sz); }
         int64_t search_describe(const char* space,
                                 const hyperdex_client_attribute_check* checks, size_t checks_sz,
                                 hyperdex_client_returncode* status,
@@ -744,6 +750,15 @@ class Client
                               hyperdex_client_returncode* status,
                               const hyperdex_client_attribute** attrs, size_t* attrs_sz)
             { return hyperdex_client_sorted_search(m_cl, space, checks, checks_sz, sort_by, limit, maxmin, status, attrs, attrs_sz); }
+        int64_t sorted_search_partial(const char* space,
+                                      const hyperdex_client_attribute_check* checks, size_t checks_sz,
+                                      const char** attrnames, size_t attrnames_sz,
+                                      const char* sort_by,
+                                      uint64_t limit,
+                                      int maxmin,
+                                      hyperdex_client_returncode* status,
+                                      const hyperdex_client_attribute** attrs, size_t* attrs_sz)
+            { return hyperdex_client_sorted_search_partial(m_cl, space, checks, checks_sz, attrnames, attrnames_sz, sort_by, limit, maxmin, status, attrs, attrs_sz); }
         int64_t count(const char* space,
                       const hyperdex_client_attribute_check* checks, size_t checks_sz,
                       hyperdex_client_returncode* status,
@@ -759,10 +774,19 @@ class Client
     public:
         int64_t loop(int timeout, hyperdex_client_returncode* status)
             { return hyperdex_client_loop(m_cl, timeout, status); }
+        int64_t loop_many(int timeout, int64_t* ids,
+                          hyperdex_client_returncode* statuses, size_t n)
+            { return hyperdex_client_loop_many(m_cl, timeout, ids, statuses, n); }
         int poll_fd()
             { return hyperdex_client_poll_fd(m_cl); }
         int block(int timeout)
             { return hyperdex_client_block(m_cl, timeout); }
+        int set_thread_safe(bool enabled)
+            { return hyperdex_client_set_thread_safe(m_cl, enabled ? 1 : 0); }
+        int set_corking(bool enabled)
+            { return hyperdex_client_set_corking(m_cl, enabled ? 1 : 0); }
+        int flush()
+            { return hyperdex_client_flush(m_cl); }
         std::string error_message()
             { return hyperdex_client_error_message(m_cl); }
         std::string error_location()
@@ -45,17 +45,19 @@ struct hyperspace;
 /* hyperspace_returncode occupies [8576, 8704) */
 enum hyperspace_returncode
 {
-    HYPERSPACE_SUCCESS       = 8576,
-    HYPERSPACE_INVALID_NAME  = 8577,
-    HYPERSPACE_INVALID_TYPE  = 8578,
-    HYPERSPACE_DUPLICATE     = 8579,
-    HYPERSPACE_IS_KEY        = 8580,
-    HYPERSPACE_UNKNOWN_ATTR  = 8581,
-    HYPERSPACE_NO_SUBSPACE   = 8582,
-    HYPERSPACE_OUT_OF_BOUNDS = 8583,
-    HYPERSPACE_UNINDEXABLE   = 8584,
-
-    HYPERSPACE_GARBAGE       = 8703
+    HYPERSPACE_SUCCESS             = 8576,
+    HYPERSPACE_INVALID_NAME        = 8577,
+    HYPERSPACE_INVALID_TYPE        = 8578,
+    HYPERSPACE_DUPLICATE           = 8579,
+    HYPERSPACE_IS_KEY              = 8580,
+    HYPERSPACE_UNKNOWN_ATTR        = 8581,
+    HYPERSPACE_NO_SUBSPACE         = 8582,
+    HYPERSPACE_OUT_OF_BOUNDS       = 8583,
+    HYPERSPACE_UNINDEXABLE         = 8584,
+    HYPERSPACE_INVALID_DURABILITY  = 8585,
+    HYPERSPACE_INVALID_CONSISTENCY = 8586,
+
+    HYPERSPACE_GARBAGE             = 8703
 };
 
 struct hyperspace*
@@ -99,6 +101,14 @@ hyperspace_set_number_of_partitions(struct hyperspace* space, uint64_t num);
 enum hyperspace_returncode
 hyperspace_use_authorization(struct hyperspace* space);
 
+/* mode is one of "none", "periodic", or "sync" */
+enum hyperspace_returncode
+hyperspace_set_durability(struct hyperspace* space, const char* mode);
+
+/* mode is one of "strong" or "stale" */
+enum hyperspace_returncode
+hyperspace_set_consistency(struct hyperspace* space, const char* mode);
+
 #ifdef __cplusplus
 } /* extern "C" */
 #endif /* __cplusplus */